@@ -10,6 +10,9 @@
 #define _TSDEF_DEF_H_
 
 
+#include <stddef.h>
+
+
 #define TSDEF_PRIMITIVE_CONVERSION_ALLOWED     0
 #define TSDEF_PRIMITIVE_CONVERSION_DISALLOWED -1
 
@@ -64,6 +67,8 @@
 #define TSDEF_EXP_TYPE_COMPARISON 1
 #define TSDEF_EXP_TYPE_LOGICAL    2
 
+#define TSDEF_BLOCK_FLAG_FROZEN 0x01
+
 #define TSDEF_IF_STATEMENT_FLAG_ELSE 0x01
 
 #define TSDEF_LOOP_TYPE_FOR   0x01
@@ -116,6 +121,8 @@ struct tsdef_variable_list
     struct tsdef_variable_list_node* start;
 
     unsigned int count;
+
+    struct tsdef_variable_reference** variables;
 };
 
 struct tsdef_function_call
@@ -138,11 +145,14 @@ struct tsdef_function_call_list
     struct tsdef_function_call_list_node* start;
 
     unsigned int count;
+
+    struct tsdef_function_call** function_calls;
 };
 
 struct tsdef_block
 {
     unsigned int depth;
+    unsigned int flags;
 
     struct tsdef_variable* variables;
     unsigned int           variable_count;
@@ -249,6 +259,8 @@ struct tsdef_exp_list
     struct tsdef_exp_list_node* start;
 
     unsigned int count;
+
+    struct tsdef_exp** exps;
 };
 
 struct tsdef_assignment
@@ -347,6 +359,14 @@ struct tsdef_unit
     unsigned int         action_count;
 };
 
+/* The byte count sums the sizes of a unit's nodes and strings, it does
+   not see allocator overhead so it only estimates the unit's footprint */
+struct tsdef_unit_measure
+{
+    unsigned int node_count;
+    size_t       estimated_bytes;
+};
+
 
 extern unsigned int tsdef_primary_exp_op_precedence[];
 extern unsigned int tsdef_logical_exp_op_precedence[];
@@ -515,8 +535,14 @@ extern int TSDef_DefineOutput (
 
 extern int  TSDef_InitializeUnit (char*, struct tsdef_unit*);
 extern int  TSDef_CloneUnit      (struct tsdef_unit*, struct tsdef_unit*);
+extern int  TSDef_FreezeUnit     (struct tsdef_unit*);
+extern void TSDef_MeasureUnit    (struct tsdef_unit*, struct tsdef_unit_measure*);
 extern void TSDef_DestroyUnit    (struct tsdef_unit*);
 
+extern int  TSDef_CloneUnitBody   (struct tsdef_unit*, struct tsdef_unit*);
+extern void TSDef_RestoreUnitBody (struct tsdef_unit*, struct tsdef_unit*, struct tsdef_variable*);
+extern void TSDef_DestroyUnitBody (struct tsdef_unit*);
+
 
 #endif
 
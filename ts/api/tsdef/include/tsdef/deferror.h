@@ -10,22 +10,23 @@
 #define _TSDEF_DEFERROR_H_
 
 
-#define TSDEF_DEF_ERROR_NONE                       0
-#define TSDEF_DEF_ERROR_INTERNAL                  -1
-#define TSDEF_DEF_ERROR_SYNTAX                    -2
-#define TSDEF_DEF_ERROR_INCOMPATIBLE_TYPES        -3
-#define TSDEF_DEF_ERROR_INVALID_USE_OF_OPERATOR   -4
-#define TSDEF_DEF_ERROR_UNDEFINED_VARIABLE        -5
-#define TSDEF_DEF_ERROR_FLOW_CONTROL_OUTSIDE_LOOP -6
-#define TSDEF_DEF_ERROR_WRONG_ARGUMENT_COUNT      -7
-#define TSDEF_DEF_ERROR_VARIABLE_REDEFINITION     -8
-#define TSDEF_DEF_ERROR_UNDEFINED_FUNCTION        -9
-#define TSDEF_DEF_ERROR_USING_VOID_TYPE           -10
-#define TSDEF_DEF_ERROR_USING_DELAYED_TYPE        -11
-#define TSDEF_DEF_ERROR_FUNCTION_REDEFINITION     -12
-#define TSDEF_DEF_ERROR_TYPE_NOT_STEPPABLE        -13
-#define TSDEF_DEF_ERROR_FUNCTION_NOT_ACTIONABLE   -14
-#define TSDEF_DEF_ERROR_FUNCTION_NOT_INVOCABLE    -15
+#define TSDEF_DEF_ERROR_NONE                          0
+#define TSDEF_DEF_ERROR_INTERNAL                     -1
+#define TSDEF_DEF_ERROR_SYNTAX                       -2
+#define TSDEF_DEF_ERROR_INCOMPATIBLE_TYPES           -3
+#define TSDEF_DEF_ERROR_INVALID_USE_OF_OPERATOR      -4
+#define TSDEF_DEF_ERROR_UNDEFINED_VARIABLE           -5
+#define TSDEF_DEF_ERROR_FLOW_CONTROL_OUTSIDE_LOOP    -6
+#define TSDEF_DEF_ERROR_WRONG_ARGUMENT_COUNT         -7
+#define TSDEF_DEF_ERROR_VARIABLE_REDEFINITION        -8
+#define TSDEF_DEF_ERROR_UNDEFINED_FUNCTION           -9
+#define TSDEF_DEF_ERROR_USING_VOID_TYPE              -10
+#define TSDEF_DEF_ERROR_USING_DELAYED_TYPE           -11
+#define TSDEF_DEF_ERROR_FUNCTION_REDEFINITION        -12
+#define TSDEF_DEF_ERROR_TYPE_NOT_STEPPABLE           -13
+#define TSDEF_DEF_ERROR_FUNCTION_NOT_ACTIONABLE      -14
+#define TSDEF_DEF_ERROR_FUNCTION_NOT_INVOCABLE       -15
+#define TSDEF_DEF_ERROR_ASYNC_FUNCTION_IN_EXPRESSION -16
 
 #define TSDEF_DEF_ERROR_FLAG_WARNING    0x01
 #define TSDEF_DEF_ERROR_FLAG_INFO_VALID 0x02
@@ -89,6 +90,11 @@ struct tsdef_def_error_info
         {
             char* name;
         }function_not_invocable;
+
+        struct
+        {
+            char* name;
+        }async_function_in_expression;
     }data;
 };
 
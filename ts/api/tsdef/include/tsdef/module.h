@@ -12,6 +12,7 @@
 
 #include <tsdef/def.h>
 #include <tsdef/arguments.h>
+#include <tsdef/deferror.h>
 #include <tsffi/register.h>
 
 
@@ -24,8 +25,30 @@
 
 #define TSDEF_MODULE_FFI_GROUP_FLAG_REFERENCED 0x01
 
+#define TSDEF_MODULE_FLAG_DEFER_RESOLVE    0x01
+#define TSDEF_MODULE_FLAG_FREE_LOOKUP_DATA 0x02
+
 #define TSDEF_MODULE_OBJECT_HASH_SIZE 2048
 
+#define TSDEF_RESOLVE_NOTIFY_BEGIN 0
+#define TSDEF_RESOLVE_NOTIFY_END   1
+
+
+struct tsdef_module_object;
+
+
+typedef int (*tsdef_module_object_lookup) (
+                                           char*,
+                                           struct tsdef_argument_types*,
+                                           void*,
+                                           struct tsdef_module_object**
+                                          );
+typedef void (*tsdef_resolve_notify)       (
+                                            unsigned int,
+                                            struct tsdef_module_object*,
+                                            void*
+                                           );
+
 
 struct tsdef_module_object
 {
@@ -76,6 +99,15 @@ struct tsdef_module
 
     struct tsdef_unit* main_unit;
 
+    unsigned int flags;
+
+    tsdef_module_object_lookup   deferred_lookup;
+    void*                        deferred_lookup_data;
+    struct tsdef_def_error_list* deferred_errors;
+
+    tsdef_resolve_notify resolve_notify;
+    void*                resolve_notify_data;
+
     unsigned int registered_ffi_group_count;
     unsigned int referenced_unit_count;
 
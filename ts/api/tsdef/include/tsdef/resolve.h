@@ -16,14 +16,6 @@
 #include <tsdef/arguments.h>
 
 
-typedef int (*tsdef_module_object_lookup) (
-                                           char*,
-                                           struct tsdef_argument_types*,
-                                           void*,
-                                           struct tsdef_module_object**
-                                          );
-
-
 extern int TSDef_ResolveUnit (
                               struct tsdef_unit*,
                               struct tsdef_argument_types*,
@@ -34,6 +26,8 @@ extern int TSDef_ResolveUnit (
                               struct tsdef_def_error_list*
                              );
 
+extern int TSDef_ResolveDeferredUnit (struct tsdef_module_object*, struct tsdef_module*);
+
 
 #endif
 
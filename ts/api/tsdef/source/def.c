@@ -28,10 +28,32 @@ static int  CloneBlock      (
                             );
 static void DestroyBlock    (struct tsdef_block*);
 
+static void DestroyStatements (struct tsdef_block*);
+static void DestroyActions    (struct tsdef_action*);
+
 static void RebaseStatementBlockDepth (struct tsdef_block*);
 
 static int CloneAction (struct tsdef_action*, struct tsdef_unit*);
 
+static int FreezeExp              (struct tsdef_exp*);
+static int FreezeExpList          (struct tsdef_exp_list*);
+static int FreezeFunctionCall     (struct tsdef_function_call*);
+static int FreezeFunctionCallList (struct tsdef_function_call_list*);
+static int FreezeVariableList     (struct tsdef_variable_list*);
+static int FreezeBlock            (struct tsdef_block*);
+
+static void MeasureNode                 (size_t, struct tsdef_unit_measure*);
+static void MeasureString               (char*, struct tsdef_unit_measure*);
+static void MeasureVariableReference    (struct tsdef_variable_reference*, struct tsdef_unit_measure*);
+static void MeasureVariableList         (struct tsdef_variable_list*, struct tsdef_unit_measure*);
+static void MeasurePrimaryExp           (struct tsdef_primary_exp*, struct tsdef_unit_measure*);
+static void MeasureExp                  (struct tsdef_exp*, struct tsdef_unit_measure*);
+static void MeasureExpList              (struct tsdef_exp_list*, struct tsdef_unit_measure*);
+static void MeasureFunctionCall         (struct tsdef_function_call*, struct tsdef_unit_measure*);
+static void MeasureFunctionCallList     (struct tsdef_function_call_list*, struct tsdef_unit_measure*);
+static void MeasureAssignment           (struct tsdef_assignment*, struct tsdef_unit_measure*);
+static void MeasureBlock                (struct tsdef_block*, struct tsdef_unit_measure*);
+
 
 unsigned int tsdef_primary_exp_op_precedence[] = {
                                                   0, /* op value */
@@ -70,6 +92,7 @@ static void InitializeBlock (
     else
         block->depth = parent_block->depth+1;
 
+    block->flags            = 0;
     block->variables        = NULL;
     block->variable_count   = 0;
     block->statements       = NULL;
@@ -188,9 +211,27 @@ clone_function_call_failed:
 }
 
 static void DestroyBlock (struct tsdef_block* block)
+{
+    struct tsdef_variable* variable;
+
+    DestroyStatements(block);
+
+    variable = block->variables;
+    while(variable != NULL)
+    {
+        struct tsdef_variable* free_variable;
+
+        free_variable = variable;
+        variable      = variable->next_variable;
+
+        free(free_variable->name);
+        free(free_variable);
+    }
+}
+
+static void DestroyStatements (struct tsdef_block* block)
 {
     struct tsdef_statement* statement;
-    struct tsdef_variable*  variable;
 
     statement = block->statements;
     while(statement != NULL)
@@ -228,19 +269,27 @@ static void DestroyBlock (struct tsdef_block* block)
         free_statement = statement;
         statement      = statement->next_statement;
 
-        free(free_statement);
+        if((block->flags&TSDEF_BLOCK_FLAG_FROZEN) == 0)
+            free(free_statement);
     }
 
-    variable = block->variables;
-    while(variable != NULL)
+    if(block->flags&TSDEF_BLOCK_FLAG_FROZEN && block->statements != NULL)
+        free(block->statements);
+}
+
+static void DestroyActions (struct tsdef_action* action)
+{
+    while(action != NULL)
     {
-        struct tsdef_variable* free_variable;
+        struct tsdef_action* free_action;
 
-        free_variable = variable;
-        variable      = variable->next_variable;
+        TSDef_DestroyFunctionCallList(action->trigger_list);
+        DestroyBlock(&action->block);
 
-        free(free_variable->name);
-        free(free_variable);
+        free_action = action;
+        action      = action->next_action;
+
+        free(free_action);
     }
 }
 
@@ -313,6 +362,616 @@ allocate_action_failed:
     return TSDEF_ERROR_MEMORY;
 }
 
+static int FreezeExp (struct tsdef_exp* exp)
+{
+    struct tsdef_primary_exp_node*    primary_node;
+    struct tsdef_comparison_exp_node* comparison_node;
+    struct tsdef_logical_exp_node*    logical_node;
+    struct tsdef_exp_value_type*      exp_value_type;
+    int                               error;
+
+    switch(exp->type)
+    {
+    case TSDEF_EXP_TYPE_PRIMARY:
+        for(
+            primary_node = exp->data.primary_exp->start;
+            primary_node != NULL;
+            primary_node = primary_node->remaining_exp
+           )
+        {
+            exp_value_type = primary_node->exp_value_type;
+
+            switch(exp_value_type->type)
+            {
+            case TSDEF_EXP_VALUE_TYPE_FUNCTION_CALL:
+                error = FreezeFunctionCall(exp_value_type->data.function_call);
+                if(error != TSDEF_ERROR_NONE)
+                    return error;
+
+                break;
+
+            case TSDEF_EXP_VALUE_TYPE_EXP:
+                error = FreezeExp(exp_value_type->data.exp);
+                if(error != TSDEF_ERROR_NONE)
+                    return error;
+
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        break;
+
+    case TSDEF_EXP_TYPE_COMPARISON:
+        comparison_node = exp->data.comparison_exp->start;
+        while(1)
+        {
+            struct tsdef_exp primary_exp;
+
+            primary_exp.type             = TSDEF_EXP_TYPE_PRIMARY;
+            primary_exp.data.primary_exp = comparison_node->left_exp;
+
+            error = FreezeExp(&primary_exp);
+            if(error != TSDEF_ERROR_NONE)
+                return error;
+
+            if(comparison_node == &exp->data.comparison_exp->end)
+            {
+                primary_exp.data.primary_exp = comparison_node->right_exp;
+
+                error = FreezeExp(&primary_exp);
+                if(error != TSDEF_ERROR_NONE)
+                    return error;
+
+                break;
+            }
+
+            comparison_node = comparison_node->remaining_exp;
+        }
+
+        break;
+
+    case TSDEF_EXP_TYPE_LOGICAL:
+        logical_node = exp->data.logical_exp->start;
+        while(1)
+        {
+            error = FreezeExp(logical_node->left_exp);
+            if(error != TSDEF_ERROR_NONE)
+                return error;
+
+            if(logical_node == &exp->data.logical_exp->end)
+            {
+                if(logical_node->right_exp != NULL)
+                {
+                    error = FreezeExp(logical_node->right_exp);
+                    if(error != TSDEF_ERROR_NONE)
+                        return error;
+                }
+
+                break;
+            }
+
+            logical_node = logical_node->remaining_exp;
+        }
+
+        break;
+    }
+
+    return TSDEF_ERROR_NONE;
+}
+
+static int FreezeExpList (struct tsdef_exp_list* exp_list)
+{
+    struct tsdef_exp_list_node* node;
+    struct tsdef_exp**          exps;
+    int                         error;
+
+    if(exp_list->exps != NULL)
+        return TSDEF_ERROR_NONE;
+
+    exps = malloc(sizeof(struct tsdef_exp*)*exp_list->count);
+    if(exps == NULL)
+        return TSDEF_ERROR_MEMORY;
+
+    exp_list->exps = exps;
+
+    for(node = exp_list->start; node != NULL; node = node->next_exp)
+    {
+        error = FreezeExp(node->exp);
+        if(error != TSDEF_ERROR_NONE)
+            return error;
+
+        *exps = node->exp;
+        exps++;
+    }
+
+    return TSDEF_ERROR_NONE;
+}
+
+static int FreezeFunctionCall (struct tsdef_function_call* function_call)
+{
+    if(function_call->arguments == NULL)
+        return TSDEF_ERROR_NONE;
+
+    return FreezeExpList(function_call->arguments);
+}
+
+static int FreezeFunctionCallList (struct tsdef_function_call_list* function_call_list)
+{
+    struct tsdef_function_call_list_node* node;
+    struct tsdef_function_call**          function_calls;
+    int                                   error;
+
+    if(function_call_list->function_calls != NULL)
+        return TSDEF_ERROR_NONE;
+
+    function_calls = malloc(sizeof(struct tsdef_function_call*)*function_call_list->count);
+    if(function_calls == NULL)
+        return TSDEF_ERROR_MEMORY;
+
+    function_call_list->function_calls = function_calls;
+
+    for(node = function_call_list->start; node != NULL; node = node->next_function_call)
+    {
+        error = FreezeFunctionCall(node->function_call);
+        if(error != TSDEF_ERROR_NONE)
+            return error;
+
+        *function_calls = node->function_call;
+        function_calls++;
+    }
+
+    return TSDEF_ERROR_NONE;
+}
+
+static int FreezeVariableList (struct tsdef_variable_list* variable_list)
+{
+    struct tsdef_variable_list_node*  node;
+    struct tsdef_variable_reference** variables;
+
+    if(variable_list->variables != NULL)
+        return TSDEF_ERROR_NONE;
+
+    variables = malloc(sizeof(struct tsdef_variable_reference*)*variable_list->count);
+    if(variables == NULL)
+        return TSDEF_ERROR_MEMORY;
+
+    variable_list->variables = variables;
+
+    for(node = variable_list->start; node != NULL; node = node->next_variable)
+    {
+        *variables = node->variable;
+        variables++;
+    }
+
+    return TSDEF_ERROR_NONE;
+}
+
+static int FreezeBlock (struct tsdef_block* block)
+{
+    struct tsdef_statement* frozen_statements;
+    struct tsdef_statement* statement;
+    struct tsdef_block*     statement_block;
+    unsigned int            index;
+    int                     error;
+
+    if(block->flags&TSDEF_BLOCK_FLAG_FROZEN)
+        return TSDEF_ERROR_NONE;
+
+    for(
+        statement = block->statements;
+        statement != NULL;
+        statement = statement->next_statement
+       )
+    {
+        switch(statement->type)
+        {
+        case TSDEF_STATEMENT_TYPE_FUNCTION_CALL:
+            error = FreezeFunctionCall(statement->data.function_call);
+
+            break;
+
+        case TSDEF_STATEMENT_TYPE_ASSIGNMENT:
+            error = FreezeExp(statement->data.assignment->rvalue);
+
+            break;
+
+        case TSDEF_STATEMENT_TYPE_IF_STATEMENT:
+            if(statement->data.if_statement->exp != NULL)
+            {
+                error = FreezeExp(statement->data.if_statement->exp);
+                if(error != TSDEF_ERROR_NONE)
+                    return error;
+            }
+
+            error = FreezeBlock(&statement->data.if_statement->block);
+
+            break;
+
+        case TSDEF_STATEMENT_TYPE_LOOP:
+            switch(statement->data.loop->type)
+            {
+            case TSDEF_LOOP_TYPE_FOR:
+                if(statement->data.loop->data.for_loop.assignment != NULL)
+                {
+                    error = FreezeExp(statement->data.loop->data.for_loop.assignment->rvalue);
+                    if(error != TSDEF_ERROR_NONE)
+                        return error;
+                }
+
+                error = FreezeExp(statement->data.loop->data.for_loop.to_exp);
+
+                break;
+
+            case TSDEF_LOOP_TYPE_WHILE:
+                error = FreezeExp(statement->data.loop->data.while_loop.exp);
+
+                break;
+            }
+
+            if(error != TSDEF_ERROR_NONE)
+                return error;
+
+            error = FreezeBlock(&statement->data.loop->block);
+
+            break;
+
+        case TSDEF_STATEMENT_TYPE_CONTINUE:
+        case TSDEF_STATEMENT_TYPE_BREAK:
+        case TSDEF_STATEMENT_TYPE_FINISH:
+            error = TSDEF_ERROR_NONE;
+
+            break;
+        }
+
+        if(error != TSDEF_ERROR_NONE)
+            return error;
+    }
+
+    if(block->statement_count == 0)
+    {
+        block->flags |= TSDEF_BLOCK_FLAG_FROZEN;
+
+        return TSDEF_ERROR_NONE;
+    }
+
+    frozen_statements = malloc(sizeof(struct tsdef_statement)*block->statement_count);
+    if(frozen_statements == NULL)
+        return TSDEF_ERROR_MEMORY;
+
+    index     = 0;
+    statement = block->statements;
+    while(statement != NULL)
+    {
+        struct tsdef_statement* free_statement;
+
+        frozen_statements[index] = *statement;
+
+        switch(statement->type)
+        {
+        case TSDEF_STATEMENT_TYPE_IF_STATEMENT:
+            statement_block = &statement->data.if_statement->block;
+
+            break;
+
+        case TSDEF_STATEMENT_TYPE_LOOP:
+            statement_block = &statement->data.loop->block;
+
+            break;
+
+        default:
+            statement_block = NULL;
+
+            break;
+        }
+
+        if(statement_block != NULL)
+            statement_block->parent_statement = &frozen_statements[index];
+
+        free_statement = statement;
+        statement      = statement->next_statement;
+
+        free(free_statement);
+
+        index++;
+        if(statement != NULL)
+            frozen_statements[index-1].next_statement = &frozen_statements[index];
+    }
+
+    block->statements     = frozen_statements;
+    block->last_statement = &frozen_statements[index-1];
+    block->flags         |= TSDEF_BLOCK_FLAG_FROZEN;
+
+    return TSDEF_ERROR_NONE;
+}
+
+static void MeasureNode (size_t size, struct tsdef_unit_measure* measure)
+{
+    measure->node_count++;
+    measure->estimated_bytes += size;
+}
+
+static void MeasureString (char* string, struct tsdef_unit_measure* measure)
+{
+    if(string != NULL)
+        measure->estimated_bytes += strlen(string)+1;
+}
+
+static void MeasureVariableReference (
+                                      struct tsdef_variable_reference* reference,
+                                      struct tsdef_unit_measure*       measure
+                                     )
+{
+    MeasureNode(sizeof(struct tsdef_variable_reference), measure);
+    MeasureString(reference->name, measure);
+}
+
+static void MeasureVariableList (
+                                 struct tsdef_variable_list* variable_list,
+                                 struct tsdef_unit_measure*  measure
+                                )
+{
+    struct tsdef_variable_list_node* node;
+
+    MeasureNode(sizeof(struct tsdef_variable_list), measure);
+
+    for(node = variable_list->start; node != NULL; node = node->next_variable)
+    {
+        if(node != &variable_list->end)
+            MeasureNode(sizeof(struct tsdef_variable_list_node), measure);
+
+        MeasureVariableReference(node->variable, measure);
+    }
+
+    if(variable_list->variables != NULL)
+        measure->estimated_bytes += sizeof(struct tsdef_variable_reference*)*variable_list->count;
+}
+
+static void MeasurePrimaryExp (
+                               struct tsdef_primary_exp*  primary_exp,
+                               struct tsdef_unit_measure* measure
+                              )
+{
+    struct tsdef_primary_exp_node* node;
+
+    MeasureNode(sizeof(struct tsdef_primary_exp), measure);
+
+    for(node = primary_exp->start; node != NULL; node = node->remaining_exp)
+    {
+        struct tsdef_exp_value_type* exp_value_type;
+
+        if(node != &primary_exp->end)
+            MeasureNode(sizeof(struct tsdef_primary_exp_node), measure);
+
+        exp_value_type = node->exp_value_type;
+
+        MeasureNode(sizeof(struct tsdef_exp_value_type), measure);
+
+        switch(exp_value_type->type)
+        {
+        case TSDEF_EXP_VALUE_TYPE_STRING:
+            MeasureString(exp_value_type->data.string_constant, measure);
+
+            break;
+
+        case TSDEF_EXP_VALUE_TYPE_FUNCTION_CALL:
+            MeasureFunctionCall(exp_value_type->data.function_call, measure);
+
+            break;
+
+        case TSDEF_EXP_VALUE_TYPE_VARIABLE:
+            MeasureVariableReference(exp_value_type->data.variable, measure);
+
+            break;
+
+        case TSDEF_EXP_VALUE_TYPE_EXP:
+            MeasureExp(exp_value_type->data.exp, measure);
+
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+static void MeasureExp (struct tsdef_exp* exp, struct tsdef_unit_measure* measure)
+{
+    struct tsdef_comparison_exp_node* comparison_node;
+    struct tsdef_logical_exp_node*    logical_node;
+
+    MeasureNode(sizeof(struct tsdef_exp), measure);
+
+    switch(exp->type)
+    {
+    case TSDEF_EXP_TYPE_PRIMARY:
+        MeasurePrimaryExp(exp->data.primary_exp, measure);
+
+        break;
+
+    case TSDEF_EXP_TYPE_COMPARISON:
+        MeasureNode(sizeof(struct tsdef_comparison_exp), measure);
+
+        comparison_node = exp->data.comparison_exp->start;
+        while(1)
+        {
+            MeasurePrimaryExp(comparison_node->left_exp, measure);
+
+            if(comparison_node == &exp->data.comparison_exp->end)
+            {
+                MeasurePrimaryExp(comparison_node->right_exp, measure);
+
+                break;
+            }
+
+            MeasureNode(sizeof(struct tsdef_comparison_exp_node), measure);
+
+            comparison_node = comparison_node->remaining_exp;
+        }
+
+        break;
+
+    case TSDEF_EXP_TYPE_LOGICAL:
+        MeasureNode(sizeof(struct tsdef_logical_exp), measure);
+
+        logical_node = exp->data.logical_exp->start;
+        while(1)
+        {
+            MeasureExp(logical_node->left_exp, measure);
+
+            if(logical_node == &exp->data.logical_exp->end)
+            {
+                if(logical_node->right_exp != NULL)
+                    MeasureExp(logical_node->right_exp, measure);
+
+                break;
+            }
+
+            MeasureNode(sizeof(struct tsdef_logical_exp_node), measure);
+
+            logical_node = logical_node->remaining_exp;
+        }
+
+        break;
+    }
+}
+
+static void MeasureExpList (struct tsdef_exp_list* exp_list, struct tsdef_unit_measure* measure)
+{
+    struct tsdef_exp_list_node* node;
+
+    MeasureNode(sizeof(struct tsdef_exp_list), measure);
+
+    for(node = exp_list->start; node != NULL; node = node->next_exp)
+    {
+        if(node != &exp_list->end)
+            MeasureNode(sizeof(struct tsdef_exp_list_node), measure);
+
+        MeasureExp(node->exp, measure);
+    }
+
+    if(exp_list->exps != NULL)
+        measure->estimated_bytes += sizeof(struct tsdef_exp*)*exp_list->count;
+}
+
+static void MeasureFunctionCall (
+                                 struct tsdef_function_call* function_call,
+                                 struct tsdef_unit_measure*  measure
+                                )
+{
+    MeasureNode(sizeof(struct tsdef_function_call), measure);
+    MeasureString(function_call->name, measure);
+
+    if(function_call->arguments != NULL)
+        MeasureExpList(function_call->arguments, measure);
+}
+
+static void MeasureFunctionCallList (
+                                     struct tsdef_function_call_list* function_call_list,
+                                     struct tsdef_unit_measure*       measure
+                                    )
+{
+    struct tsdef_function_call_list_node* node;
+
+    MeasureNode(sizeof(struct tsdef_function_call_list), measure);
+
+    for(node = function_call_list->start; node != NULL; node = node->next_function_call)
+    {
+        if(node != &function_call_list->end)
+            MeasureNode(sizeof(struct tsdef_function_call_list_node), measure);
+
+        MeasureFunctionCall(node->function_call, measure);
+    }
+
+    if(function_call_list->function_calls != NULL)
+        measure->estimated_bytes += sizeof(struct tsdef_function_call*)*function_call_list->count;
+}
+
+static void MeasureAssignment (
+                               struct tsdef_assignment*   assignment,
+                               struct tsdef_unit_measure* measure
+                              )
+{
+    MeasureNode(sizeof(struct tsdef_assignment), measure);
+    MeasureVariableReference(assignment->lvalue, measure);
+    MeasureExp(assignment->rvalue, measure);
+}
+
+static void MeasureBlock (struct tsdef_block* block, struct tsdef_unit_measure* measure)
+{
+    struct tsdef_statement* statement;
+    struct tsdef_variable*  variable;
+    struct tsdef_loop*      loop;
+
+    for(variable = block->variables; variable != NULL; variable = variable->next_variable)
+    {
+        MeasureNode(sizeof(struct tsdef_variable), measure);
+        MeasureString(variable->name, measure);
+    }
+
+    for(statement = block->statements; statement != NULL; statement = statement->next_statement)
+    {
+        MeasureNode(sizeof(struct tsdef_statement), measure);
+
+        switch(statement->type)
+        {
+        case TSDEF_STATEMENT_TYPE_FUNCTION_CALL:
+            MeasureFunctionCall(statement->data.function_call, measure);
+
+            break;
+
+        case TSDEF_STATEMENT_TYPE_ASSIGNMENT:
+            MeasureAssignment(statement->data.assignment, measure);
+
+            break;
+
+        case TSDEF_STATEMENT_TYPE_IF_STATEMENT:
+            MeasureNode(sizeof(struct tsdef_if_statement), measure);
+
+            if(statement->data.if_statement->exp != NULL)
+                MeasureExp(statement->data.if_statement->exp, measure);
+
+            MeasureBlock(&statement->data.if_statement->block, measure);
+
+            break;
+
+        case TSDEF_STATEMENT_TYPE_LOOP:
+            loop = statement->data.loop;
+
+            MeasureNode(sizeof(struct tsdef_loop), measure);
+
+            switch(loop->type)
+            {
+            case TSDEF_LOOP_TYPE_FOR:
+                if(loop->data.for_loop.assignment != NULL)
+                    MeasureAssignment(loop->data.for_loop.assignment, measure);
+                else
+                    MeasureVariableReference(loop->data.for_loop.variable, measure);
+
+                MeasureExp(loop->data.for_loop.to_exp, measure);
+
+                break;
+
+            case TSDEF_LOOP_TYPE_WHILE:
+                MeasureExp(loop->data.while_loop.exp, measure);
+
+                break;
+            }
+
+            MeasureBlock(&loop->block, measure);
+
+            break;
+
+        case TSDEF_STATEMENT_TYPE_CONTINUE:
+        case TSDEF_STATEMENT_TYPE_BREAK:
+        case TSDEF_STATEMENT_TYPE_FINISH:
+            break;
+        }
+    }
+}
+
 
 struct tsdef_variable* TSDef_LookupVariable (char* name, struct tsdef_block* block)
 {
@@ -455,7 +1114,8 @@ int TSDef_ConstructVariableList (
         node                = &variable_list->end;
         node->next_variable = NULL;
 
-        variable_list->count = 1;
+        variable_list->count     = 1;
+        variable_list->variables = NULL;
     }
     else
     {
@@ -529,7 +1189,8 @@ struct tsdef_variable_list* TSDef_CloneVariableList (struct tsdef_variable_list*
 
     cloned_node->next_variable = NULL;
 
-    clone->count = variable_list->count;
+    clone->count     = variable_list->count;
+    clone->variables = NULL;
 
     return clone;
 
@@ -582,6 +1243,9 @@ void TSDef_DestroyVariableList (struct tsdef_variable_list* variable_list)
 
     TSDef_DestroyVariableReference(node->variable);
 
+    if(variable_list->variables != NULL)
+        free(variable_list->variables);
+
     free(variable_list);
 }
 
@@ -679,7 +1343,8 @@ int TSDef_ConstructFunctionCallList (
         node                     = &function_call_list->end;
         node->next_function_call = NULL;
 
-        function_call_list->count = 1;
+        function_call_list->count          = 1;
+        function_call_list->function_calls = NULL;
     }
     else
     {
@@ -753,7 +1418,8 @@ struct tsdef_function_call_list* TSDef_CloneFunctionCallList (struct tsdef_funct
 
     cloned_node->next_function_call = NULL;
 
-    clone->count = function_call_list->count;
+    clone->count          = function_call_list->count;
+    clone->function_calls = NULL;
 
     return clone;
 
@@ -806,6 +1472,9 @@ void TSDef_DestroyFunctionCallList (struct tsdef_function_call_list* function_ca
 
     TSDef_DestroyFunctionCall(node->function_call);
 
+    if(function_call_list->function_calls != NULL)
+        free(function_call_list->function_calls);
+
     free(function_call_list);
 }
 
@@ -1803,6 +2472,7 @@ int TSDef_ConstructExpList (
         node->next_exp = NULL;
 
         exp_list->count = 1;
+        exp_list->exps  = NULL;
     }
     else
     {
@@ -1877,6 +2547,7 @@ struct tsdef_exp_list* TSDef_CloneExpList (struct tsdef_exp_list* exp_list)
     cloned_node->next_exp = NULL;
 
     clone->count = exp_list->count;
+    clone->exps  = NULL;
 
     return clone;
 
@@ -1929,6 +2600,9 @@ void TSDef_DestroyExpList (struct tsdef_exp_list* exp_list)
 
     TSDef_DestroyExp(node->exp);
 
+    if(exp_list->exps != NULL)
+        free(exp_list->exps);
+
     free(exp_list);
 }
 
@@ -2472,9 +3146,76 @@ duplicate_name_failed:
     return TSDEF_ERROR_MEMORY;
 }
 
-void TSDef_DestroyUnit (struct tsdef_unit* unit)
+int TSDef_FreezeUnit (struct tsdef_unit* unit)
 {
     struct tsdef_action* action;
+    int                  error;
+
+    if(unit->input != NULL)
+    {
+        error = FreezeVariableList(unit->input->input_variables);
+        if(error != TSDEF_ERROR_NONE)
+            return error;
+    }
+
+    if(unit->output != NULL)
+    {
+        error = FreezeExp(unit->output->output_variable_assignment->rvalue);
+        if(error != TSDEF_ERROR_NONE)
+            return error;
+    }
+
+    error = FreezeBlock(&unit->global_block);
+    if(error != TSDEF_ERROR_NONE)
+        return error;
+
+    for(action = unit->actions; action != NULL; action = action->next_action)
+    {
+        error = FreezeFunctionCallList(action->trigger_list);
+        if(error != TSDEF_ERROR_NONE)
+            return error;
+
+        error = FreezeBlock(&action->block);
+        if(error != TSDEF_ERROR_NONE)
+            return error;
+    }
+
+    return TSDEF_ERROR_NONE;
+}
+
+void TSDef_MeasureUnit (struct tsdef_unit* unit, struct tsdef_unit_measure* measure)
+{
+    struct tsdef_action* action;
+
+    measure->node_count = 0;
+    measure->estimated_bytes = 0;
+
+    MeasureString(unit->name, measure);
+
+    if(unit->input != NULL)
+    {
+        MeasureNode(sizeof(struct tsdef_input), measure);
+        MeasureVariableList(unit->input->input_variables, measure);
+    }
+
+    if(unit->output != NULL)
+    {
+        MeasureNode(sizeof(struct tsdef_output), measure);
+        MeasureAssignment(unit->output->output_variable_assignment, measure);
+    }
+
+    MeasureBlock(&unit->global_block, measure);
+
+    for(action = unit->actions; action != NULL; action = action->next_action)
+    {
+        MeasureNode(sizeof(struct tsdef_action), measure);
+        MeasureFunctionCallList(action->trigger_list, measure);
+        MeasureBlock(&action->block, measure);
+    }
+}
+
+void TSDef_DestroyUnit (struct tsdef_unit* unit)
+{
     struct tsdef_input*  input;
     struct tsdef_output* output;
 
@@ -2495,19 +3236,94 @@ void TSDef_DestroyUnit (struct tsdef_unit* unit)
     }
 
     DestroyBlock(&unit->global_block);
+    DestroyActions(unit->actions);
+}
 
-    action = unit->actions;
-    while(action != NULL)
+int TSDef_CloneUnitBody (struct tsdef_unit* original_unit, struct tsdef_unit* cloned_unit)
+{
+    struct tsdef_action* action;
+    int                  error;
+
+    error = CloneBlock(&original_unit->global_block, NULL, NULL, &cloned_unit->global_block);
+    if(error != TSDEF_ERROR_NONE)
+        return error;
+
+    cloned_unit->actions      = NULL;
+    cloned_unit->action_count = 0;
+    for(action = original_unit->actions; action != NULL; action = action->next_action)
     {
-        struct tsdef_action* free_action;
+        error = CloneAction(action, cloned_unit);
+        if(error != TSDEF_ERROR_NONE)
+            goto clone_action_failed;
+    }
 
-        TSDef_DestroyFunctionCallList(action->trigger_list);
-        DestroyBlock(&action->block);
+    return TSDEF_ERROR_NONE;
 
-        free_action = action;
-        action      = action->next_action;
+clone_action_failed:
+    TSDef_DestroyUnitBody(cloned_unit);
 
-        free(free_action);
+    return error;
+}
+
+void TSDef_RestoreUnitBody (
+                            struct tsdef_unit*     unit,
+                            struct tsdef_unit*     saved_unit,
+                            struct tsdef_variable* kept_variables
+                           )
+{
+    struct tsdef_block*     global_block;
+    struct tsdef_statement* statement;
+    struct tsdef_action*    action;
+
+    global_block = &unit->global_block;
+
+    DestroyStatements(global_block);
+    DestroyActions(unit->actions);
+
+    while(global_block->variables != kept_variables)
+    {
+        struct tsdef_variable* free_variable;
+
+        free_variable           = global_block->variables;
+        global_block->variables = free_variable->next_variable;
+
+        free(free_variable->name);
+        free(free_variable);
+
+        global_block->variable_count--;
+    }
+
+    /* The saved body is moved rather than cloned again so restoring can't
+       fail, only the blocks that point at the global block need fixing */
+    global_block->flags           = saved_unit->global_block.flags;
+    global_block->statements      = saved_unit->global_block.statements;
+    global_block->last_statement  = saved_unit->global_block.last_statement;
+    global_block->statement_count = saved_unit->global_block.statement_count;
+
+    for(statement = global_block->statements; statement != NULL; statement = statement->next_statement)
+    {
+        if(statement->type == TSDEF_STATEMENT_TYPE_IF_STATEMENT)
+            statement->data.if_statement->block.parent_block = global_block;
+        else if(statement->type == TSDEF_STATEMENT_TYPE_LOOP)
+            statement->data.loop->block.parent_block = global_block;
     }
+
+    unit->actions      = saved_unit->actions;
+    unit->action_count = saved_unit->action_count;
+
+    for(action = unit->actions; action != NULL; action = action->next_action)
+        action->block.parent_block = global_block;
+
+    saved_unit->global_block.statements      = NULL;
+    saved_unit->global_block.last_statement  = NULL;
+    saved_unit->global_block.statement_count = 0;
+    saved_unit->actions                      = NULL;
+    saved_unit->action_count                 = 0;
+}
+
+void TSDef_DestroyUnitBody (struct tsdef_unit* unit)
+{
+    DestroyBlock(&unit->global_block);
+    DestroyActions(unit->actions);
 }
 
@@ -128,6 +128,11 @@ void TSDef_DestroyDefErrorList (struct tsdef_def_error_list* error_list)
 
                 break;
 
+            case TSDEF_DEF_ERROR_ASYNC_FUNCTION_IN_EXPRESSION:
+                free(errors->info.data.async_function_in_expression.name);
+
+                break;
+
             default:
                 break;
             }
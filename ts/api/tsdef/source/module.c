@@ -56,6 +56,12 @@ void TSDef_InitializeModule (struct tsdef_module* module)
     }
 
     module->main_unit                  = NULL;
+    module->flags                      = 0;
+    module->deferred_lookup            = NULL;
+    module->deferred_lookup_data       = NULL;
+    module->deferred_errors            = NULL;
+    module->resolve_notify             = NULL;
+    module->resolve_notify_data        = NULL;
     module->registered_ffi_group_count = 0;
     module->referenced_unit_count      = 0;
     module->unresolved_unit_objects    = NULL;
@@ -121,6 +127,9 @@ void TSDef_DestroyModule (struct tsdef_module* module)
             free(free_group);
         }
     }
+
+    if(module->flags&TSDEF_MODULE_FLAG_FREE_LOOKUP_DATA)
+        free(module->deferred_lookup_data);
 }
 
 int TSDef_LookupModuleObject (
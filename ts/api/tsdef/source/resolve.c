@@ -39,6 +39,8 @@ struct resolve_state
     struct tsdef_statement* current_statement;
     unsigned int            current_location;
 
+    struct tsdef_function_call* awaited_call;
+
     struct tsdef_module* module;
 
     tsdef_module_object_lookup module_object_lookup;
@@ -57,6 +59,8 @@ static void HandleError (
                          struct tsdef_def_error_info*
                         );
 
+static struct tsdef_function_call* AwaitedCallOfExp (struct tsdef_exp*);
+
 static int DecideExpValueTypePrimitive (struct resolve_state*, struct tsdef_block*, struct tsdef_exp_value_type*);
 
 static int DecideFunctionCallPrimitive     (struct resolve_state*, struct tsdef_block*, struct tsdef_function_call*, unsigned int);
@@ -85,6 +89,8 @@ static int ResolveInputTypes (
                              );
 static int ResolveOutputType (struct tsdef_unit*, struct resolve_state*);
 
+static int ResolveUnitBody (struct tsdef_module_object*, struct resolve_state*);
+
 
 static void HandleError (
                          int                          def_error,
@@ -174,6 +180,27 @@ append_error_list_failed:
     }
 }
 
+static struct tsdef_function_call* AwaitedCallOfExp (struct tsdef_exp* exp)
+{
+    struct tsdef_primary_exp*    primary_exp;
+    struct tsdef_exp_value_type* exp_value_type;
+
+    if(exp->type != TSDEF_EXP_TYPE_PRIMARY)
+        return NULL;
+
+    primary_exp = exp->data.primary_exp;
+    if(primary_exp->flags&TSDEF_PRIMARY_EXP_FLAG_NEGATE)
+        return NULL;
+    if(primary_exp->start->op != TSDEF_PRIMARY_EXP_OP_VALUE || primary_exp->start->remaining_exp != NULL)
+        return NULL;
+
+    exp_value_type = primary_exp->start->exp_value_type;
+    if(exp_value_type->type != TSDEF_EXP_VALUE_TYPE_FUNCTION_CALL)
+        return NULL;
+
+    return exp_value_type->data.function_call;
+}
+
 static int DecideExpValueTypePrimitive (
                                         struct resolve_state*        state,
                                         struct tsdef_block*          block,
@@ -437,7 +464,11 @@ static int DecideFunctionCallPrimitive (
     }
     else
     {
-        if(type == INVOCABLE_FUNCTION && module_object->type.ffi.function_definition->function == NULL)
+        if(
+           type == INVOCABLE_FUNCTION &&
+           module_object->type.ffi.function_definition->function == NULL &&
+           module_object->type.ffi.function_definition->async_function == NULL
+          )
         {
             struct tsdef_def_error_info info;
 
@@ -463,6 +494,25 @@ static int DecideFunctionCallPrimitive (
 
             HandleError(TSDEF_DEF_ERROR_FUNCTION_NOT_ACTIONABLE, SEVERITY_ERROR, state, &info);
         }
+        else if(
+                type == INVOCABLE_FUNCTION &&
+                module_object->type.ffi.function_definition->async_function != NULL &&
+                function_call != state->awaited_call
+               )
+        {
+            struct tsdef_def_error_info info;
+
+            /* Only a call that is a whole statement or assignment can wait
+               without holding up the module */
+            if(state->error_list != NULL)
+            {
+                info.data.async_function_in_expression.name = strdup(module_object->type.ffi.function_definition->name);
+                if(info.data.async_function_in_expression.name == NULL)
+                    return ABORT_RESOLVE;
+            }
+
+            HandleError(TSDEF_DEF_ERROR_ASYNC_FUNCTION_IN_EXPRESSION, SEVERITY_ERROR, state, &info);
+        }
 
         function_call->module_object = module_object;
 
@@ -765,6 +815,7 @@ static int PerformAssignment (
 {
     struct tsdef_variable_reference* reference;
     struct tsdef_variable*           variable;
+    struct tsdef_function_call*      awaited_call;
     struct tsdef_exp*                exp;
     unsigned int                     exp_primitive_type;
     unsigned int                     variable_type;
@@ -773,7 +824,13 @@ static int PerformAssignment (
     reference = assignment->lvalue;
     exp       = assignment->rvalue;
 
+    awaited_call        = state->awaited_call;
+    state->awaited_call = AwaitedCallOfExp(exp);
+
     error = DecideExpPrimitive(state, block, exp);
+
+    state->awaited_call = awaited_call;
+
     if(error != CONTINUE_RESOLVE)
         return error;
 
@@ -834,7 +891,11 @@ static int ProcessFunctionCall (
                                 struct tsdef_function_call* function_call
                                )
 {
-    int error;
+    struct tsdef_function_call* awaited_call;
+    int                         error;
+
+    awaited_call        = state->awaited_call;
+    state->awaited_call = function_call;
 
     error = DecideFunctionCallPrimitive(
                                         state,
@@ -842,6 +903,9 @@ static int ProcessFunctionCall (
                                         function_call,
                                         INVOCABLE_FUNCTION
                                        );
+
+    state->awaited_call = awaited_call;
+
     if(error == ABORT_RESOLVE)
         return ABORT_RESOLVE;
 
@@ -1237,6 +1301,55 @@ static int ResolveOutputType (struct tsdef_unit* unit, struct resolve_state* sta
     return CONTINUE_RESOLVE;
 }
 
+static int ResolveUnitBody (
+                            struct tsdef_module_object* module_object,
+                            struct resolve_state*       state
+                           )
+{
+    struct tsdef_module* module;
+    int                  error;
+
+    module = state->module;
+
+    if(module->resolve_notify != NULL)
+        module->resolve_notify(TSDEF_RESOLVE_NOTIFY_BEGIN, module_object, module->resolve_notify_data);
+
+    state->current_unit      = module_object->type.unit;
+    state->current_block     = &state->current_unit->global_block;
+    state->current_statement = state->current_unit->global_block.statements;
+
+    error = ProcessStatements(state);
+    if(error != CONTINUE_RESOLVE)
+        goto resolve_failed;
+
+    error = ProcessActions(state);
+    if(error != CONTINUE_RESOLVE)
+        goto resolve_failed;
+
+    if(state->error_count != 0)
+        goto resolve_failed;
+
+    error = TSDef_FreezeUnit(state->current_unit);
+    if(error != TSDEF_ERROR_NONE)
+        goto freeze_unit_failed;
+
+    TSDef_MarkUnitResolved(module_object, module);
+
+    if(module->resolve_notify != NULL)
+        module->resolve_notify(TSDEF_RESOLVE_NOTIFY_END, module_object, module->resolve_notify_data);
+
+    return TSDEF_ERROR_NONE;
+
+resolve_failed:
+    error = TSDEF_ERROR_RESOLVE_ERROR;
+
+freeze_unit_failed:
+    if(module->resolve_notify != NULL)
+        module->resolve_notify(TSDEF_RESOLVE_NOTIFY_END, module_object, module->resolve_notify_data);
+
+    return error;
+}
+
 int TSDef_ResolveUnit (
                        struct tsdef_unit*           unit,
                        struct tsdef_argument_types* arguments,
@@ -1254,6 +1367,7 @@ int TSDef_ResolveUnit (
     state.current_unit         = unit;
     state.current_block        = NULL;
     state.current_statement    = NULL;
+    state.awaited_call         = NULL;
     state.module               = module;
     state.module_object_lookup = module_object_lookup;
     state.lookup_data          = lookup_data;
@@ -1275,31 +1389,79 @@ int TSDef_ResolveUnit (
     if(error == ABORT_RESOLVE)
         return TSDEF_ERROR_RESOLVE_ERROR;
 
+    if(module->flags&TSDEF_MODULE_FLAG_DEFER_RESOLVE)
+    {
+        module->deferred_lookup      = module_object_lookup;
+        module->deferred_lookup_data = lookup_data;
+        module->deferred_errors      = errors;
+    }
+
     while(module_object != NULL)
     {
-        state.current_unit      = module_object->type.unit;
-        state.current_block     = &state.current_unit->global_block;
-        state.current_statement = state.current_unit->global_block.statements;
+        error = ResolveUnitBody(module_object, &state);
+        if(error != TSDEF_ERROR_NONE)
+            return error;
 
-        error = ProcessStatements(&state);
-        if(error != CONTINUE_RESOLVE)
-            return TSDEF_ERROR_RESOLVE_ERROR;
+        if(module->flags&TSDEF_MODULE_FLAG_DEFER_RESOLVE)
+            break;
 
-        error = ProcessActions(&state);
-        if(error != CONTINUE_RESOLVE)
-            return TSDEF_ERROR_RESOLVE_ERROR;
+        module_object = module->unresolved_unit_objects;
+    }
+
+    if(state.warning_count != 0)
+        return TSDEF_ERROR_RESOLVE_WARNING;
+
+    return TSDEF_ERROR_NONE;
+}
 
-        if(state.error_count != 0)
-            return TSDEF_ERROR_RESOLVE_ERROR;
+int TSDef_ResolveDeferredUnit (
+                               struct tsdef_module_object* module_object,
+                               struct tsdef_module*        module
+                              )
+{
+    struct resolve_state   state;
+    struct tsdef_unit      saved_unit;
+    struct tsdef_variable* kept_variables;
+    int                    error;
 
-        TSDef_MarkUnitResolved(module_object, module);
+    if(module_object->flags&TSDEF_MODULE_OBJECT_FLAG_REFERENCED)
+        return TSDEF_ERROR_NONE;
 
-        module_object = module->unresolved_unit_objects;
-    }
+    /* Resolving declares variables and types the body in place, so a copy
+       is kept to put the unit back if resolution fails */
+    error = TSDef_CloneUnitBody(module_object->type.unit, &saved_unit);
+    if(error != TSDEF_ERROR_NONE)
+        return error;
+
+    kept_variables = module_object->type.unit->global_block.variables;
+
+    state.current_unit         = module_object->type.unit;
+    state.current_block        = NULL;
+    state.current_statement    = NULL;
+    state.current_location     = 0;
+    state.awaited_call         = NULL;
+    state.module               = module;
+    state.module_object_lookup = module->deferred_lookup;
+    state.lookup_data          = module->deferred_lookup_data;
+    state.error_list           = module->deferred_errors;
+    state.error_count          = 0;
+    state.warning_count        = 0;
+
+    error = ResolveUnitBody(module_object, &state);
+    if(error != TSDEF_ERROR_NONE)
+        goto resolve_unit_body_failed;
+
+    TSDef_DestroyUnitBody(&saved_unit);
 
     if(state.warning_count != 0)
         return TSDEF_ERROR_RESOLVE_WARNING;
 
     return TSDEF_ERROR_NONE;
+
+resolve_unit_body_failed:
+    TSDef_RestoreUnitBody(module_object->type.unit, &saved_unit, kept_variables);
+    TSDef_DestroyUnitBody(&saved_unit);
+
+    return error;
 }
 
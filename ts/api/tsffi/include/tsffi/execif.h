@@ -17,7 +17,71 @@
 #define TSFFI_ALERT_WARNING 1
 #define TSFFI_ALERT_ERROR   2
 
+#define TSFFI_TIMER_ONCE     0
+#define TSFFI_TIMER_PERIODIC 1
 
+#define TSFFI_CLOCK_REAL    0
+#define TSFFI_CLOCK_VIRTUAL 1
+
+
+/* A waitable object the interpreter can sleep on: a HANDLE on Windows,
+   a file descriptor elsewhere */
+#ifdef _WIN32
+    typedef void* tsffi_wait_handle;
+#else
+    typedef int tsffi_wait_handle;
+#endif
+
+typedef void (*tsffi_reactor_callback) (void*);
+typedef void (*tsffi_suspend_cancel)   (void*);
+
+struct tsffi_invocation_data;
+union  tsffi_value;
+
+/* The reactor entries (watch_handle, start_timer, cancel_registration)
+   attach a callback to the interpreter's own wait.  They may only be used
+   from the module thread, that is from action controllers, group
+   begin/state/end functions, and reactor callbacks.  Callbacks also run on
+   the module thread and typically call signal_action.  A one-shot timer
+   stays registered after it fires until it is cancelled or the module
+   ends.
+
+   suspend_unit lets a function called as a statement park the calling
+   unit instance instead of blocking; other actions keep running until
+   resume_unit is called with the returned token, from any thread.  It
+   returns NULL when the call site can't be suspended (the call is part
+   of an expression or the unit is being stepped), in which case the
+   function must complete synchronously.  If the unit is stopped before it
+   is resumed the cancel callback runs on the interpreter's thread and the
+   token must not be used afterwards.
+
+   An async_function starts its operation and returns; the token it is
+   handed is passed to complete_function exactly once, from any thread,
+   with the error and output the function would otherwise have returned.
+   A string output must come from allocate_memory.  If the function
+   returns an error it must not complete the token.  The call must be the
+   whole of a statement or assignment, anywhere else in an expression it
+   is rejected when the unit is resolved.  Only the calling unit instance
+   waits for it, unless that instance can't be suspended; then the module
+   thread waits while still running reactor callbacks, and a dispatch
+   worker blocks until the call is completed from another thread.
+
+   An action controller whose definition has TSFFI_FUNCTION_FLAG_PUSH_STATE
+   is never sent TSFFI_QUERY_ACTION.  It reports each change of its trigger
+   state with signal_action_state instead of signal_action, passing the
+   user data slot it was handed at TSFFI_INIT_ACTION to name the trigger.
+   Every trigger starts out pending.
+
+   signal_actions signals several actions with a single wakeup of the
+   interpreter.  Each entry is the execif_data an action was handed; the
+   actions may belong to different units and modules.
+
+   read_clock reports the millisecond clock reactor timers run on and
+   returns TSFFI_CLOCK_VIRTUAL when the module runs in virtual time.  A
+   virtual clock starts at zero and only moves when the module has nothing
+   signaled or ready and would wait for a timer, so plugins that keep time of their own must switch to
+   reactor timers and this clock while it is virtual.  It may be used from
+   the module thread and from the dispatch workers running its actions. */
 struct tsffi_execif
 {
     void (*signal_action) (void*);
@@ -27,6 +91,20 @@ struct tsffi_execif
 
     void* (*allocate_memory) (void*, size_t);
     void  (*free_memory)     (void*, void*);
+
+    void* (*watch_handle)        (void*, tsffi_wait_handle, tsffi_reactor_callback, void*);
+    void* (*start_timer)         (void*, unsigned int, unsigned int, tsffi_reactor_callback, void*);
+    void  (*cancel_registration) (void*, void*);
+
+    void* (*suspend_unit) (struct tsffi_invocation_data*, tsffi_suspend_cancel, void*);
+    void  (*resume_unit)  (void*, void*);
+
+    void (*complete_function) (void*, void*, int, union tsffi_value*);
+
+    void (*signal_action_state) (void*, void**, unsigned int);
+    void (*signal_actions)      (void*, void**, unsigned int);
+
+    int (*read_clock) (void*, unsigned int*);
 };
 
 
@@ -47,6 +47,8 @@ struct tsffi_invocation_data
 
     char*        unit_name;
     unsigned int unit_location;
+
+    void* suspend_data;
 };
 
 
@@ -57,6 +59,13 @@ typedef int (*tsffi_function) (
                                union tsffi_value*
                               );
 
+typedef int (*tsffi_async_function) (
+                                     struct tsffi_invocation_data*,
+                                     void*,
+                                     void*,
+                                     union tsffi_value*
+                                    );
+
 typedef int (*tsffi_action_controller) (
                                         struct tsffi_invocation_data*,
                                         unsigned int,
@@ -20,6 +20,10 @@
 #define TSFFI_MODULE_SLEEPING 0
 #define TSFFI_MODULE_RUNNING  1
 
+#define TSFFI_GROUP_FLAG_THREAD_SAFE 0x01
+
+#define TSFFI_FUNCTION_FLAG_PUSH_STATE 0x01
+
 
 struct tsffi_registration_group;
 
@@ -57,6 +61,9 @@ struct tsffi_function_definition
     unsigned int            output_type;
     unsigned int            argument_count;
     unsigned int            argument_types[TSFFI_MAX_INPUT_ARGUMENTS];
+
+    tsffi_async_function async_function;
+    unsigned int         flags;
 };
 
 struct tsffi_registration_group
@@ -69,6 +76,8 @@ struct tsffi_registration_group
     tsffi_end_module   end_function;
 
     void* user_data;
+
+    unsigned int flags;
 };
 
 
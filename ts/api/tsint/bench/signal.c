@@ -0,0 +1,212 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+/* Measures how long a module thread parked in TSInt_ListenForAction
+   takes to wake once another thread calls TSInt_SignalAction, and the
+   same handoff through a plain mutex and condition variable as a
+   baseline.  Prints the p50 and p99 of each. */
+
+#include "sync.h"
+
+#include <tsint/error.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+
+#define SAMPLE_COUNT     20000
+#define SIGNAL_DELAY_NS  20000
+
+
+struct signal_bench
+{
+    struct tsint_module_sync_data sync_data;
+    tsint_semaphore               ready_signal;
+
+    pthread_mutex_t condition_sync;
+    pthread_cond_t  condition;
+    int             condition_set;
+
+    volatile long long sent_time;
+    long long*         samples;
+    unsigned int       sample_count;
+};
+
+
+static long long ReadTime       (void);
+static void      Delay          (void);
+static int       CompareSamples (const void*, const void*);
+static void      Report         (char*, long long*, unsigned int);
+static void      SignalSync     (void*);
+static void      SignalCondition(void*);
+
+
+static long long ReadTime (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (long long)now.tv_sec*1000000000LL+now.tv_nsec;
+}
+
+static void Delay (void)
+{
+    struct timespec delay;
+
+    /* Give the listener time to park so the wakeup path is measured */
+    delay.tv_sec  = 0;
+    delay.tv_nsec = SIGNAL_DELAY_NS;
+
+    nanosleep(&delay, NULL);
+}
+
+static int CompareSamples (const void* first, const void* second)
+{
+    long long first_sample;
+    long long second_sample;
+
+    first_sample  = *(const long long*)first;
+    second_sample = *(const long long*)second;
+
+    return (first_sample > second_sample)-(first_sample < second_sample);
+}
+
+static void Report (char* name, long long* samples, unsigned int sample_count)
+{
+    qsort(samples, sample_count, sizeof(long long), &CompareSamples);
+
+    printf(
+           "%-10s p50 %8.2f us  p99 %8.2f us\n",
+           name,
+           samples[sample_count/2]/1000.0,
+           samples[sample_count*99/100]/1000.0
+          );
+}
+
+static void SignalSync (void* user_data)
+{
+    struct signal_bench* bench;
+    unsigned int         index;
+
+    bench = user_data;
+
+    for(index = 0; index < bench->sample_count; index++)
+    {
+        TSInt_WaitSemaphore(&bench->ready_signal);
+
+        Delay();
+
+        bench->sent_time = ReadTime();
+
+        TSInt_SignalAction(&bench->sync_data);
+    }
+}
+
+static void SignalCondition (void* user_data)
+{
+    struct signal_bench* bench;
+    unsigned int         index;
+
+    bench = user_data;
+
+    for(index = 0; index < bench->sample_count; index++)
+    {
+        TSInt_WaitSemaphore(&bench->ready_signal);
+
+        Delay();
+
+        pthread_mutex_lock(&bench->condition_sync);
+
+        bench->sent_time     = ReadTime();
+        bench->condition_set = 1;
+
+        pthread_cond_signal(&bench->condition);
+        pthread_mutex_unlock(&bench->condition_sync);
+    }
+}
+
+
+int main (int argc, char** argv)
+{
+    struct signal_bench bench;
+    tsint_thread        thread;
+    unsigned int        index;
+    int                 error;
+
+    bench.sample_count = SAMPLE_COUNT;
+    bench.samples      = malloc(sizeof(long long)*SAMPLE_COUNT);
+    if(bench.samples == NULL)
+        return 1;
+
+    error = TSInt_InitializeSyncData(&bench.sync_data, NULL);
+    if(error != TSINT_ERROR_NONE)
+        return 1;
+
+    error = TSInt_InitializeSemaphore(&bench.ready_signal);
+    if(error != TSINT_ERROR_NONE)
+        return 1;
+
+    error = TSInt_StartThread(&SignalSync, &bench, &thread);
+    if(error != TSINT_ERROR_NONE)
+        return 1;
+
+    for(index = 0; index < SAMPLE_COUNT; index++)
+    {
+        TSInt_PostSemaphore(&bench.ready_signal, 1);
+        TSInt_ListenForAction(&bench.sync_data, 0);
+
+        bench.samples[index] = ReadTime()-bench.sent_time;
+
+        TSInt_ClearSignal(&bench.sync_data);
+    }
+
+    TSInt_JoinThread(thread);
+
+    Report("sync", bench.samples, SAMPLE_COUNT);
+
+    pthread_mutex_init(&bench.condition_sync, NULL);
+    pthread_cond_init(&bench.condition, NULL);
+
+    bench.condition_set = 0;
+
+    error = TSInt_StartThread(&SignalCondition, &bench, &thread);
+    if(error != TSINT_ERROR_NONE)
+        return 1;
+
+    for(index = 0; index < SAMPLE_COUNT; index++)
+    {
+        TSInt_PostSemaphore(&bench.ready_signal, 1);
+
+        pthread_mutex_lock(&bench.condition_sync);
+
+        while(!bench.condition_set)
+            pthread_cond_wait(&bench.condition, &bench.condition_sync);
+
+        bench.samples[index] = ReadTime()-bench.sent_time;
+        bench.condition_set  = 0;
+
+        pthread_mutex_unlock(&bench.condition_sync);
+    }
+
+    TSInt_JoinThread(thread);
+
+    Report("condvar", bench.samples, SAMPLE_COUNT);
+
+    pthread_cond_destroy(&bench.condition);
+    pthread_mutex_destroy(&bench.condition_sync);
+
+    TSInt_DestroySemaphore(&bench.ready_signal);
+    TSInt_DestroySyncData(&bench.sync_data);
+
+    free(bench.samples);
+
+    return 0;
+}
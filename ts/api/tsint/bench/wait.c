@@ -0,0 +1,217 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+/* Measures the signal to wake latency of each module wait policy.  The
+   listener follows the same loop as WaitForAction in module.c: block
+   parks in TSInt_ListenForAction, spin busy waits on the queued flag for
+   up to the spin budget with a zero timeout sweep every WAIT_POLL_INTERVAL
+   iterations before parking, and poll never parks.  Prints the p50 and
+   p99 of each. */
+
+#include "sync.h"
+
+#include <tsint/error.h>
+#include <tsint/exception.h>
+#include <tsint/module.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+
+#define SAMPLE_COUNT       20000
+#define SIGNAL_DELAY_NS    20000
+#define WAIT_POLL_INTERVAL 64
+#define SPIN_TIME          1
+
+
+struct wait_bench
+{
+    struct tsint_module_sync_data sync_data;
+    tsint_semaphore               ready_signal;
+
+    volatile long               queued;
+    volatile unsigned long long sent_time;
+    unsigned long long*         samples;
+    unsigned int                sample_count;
+};
+
+
+static void Delay          (void);
+static int  CompareSamples (const void*, const void*);
+static void Report         (char*, unsigned long long*, unsigned int);
+static int  Wait           (struct wait_bench*, unsigned int);
+static void Signal         (void*);
+static int  Measure        (struct wait_bench*, char*, unsigned int);
+
+
+static void Delay (void)
+{
+    struct timespec delay;
+
+    /* Give the listener time to settle into its wait */
+    delay.tv_sec  = 0;
+    delay.tv_nsec = SIGNAL_DELAY_NS;
+
+    nanosleep(&delay, NULL);
+}
+
+static int CompareSamples (const void* first, const void* second)
+{
+    unsigned long long first_sample;
+    unsigned long long second_sample;
+
+    first_sample  = *(const unsigned long long*)first;
+    second_sample = *(const unsigned long long*)second;
+
+    return (first_sample > second_sample)-(first_sample < second_sample);
+}
+
+static void Report (char* name, unsigned long long* samples, unsigned int sample_count)
+{
+    qsort(samples, sample_count, sizeof(unsigned long long), &CompareSamples);
+
+    printf(
+           "%-10s p50 %8llu us  p99 %8llu us\n",
+           name,
+           samples[sample_count/2],
+           samples[sample_count*99/100]
+          );
+}
+
+static int Wait (struct wait_bench* bench, unsigned int mode)
+{
+    if(mode == TSINT_WAIT_SPIN || mode == TSINT_WAIT_POLL)
+    {
+        unsigned long long start_time;
+        unsigned int       spin_count;
+
+        start_time = TSInt_ReadPreciseClock();
+        spin_count = 0;
+
+        while(!bench->queued)
+        {
+            int exception;
+
+            TSInt_PauseProcessor();
+
+            spin_count++;
+            if(spin_count%WAIT_POLL_INTERVAL != 0)
+                continue;
+
+            exception = TSInt_PollForAction(&bench->sync_data);
+            if(exception != TSINT_EXCEPTION_NONE)
+                return exception;
+
+            if(
+               mode == TSINT_WAIT_SPIN &&
+               TSInt_ReadPreciseClock()-start_time >= SPIN_TIME*1000ULL
+              )
+            {
+                break;
+            }
+        }
+
+        if(bench->queued)
+            return TSInt_PollForAction(&bench->sync_data);
+    }
+
+    return TSInt_ListenForAction(&bench->sync_data, 0);
+}
+
+static void Signal (void* user_data)
+{
+    struct wait_bench* bench;
+    unsigned int       index;
+
+    bench = user_data;
+
+    for(index = 0; index < bench->sample_count; index++)
+    {
+        TSInt_WaitSemaphore(&bench->ready_signal);
+
+        Delay();
+
+        bench->sent_time = TSInt_ReadPreciseClock();
+
+        TSInt_AtomicExchange(&bench->queued, 1);
+        TSInt_SignalAction(&bench->sync_data);
+    }
+}
+
+static int Measure (struct wait_bench* bench, char* name, unsigned int mode)
+{
+    tsint_thread thread;
+    unsigned int index;
+    int          error;
+
+    bench->queued = 0;
+
+    error = TSInt_StartThread(&Signal, bench, &thread);
+    if(error != TSINT_ERROR_NONE)
+        return error;
+
+    for(index = 0; index < bench->sample_count; index++)
+    {
+        TSInt_PostSemaphore(&bench->ready_signal, 1);
+
+        error = Wait(bench, mode);
+        if(error != TSINT_EXCEPTION_NONE)
+            break;
+
+        bench->samples[index] = TSInt_ReadPreciseClock()-bench->sent_time;
+
+        TSInt_AtomicExchange(&bench->queued, 0);
+        TSInt_ClearSignal(&bench->sync_data);
+    }
+
+    TSInt_JoinThread(thread);
+
+    if(error != TSINT_EXCEPTION_NONE)
+        return error;
+
+    Report(name, bench->samples, bench->sample_count);
+
+    return TSINT_ERROR_NONE;
+}
+
+
+int main (int argc, char** argv)
+{
+    struct wait_bench bench;
+    int               error;
+
+    bench.sample_count = SAMPLE_COUNT;
+    bench.samples      = malloc(sizeof(unsigned long long)*SAMPLE_COUNT);
+    if(bench.samples == NULL)
+        return 1;
+
+    error = TSInt_InitializeSyncData(&bench.sync_data, NULL);
+    if(error != TSINT_ERROR_NONE)
+        return 1;
+
+    error = TSInt_InitializeSemaphore(&bench.ready_signal);
+    if(error != TSINT_ERROR_NONE)
+        return 1;
+
+    if(Measure(&bench, "block", TSINT_WAIT_BLOCK) != TSINT_ERROR_NONE)
+        return 1;
+
+    if(Measure(&bench, "spin", TSINT_WAIT_SPIN) != TSINT_ERROR_NONE)
+        return 1;
+
+    if(Measure(&bench, "poll", TSINT_WAIT_POLL) != TSINT_ERROR_NONE)
+        return 1;
+
+    TSInt_DestroySemaphore(&bench.ready_signal);
+    TSInt_DestroySyncData(&bench.sync_data);
+
+    free(bench.samples);
+
+    return 0;
+}
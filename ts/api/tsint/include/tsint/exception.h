@@ -15,6 +15,8 @@
 #define TSINT_EXCEPTION_DIVIDE_BY_ZERO -2
 #define TSINT_EXCEPTION_FFI            -3
 #define TSINT_EXCEPTION_HALT           -4
+#define TSINT_EXCEPTION_RESOLVE        -5
+#define TSINT_EXCEPTION_WAIT           -6
 
 
 #endif
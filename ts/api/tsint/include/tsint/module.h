@@ -19,11 +19,43 @@
 #include <tsffi/execif.h>
 
 
-#define TSINT_ACTION_STATE_FLAG_SIGNALED 0x01
-#define TSINT_ACTION_STATE_FLAG_FINISHED 0x02
-
-#define TSINT_UNIT_STATE_FLAG_FINISH 0x01
-
+#define TSINT_ACTION_STATE_FLAG_SIGNALED  0x01
+#define TSINT_ACTION_STATE_FLAG_FINISHED  0x02
+#define TSINT_ACTION_STATE_FLAG_COLLECTED 0x04
+
+/* Once an action leaves idle its push onto the signal queue may still be
+   in flight, so only the module's drain of the queue takes it back off.  A
+   discarded action stays queued and is dropped by that drain */
+#define TSINT_ACTION_SIGNAL_IDLE      0
+#define TSINT_ACTION_SIGNAL_QUEUED    1
+#define TSINT_ACTION_SIGNAL_FINISHED  2
+#define TSINT_ACTION_SIGNAL_DISCARDED 3
+
+#define TSINT_UNIT_STATE_FLAG_FINISH      0x01
+#define TSINT_UNIT_STATE_FLAG_STOPPED     0x02
+#define TSINT_UNIT_STATE_FLAG_INITIALIZED 0x04
+#define TSINT_UNIT_STATE_FLAG_SUSPENDABLE 0x08
+#define TSINT_UNIT_STATE_FLAG_SUSPENDED   0x10
+
+#define TSINT_WAIT_BLOCK        0
+#define TSINT_WAIT_SPIN         1
+#define TSINT_WAIT_POLL         2
+#define TSINT_WAIT_VIRTUAL_TIME 3
+
+
+struct tsint_async_call;
+
+/* Selects how the interpreter waits for a signaled action.  Blocking
+   sleeps in the kernel right away, spinning checks the signal queue for
+   up to spin_time milliseconds before it sleeps, and polling never sleeps.
+   Virtual time blocks like the default, but timers run on a clock that
+   starts at zero and jumps to the next deadline whenever the module would
+   wait for it */
+struct tsint_wait_policy
+{
+    unsigned int mode;
+    unsigned int spin_time;
+};
 
 struct tsint_execution_stack
 {
@@ -51,11 +83,19 @@ struct tsint_action_state
     struct tsdef_action*     action;
     struct tsint_unit_state* unit_state;
 
-    unsigned int flags;
+    unsigned int  flags;
+    volatile long signal_state;
 
     struct tsffi_invocation_data invocation_data;
     void**                       trigger_user_data;
+    volatile long*               trigger_states;
+
+    unsigned int  query_count;
+    volatile long triggered_count;
+    volatile long finished_count;
 
+    struct tsint_action_state* next_queued_action;
+    struct tsint_action_state* next_dispatched_action;
     struct tsint_action_state* next_action;
     struct tsint_action_state* previous_action;
 };
@@ -85,6 +125,19 @@ struct tsint_unit_state
     struct tsint_unit_state* next_active_unit;
     struct tsint_unit_state* previous_active_unit;
 
+    struct tsint_action_state* dispatched_actions;
+    struct tsint_action_state* last_dispatched_action;
+    struct tsint_unit_state*   next_retired_unit;
+
+    struct tsdef_statement*    resume_statement;
+    struct tsint_action_state* suspended_action;
+    struct tsint_unit_state*   calling_unit;
+    struct tsint_action_state* deferred_actions;
+    tsffi_suspend_cancel       suspend_cancel;
+    void*                      suspend_cancel_data;
+    struct tsint_async_call*   async_call;
+    struct tsint_action_state  resume_state;
+
     void**                    trigger_user_data;
     struct tsint_action_state action_state[];
 };
@@ -97,15 +150,17 @@ struct tsint_module_state
     struct tsffi_execif*              module_execif;
 
     struct tsint_module_sync_data* sync_data;
+    struct tsint_dispatch_pool*    dispatch_pool;
 
     unsigned int next_unit_id;
 
-    void** ffi_group_data;
+    void**                         ffi_group_data;
+    struct tsdef_module_ffi_group* started_ffi_groups;
 
     struct tsint_unit_state* active_units;
 
-    struct tsint_action_state* pending_actions;
-    struct tsint_action_state* signaled_actions;
+    struct tsint_action_state* volatile signal_queue;
+    struct tsint_action_state*          signaled_actions;
 };
 
 struct tsint_module_abort_signal;
@@ -123,7 +178,9 @@ extern int TSInt_InterpretModule (
                                   union tsint_value*,
                                   struct tsint_controller_data*,
                                   struct tsint_execif_data*,
-                                  struct tsint_module_abort_signal*
+                                  struct tsint_module_abort_signal*,
+                                  unsigned int,
+                                  struct tsint_wait_policy*
                                  );
 
 
@@ -8,6 +8,7 @@
 
 #include "action.h"
 #include "sync.h"
+#include "dispatch.h"
 #include "ffi.h"
 
 #include <tsint/error.h>
@@ -22,15 +23,55 @@ static void  SetExceptionText (void*, char*);
 static void* AllocateMemory   (void*, size_t);
 static void  FreeMemory       (void*, void*);
 
-static void AddToPending  (struct tsint_action_state*, struct tsint_module_state*);
-static void MoveToPending (struct tsint_action_state*, struct tsint_module_state*);
-static void RemoveFromAll (struct tsint_action_state*, struct tsint_module_state*);
-
-
-static struct tsffi_execif tsint_action_execif = {&SignalAction, &Alert, &SetExceptionText, &AllocateMemory, &FreeMemory};
+static void* WatchHandle        (void*, tsffi_wait_handle, tsffi_reactor_callback, void*);
+static void* StartTimer         (void*, unsigned int, unsigned int, tsffi_reactor_callback, void*);
+static void  CancelRegistration (void*, void*);
+
+static void* SuspendUnit (struct tsffi_invocation_data*, tsffi_suspend_cancel, void*);
+static void  ResumeUnit  (void*, void*);
+
+static void CompleteFunction (void*, void*, int, union tsffi_value*);
+
+static void SignalActionState (void*, void**, unsigned int);
+static void SignalActions     (void*, void**, unsigned int);
+static int  ReadClock         (void*, unsigned int*);
+
+static void PushSignalChain (
+                             struct tsint_action_state*,
+                             struct tsint_action_state*,
+                             struct tsint_module_state*
+                            );
+static int  ClaimSignal    (struct tsint_action_state*);
+static void PushSignal     (struct tsint_action_state*, struct tsint_module_state*);
+static void UnlinkSignaled (struct tsint_action_state*, struct tsint_module_state*);
+static void ResetSignal    (struct tsint_action_state*);
+static void DiscardSignal  (struct tsint_action_state*, struct tsint_module_state*);
+
+
+static struct tsffi_execif tsint_action_execif = {
+                                                  &SignalAction,
+                                                  &Alert,
+                                                  &SetExceptionText,
+                                                  &AllocateMemory,
+                                                  &FreeMemory,
+                                                  &WatchHandle,
+                                                  &StartTimer,
+                                                  &CancelRegistration,
+                                                  &SuspendUnit,
+                                                  &ResumeUnit,
+                                                  &CompleteFunction,
+                                                  &SignalActionState,
+                                                  &SignalActions,
+                                                  &ReadClock
+                                                 };
 
 
 static void  SignalAction (void* user_data)
+{
+    TSInt_QueueAction(user_data);
+}
+
+static void Alert (void* user_data, unsigned int alert_severity, char* text)
 {
     struct tsint_action_state* action_state;
     struct tsint_module_state* module_state;
@@ -38,36 +79,32 @@ static void  SignalAction (void* user_data)
     action_state = user_data;
     module_state = action_state->unit_state->module_state;
 
-    TSInt_LockActionStateSync(module_state->sync_data);
+    module_state->module_execif->alert(module_state, alert_severity, text);
+}
 
-    if(
-       !(action_state->flags&TSINT_ACTION_STATE_FLAG_SIGNALED) &&
-       !(action_state->flags&TSINT_ACTION_STATE_FLAG_FINISHED)
-      )
-    {
-        action_state->flags |= TSINT_ACTION_STATE_FLAG_SIGNALED;
+static void SetExceptionText (void* user_data, char* text)
+{
+    struct tsint_action_state* action_state;
+    struct tsint_module_state* module_state;
 
-        if(action_state->next_action != NULL)
-            action_state->next_action->previous_action = action_state->previous_action;
-        if(action_state->previous_action != NULL)
-            action_state->previous_action->next_action = action_state->next_action;
-        else
-            module_state->pending_actions = action_state->next_action;
+    action_state = user_data;
+    module_state = action_state->unit_state->module_state;
 
-        action_state->previous_action  = NULL;
-        action_state->next_action      = module_state->signaled_actions;
-        module_state->signaled_actions = action_state;
+    module_state->module_execif->set_exception_text(module_state, text);
+}
 
-        if(action_state->next_action != NULL)
-           action_state->next_action->previous_action = action_state;
+static void* AllocateMemory (void* user_data, size_t size)
+{
+    struct tsint_action_state* action_state;
+    struct tsint_module_state* module_state;
 
-        TSInt_SignalAction(module_state->sync_data);
-    }
+    action_state = user_data;
+    module_state = action_state->unit_state->module_state;
 
-    TSInt_UnlockActionStateSync(module_state->sync_data);
+    return module_state->module_execif->allocate_memory(module_state, size);
 }
 
-static void Alert (void* user_data, unsigned int alert_severity, char* text)
+static void FreeMemory (void* user_data, void* memory)
 {
     struct tsint_action_state* action_state;
     struct tsint_module_state* module_state;
@@ -75,10 +112,15 @@ static void Alert (void* user_data, unsigned int alert_severity, char* text)
     action_state = user_data;
     module_state = action_state->unit_state->module_state;
 
-    module_state->module_execif->alert(module_state, alert_severity, text);
+    module_state->module_execif->free_memory(module_state, memory);
 }
 
-static void SetExceptionText (void* user_data, char* text)
+static void* WatchHandle (
+                          void*                  user_data,
+                          tsffi_wait_handle      handle,
+                          tsffi_reactor_callback callback,
+                          void*                  callback_data
+                         )
 {
     struct tsint_action_state* action_state;
     struct tsint_module_state* module_state;
@@ -86,10 +128,16 @@ static void SetExceptionText (void* user_data, char* text)
     action_state = user_data;
     module_state = action_state->unit_state->module_state;
 
-    module_state->module_execif->set_exception_text(module_state, text);
+    return module_state->module_execif->watch_handle(module_state, handle, callback, callback_data);
 }
 
-static void* AllocateMemory (void* user_data, size_t size)
+static void* StartTimer (
+                         void*                  user_data,
+                         unsigned int           milliseconds,
+                         unsigned int           timer_flags,
+                         tsffi_reactor_callback callback,
+                         void*                  callback_data
+                        )
 {
     struct tsint_action_state* action_state;
     struct tsint_module_state* module_state;
@@ -97,10 +145,16 @@ static void* AllocateMemory (void* user_data, size_t size)
     action_state = user_data;
     module_state = action_state->unit_state->module_state;
 
-    return module_state->module_execif->allocate_memory(module_state, size);
+    return module_state->module_execif->start_timer(
+                                                    module_state,
+                                                    milliseconds,
+                                                    timer_flags,
+                                                    callback,
+                                                    callback_data
+                                                   );
 }
 
-static void FreeMemory (void* user_data, void* memory)
+static void CancelRegistration (void* user_data, void* registration)
 {
     struct tsint_action_state* action_state;
     struct tsint_module_state* module_state;
@@ -108,84 +162,222 @@ static void FreeMemory (void* user_data, void* memory)
     action_state = user_data;
     module_state = action_state->unit_state->module_state;
 
-    module_state->module_execif->free_memory(module_state, memory);
+    module_state->module_execif->cancel_registration(module_state, registration);
 }
 
-static void AddToPending (
-                          struct tsint_action_state* action_state,
-                          struct tsint_module_state* module_state
+static void* SuspendUnit (
+                          struct tsffi_invocation_data* invocation_data,
+                          tsffi_suspend_cancel          cancel,
+                          void*                         cancel_data
                          )
 {
-    TSInt_LockActionStateSync(module_state->sync_data);
+    struct tsint_action_state* action_state;
+    struct tsint_module_state* module_state;
 
-    action_state->flags &= ~TSINT_ACTION_STATE_FLAG_SIGNALED;
+    action_state = invocation_data->execif_data;
+    module_state = action_state->unit_state->module_state;
 
-    action_state->next_action     = module_state->pending_actions;
-    module_state->pending_actions = action_state;
-    action_state->previous_action = NULL;
+    return module_state->module_execif->suspend_unit(invocation_data, cancel, cancel_data);
+}
 
-    if(action_state->next_action != NULL)
-       action_state->next_action->previous_action = action_state;
+static void ResumeUnit (void* user_data, void* resume_token)
+{
+    struct tsint_action_state* action_state;
+    struct tsint_module_state* module_state;
 
-    TSInt_UnlockActionStateSync(module_state->sync_data);
+    action_state = user_data;
+    module_state = action_state->unit_state->module_state;
+
+    module_state->module_execif->resume_unit(module_state, resume_token);
 }
 
-static void MoveToPending (
-                           struct tsint_action_state* action_state,
-                           struct tsint_module_state* module_state
-                          )
+static void CompleteFunction (
+                              void*              user_data,
+                              void*              completion_token,
+                              int                error,
+                              union tsffi_value* output
+                             )
+{
+    struct tsint_action_state* action_state;
+    struct tsint_module_state* module_state;
+
+    action_state = user_data;
+    module_state = action_state->unit_state->module_state;
+
+    module_state->module_execif->complete_function(module_state, completion_token, error, output);
+}
+
+static void SignalActionState (void* user_data, void** trigger_data, unsigned int state)
+{
+    struct tsint_action_state* action_state;
+    unsigned int               trigger_index;
+    long                       previous_state;
+
+    action_state  = user_data;
+    trigger_index = (unsigned int)(trigger_data-action_state->trigger_user_data);
+
+    if(trigger_index >= action_state->action->trigger_list->count)
+        return;
+
+    /* Counters only ever move with the exchange below, so evaluation can
+       read them without asking each trigger */
+    previous_state = TSInt_AtomicExchange(&action_state->trigger_states[trigger_index], state);
+    if(previous_state != (long)state)
+    {
+        if(previous_state == TSFFI_ACTION_STATE_TRIGGERED)
+            TSInt_AtomicAdd(&action_state->triggered_count, -1);
+        else if(previous_state == TSFFI_ACTION_STATE_FINISHED)
+            TSInt_AtomicAdd(&action_state->finished_count, -1);
+
+        if(state == TSFFI_ACTION_STATE_TRIGGERED)
+            TSInt_AtomicAdd(&action_state->triggered_count, 1);
+        else if(state == TSFFI_ACTION_STATE_FINISHED)
+            TSInt_AtomicAdd(&action_state->finished_count, 1);
+    }
+
+    /* A trigger going back to pending can neither run nor finish the
+       action, so only the counters need to see it */
+    if(state != TSFFI_ACTION_STATE_TRIGGERED && state != TSFFI_ACTION_STATE_FINISHED)
+        return;
+
+    TSInt_QueueAction(action_state);
+}
+
+static void SignalActions (void* user_data, void** action_data, unsigned int action_count)
+{
+    TSInt_QueueActions((struct tsint_action_state**)action_data, action_count);
+}
+
+static int ReadClock (void* user_data, unsigned int* clock)
 {
-    TSInt_LockActionStateSync(module_state->sync_data);
+    struct tsint_action_state* action_state;
+    struct tsint_module_state* module_state;
+
+    action_state = user_data;
+    module_state = action_state->unit_state->module_state;
+
+    return module_state->module_execif->read_clock(module_state, clock);
+}
+
+static void PushSignalChain (
+                             struct tsint_action_state* first_action,
+                             struct tsint_action_state* last_action,
+                             struct tsint_module_state* module_state
+                            )
+{
+    struct tsint_action_state* queue_head;
+    void*                      exchanged_head;
+
+    do
+    {
+        queue_head = module_state->signal_queue;
+
+        last_action->next_queued_action = queue_head;
+
+        exchanged_head = TSInt_AtomicCompareExchangePointer(
+                                                            (void* volatile*)&module_state->signal_queue,
+                                                            first_action,
+                                                            queue_head
+                                                           );
+    }while(exchanged_head != queue_head);
+
+    /* Only the push onto an empty queue needs to wake the module, any
+       later push is picked up by the same drain */
+    if(queue_head == NULL)
+        TSInt_SignalAction(module_state->sync_data);
+}
+
+static int ClaimSignal (struct tsint_action_state* action_state)
+{
+    long previous_state;
+
+    /* A discarded action is still on its way through the queue, so it is
+       only marked queued again rather than pushed a second time */
+    while(1)
+    {
+        previous_state = TSInt_AtomicCompareExchange(
+                                                     &action_state->signal_state,
+                                                     TSINT_ACTION_SIGNAL_QUEUED,
+                                                     TSINT_ACTION_SIGNAL_IDLE
+                                                    );
+        if(previous_state == TSINT_ACTION_SIGNAL_IDLE)
+            return 1;
+        if(previous_state != TSINT_ACTION_SIGNAL_DISCARDED)
+            return 0;
+
+        previous_state = TSInt_AtomicCompareExchange(
+                                                     &action_state->signal_state,
+                                                     TSINT_ACTION_SIGNAL_QUEUED,
+                                                     TSINT_ACTION_SIGNAL_DISCARDED
+                                                    );
+        if(previous_state == TSINT_ACTION_SIGNAL_DISCARDED)
+            return 0;
+    }
+}
+
+static void PushSignal (
+                        struct tsint_action_state* action_state,
+                        struct tsint_module_state* module_state
+                       )
+{
+    PushSignalChain(action_state, action_state, module_state);
+}
+
+static void UnlinkSignaled (
+                            struct tsint_action_state* action_state,
+                            struct tsint_module_state* module_state
+                           )
+{
+    if(!(action_state->flags&TSINT_ACTION_STATE_FLAG_SIGNALED))
+        return;
 
     if(action_state->next_action != NULL)
         action_state->next_action->previous_action = action_state->previous_action;
     if(action_state->previous_action != NULL)
         action_state->previous_action->next_action = action_state->next_action;
     else
-    {
-        if(action_state->flags&TSINT_ACTION_STATE_FLAG_SIGNALED)
-            module_state->signaled_actions = action_state->next_action;
-        else
-            module_state->pending_actions = action_state->next_action;
-    }
+        module_state->signaled_actions = action_state->next_action;
 
+    action_state->next_action     = NULL;
     action_state->previous_action = NULL;
-    action_state->next_action     = module_state->pending_actions;
-    module_state->pending_actions = action_state;
-
-    if(action_state->next_action != NULL)
-       action_state->next_action->previous_action = action_state;
 
     action_state->flags &= ~TSINT_ACTION_STATE_FLAG_SIGNALED;
+}
+
+static void ResetSignal (struct tsint_action_state* action_state)
+{
+    action_state->flags &= ~TSINT_ACTION_STATE_FLAG_COLLECTED;
 
-    TSInt_UnlockActionStateSync(module_state->sync_data);
+    TSInt_AtomicExchange(&action_state->signal_state, TSINT_ACTION_SIGNAL_IDLE);
 }
 
-static void RemoveFromAll (
+static void DiscardSignal (
                            struct tsint_action_state* action_state,
                            struct tsint_module_state* module_state
                           )
 {
-    TSInt_LockActionStateSync(module_state->sync_data);
+    if(action_state->signal_state != TSINT_ACTION_SIGNAL_QUEUED)
+        return;
 
-    if(!(action_state->flags&TSINT_ACTION_STATE_FLAG_FINISHED))
-    {
-        action_state->flags |= TSINT_ACTION_STATE_FLAG_FINISHED;
+    TSInt_LockModuleState(module_state);
 
-        if(action_state->next_action != NULL)
-            action_state->next_action->previous_action = action_state->previous_action;
-        if(action_state->previous_action != NULL)
-            action_state->previous_action->next_action = action_state->next_action;
-        else
-        {
-            if(action_state->flags&TSINT_ACTION_STATE_FLAG_SIGNALED)
-                module_state->signaled_actions = action_state->next_action;
-            else
-                module_state->pending_actions = action_state->next_action;
-        }
+    /* Only an action the module already drained can be taken back here,
+       one that may still be on its way is left for the drain to drop */
+    if(action_state->flags&TSINT_ACTION_STATE_FLAG_SIGNALED)
+    {
+        UnlinkSignaled(action_state, module_state);
+        ResetSignal(action_state);
+    }
+    else if(!(action_state->flags&TSINT_ACTION_STATE_FLAG_COLLECTED))
+    {
+        TSInt_AtomicCompareExchange(
+                                    &action_state->signal_state,
+                                    TSINT_ACTION_SIGNAL_DISCARDED,
+                                    TSINT_ACTION_SIGNAL_QUEUED
+                                   );
     }
 
-    TSInt_UnlockActionStateSync(module_state->sync_data);
+    TSInt_UnlockModuleState(module_state);
 }
 
 
@@ -199,8 +391,10 @@ int TSInt_InitActions (
     struct tsdef_action*                  unwind_action;
     struct tsint_action_state*            action_state;
     struct tsint_module_state*            module_state;
-    struct tsdef_function_call_list_node* current_signal;
-    struct tsdef_function_call_list_node* unwind_signal;
+    struct tsdef_function_call**          function_calls;
+    unsigned int                          signal_index;
+    unsigned int                          unwind_count;
+    unsigned int                          unwind_index;
     void**                                trigger_user_data;
     int                                   exception;
 
@@ -215,20 +409,29 @@ int TSInt_InitActions (
         action_state->unit_state = unit_state;
         action_state->flags      = 0;
 
+        action_state->signal_state       = TSINT_ACTION_SIGNAL_IDLE;
+        action_state->next_queued_action = NULL;
+        action_state->next_action        = NULL;
+        action_state->previous_action    = NULL;
+
         action_state->invocation_data.execif             = &tsint_action_execif;
         action_state->invocation_data.execif_data        = action_state;
         action_state->invocation_data.unit_invocation_id = unit_state->unit_id;
         action_state->invocation_data.unit_name          = unit->name;
         action_state->invocation_data.unit_location      = current_action->location;
+        action_state->invocation_data.suspend_data       = NULL;
 
-        AddToPending(action_state, module_state);
+        action_state->query_count     = 0;
+        action_state->triggered_count = 0;
+        action_state->finished_count  = 0;
 
         trigger_user_data = action_state->trigger_user_data;
 
+        function_calls = current_action->trigger_list->function_calls;
         for(
-            current_signal = current_action->trigger_list->start;
-            current_signal != NULL;
-            current_signal = current_signal->next_function_call
+            signal_index = 0;
+            signal_index < current_action->trigger_list->count;
+            signal_index++
            )
         {
             struct tsdef_module_object*       module_object;
@@ -239,11 +442,18 @@ int TSInt_InitActions (
 
             *trigger_user_data = NULL;
 
-            function_call  = current_signal->function_call;
+            function_call  = function_calls[signal_index];
             module_object  = function_call->module_object;
             ffi_definition = module_object->type.ffi.function_definition;
             ffi_group      = module_object->type.ffi.group;
 
+            /* Set before the controller starts, it may report a state
+               during initialization */
+            action_state->trigger_states[signal_index] = TSFFI_ACTION_STATE_PENDING;
+
+            if(!(ffi_definition->flags&TSFFI_FUNCTION_FLAG_PUSH_STATE))
+                action_state->query_count++;
+
             exception = TSInt_ExpListToFFIArguments(
                                                     function_call->arguments,
                                                     ffi_definition->argument_types,
@@ -253,6 +463,8 @@ int TSInt_InitActions (
             if(exception != TSINT_EXCEPTION_NONE)
                 goto create_arguments_failed;
 
+            TSInt_LockFFIGroup(module_state, ffi_group);
+
             exception = ffi_definition->action_controller(
                                                           &action_state->invocation_data,
                                                           TSFFI_INIT_ACTION,
@@ -262,6 +474,8 @@ int TSInt_InitActions (
                                                           trigger_user_data
                                                          );
 
+            TSInt_UnlockFFIGroup(module_state, ffi_group);
+
             TSInt_DestroyFFIArguments(
                                       ffi_definition->argument_types,
                                       ffi_definition->argument_count,
@@ -293,23 +507,27 @@ create_arguments_failed:
     while(1)
     {
         trigger_user_data = action_state->trigger_user_data;
+        function_calls    = unwind_action->trigger_list->function_calls;
 
-        for(
-            unwind_signal = unwind_action->trigger_list->start;
-            unwind_signal != NULL && unwind_signal != current_signal;
-            unwind_signal = unwind_signal->next_function_call
-           )
+        if(unwind_action == current_action)
+            unwind_count = signal_index;
+        else
+            unwind_count = unwind_action->trigger_list->count;
+
+        for(unwind_index = 0; unwind_index < unwind_count; unwind_index++)
         {
             struct tsdef_module_object*       module_object;
             struct tsdef_function_call*       function_call;
             struct tsffi_function_definition* ffi_definition;
             struct tsdef_module_ffi_group*    ffi_group;
 
-            function_call  = unwind_signal->function_call;
+            function_call  = function_calls[unwind_index];
             module_object  = function_call->module_object;
             ffi_definition = module_object->type.ffi.function_definition;
             ffi_group      = module_object->type.ffi.group;
 
+            TSInt_LockFFIGroup(module_state, ffi_group);
+
             ffi_definition->action_controller(
                                               &action_state->invocation_data,
                                               TSFFI_STOP_ACTION,
@@ -319,10 +537,12 @@ create_arguments_failed:
                                               trigger_user_data
                                              );
 
+            TSInt_UnlockFFIGroup(module_state, ffi_group);
+
             trigger_user_data++;
         }
 
-        RemoveFromAll(action_state, module_state);
+        TSInt_RemoveAction(action_state);
 
         if(unwind_action == current_action)
             break;
@@ -341,7 +561,8 @@ int TSInt_EvaluateAction (struct tsint_action_state* action_state, unsigned int*
     struct tsdef_action*                  action;
     struct tsint_unit_state*              unit_state;
     struct tsint_module_state*            module_state;
-    struct tsdef_function_call_list_node* current_signal;
+    struct tsdef_function_call**          function_calls;
+    unsigned int                          signal_index;
     unsigned int                          triggered_count;
     unsigned int                          finished_count;
     void**                                trigger_user_data;
@@ -350,61 +571,76 @@ int TSInt_EvaluateAction (struct tsint_action_state* action_state, unsigned int*
     unit_state   = action_state->unit_state;
     module_state = unit_state->module_state;
 
-    AddToPending(action_state, module_state);
+    ResetSignal(action_state);
 
-    triggered_count = 0;
-    finished_count  = 0;
+    /* Read after the reset, a state pushed from here on queues the action
+       again */
+    triggered_count = action_state->triggered_count;
+    finished_count  = action_state->finished_count;
 
-    trigger_user_data = action_state->trigger_user_data;
-
-    for(
-        current_signal = action->trigger_list->start;
-        current_signal != NULL;
-        current_signal = current_signal->next_function_call
-       )
+    /* Triggers that push their state are already counted */
+    if(action_state->query_count != 0)
     {
-        struct tsdef_module_object*       module_object;
-        struct tsdef_function_call*       function_call;
-        struct tsffi_function_definition* ffi_definition;
-        struct tsdef_module_ffi_group*    ffi_group;
-        unsigned int                      state;
-        int                               exception;
+        trigger_user_data = action_state->trigger_user_data;
 
-        function_call  = current_signal->function_call;
-        module_object  = function_call->module_object;
-        ffi_definition = module_object->type.ffi.function_definition;
-        ffi_group      = module_object->type.ffi.group;
+        function_calls = action->trigger_list->function_calls;
+        for(signal_index = 0; signal_index < action->trigger_list->count; signal_index++)
+        {
+            struct tsdef_module_object*       module_object;
+            struct tsdef_function_call*       function_call;
+            struct tsffi_function_definition* ffi_definition;
+            struct tsdef_module_ffi_group*    ffi_group;
+            unsigned int                      state;
+            int                               exception;
 
-        exception = ffi_definition->action_controller(
-                                                      &action_state->invocation_data,
-                                                      TSFFI_QUERY_ACTION,
-                                                      module_state->ffi_group_data[ffi_group->group_id],
-                                                      NULL,
-                                                      &state,
-                                                      trigger_user_data
-                                                     );
-        if(exception != TSFFI_ERROR_NONE)
-            goto query_action_failed;
+            function_call  = function_calls[signal_index];
+            module_object  = function_call->module_object;
+            ffi_definition = module_object->type.ffi.function_definition;
+            ffi_group      = module_object->type.ffi.group;
 
-        switch(state)
-        {
-        case TSFFI_ACTION_STATE_TRIGGERED:
-            triggered_count++;
+            if(ffi_definition->flags&TSFFI_FUNCTION_FLAG_PUSH_STATE)
+            {
+                trigger_user_data++;
 
-            break;
+                continue;
+            }
 
-        case TSFFI_ACTION_STATE_FINISHED:
-            finished_count++;
+            TSInt_LockFFIGroup(module_state, ffi_group);
 
-            break;
-        }
+            exception = ffi_definition->action_controller(
+                                                          &action_state->invocation_data,
+                                                          TSFFI_QUERY_ACTION,
+                                                          module_state->ffi_group_data[ffi_group->group_id],
+                                                          NULL,
+                                                          &state,
+                                                          trigger_user_data
+                                                         );
 
-        trigger_user_data++;
+            TSInt_UnlockFFIGroup(module_state, ffi_group);
+
+            if(exception != TSFFI_ERROR_NONE)
+                goto query_action_failed;
+
+            switch(state)
+            {
+            case TSFFI_ACTION_STATE_TRIGGERED:
+                triggered_count++;
+
+                break;
+
+            case TSFFI_ACTION_STATE_FINISHED:
+                finished_count++;
+
+                break;
+            }
+
+            trigger_user_data++;
+        }
     }
 
     if(finished_count == action->trigger_list->count)
     {
-        RemoveFromAll(action_state, module_state);
+        TSInt_RemoveAction(action_state);
 
         unit_state->active_action_count--;
 
@@ -421,7 +657,7 @@ int TSInt_EvaluateAction (struct tsint_action_state* action_state, unsigned int*
     return TSINT_EXCEPTION_NONE;
 
 query_action_failed:
-    RemoveFromAll(action_state, module_state);
+    TSInt_RemoveAction(action_state);
 
     return TSINT_EXCEPTION_FFI;
 }
@@ -431,7 +667,8 @@ int TSInt_PrepActionRun (struct tsint_action_state* action_state)
     struct tsdef_action*                  action;
     struct tsint_unit_state*              unit_state;
     struct tsint_module_state*            module_state;
-    struct tsdef_function_call_list_node* current_signal;
+    struct tsdef_function_call**          function_calls;
+    unsigned int                          signal_index;
     void**                                trigger_user_data;
 
     action       = action_state->action;
@@ -440,11 +677,8 @@ int TSInt_PrepActionRun (struct tsint_action_state* action_state)
 
     trigger_user_data = action_state->trigger_user_data;
 
-    for(
-        current_signal = action->trigger_list->start;
-        current_signal != NULL;
-        current_signal = current_signal->next_function_call
-       )
+    function_calls = action->trigger_list->function_calls;
+    for(signal_index = 0; signal_index < action->trigger_list->count; signal_index++)
     {
         struct tsdef_module_object*       module_object;
         struct tsdef_function_call*       function_call;
@@ -452,11 +686,13 @@ int TSInt_PrepActionRun (struct tsint_action_state* action_state)
         struct tsdef_module_ffi_group*    ffi_group;
         int                               exception;
 
-        function_call  = current_signal->function_call;
+        function_call  = function_calls[signal_index];
         module_object  = function_call->module_object;
         ffi_definition = module_object->type.ffi.function_definition;
         ffi_group      = module_object->type.ffi.group;
 
+        TSInt_LockFFIGroup(module_state, ffi_group);
+
         exception = ffi_definition->action_controller(
                                                       &action_state->invocation_data,
                                                       TSFFI_RUNNING_ACTION,
@@ -465,6 +701,9 @@ int TSInt_PrepActionRun (struct tsint_action_state* action_state)
                                                       NULL,
                                                       trigger_user_data
                                                      );
+
+        TSInt_UnlockFFIGroup(module_state, ffi_group);
+
         if(exception != TSFFI_ERROR_NONE)
             goto wait_action_failed;
 
@@ -474,7 +713,7 @@ int TSInt_PrepActionRun (struct tsint_action_state* action_state)
     return TSINT_EXCEPTION_NONE;
 
 wait_action_failed:
-    RemoveFromAll(action_state, module_state);
+    TSInt_RemoveAction(action_state);
 
     return TSINT_EXCEPTION_FFI;
 }
@@ -484,7 +723,8 @@ int TSInt_UpdateAction (struct tsint_action_state* action_state)
     struct tsdef_action*                  action;
     struct tsint_unit_state*              unit_state;
     struct tsint_module_state*            module_state;
-    struct tsdef_function_call_list_node* current_signal;
+    struct tsdef_function_call**          function_calls;
+    unsigned int                          signal_index;
     void**                                trigger_user_data;
     int                                   exception;
 
@@ -492,15 +732,12 @@ int TSInt_UpdateAction (struct tsint_action_state* action_state)
     unit_state   = action_state->unit_state;
     module_state = unit_state->module_state;
 
-    MoveToPending(action_state, module_state);
+    DiscardSignal(action_state, module_state);
 
     trigger_user_data = action_state->trigger_user_data;
 
-    for(
-        current_signal = action->trigger_list->start;
-        current_signal != NULL;
-        current_signal = current_signal->next_function_call
-       )
+    function_calls = action->trigger_list->function_calls;
+    for(signal_index = 0; signal_index < action->trigger_list->count; signal_index++)
     {
         struct tsdef_module_object*       module_object;
         struct tsdef_function_call*       function_call;
@@ -508,7 +745,7 @@ int TSInt_UpdateAction (struct tsint_action_state* action_state)
         struct tsdef_module_ffi_group*    ffi_group;
         union tsffi_value*                ffi_arguments;
 
-        function_call  = current_signal->function_call;
+        function_call  = function_calls[signal_index];
         module_object  = function_call->module_object;
         ffi_definition = module_object->type.ffi.function_definition;
         ffi_group      = module_object->type.ffi.group;
@@ -522,6 +759,8 @@ int TSInt_UpdateAction (struct tsint_action_state* action_state)
         if(exception != TSINT_EXCEPTION_NONE)
             goto create_arguments_failed;
 
+        TSInt_LockFFIGroup(module_state, ffi_group);
+
         exception = ffi_definition->action_controller(
                                                       &action_state->invocation_data,
                                                       TSFFI_UPDATE_ACTION,
@@ -531,6 +770,8 @@ int TSInt_UpdateAction (struct tsint_action_state* action_state)
                                                       trigger_user_data
                                                      );
 
+        TSInt_UnlockFFIGroup(module_state, ffi_group);
+
         TSInt_DestroyFFIArguments(
                                   ffi_definition->argument_types,
                                   ffi_definition->argument_count,
@@ -551,7 +792,7 @@ int TSInt_UpdateAction (struct tsint_action_state* action_state)
 
 update_action_failed:
 create_arguments_failed:
-    RemoveFromAll(action_state, module_state);
+    TSInt_RemoveAction(action_state);
 
     return exception;
 }
@@ -562,7 +803,8 @@ void TSInt_StopActions (struct tsint_unit_state* unit_state)
     struct tsdef_action*                  current_action;
     struct tsint_action_state*            action_state;
     struct tsint_module_state*            module_state;
-    struct tsdef_function_call_list_node* current_signal;
+    struct tsdef_function_call**          function_calls;
+    unsigned int                          signal_index;
     void**                                trigger_user_data;
     int                                   exception;
 
@@ -575,22 +817,21 @@ void TSInt_StopActions (struct tsint_unit_state* unit_state)
     {
         trigger_user_data = action_state->trigger_user_data;
 
-        for(
-            current_signal = current_action->trigger_list->start;
-            current_signal != NULL;
-            current_signal = current_signal->next_function_call
-           )
+        function_calls = current_action->trigger_list->function_calls;
+        for(signal_index = 0; signal_index < current_action->trigger_list->count; signal_index++)
         {
             struct tsdef_module_object*       module_object;
             struct tsdef_function_call*       function_call;
             struct tsffi_function_definition* ffi_definition;
             struct tsdef_module_ffi_group*    ffi_group;
 
-            function_call  = current_signal->function_call;
+            function_call  = function_calls[signal_index];
             module_object  = function_call->module_object;
             ffi_definition = module_object->type.ffi.function_definition;
             ffi_group      = module_object->type.ffi.group;
 
+            TSInt_LockFFIGroup(module_state, ffi_group);
+
             ffi_definition->action_controller(
                                               &action_state->invocation_data,
                                               TSFFI_STOP_ACTION,
@@ -600,13 +841,181 @@ void TSInt_StopActions (struct tsint_unit_state* unit_state)
                                               trigger_user_data
                                              );
 
+            TSInt_UnlockFFIGroup(module_state, ffi_group);
+
             trigger_user_data++;
         }
 
-        RemoveFromAll(action_state, module_state);
+        TSInt_RemoveAction(action_state);
 
         action_state++;
 
         current_action = current_action->next_action;
     }
 }
+
+void TSInt_QueueAction (struct tsint_action_state* action_state)
+{
+    if(!ClaimSignal(action_state))
+        return;
+
+    PushSignal(action_state, action_state->unit_state->module_state);
+}
+
+void TSInt_QueueActions (struct tsint_action_state** actions, unsigned int action_count)
+{
+    struct tsint_action_state* first_action;
+    struct tsint_action_state* last_action;
+    struct tsint_module_state* chain_module;
+    unsigned int               index;
+
+    /* Chain every action that isn't already queued and publish each
+       module's run of actions with a single exchange */
+    first_action = NULL;
+    last_action  = NULL;
+    chain_module = NULL;
+    for(index = 0; index < action_count; index++)
+    {
+        struct tsint_action_state* action_state;
+        struct tsint_module_state* module_state;
+
+        action_state = actions[index];
+
+        if(!ClaimSignal(action_state))
+            continue;
+
+        module_state = action_state->unit_state->module_state;
+        if(module_state != chain_module && first_action != NULL)
+        {
+            PushSignalChain(first_action, last_action, chain_module);
+
+            first_action = NULL;
+        }
+
+        if(first_action == NULL)
+            last_action = action_state;
+
+        action_state->next_queued_action = first_action;
+        first_action                     = action_state;
+        chain_module                     = module_state;
+    }
+
+    if(first_action != NULL)
+        PushSignalChain(first_action, last_action, chain_module);
+}
+
+void TSInt_RequeueAction (struct tsint_action_state* action_state)
+{
+    /* The action was taken off the queue but never evaluated, so it is
+       still marked queued and only needs to be linked again */
+    action_state->flags &= ~TSINT_ACTION_STATE_FLAG_COLLECTED;
+
+    PushSignal(action_state, action_state->unit_state->module_state);
+}
+
+long TSInt_RemoveAction (struct tsint_action_state* action_state)
+{
+    struct tsint_module_state* module_state;
+    long                       previous_state;
+
+    module_state = action_state->unit_state->module_state;
+
+    TSInt_LockModuleState(module_state);
+
+    if(action_state->flags&TSINT_ACTION_STATE_FLAG_FINISHED)
+    {
+        previous_state = TSINT_ACTION_SIGNAL_FINISHED;
+
+        goto already_finished;
+    }
+
+    action_state->flags |= TSINT_ACTION_STATE_FLAG_FINISHED;
+
+    previous_state = TSInt_AtomicExchange(&action_state->signal_state, TSINT_ACTION_SIGNAL_FINISHED);
+    if(previous_state == TSINT_ACTION_SIGNAL_QUEUED || previous_state == TSINT_ACTION_SIGNAL_DISCARDED)
+    {
+        /* The unit is freed once its actions are removed, so wait out a
+           push that has claimed the action but not linked it yet */
+        while(!(action_state->flags&TSINT_ACTION_STATE_FLAG_COLLECTED))
+        {
+            TSInt_CollectSignaledActions(module_state);
+
+            if(!(action_state->flags&TSINT_ACTION_STATE_FLAG_COLLECTED))
+                TSInt_PauseProcessor();
+        }
+
+        UnlinkSignaled(action_state, module_state);
+    }
+
+already_finished:
+    TSInt_UnlockModuleState(module_state);
+
+    return previous_state;
+}
+
+void TSInt_CollectSignaledActions (struct tsint_module_state* module_state)
+{
+    struct tsint_action_state* queued_actions;
+    struct tsint_action_state* action_state;
+    struct tsint_action_state* first_action;
+    struct tsint_action_state* last_action;
+
+    queued_actions = TSInt_AtomicExchangePointer((void* volatile*)&module_state->signal_queue, NULL);
+    if(queued_actions == NULL)
+        return;
+
+    first_action = NULL;
+    last_action  = NULL;
+
+    action_state = queued_actions;
+    while(action_state != NULL)
+    {
+        struct tsint_action_state* next_action;
+        long                       previous_state;
+
+        next_action = action_state->next_queued_action;
+
+        /* A discarded action is dropped here, where nothing else can be
+           pushing it, unless it was queued again in the meantime */
+        previous_state = TSInt_AtomicCompareExchange(
+                                                     &action_state->signal_state,
+                                                     TSINT_ACTION_SIGNAL_IDLE,
+                                                     TSINT_ACTION_SIGNAL_DISCARDED
+                                                    );
+        if(previous_state != TSINT_ACTION_SIGNAL_DISCARDED)
+        {
+            action_state->flags          |= TSINT_ACTION_STATE_FLAG_SIGNALED|TSINT_ACTION_STATE_FLAG_COLLECTED;
+            action_state->previous_action = last_action;
+            action_state->next_action     = NULL;
+
+            if(last_action != NULL)
+                last_action->next_action = action_state;
+            else
+                first_action = action_state;
+
+            last_action = action_state;
+        }
+
+        action_state = next_action;
+    }
+
+    if(first_action == NULL)
+        return;
+
+    last_action->next_action = module_state->signaled_actions;
+    if(last_action->next_action != NULL)
+        last_action->next_action->previous_action = last_action;
+
+    module_state->signaled_actions = first_action;
+}
+
+struct tsint_action_state* TSInt_TakeSignaledAction (struct tsint_module_state* module_state)
+{
+    struct tsint_action_state* action_state;
+
+    action_state = module_state->signaled_actions;
+    if(action_state != NULL)
+        UnlinkSignaled(action_state, module_state);
+
+    return action_state;
+}
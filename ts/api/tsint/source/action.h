@@ -25,6 +25,14 @@ extern int  TSInt_EvaluateAction (struct tsint_action_state*, unsigned int*);
 extern int  TSInt_PrepActionRun  (struct tsint_action_state*);
 extern int  TSInt_UpdateAction   (struct tsint_action_state*);
 
+extern void TSInt_QueueAction   (struct tsint_action_state*);
+extern void TSInt_QueueActions  (struct tsint_action_state**, unsigned int);
+extern void TSInt_RequeueAction (struct tsint_action_state*);
+extern long TSInt_RemoveAction  (struct tsint_action_state*);
+
+extern void                       TSInt_CollectSignaledActions (struct tsint_module_state*);
+extern struct tsint_action_state* TSInt_TakeSignaledAction     (struct tsint_module_state*);
+
 
 #endif
 
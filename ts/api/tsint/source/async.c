@@ -0,0 +1,535 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#include "async.h"
+#include "assignment.h"
+#include "unit.h"
+#include "ffi.h"
+#include "dispatch.h"
+
+#include <tsdef/module.h>
+#include <tsdef/ffi.h>
+#include <tsffi/register.h>
+#include <tsffi/error.h>
+#include <tsint/error.h>
+#include <tsint/exception.h>
+#include <tsint/variable.h>
+#include <tsint/value.h>
+
+#include <malloc.h>
+#include <stdlib.h>
+
+
+#define TSINT_ASYNC_CALL_FLAG_BLOCKING 0x04
+
+
+static int  AllocCall   (
+                         struct tsint_unit_state*,
+                         struct tsdef_assignment*,
+                         unsigned int,
+                         unsigned int,
+                         struct tsint_async_call**
+                        );
+static void FreeCall    (struct tsint_async_call*);
+static int  StartCall   (
+                         struct tsdef_function_call*,
+                         union tsffi_value*,
+                         struct tsint_unit_state*,
+                         struct tsint_async_call*
+                        );
+static int  WaitForCall (struct tsint_async_call*);
+static int  StoreOutput (struct tsint_async_call*);
+
+
+static int AllocCall (
+                      struct tsint_unit_state*  unit_state,
+                      struct tsdef_assignment*  assignment,
+                      unsigned int              output_type,
+                      unsigned int              flags,
+                      struct tsint_async_call** allocated_call
+                     )
+{
+    struct tsint_async_call* call;
+    int                      error;
+
+    call = malloc(sizeof(struct tsint_async_call));
+    if(call == NULL)
+        goto allocate_call_failed;
+
+    error = TSInt_InitializeMutex(&call->call_sync);
+    if(error != TSINT_ERROR_NONE)
+        goto initialize_mutex_failed;
+
+    if(flags&TSINT_ASYNC_CALL_FLAG_BLOCKING)
+    {
+        error = TSInt_InitializeSemaphore(&call->completion_signal);
+        if(error != TSINT_ERROR_NONE)
+            goto initialize_semaphore_failed;
+    }
+
+    call->unit_state  = unit_state;
+    call->assignment  = assignment;
+    call->output_type = output_type;
+    call->flags       = flags;
+    call->error       = TSFFI_ERROR_NONE;
+
+    *allocated_call = call;
+
+    return TSINT_EXCEPTION_NONE;
+
+initialize_semaphore_failed:
+    TSInt_DestroyMutex(&call->call_sync);
+initialize_mutex_failed:
+    free(call);
+
+allocate_call_failed:
+    return TSINT_EXCEPTION_OUT_OF_MEMORY;
+}
+
+static void FreeCall (struct tsint_async_call* call)
+{
+    if(call->flags&TSINT_ASYNC_CALL_FLAG_BLOCKING)
+        TSInt_DestroySemaphore(&call->completion_signal);
+
+    TSInt_DestroyMutex(&call->call_sync);
+
+    free(call);
+}
+
+static int StartCall (
+                      struct tsdef_function_call* function_call,
+                      union tsffi_value*          ffi_arguments,
+                      struct tsint_unit_state*    unit_state,
+                      struct tsint_async_call*    call
+                     )
+{
+    struct tsffi_invocation_data      invocation_data;
+    struct tsffi_function_definition* ffi_function;
+    struct tsdef_module_ffi_group*    ffi_group;
+    struct tsint_module_state*        module_state;
+    int                               error;
+
+    ffi_function = function_call->module_object->type.ffi.function_definition;
+    ffi_group    = function_call->module_object->type.ffi.group;
+    module_state = unit_state->module_state;
+
+    invocation_data.execif             = module_state->module_execif;
+    invocation_data.execif_data        = module_state;
+    invocation_data.unit_invocation_id = unit_state->unit_id;
+    invocation_data.unit_name          = unit_state->unit->name;
+
+    if(unit_state->current_statement != NULL)
+        invocation_data.unit_location = unit_state->current_statement->location;
+    else
+        invocation_data.unit_location = 0;
+
+    invocation_data.suspend_data = NULL;
+
+    TSInt_LockFFIGroup(module_state, ffi_group);
+
+    error = ffi_function->async_function(
+                                         &invocation_data,
+                                         module_state->ffi_group_data[ffi_group->group_id],
+                                         call,
+                                         ffi_arguments
+                                        );
+
+    TSInt_UnlockFFIGroup(module_state, ffi_group);
+
+    TSInt_DestroyFFIArguments(
+                              ffi_function->argument_types,
+                              ffi_function->argument_count,
+                              ffi_arguments
+                             );
+
+    if(error != TSFFI_ERROR_NONE)
+        return TSINT_EXCEPTION_FFI;
+
+    return TSINT_EXCEPTION_NONE;
+}
+
+static int WaitForCall (struct tsint_async_call* call)
+{
+    struct tsint_module_state*  module_state;
+    struct tsint_dispatch_pool* pool;
+    unsigned int                completed;
+    int                         exception;
+
+    module_state = call->unit_state->module_state;
+    pool         = module_state->dispatch_pool;
+
+    /* Outside of a batch this is the module thread, which keeps running
+       the reactor so that a plugin can complete the call from one of its
+       callbacks.  Signaled actions stay queued until the call is done */
+    if(pool == NULL || !(pool->flags&TSINT_DISPATCH_POOL_FLAG_DISPATCHING))
+    {
+        while(1)
+        {
+            TSInt_ClearSignal(module_state->sync_data);
+
+            TSInt_LockMutex(&call->call_sync);
+
+            completed = call->flags&TSINT_ASYNC_CALL_FLAG_COMPLETED;
+
+            TSInt_UnlockMutex(&call->call_sync);
+
+            if(completed)
+                break;
+
+            exception = TSInt_ListenForAction(module_state->sync_data, 0);
+            if(exception != TSINT_EXCEPTION_NONE)
+                goto listen_failed;
+        }
+
+        /* Clearing may have taken the wake meant for actions queued in
+           the meantime, so the module loop is woken again */
+        TSInt_SignalAction(module_state->sync_data);
+    }
+
+    TSInt_WaitSemaphore(&call->completion_signal);
+
+    return TSINT_EXCEPTION_NONE;
+
+listen_failed:
+    TSInt_LockMutex(&call->call_sync);
+
+    completed = call->flags&TSINT_ASYNC_CALL_FLAG_COMPLETED;
+    if(!completed)
+        call->flags |= TSINT_ASYNC_CALL_FLAG_ABANDONED;
+
+    TSInt_UnlockMutex(&call->call_sync);
+
+    /* Still running, whoever completes it releases it */
+    if(!completed)
+        return exception;
+
+    TSInt_WaitSemaphore(&call->completion_signal);
+
+    if(call->error == TSFFI_ERROR_NONE)
+        TSInt_DestroyFFIArgument(call->output, call->output_type);
+
+    FreeCall(call);
+
+    return exception;
+}
+
+static int StoreOutput (struct tsint_async_call* call)
+{
+    union tsint_value      function_output;
+    union tsint_value      value;
+    struct tsint_variable* variable_data;
+    struct tsdef_variable* variable_def;
+    unsigned int           output_type;
+    int                    error;
+
+    variable_def  = call->assignment->lvalue->variable;
+    variable_data = TSInt_LookupVariableAddress(variable_def, call->unit_state);
+
+    error = TSInt_FFITypeToDefType(call->output, call->output_type, &function_output);
+    if(error != TSFFI_ERROR_NONE)
+        return TSINT_EXCEPTION_FFI;
+
+    output_type = TSDef_TranslateFFIType(call->output_type);
+
+    error = TSInt_ConvertValue(
+                               function_output,
+                               output_type,
+                               variable_def->primitive_type,
+                               &value
+                              );
+
+    TSInt_DestroyValue(function_output, output_type);
+
+    if(error != TSINT_ERROR_NONE)
+        return TSINT_EXCEPTION_OUT_OF_MEMORY;
+
+    if(variable_data->flags&TSINT_VARIABLE_FLAG_INITIALIZED)
+        TSInt_DestroyValue(variable_data->value, variable_def->primitive_type);
+
+    variable_data->value  = value;
+    variable_data->flags |= TSINT_VARIABLE_FLAG_INITIALIZED;
+
+    return TSINT_EXCEPTION_NONE;
+}
+
+
+struct tsdef_function_call* TSInt_AsyncCallOfExp (struct tsdef_exp* exp)
+{
+    struct tsdef_primary_exp*    primary_exp;
+    struct tsdef_exp_value_type* exp_value_type;
+    struct tsdef_function_call*  function_call;
+    struct tsdef_module_object*  module_object;
+
+    if(exp->type != TSDEF_EXP_TYPE_PRIMARY)
+        return NULL;
+
+    primary_exp = exp->data.primary_exp;
+    if(primary_exp->flags&TSDEF_PRIMARY_EXP_FLAG_NEGATE)
+        return NULL;
+    if(primary_exp->start->op != TSDEF_PRIMARY_EXP_OP_VALUE || primary_exp->start->remaining_exp != NULL)
+        return NULL;
+
+    exp_value_type = primary_exp->start->exp_value_type;
+    if(exp_value_type->type != TSDEF_EXP_VALUE_TYPE_FUNCTION_CALL)
+        return NULL;
+
+    function_call = exp_value_type->data.function_call;
+    module_object = function_call->module_object;
+
+    if(module_object->flags&TSDEF_MODULE_OBJECT_FLAG_UNIT_OBJECT)
+        return NULL;
+    if(module_object->type.ffi.function_definition->async_function == NULL)
+        return NULL;
+
+    return function_call;
+}
+
+int TSInt_InvokeAsyncFunction (
+                               struct tsdef_function_call* function_call,
+                               struct tsint_unit_state*    unit_state,
+                               union tsffi_value*          output
+                              )
+{
+    struct tsffi_function_definition* ffi_function;
+    union tsffi_value*                ffi_arguments;
+    struct tsint_async_call*          call;
+    int                               exception;
+
+    ffi_function = function_call->module_object->type.ffi.function_definition;
+
+    exception = AllocCall(
+                          unit_state,
+                          NULL,
+                          ffi_function->output_type,
+                          TSINT_ASYNC_CALL_FLAG_BLOCKING,
+                          &call
+                         );
+    if(exception != TSINT_EXCEPTION_NONE)
+        goto allocate_call_failed;
+
+    exception = TSInt_ExpListToFFIArguments(
+                                            function_call->arguments,
+                                            ffi_function->argument_types,
+                                            unit_state,
+                                            &ffi_arguments
+                                           );
+    if(exception != TSINT_EXCEPTION_NONE)
+        goto convert_arguments_failed;
+
+    exception = StartCall(function_call, ffi_arguments, unit_state, call);
+    if(exception != TSINT_EXCEPTION_NONE)
+        goto start_call_failed;
+
+    /* Only a unit that can't be suspended gets here */
+    exception = WaitForCall(call);
+    if(exception != TSINT_EXCEPTION_NONE)
+        goto wait_call_failed;
+
+    if(call->error != TSFFI_ERROR_NONE)
+    {
+        exception = TSINT_EXCEPTION_FFI;
+
+        goto call_failed;
+    }
+
+    *output = call->output;
+
+    FreeCall(call);
+
+    return TSINT_EXCEPTION_NONE;
+
+call_failed:
+start_call_failed:
+convert_arguments_failed:
+    FreeCall(call);
+
+wait_call_failed:
+allocate_call_failed:
+    return exception;
+}
+
+int TSInt_StartAsyncCall (
+                          struct tsdef_function_call* function_call,
+                          struct tsdef_assignment*    assignment,
+                          struct tsint_unit_state*    unit_state
+                         )
+{
+    struct tsffi_function_definition* ffi_function;
+    union tsffi_value*                ffi_arguments;
+    struct tsint_async_call*          call;
+    void*                             resume_token;
+    int                               exception;
+
+    ffi_function = function_call->module_object->type.ffi.function_definition;
+
+    exception = AllocCall(unit_state, assignment, ffi_function->output_type, 0, &call);
+    if(exception != TSINT_EXCEPTION_NONE)
+        return exception;
+
+    resume_token = TSInt_SuspendUnit(unit_state, NULL, NULL);
+    if(resume_token == NULL)
+        goto suspend_unit_failed;
+
+    exception = TSInt_ExpListToFFIArguments(
+                                            function_call->arguments,
+                                            ffi_function->argument_types,
+                                            unit_state,
+                                            &ffi_arguments
+                                           );
+    if(exception != TSINT_EXCEPTION_NONE)
+        goto convert_arguments_failed;
+
+    /* The call is attached before it starts, a plugin may complete it
+       before the start function even returns */
+    unit_state->async_call = call;
+
+    exception = StartCall(function_call, ffi_arguments, unit_state, call);
+    if(exception != TSINT_EXCEPTION_NONE)
+        goto start_call_failed;
+
+    return TSINT_EXCEPTION_NONE;
+
+start_call_failed:
+    unit_state->async_call = NULL;
+convert_arguments_failed:
+    unit_state->flags &= ~TSINT_UNIT_STATE_FLAG_SUSPENDED;
+
+    FreeCall(call);
+
+    return exception;
+
+suspend_unit_failed:
+    FreeCall(call);
+
+    /* The unit can't wait right now, so fall back to the blocking call */
+    if(assignment != NULL)
+        return TSInt_PerformAssignment(assignment, unit_state);
+    else
+    {
+        union tsffi_value output;
+
+        exception = TSInt_InvokeAsyncFunction(function_call, unit_state, &output);
+        if(exception != TSINT_EXCEPTION_NONE)
+            return exception;
+
+        TSInt_DestroyFFIArgument(output, ffi_function->output_type);
+    }
+
+    return TSINT_EXCEPTION_NONE;
+}
+
+int TSInt_FinishAsyncCall (struct tsint_unit_state* unit_state)
+{
+    struct tsint_async_call* call;
+    int                      exception;
+
+    call = unit_state->async_call;
+
+    unit_state->async_call = NULL;
+
+    /* The completing thread may still be queueing the resume */
+    TSInt_LockMutex(&call->call_sync);
+    TSInt_UnlockMutex(&call->call_sync);
+
+    if(call->error != TSFFI_ERROR_NONE)
+    {
+        FreeCall(call);
+
+        return TSINT_EXCEPTION_FFI;
+    }
+
+    if(call->assignment != NULL)
+        exception = StoreOutput(call);
+    else
+        exception = TSINT_EXCEPTION_NONE;
+
+    TSInt_DestroyFFIArgument(call->output, call->output_type);
+
+    FreeCall(call);
+
+    return exception;
+}
+
+void TSInt_AbandonAsyncCall (struct tsint_unit_state* unit_state)
+{
+    struct tsint_async_call* call;
+
+    call = unit_state->async_call;
+    if(call == NULL)
+        return;
+
+    unit_state->async_call = NULL;
+
+    TSInt_LockMutex(&call->call_sync);
+
+    /* Still running, whoever completes it releases it */
+    if(!(call->flags&TSINT_ASYNC_CALL_FLAG_COMPLETED))
+    {
+        call->flags |= TSINT_ASYNC_CALL_FLAG_ABANDONED;
+
+        TSInt_UnlockMutex(&call->call_sync);
+
+        return;
+    }
+
+    TSInt_UnlockMutex(&call->call_sync);
+
+    if(call->error == TSFFI_ERROR_NONE)
+        TSInt_DestroyFFIArgument(call->output, call->output_type);
+
+    FreeCall(call);
+}
+
+void TSInt_CompleteAsyncCall (
+                              struct tsint_async_call* call,
+                              int                      error,
+                              union tsffi_value*       output
+                             )
+{
+    TSInt_LockMutex(&call->call_sync);
+
+    if(call->flags&TSINT_ASYNC_CALL_FLAG_ABANDONED)
+    {
+        TSInt_UnlockMutex(&call->call_sync);
+
+        if(error == TSFFI_ERROR_NONE && output != NULL)
+            TSInt_DestroyFFIArgument(*output, call->output_type);
+
+        FreeCall(call);
+
+        return;
+    }
+
+    call->error = error;
+
+    if(error == TSFFI_ERROR_NONE && output != NULL)
+        call->output = *output;
+    else
+        call->output.string_data = NULL;
+
+    call->flags |= TSINT_ASYNC_CALL_FLAG_COMPLETED;
+
+    if(call->flags&TSINT_ASYNC_CALL_FLAG_BLOCKING)
+    {
+        struct tsint_module_sync_data* sync_data;
+
+        /* The waiter frees the call once the post arrives */
+        sync_data = call->unit_state->module_state->sync_data;
+
+        TSInt_UnlockMutex(&call->call_sync);
+
+        TSInt_SignalAction(sync_data);
+        TSInt_PostSemaphore(&call->completion_signal, 1);
+
+        return;
+    }
+
+    TSInt_ResumeUnit(call->unit_state);
+
+    TSInt_UnlockMutex(&call->call_sync);
+}
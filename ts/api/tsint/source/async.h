@@ -0,0 +1,56 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#ifndef _TSINT_ASYNC_H_
+#define _TSINT_ASYNC_H_
+
+
+#include "sync.h"
+
+#include <tsdef/def.h>
+#include <tsffi/function.h>
+#include <tsint/module.h>
+
+
+#define TSINT_ASYNC_CALL_FLAG_COMPLETED 0x01
+#define TSINT_ASYNC_CALL_FLAG_ABANDONED 0x02
+
+
+struct tsint_async_call
+{
+    struct tsint_unit_state* unit_state;
+    struct tsdef_assignment* assignment;
+    unsigned int             output_type;
+
+    tsint_mutex     call_sync;
+    tsint_semaphore completion_signal;
+
+    unsigned int      flags;
+    int               error;
+    union tsffi_value output;
+};
+
+
+extern struct tsdef_function_call* TSInt_AsyncCallOfExp (struct tsdef_exp*);
+
+extern int  TSInt_InvokeAsyncFunction (
+                                       struct tsdef_function_call*,
+                                       struct tsint_unit_state*,
+                                       union tsffi_value*
+                                      );
+extern int  TSInt_StartAsyncCall      (
+                                       struct tsdef_function_call*,
+                                       struct tsdef_assignment*,
+                                       struct tsint_unit_state*
+                                      );
+extern int  TSInt_FinishAsyncCall     (struct tsint_unit_state*);
+extern void TSInt_AbandonAsyncCall    (struct tsint_unit_state*);
+extern void TSInt_CompleteAsyncCall   (struct tsint_async_call*, int, union tsffi_value*);
+
+
+#endif
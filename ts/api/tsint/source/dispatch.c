@@ -0,0 +1,548 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#include "dispatch.h"
+#include "unit.h"
+#include "action.h"
+
+#include <tsint/error.h>
+#include <tsint/exception.h>
+#include <tsint/controller.h>
+#include <tsffi/register.h>
+
+#include <stdlib.h>
+#include <malloc.h>
+
+
+#define INITIAL_CAPACITY 16
+
+
+static int                      PushTask  (struct tsint_dispatch_worker*, struct tsint_unit_state*);
+static struct tsint_unit_state* PopTask   (struct tsint_dispatch_worker*);
+static struct tsint_unit_state* StealTask (struct tsint_dispatch_worker*);
+static struct tsint_unit_state* TakeTask  (struct tsint_dispatch_pool*, unsigned int);
+
+static void RunUnitTask  (struct tsint_dispatch_pool*, struct tsint_unit_state*);
+static void RunTasks     (struct tsint_dispatch_pool*, unsigned int);
+static void WorkerThread (void*);
+
+static void StopWorkers (struct tsint_dispatch_pool*, unsigned int);
+
+
+static int PushTask (struct tsint_dispatch_worker* worker, struct tsint_unit_state* unit_state)
+{
+    int error;
+
+    error = TSINT_ERROR_NONE;
+
+    TSInt_LockMutex(&worker->task_sync);
+
+    if(worker->task_count == worker->task_capacity)
+    {
+        struct tsint_unit_state** tasks;
+        unsigned int              capacity;
+        unsigned int              index;
+
+        capacity = worker->task_capacity > 0 ? worker->task_capacity*2 : INITIAL_CAPACITY;
+
+        tasks = malloc(sizeof(struct tsint_unit_state*)*capacity);
+        if(tasks == NULL)
+        {
+            error = TSINT_ERROR_MEMORY;
+
+            goto allocate_tasks_failed;
+        }
+
+        for(index = 0; index < worker->task_count; index++)
+            tasks[index] = worker->tasks[(worker->first_task+index)%worker->task_capacity];
+
+        free(worker->tasks);
+
+        worker->tasks         = tasks;
+        worker->task_capacity = capacity;
+        worker->first_task    = 0;
+    }
+
+    worker->tasks[(worker->first_task+worker->task_count)%worker->task_capacity] = unit_state;
+    worker->task_count++;
+
+allocate_tasks_failed:
+    TSInt_UnlockMutex(&worker->task_sync);
+
+    return error;
+}
+
+static struct tsint_unit_state* PopTask (struct tsint_dispatch_worker* worker)
+{
+    struct tsint_unit_state* unit_state;
+
+    unit_state = NULL;
+
+    TSInt_LockMutex(&worker->task_sync);
+
+    if(worker->task_count > 0)
+    {
+        worker->task_count--;
+
+        unit_state = worker->tasks[(worker->first_task+worker->task_count)%worker->task_capacity];
+    }
+
+    TSInt_UnlockMutex(&worker->task_sync);
+
+    return unit_state;
+}
+
+static struct tsint_unit_state* StealTask (struct tsint_dispatch_worker* worker)
+{
+    struct tsint_unit_state* unit_state;
+
+    unit_state = NULL;
+
+    TSInt_LockMutex(&worker->task_sync);
+
+    if(worker->task_count > 0)
+    {
+        unit_state = worker->tasks[worker->first_task];
+
+        worker->first_task = (worker->first_task+1)%worker->task_capacity;
+        worker->task_count--;
+    }
+
+    TSInt_UnlockMutex(&worker->task_sync);
+
+    return unit_state;
+}
+
+static struct tsint_unit_state* TakeTask (struct tsint_dispatch_pool* pool, unsigned int worker_index)
+{
+    struct tsint_unit_state* unit_state;
+    unsigned int             offset;
+
+    /* Own work is taken newest first, stolen work oldest first */
+    unit_state = PopTask(&pool->workers[worker_index]);
+    if(unit_state != NULL)
+        return unit_state;
+
+    for(offset = 1; offset < pool->worker_count; offset++)
+    {
+        unit_state = StealTask(&pool->workers[(worker_index+offset)%pool->worker_count]);
+        if(unit_state != NULL)
+            return unit_state;
+    }
+
+    return NULL;
+}
+
+static void RunUnitTask (struct tsint_dispatch_pool* pool, struct tsint_unit_state* unit_state)
+{
+    struct tsint_action_state* action_state;
+
+    action_state = unit_state->dispatched_actions;
+
+    unit_state->dispatched_actions     = NULL;
+    unit_state->last_dispatched_action = NULL;
+
+    while(action_state != NULL && pool->exception == TSINT_EXCEPTION_NONE)
+    {
+        struct tsint_action_state* next_action;
+        unsigned int               finished;
+
+        next_action = action_state->next_dispatched_action;
+
+        TSInt_LockMutex(&pool->state_sync);
+
+        finished = action_state->flags&TSINT_ACTION_STATE_FLAG_FINISHED;
+
+        TSInt_UnlockMutex(&pool->state_sync);
+
+        if(!finished)
+        {
+            int mode;
+            int exception;
+
+            mode      = TSINT_CONTROL_RUN;
+            exception = TSInt_ProcessUnitAction(action_state, &mode);
+            if(exception != TSINT_EXCEPTION_NONE)
+            {
+                TSInt_AtomicCompareExchange(&pool->exception, exception, TSINT_EXCEPTION_NONE);
+
+                break;
+            }
+
+            /* A stopped unit is only retired, so its state is still
+               readable until the batch ends */
+            if(unit_state->flags&TSINT_UNIT_STATE_FLAG_STOPPED)
+                break;
+        }
+
+        action_state = next_action;
+    }
+
+    if(TSInt_AtomicAdd(&pool->remaining_units, -1) == 1)
+        TSInt_PostSemaphore(&pool->finish_signal, 1);
+}
+
+static void RunTasks (struct tsint_dispatch_pool* pool, unsigned int worker_index)
+{
+    struct tsint_unit_state* unit_state;
+
+    unit_state = TakeTask(pool, worker_index);
+    while(unit_state != NULL)
+    {
+        RunUnitTask(pool, unit_state);
+
+        unit_state = TakeTask(pool, worker_index);
+    }
+}
+
+static void WorkerThread (void* user_data)
+{
+    struct tsint_dispatch_worker* worker;
+    struct tsint_dispatch_pool*   pool;
+
+    worker = user_data;
+    pool   = worker->pool;
+
+    while(1)
+    {
+        TSInt_WaitSemaphore(&pool->start_signal);
+
+        if(pool->flags&TSINT_DISPATCH_POOL_FLAG_SHUTDOWN)
+            break;
+
+        RunTasks(pool, (unsigned int)(worker-pool->workers));
+    }
+}
+
+static void StopWorkers (struct tsint_dispatch_pool* pool, unsigned int started_count)
+{
+    unsigned int index;
+
+    TSInt_AtomicExchange(&pool->flags, TSINT_DISPATCH_POOL_FLAG_SHUTDOWN);
+    TSInt_PostSemaphore(&pool->start_signal, started_count);
+
+    for(index = 1; index <= started_count; index++)
+        TSInt_JoinThread(pool->workers[index].thread);
+}
+
+
+int TSInt_AllocDispatchPool (
+                             struct tsint_module_state*   module_state,
+                             unsigned int                 worker_count,
+                             struct tsint_dispatch_pool** pool
+                            )
+{
+    struct tsint_dispatch_pool* allocated_pool;
+    unsigned int                index;
+    int                         error;
+
+    allocated_pool = malloc(sizeof(struct tsint_dispatch_pool));
+    if(allocated_pool == NULL)
+        return TSINT_ERROR_MEMORY;
+
+    allocated_pool->workers = malloc(sizeof(struct tsint_dispatch_worker)*worker_count);
+    if(allocated_pool->workers == NULL)
+    {
+        error = TSINT_ERROR_MEMORY;
+
+        goto allocate_workers_failed;
+    }
+
+    error = TSInt_InitializeMutex(&allocated_pool->state_sync);
+    if(error != TSINT_ERROR_NONE)
+        goto initialize_state_sync_failed;
+
+    error = TSInt_InitializeMutex(&allocated_pool->ffi_sync);
+    if(error != TSINT_ERROR_NONE)
+        goto initialize_ffi_sync_failed;
+
+    error = TSInt_InitializeMutex(&allocated_pool->controller_sync);
+    if(error != TSINT_ERROR_NONE)
+        goto initialize_controller_sync_failed;
+
+    error = TSInt_InitializeSemaphore(&allocated_pool->start_signal);
+    if(error != TSINT_ERROR_NONE)
+        goto initialize_start_signal_failed;
+
+    error = TSInt_InitializeSemaphore(&allocated_pool->finish_signal);
+    if(error != TSINT_ERROR_NONE)
+        goto initialize_finish_signal_failed;
+
+    allocated_pool->module_state    = module_state;
+    allocated_pool->flags           = 0;
+    allocated_pool->remaining_units = 0;
+    allocated_pool->exception       = TSINT_EXCEPTION_NONE;
+    allocated_pool->batch_units     = NULL;
+    allocated_pool->batch_capacity  = 0;
+    allocated_pool->retired_units   = NULL;
+    allocated_pool->worker_count    = worker_count;
+
+    for(index = 0; index < worker_count; index++)
+    {
+        struct tsint_dispatch_worker* worker;
+
+        worker = &allocated_pool->workers[index];
+
+        error = TSInt_InitializeMutex(&worker->task_sync);
+        if(error != TSINT_ERROR_NONE)
+            goto initialize_task_sync_failed;
+
+        worker->pool          = allocated_pool;
+        worker->tasks         = NULL;
+        worker->task_capacity = 0;
+        worker->first_task    = 0;
+        worker->task_count    = 0;
+    }
+
+    /* The module thread works the first queue itself */
+    for(index = 1; index < worker_count; index++)
+    {
+        struct tsint_dispatch_worker* worker;
+
+        worker = &allocated_pool->workers[index];
+
+        error = TSInt_StartThread(&WorkerThread, worker, &worker->thread);
+        if(error != TSINT_ERROR_NONE)
+            goto start_thread_failed;
+    }
+
+    *pool = allocated_pool;
+
+    return TSINT_ERROR_NONE;
+
+start_thread_failed:
+    StopWorkers(allocated_pool, index-1);
+
+    index = worker_count;
+
+initialize_task_sync_failed:
+    while(index--)
+        TSInt_DestroyMutex(&allocated_pool->workers[index].task_sync);
+
+    TSInt_DestroySemaphore(&allocated_pool->finish_signal);
+initialize_finish_signal_failed:
+    TSInt_DestroySemaphore(&allocated_pool->start_signal);
+initialize_start_signal_failed:
+    TSInt_DestroyMutex(&allocated_pool->controller_sync);
+initialize_controller_sync_failed:
+    TSInt_DestroyMutex(&allocated_pool->ffi_sync);
+initialize_ffi_sync_failed:
+    TSInt_DestroyMutex(&allocated_pool->state_sync);
+initialize_state_sync_failed:
+    free(allocated_pool->workers);
+allocate_workers_failed:
+    free(allocated_pool);
+
+    return error;
+}
+
+void TSInt_FreeDispatchPool (struct tsint_dispatch_pool* pool)
+{
+    unsigned int index;
+
+    StopWorkers(pool, pool->worker_count-1);
+
+    TSInt_ReleaseRetiredUnits(pool);
+
+    for(index = 0; index < pool->worker_count; index++)
+    {
+        TSInt_DestroyMutex(&pool->workers[index].task_sync);
+        free(pool->workers[index].tasks);
+    }
+
+    TSInt_DestroySemaphore(&pool->finish_signal);
+    TSInt_DestroySemaphore(&pool->start_signal);
+    TSInt_DestroyMutex(&pool->controller_sync);
+    TSInt_DestroyMutex(&pool->ffi_sync);
+    TSInt_DestroyMutex(&pool->state_sync);
+
+    free(pool->batch_units);
+    free(pool->workers);
+    free(pool);
+}
+
+int TSInt_DispatchSignaledActions (struct tsint_dispatch_pool* pool)
+{
+    struct tsint_action_state* action_state;
+    unsigned int               unit_count;
+    unsigned int               wake_count;
+    unsigned int               index;
+
+    /* Group the batch by unit instance so that actions of one unit stay
+       serialized while different units run concurrently */
+    unit_count = 0;
+
+    action_state = TSInt_TakeSignaledAction(pool->module_state);
+    while(action_state != NULL)
+    {
+        struct tsint_unit_state* unit_state;
+
+        unit_state = action_state->unit_state;
+
+        action_state->next_dispatched_action = NULL;
+
+        if(unit_state->dispatched_actions == NULL)
+        {
+            if(unit_count == pool->batch_capacity)
+            {
+                struct tsint_unit_state** batch_units;
+                unsigned int              capacity;
+
+                capacity = pool->batch_capacity > 0 ? pool->batch_capacity*2 : INITIAL_CAPACITY;
+
+                batch_units = realloc(pool->batch_units, sizeof(struct tsint_unit_state*)*capacity);
+                if(batch_units == NULL)
+                    return TSINT_EXCEPTION_OUT_OF_MEMORY;
+
+                pool->batch_units    = batch_units;
+                pool->batch_capacity = capacity;
+            }
+
+            pool->batch_units[unit_count] = unit_state;
+            unit_count++;
+
+            unit_state->dispatched_actions = action_state;
+        }
+        else
+            unit_state->last_dispatched_action->next_dispatched_action = action_state;
+
+        unit_state->last_dispatched_action = action_state;
+
+        action_state = TSInt_TakeSignaledAction(pool->module_state);
+    }
+
+    if(unit_count == 0)
+        return TSINT_EXCEPTION_NONE;
+
+    pool->exception       = TSINT_EXCEPTION_NONE;
+    pool->remaining_units = unit_count;
+    pool->flags          |= TSINT_DISPATCH_POOL_FLAG_DISPATCHING;
+
+    for(index = 0; index < unit_count; index++)
+    {
+        int error;
+
+        error = PushTask(&pool->workers[index%pool->worker_count], pool->batch_units[index]);
+        if(error != TSINT_ERROR_NONE)
+            RunUnitTask(pool, pool->batch_units[index]);
+    }
+
+    wake_count = unit_count-1;
+    if(wake_count > pool->worker_count-1)
+        wake_count = pool->worker_count-1;
+
+    TSInt_PostSemaphore(&pool->start_signal, wake_count);
+
+    RunTasks(pool, 0);
+
+    TSInt_WaitSemaphore(&pool->finish_signal);
+
+    pool->flags &= ~TSINT_DISPATCH_POOL_FLAG_DISPATCHING;
+
+    TSInt_ReleaseRetiredUnits(pool);
+
+    return pool->exception;
+}
+
+void TSInt_RetireUnit (struct tsint_dispatch_pool* pool, struct tsint_unit_state* unit_state)
+{
+    if(!(pool->flags&TSINT_DISPATCH_POOL_FLAG_DISPATCHING))
+    {
+        free(unit_state->trigger_user_data);
+        free(unit_state);
+
+        return;
+    }
+
+    TSInt_LockMutex(&pool->state_sync);
+
+    unit_state->flags            |= TSINT_UNIT_STATE_FLAG_STOPPED;
+    unit_state->next_retired_unit = pool->retired_units;
+    pool->retired_units           = unit_state;
+
+    TSInt_UnlockMutex(&pool->state_sync);
+}
+
+void TSInt_ReleaseRetiredUnits (struct tsint_dispatch_pool* pool)
+{
+    struct tsint_unit_state* unit_state;
+
+    unit_state = pool->retired_units;
+    while(unit_state != NULL)
+    {
+        struct tsint_unit_state* free_unit_state;
+
+        free_unit_state = unit_state;
+        unit_state      = unit_state->next_retired_unit;
+
+        free(free_unit_state->trigger_user_data);
+        free(free_unit_state);
+    }
+
+    pool->retired_units = NULL;
+}
+
+void TSInt_LockModuleState (struct tsint_module_state* module_state)
+{
+    if(module_state->dispatch_pool != NULL)
+        TSInt_LockMutex(&module_state->dispatch_pool->state_sync);
+}
+
+void TSInt_UnlockModuleState (struct tsint_module_state* module_state)
+{
+    if(module_state->dispatch_pool != NULL)
+        TSInt_UnlockMutex(&module_state->dispatch_pool->state_sync);
+}
+
+void TSInt_LockFFIGroup (
+                         struct tsint_module_state*     module_state,
+                         struct tsdef_module_ffi_group* ffi_group
+                        )
+{
+    if(module_state->dispatch_pool == NULL)
+        return;
+
+    if(!(ffi_group->group->flags&TSFFI_GROUP_FLAG_THREAD_SAFE))
+        TSInt_LockMutex(&module_state->dispatch_pool->ffi_sync);
+}
+
+void TSInt_UnlockFFIGroup (
+                           struct tsint_module_state*     module_state,
+                           struct tsdef_module_ffi_group* ffi_group
+                          )
+{
+    if(module_state->dispatch_pool == NULL)
+        return;
+
+    if(!(ffi_group->group->flags&TSFFI_GROUP_FLAG_THREAD_SAFE))
+        TSInt_UnlockMutex(&module_state->dispatch_pool->ffi_sync);
+}
+
+void TSInt_LockFFIGroups (struct tsint_module_state* module_state)
+{
+    if(module_state->dispatch_pool != NULL)
+        TSInt_LockMutex(&module_state->dispatch_pool->ffi_sync);
+}
+
+void TSInt_UnlockFFIGroups (struct tsint_module_state* module_state)
+{
+    if(module_state->dispatch_pool != NULL)
+        TSInt_UnlockMutex(&module_state->dispatch_pool->ffi_sync);
+}
+
+void TSInt_LockController (struct tsint_module_state* module_state)
+{
+    if(module_state->dispatch_pool != NULL)
+        TSInt_LockMutex(&module_state->dispatch_pool->controller_sync);
+}
+
+void TSInt_UnlockController (struct tsint_module_state* module_state)
+{
+    if(module_state->dispatch_pool != NULL)
+        TSInt_UnlockMutex(&module_state->dispatch_pool->controller_sync);
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#ifndef _TSINT_DISPATCH_H_
+#define _TSINT_DISPATCH_H_
+
+
+#include "sync.h"
+
+#include <tsdef/module.h>
+#include <tsint/module.h>
+
+
+#define TSINT_DISPATCH_POOL_FLAG_SHUTDOWN    0x01
+#define TSINT_DISPATCH_POOL_FLAG_DISPATCHING 0x02
+
+
+struct tsint_dispatch_worker
+{
+    struct tsint_dispatch_pool* pool;
+    tsint_thread                thread;
+
+    tsint_mutex               task_sync;
+    struct tsint_unit_state** tasks;
+    unsigned int              task_capacity;
+    unsigned int              first_task;
+    unsigned int              task_count;
+};
+
+struct tsint_dispatch_pool
+{
+    struct tsint_module_state* module_state;
+
+    tsint_mutex state_sync;
+    tsint_mutex ffi_sync;
+    tsint_mutex controller_sync;
+
+    tsint_semaphore start_signal;
+    tsint_semaphore finish_signal;
+
+    volatile long flags;
+    volatile long remaining_units;
+    volatile long exception;
+
+    struct tsint_unit_state** batch_units;
+    unsigned int              batch_capacity;
+
+    struct tsint_unit_state* retired_units;
+
+    unsigned int                  worker_count;
+    struct tsint_dispatch_worker* workers;
+};
+
+
+extern int  TSInt_AllocDispatchPool (
+                                     struct tsint_module_state*,
+                                     unsigned int,
+                                     struct tsint_dispatch_pool**
+                                    );
+extern void TSInt_FreeDispatchPool  (struct tsint_dispatch_pool*);
+
+extern int  TSInt_DispatchSignaledActions (struct tsint_dispatch_pool*);
+extern void TSInt_RetireUnit              (struct tsint_dispatch_pool*, struct tsint_unit_state*);
+extern void TSInt_ReleaseRetiredUnits     (struct tsint_dispatch_pool*);
+
+extern void TSInt_LockModuleState   (struct tsint_module_state*);
+extern void TSInt_UnlockModuleState (struct tsint_module_state*);
+extern void TSInt_LockFFIGroup      (struct tsint_module_state*, struct tsdef_module_ffi_group*);
+extern void TSInt_UnlockFFIGroup    (struct tsint_module_state*, struct tsdef_module_ffi_group*);
+extern void TSInt_LockFFIGroups     (struct tsint_module_state*);
+extern void TSInt_UnlockFFIGroups   (struct tsint_module_state*);
+extern void TSInt_LockController    (struct tsint_module_state*);
+extern void TSInt_UnlockController  (struct tsint_module_state*);
+
+
+#endif
@@ -10,6 +10,8 @@
 #include "expeval.h"
 #include "unit.h"
 #include "ffi.h"
+#include "async.h"
+#include "dispatch.h"
 
 #include <tsdef/module.h>
 #include <tsdef/ffi.h>
@@ -63,6 +65,10 @@ static int ExecuteFunction (
         int                mode;
         int                original_mode;
 
+        exception = TSInt_ResolveDeferredUnit(module_object, module_state);
+        if(exception != TSINT_EXCEPTION_NONE)
+            return exception;
+
         unit = module_object->type.unit;
 
         exception = TSInt_ExpListToValueArray(
@@ -82,7 +88,8 @@ static int ExecuteFunction (
                                      arguments,
                                      &function_output,
                                      &mode,
-                                     module_state
+                                     module_state,
+                                     unit_state
                                     );
         if(original_mode != mode)
             unit_state->mode = mode;
@@ -105,40 +112,55 @@ static int ExecuteFunction (
         ffi_function = module_object->type.ffi.function_definition;
         ffi_group    = module_object->type.ffi.group;
 
-        exception = TSInt_ExpListToFFIArguments(
-                                                function_call->arguments,
-                                                ffi_function->argument_types,
-                                                unit_state,
-                                                &ffi_arguments
-                                               );
-        if(exception != TSINT_EXCEPTION_NONE)
-            return exception;
-
-        invocation_data.execif             = module_state->module_execif;
-        invocation_data.execif_data        = module_state;
-        invocation_data.unit_invocation_id = unit_state->unit_id;
-        invocation_data.unit_name          = unit_state->unit->name;
-
-        if(unit_state->current_statement != NULL)
-            invocation_data.unit_location = unit_state->current_statement->location;
+        if(ffi_function->async_function != NULL)
+        {
+            exception = TSInt_InvokeAsyncFunction(function_call, unit_state, &ffi_output);
+            if(exception != TSINT_EXCEPTION_NONE)
+                return exception;
+        }
         else
-            invocation_data.unit_location = 0;
-
-        exception = ffi_function->function(
-                                           &invocation_data,
-                                           module_state->ffi_group_data[ffi_group->group_id],
-                                           &ffi_output,
-                                           ffi_arguments
-                                          );
-
-        TSInt_DestroyFFIArguments(
-                                  ffi_function->argument_types,
-                                  ffi_function->argument_count,
-                                  ffi_arguments
-                                 );
+        {
+            exception = TSInt_ExpListToFFIArguments(
+                                                    function_call->arguments,
+                                                    ffi_function->argument_types,
+                                                    unit_state,
+                                                    &ffi_arguments
+                                                   );
+            if(exception != TSINT_EXCEPTION_NONE)
+                return exception;
+
+            invocation_data.execif             = module_state->module_execif;
+            invocation_data.execif_data        = module_state;
+            invocation_data.unit_invocation_id = unit_state->unit_id;
+            invocation_data.unit_name          = unit_state->unit->name;
+
+            if(unit_state->current_statement != NULL)
+                invocation_data.unit_location = unit_state->current_statement->location;
+            else
+                invocation_data.unit_location = 0;
+
+            invocation_data.suspend_data = NULL;
+
+            TSInt_LockFFIGroup(module_state, ffi_group);
+
+            exception = ffi_function->function(
+                                               &invocation_data,
+                                               module_state->ffi_group_data[ffi_group->group_id],
+                                               &ffi_output,
+                                               ffi_arguments
+                                              );
+
+            TSInt_UnlockFFIGroup(module_state, ffi_group);
+
+            TSInt_DestroyFFIArguments(
+                                      ffi_function->argument_types,
+                                      ffi_function->argument_count,
+                                      ffi_arguments
+                                     );
 
-        if(exception != TSFFI_ERROR_NONE)
-            return TSINT_EXCEPTION_FFI;
+            if(exception != TSFFI_ERROR_NONE)
+                return TSINT_EXCEPTION_FFI;
+        }
 
         output_type = ffi_function->output_type;
 
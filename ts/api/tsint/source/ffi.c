@@ -117,8 +117,9 @@ int TSInt_ExpListToFFIArguments (
 {
     union tsffi_value*          ffi_arguments;
     union tsffi_value*          original_ffi_arguments;
-    struct tsdef_exp_list_node* exp_node;
+    struct tsdef_exp**          exps;
     size_t                      alloc_size;
+    unsigned int                index;
     int                         exception;
 
     if(exp_list == NULL)
@@ -135,7 +136,8 @@ int TSInt_ExpListToFFIArguments (
 
     original_ffi_arguments = ffi_arguments;
 
-    for(exp_node = exp_list->start; exp_node != NULL; exp_node = exp_node->next_exp)
+    exps = exp_list->exps;
+    for(index = 0; index < exp_list->count; index++)
     {
         union tsint_value def_value;
         unsigned int      def_type;
@@ -144,7 +146,7 @@ int TSInt_ExpListToFFIArguments (
 
         exception = TSInt_EvaluateExp(
                                       def_type,
-                                      exp_node->exp,
+                                      exps[index],
                                       state,
                                       &def_value
                                      );
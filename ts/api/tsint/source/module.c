@@ -13,6 +13,9 @@
 
 #include "sync.h"
 #include "unit.h"
+#include "action.h"
+#include "async.h"
+#include "dispatch.h"
 #include "block.h"
 #include "statement.h"
 
@@ -20,15 +23,46 @@
 #include <malloc.h>
 
 
+#define WAIT_POLL_INTERVAL 64
+
+
 static void  Alert            (void*, unsigned int, char*);
 static void  SetExceptionText (void*, char*);
 static void* AllocateMemory   (void*, size_t);
 static void  FreeMemory       (void*, void*);
 
-static int ChangeState (struct tsint_module_state*, unsigned int);
+static void* WatchHandle        (void*, tsffi_wait_handle, tsffi_reactor_callback, void*);
+static void* StartTimer         (void*, unsigned int, unsigned int, tsffi_reactor_callback, void*);
+static void  CancelRegistration (void*, void*);
+
+static void* SuspendUnit (struct tsffi_invocation_data*, tsffi_suspend_cancel, void*);
+static void  ResumeUnit  (void*, void*);
+
+static void CompleteFunction (void*, void*, int, union tsffi_value*);
+
+static void SignalActions (void*, void**, unsigned int);
+static int  ReadClock     (void*, unsigned int*);
+
+static int ChangeState   (struct tsint_module_state*, unsigned int);
+static int WaitForAction (struct tsint_module_state*, struct tsint_wait_policy*);
 
 
-static struct tsffi_execif tsint_module_execif = {NULL, &Alert, &SetExceptionText, &AllocateMemory, &FreeMemory};
+static struct tsffi_execif tsint_module_execif = {
+                                                  NULL,
+                                                  &Alert,
+                                                  &SetExceptionText,
+                                                  &AllocateMemory,
+                                                  &FreeMemory,
+                                                  &WatchHandle,
+                                                  &StartTimer,
+                                                  &CancelRegistration,
+                                                  &SuspendUnit,
+                                                  &ResumeUnit,
+                                                  &CompleteFunction,
+                                                  NULL,
+                                                  &SignalActions,
+                                                  &ReadClock
+                                                 };
 
 
 static void Alert (void* user_data, unsigned int alert_severity, char* text)
@@ -73,22 +107,119 @@ static void FreeMemory (void* user_data, void* memory)
     free(memory);
 }
 
+static void* WatchHandle (
+                          void*                  user_data,
+                          tsffi_wait_handle      handle,
+                          tsffi_reactor_callback callback,
+                          void*                  callback_data
+                         )
+{
+    struct tsint_module_state* module_state;
+    void*                      registration;
+
+    module_state = user_data;
+
+    TSInt_LockModuleState(module_state);
+
+    registration = TSInt_WatchHandle(module_state->sync_data, handle, callback, callback_data);
+
+    TSInt_UnlockModuleState(module_state);
+
+    return registration;
+}
+
+static void* StartTimer (
+                         void*                  user_data,
+                         unsigned int           milliseconds,
+                         unsigned int           timer_flags,
+                         tsffi_reactor_callback callback,
+                         void*                  callback_data
+                        )
+{
+    struct tsint_module_state* module_state;
+    void*                      registration;
+
+    module_state = user_data;
+
+    TSInt_LockModuleState(module_state);
+
+    registration = TSInt_StartTimer(module_state->sync_data, milliseconds, timer_flags, callback, callback_data);
+
+    TSInt_UnlockModuleState(module_state);
+
+    return registration;
+}
+
+static void CancelRegistration (void* user_data, void* registration)
+{
+    struct tsint_module_state* module_state;
+
+    module_state = user_data;
+
+    TSInt_LockModuleState(module_state);
+    TSInt_CancelRegistration(module_state->sync_data, registration);
+    TSInt_UnlockModuleState(module_state);
+}
+
+static void* SuspendUnit (
+                          struct tsffi_invocation_data* invocation_data,
+                          tsffi_suspend_cancel          cancel,
+                          void*                         cancel_data
+                         )
+{
+    return TSInt_SuspendUnit(invocation_data->suspend_data, cancel, cancel_data);
+}
+
+static void ResumeUnit (void* user_data, void* resume_token)
+{
+    TSInt_ResumeUnit(resume_token);
+}
+
+static void CompleteFunction (
+                              void*              user_data,
+                              void*              completion_token,
+                              int                error,
+                              union tsffi_value* output
+                             )
+{
+    TSInt_CompleteAsyncCall(completion_token, error, output);
+}
+
+static void SignalActions (void* user_data, void** action_data, unsigned int action_count)
+{
+    TSInt_QueueActions((struct tsint_action_state**)action_data, action_count);
+}
+
+static int ReadClock (void* user_data, unsigned int* clock)
+{
+    struct tsint_module_state* module_state;
+    struct tsint_reactor*      reactor;
+
+    module_state = user_data;
+    reactor      = &module_state->sync_data->reactor;
+
+    *clock = TSInt_ReadReactorClock(reactor);
+
+    if(reactor->flags&TSINT_REACTOR_FLAG_VIRTUAL_TIME)
+        return TSFFI_CLOCK_VIRTUAL;
+
+    return TSFFI_CLOCK_REAL;
+}
+
 static int ChangeState (
                         struct tsint_module_state* module_state,
                         unsigned int               changed_state
                        )
 {
     struct tsdef_module_ffi_group* module_group;
-    struct tsdef_module*           module;
     struct tsffi_execif*           execif;
     void**                         ffi_group_data;
 
-    module         = module_state->module;
     execif         = module_state->module_execif;
     ffi_group_data = module_state->ffi_group_data;
 
     for(
-        module_group = module->referenced_ffi_groups;
+        module_group = module_state->started_ffi_groups;
         module_group != NULL;
         module_group = module_group->next_group
        )
@@ -116,6 +247,72 @@ static int ChangeState (
     return TSFFI_ERROR_NONE;
 }
 
+static int WaitForAction (
+                          struct tsint_module_state* module_state,
+                          struct tsint_wait_policy*  wait_policy
+                         )
+{
+    struct tsint_module_sync_data* sync_data;
+    int                            error;
+
+    sync_data = module_state->sync_data;
+
+    /* Actions signaled while the last batch ran are handled right away,
+       without telling the groups the module slept, but ready watches and
+       timers still get a zero timeout sweep so they aren't starved */
+    if(module_state->signal_queue != NULL)
+        return TSInt_PollForAction(sync_data);
+
+    if(
+       wait_policy != NULL &&
+       (wait_policy->mode == TSINT_WAIT_SPIN || wait_policy->mode == TSINT_WAIT_POLL)
+      )
+    {
+        unsigned long long start_time;
+        unsigned long long spin_time;
+        unsigned int       spin_count;
+
+        /* The tick clock is too coarse for millisecond spin budgets */
+        start_time = TSInt_ReadPreciseClock();
+        spin_time  = (unsigned long long)wait_policy->spin_time*1000;
+        spin_count = 0;
+
+        while(module_state->signal_queue == NULL)
+        {
+            TSInt_PauseProcessor();
+
+            spin_count++;
+            if(spin_count%WAIT_POLL_INTERVAL != 0)
+                continue;
+
+            error = TSInt_PollForAction(sync_data);
+            if(error != TSINT_EXCEPTION_NONE)
+                return error;
+
+            if(
+               wait_policy->mode == TSINT_WAIT_SPIN &&
+               TSInt_ReadPreciseClock()-start_time >= spin_time
+              )
+            {
+                break;
+            }
+        }
+
+        if(module_state->signal_queue != NULL)
+            return TSInt_PollForAction(sync_data);
+    }
+
+    error = ChangeState(module_state, TSFFI_MODULE_SLEEPING);
+    if(error != TSFFI_ERROR_NONE)
+        return error;
+
+    error = TSInt_ListenForAction(sync_data, TSINT_LISTEN_FLAG_ADVANCE_CLOCK);
+    if(error != TSINT_EXCEPTION_NONE)
+        return error;
+
+    return ChangeState(module_state, TSFFI_MODULE_RUNNING);
+}
+
 
 int TSInt_AllocAbortSignal (struct tsint_module_abort_signal** abort_signal)
 {
@@ -161,7 +358,9 @@ int TSInt_InterpretModule (
                            union tsint_value*                output,
                            struct tsint_controller_data*     controller_data,
                            struct tsint_execif_data*         execif_data,
-                           struct tsint_module_abort_signal* abort_signal
+                           struct tsint_module_abort_signal* abort_signal,
+                           unsigned int                      worker_count,
+                           struct tsint_wait_policy*         wait_policy
                           )
 {
     struct tsint_module_state      state;
@@ -180,15 +379,28 @@ int TSInt_InterpretModule (
     if(error != TSINT_ERROR_NONE)
         goto initialize_sync_data_failed;
 
-    state.module           = module;
-    state.controller_data  = controller_data;
-    state.user_execif_data = execif_data;
-    state.module_execif    = &tsint_module_execif;
-    state.sync_data        = &sync_data;
-    state.next_unit_id     = 1;
-    state.active_units     = NULL;
-    state.pending_actions  = NULL;
-    state.signaled_actions = NULL;
+    if(wait_policy != NULL && wait_policy->mode == TSINT_WAIT_VIRTUAL_TIME)
+        TSInt_UseVirtualClock(&sync_data.reactor);
+
+    state.module             = module;
+    state.controller_data    = controller_data;
+    state.user_execif_data   = execif_data;
+    state.module_execif      = &tsint_module_execif;
+    state.sync_data          = &sync_data;
+    state.dispatch_pool      = NULL;
+    state.next_unit_id       = 1;
+    state.ffi_group_data     = NULL;
+    state.started_ffi_groups = module->referenced_ffi_groups;
+    state.active_units       = NULL;
+    state.signal_queue       = NULL;
+    state.signaled_actions   = NULL;
+
+    if(worker_count > 1)
+    {
+        error = TSInt_AllocDispatchPool(&state, worker_count, &state.dispatch_pool);
+        if(error != TSINT_ERROR_NONE)
+            goto alloc_dispatch_pool_failed;
+    }
 
     if(module->registered_ffi_group_count > 0)
     {
@@ -233,48 +445,45 @@ int TSInt_InterpretModule (
         }
     }
 
-    error = TSInt_InvokeUnit(module->main_unit, arguments, output, &mode, &state);
+    error = TSInt_InvokeUnit(module->main_unit, arguments, output, &mode, &state, NULL);
     if(error != TSINT_EXCEPTION_NONE)
         goto unit_exception;
 
     while(state.active_units != NULL)
     {
-        struct tsint_action_state* signaled_actions;
         struct tsint_action_state* current_action;
 
-        error = ChangeState(&state, TSFFI_MODULE_SLEEPING);
-        if(error != TSFFI_ERROR_NONE)
-            goto unit_exception;
-
-        error = TSInt_ListenForAction(state.sync_data);
+        error = WaitForAction(&state, wait_policy);
         if(error != TSINT_EXCEPTION_NONE)
             goto unit_exception;
 
-        error = ChangeState(&state, TSFFI_MODULE_RUNNING);
-        if(error != TSFFI_ERROR_NONE)
-            goto unit_exception;
-
-        TSInt_LockActionStateSync(&sync_data);
         TSInt_ClearSignal(state.sync_data);
+        TSInt_CollectSignaledActions(&state);
 
-        signaled_actions       = state.signaled_actions;
-        state.signaled_actions = NULL;
+        /* Stepping through actions needs them on this thread, so only
+           free running batches are handed to the workers */
+        if(state.dispatch_pool != NULL && mode == TSINT_CONTROL_RUN)
+        {
+            error = TSInt_DispatchSignaledActions(state.dispatch_pool);
+            if(error != TSINT_EXCEPTION_NONE)
+                goto unit_exception;
 
-        TSInt_UnlockActionStateSync(&sync_data);
+            continue;
+        }
 
-        while(signaled_actions != NULL)
+        current_action = TSInt_TakeSignaledAction(&state);
+        while(current_action != NULL)
         {
-            current_action   = signaled_actions;
-            signaled_actions = signaled_actions->next_action;
-
             error = TSInt_ProcessUnitAction(current_action, &mode);
             if(error != TSINT_EXCEPTION_NONE)
                 goto unit_exception;
+
+            current_action = TSInt_TakeSignaledAction(&state);
         }
     }
 
     for(
-        module_group = module->referenced_ffi_groups;
+        module_group = state.started_ffi_groups;
         module_group != NULL;
         module_group = module_group->next_group
        )
@@ -298,6 +507,9 @@ int TSInt_InterpretModule (
     if(module->registered_ffi_group_count > 0)
         free(state.ffi_group_data);
 
+    if(state.dispatch_pool != NULL)
+        TSInt_FreeDispatchPool(state.dispatch_pool);
+
     TSInt_DestroySyncData(&sync_data);
 
     return TSINT_EXCEPTION_NONE;
@@ -310,7 +522,7 @@ unit_exception:
 
 begin_group_failed:
     for(
-        unwind_module_group = module->referenced_ffi_groups;
+        unwind_module_group = state.started_ffi_groups;
         unwind_module_group != NULL && unwind_module_group != module_group;
         unwind_module_group = unwind_module_group->next_group
        )
@@ -335,6 +547,10 @@ begin_group_failed:
         free(state.ffi_group_data);
 
 allocate_group_data_failed:
+    if(state.dispatch_pool != NULL)
+        TSInt_FreeDispatchPool(state.dispatch_pool);
+
+alloc_dispatch_pool_failed:
     TSInt_DestroySyncData(&sync_data);
 
 initialize_sync_data_failed:
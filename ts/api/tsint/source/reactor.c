@@ -0,0 +1,329 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#include "reactor.h"
+#include "sync.h"
+
+#include <tsint/error.h>
+
+#include <stdlib.h>
+#include <malloc.h>
+
+
+static void LinkEntry   (struct tsint_reactor*, struct tsint_reactor_entry*);
+static void UnlinkEntry (struct tsint_reactor*, struct tsint_reactor_entry*);
+static void InsertTimer (struct tsint_reactor*, struct tsint_reactor_entry*);
+static void RemoveTimer (struct tsint_reactor*, struct tsint_reactor_entry*);
+static void FreeEntries (struct tsint_reactor_entry*);
+
+
+static void LinkEntry (struct tsint_reactor* reactor, struct tsint_reactor_entry* entry)
+{
+    entry->previous_entry = NULL;
+    entry->next_entry     = reactor->entries;
+    reactor->entries      = entry;
+
+    if(entry->next_entry != NULL)
+        entry->next_entry->previous_entry = entry;
+}
+
+static void UnlinkEntry (struct tsint_reactor* reactor, struct tsint_reactor_entry* entry)
+{
+    if(entry->next_entry != NULL)
+        entry->next_entry->previous_entry = entry->previous_entry;
+    if(entry->previous_entry != NULL)
+        entry->previous_entry->next_entry = entry->next_entry;
+    else
+        reactor->entries = entry->next_entry;
+}
+
+static void InsertTimer (struct tsint_reactor* reactor, struct tsint_reactor_entry* entry)
+{
+    struct tsint_reactor_entry* previous_timer;
+    struct tsint_reactor_entry* current_timer;
+
+    /* Deadlines wrap with the clock, so order them by signed distance */
+    previous_timer = NULL;
+    current_timer  = reactor->timers;
+    while(current_timer != NULL && (int)(entry->deadline-current_timer->deadline) >= 0)
+    {
+        previous_timer = current_timer;
+        current_timer  = current_timer->next_timer;
+    }
+
+    entry->previous_timer = previous_timer;
+    entry->next_timer     = current_timer;
+
+    if(current_timer != NULL)
+        current_timer->previous_timer = entry;
+    if(previous_timer != NULL)
+        previous_timer->next_timer = entry;
+    else
+        reactor->timers = entry;
+
+    entry->flags |= TSINT_REACTOR_ENTRY_FLAG_PENDING;
+}
+
+static void RemoveTimer (struct tsint_reactor* reactor, struct tsint_reactor_entry* entry)
+{
+    if(entry->next_timer != NULL)
+        entry->next_timer->previous_timer = entry->previous_timer;
+    if(entry->previous_timer != NULL)
+        entry->previous_timer->next_timer = entry->next_timer;
+    else
+        reactor->timers = entry->next_timer;
+
+    entry->flags &= ~TSINT_REACTOR_ENTRY_FLAG_PENDING;
+}
+
+static void FreeEntries (struct tsint_reactor_entry* entry)
+{
+    while(entry != NULL)
+    {
+        struct tsint_reactor_entry* free_entry;
+
+        free_entry = entry;
+        entry      = entry->next_entry;
+
+        free(free_entry);
+    }
+}
+
+
+void TSInt_InitializeReactor (struct tsint_reactor* reactor)
+{
+    reactor->flags           = 0;
+    reactor->virtual_clock   = 0;
+    reactor->entries         = NULL;
+    reactor->timers          = NULL;
+    reactor->retired_entries = NULL;
+    reactor->watch_count     = 0;
+}
+
+void TSInt_DestroyReactor (struct tsint_reactor* reactor)
+{
+    FreeEntries(reactor->entries);
+    FreeEntries(reactor->retired_entries);
+
+    TSInt_InitializeReactor(reactor);
+}
+
+void TSInt_UseVirtualClock (struct tsint_reactor* reactor)
+{
+    reactor->flags |= TSINT_REACTOR_FLAG_VIRTUAL_TIME;
+
+    TSInt_AtomicExchange(&reactor->virtual_clock, 0);
+}
+
+unsigned int TSInt_ReadReactorClock (struct tsint_reactor* reactor)
+{
+    if(reactor->flags&TSINT_REACTOR_FLAG_VIRTUAL_TIME)
+        return (unsigned int)reactor->virtual_clock;
+
+    return TSInt_ReadClock();
+}
+
+int TSInt_AdvanceVirtualClock (struct tsint_reactor* reactor)
+{
+    unsigned int deadline;
+
+    if(!(reactor->flags&TSINT_REACTOR_FLAG_VIRTUAL_TIME) || reactor->timers == NULL)
+        return 0;
+
+    deadline = reactor->timers->deadline;
+    if((int)(deadline-(unsigned int)reactor->virtual_clock) <= 0)
+        return 0;
+
+    TSInt_AtomicExchange(&reactor->virtual_clock, (long)deadline);
+
+    return 1;
+}
+
+void* TSInt_WatchHandle (
+                         struct tsint_module_sync_data* sync_data,
+                         tsffi_wait_handle              handle,
+                         tsffi_reactor_callback         callback,
+                         void*                          user_data
+                        )
+{
+    struct tsint_reactor_entry* entry;
+    int                         error;
+
+    entry = malloc(sizeof(struct tsint_reactor_entry));
+    if(entry == NULL)
+        goto allocate_entry_failed;
+
+    entry->type      = TSINT_REACTOR_ENTRY_WATCH;
+    entry->flags     = 0;
+    entry->callback  = callback;
+    entry->user_data = user_data;
+    entry->handle    = handle;
+    entry->deadline  = 0;
+    entry->period    = 0;
+
+    error = TSInt_AttachWatch(sync_data, entry);
+    if(error != TSINT_ERROR_NONE)
+        goto attach_watch_failed;
+
+    LinkEntry(&sync_data->reactor, entry);
+
+    sync_data->reactor.watch_count++;
+
+    return entry;
+
+attach_watch_failed:
+    free(entry);
+
+allocate_entry_failed:
+    return NULL;
+}
+
+void* TSInt_StartTimer (
+                        struct tsint_module_sync_data* sync_data,
+                        unsigned int                   milliseconds,
+                        unsigned int                   timer_flags,
+                        tsffi_reactor_callback         callback,
+                        void*                          user_data
+                       )
+{
+    struct tsint_reactor_entry* entry;
+
+    entry = malloc(sizeof(struct tsint_reactor_entry));
+    if(entry == NULL)
+        return NULL;
+
+    entry->type      = TSINT_REACTOR_ENTRY_TIMER;
+    entry->flags     = 0;
+    entry->callback  = callback;
+    entry->user_data = user_data;
+    entry->deadline  = TSInt_ReadReactorClock(&sync_data->reactor)+milliseconds;
+
+    if(timer_flags&TSFFI_TIMER_PERIODIC)
+        entry->period = milliseconds > 0 ? milliseconds : 1;
+    else
+        entry->period = 0;
+
+    LinkEntry(&sync_data->reactor, entry);
+    InsertTimer(&sync_data->reactor, entry);
+
+    return entry;
+}
+
+void TSInt_CancelRegistration (struct tsint_module_sync_data* sync_data, void* registration)
+{
+    struct tsint_reactor*       reactor;
+    struct tsint_reactor_entry* entry;
+
+    if(registration == NULL)
+        return;
+
+    reactor = &sync_data->reactor;
+    entry   = registration;
+
+    if(entry->flags&TSINT_REACTOR_ENTRY_FLAG_CANCELED)
+        return;
+
+    if(entry->type == TSINT_REACTOR_ENTRY_WATCH)
+    {
+        TSInt_DetachWatch(sync_data, entry);
+
+        reactor->watch_count--;
+    }
+    else if(entry->flags&TSINT_REACTOR_ENTRY_FLAG_PENDING)
+        RemoveTimer(reactor, entry);
+
+    UnlinkEntry(reactor, entry);
+
+    /* A dispatch in progress may still hold this entry in its ready set,
+       so keep it around until the dispatch ends */
+    if(reactor->flags&TSINT_REACTOR_FLAG_DISPATCHING)
+    {
+        entry->flags     |= TSINT_REACTOR_ENTRY_FLAG_CANCELED;
+        entry->next_entry = reactor->retired_entries;
+
+        reactor->retired_entries = entry;
+    }
+    else
+        free(entry);
+}
+
+unsigned int TSInt_GetReactorTimeout (struct tsint_reactor* reactor)
+{
+    int remaining;
+
+    if(reactor->timers == NULL)
+        return TSINT_REACTOR_NO_TIMEOUT;
+
+    remaining = (int)(reactor->timers->deadline-TSInt_ReadReactorClock(reactor));
+    if(remaining <= 0)
+        return 0;
+
+    /* A virtual clock never moves by itself while the module waits, so a
+       timer that isn't due yet can't end the wait */
+    if(reactor->flags&TSINT_REACTOR_FLAG_VIRTUAL_TIME)
+        return TSINT_REACTOR_NO_TIMEOUT;
+
+    return remaining;
+}
+
+void TSInt_BeginReactorDispatch (struct tsint_reactor* reactor)
+{
+    reactor->flags |= TSINT_REACTOR_FLAG_DISPATCHING;
+}
+
+void TSInt_EndReactorDispatch (struct tsint_reactor* reactor)
+{
+    reactor->flags &= ~TSINT_REACTOR_FLAG_DISPATCHING;
+
+    FreeEntries(reactor->retired_entries);
+
+    reactor->retired_entries = NULL;
+}
+
+void TSInt_DispatchWatch (struct tsint_reactor_entry* entry)
+{
+    if(entry->flags&TSINT_REACTOR_ENTRY_FLAG_CANCELED)
+        return;
+
+    entry->callback(entry->user_data);
+}
+
+unsigned int TSInt_DispatchTimers (struct tsint_reactor* reactor)
+{
+    unsigned int now;
+    unsigned int fired_count;
+
+    now         = TSInt_ReadReactorClock(reactor);
+    fired_count = 0;
+
+    while(reactor->timers != NULL && (int)(reactor->timers->deadline-now) <= 0)
+    {
+        struct tsint_reactor_entry* entry;
+
+        entry = reactor->timers;
+
+        RemoveTimer(reactor, entry);
+
+        /* Rearm before the callback runs, the callback may cancel the
+           timer and release it */
+        if(entry->period != 0)
+        {
+            entry->deadline += entry->period;
+            if((int)(entry->deadline-now) <= 0)
+                entry->deadline = now+entry->period;
+
+            InsertTimer(reactor, entry);
+        }
+
+        entry->callback(entry->user_data);
+
+        fired_count++;
+    }
+
+    return fired_count;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#ifndef _TSINT_REACTOR_H_
+#define _TSINT_REACTOR_H_
+
+
+#include <tsffi/execif.h>
+
+
+#define TSINT_REACTOR_ENTRY_WATCH 0
+#define TSINT_REACTOR_ENTRY_TIMER 1
+
+#define TSINT_REACTOR_ENTRY_FLAG_PENDING  0x01
+#define TSINT_REACTOR_ENTRY_FLAG_CANCELED 0x02
+
+#define TSINT_REACTOR_FLAG_DISPATCHING  0x01
+#define TSINT_REACTOR_FLAG_VIRTUAL_TIME 0x02
+
+#define TSINT_REACTOR_NO_TIMEOUT 0xFFFFFFFF
+
+
+struct tsint_module_sync_data;
+
+struct tsint_reactor_entry
+{
+    unsigned int type;
+    unsigned int flags;
+
+    tsffi_reactor_callback callback;
+    void*                  user_data;
+
+    tsffi_wait_handle handle;
+    unsigned int      deadline;
+    unsigned int      period;
+
+    struct tsint_reactor_entry* next_entry;
+    struct tsint_reactor_entry* previous_entry;
+
+    struct tsint_reactor_entry* next_timer;
+    struct tsint_reactor_entry* previous_timer;
+};
+
+/* Only the module thread moves virtual_clock, but dispatch workers may
+   read it through read_clock, so it is written atomically */
+struct tsint_reactor
+{
+    unsigned int  flags;
+    volatile long virtual_clock;
+
+    struct tsint_reactor_entry* entries;
+    struct tsint_reactor_entry* timers;
+    struct tsint_reactor_entry* retired_entries;
+
+    unsigned int watch_count;
+};
+
+
+extern void TSInt_InitializeReactor (struct tsint_reactor*);
+extern void TSInt_DestroyReactor    (struct tsint_reactor*);
+
+extern void         TSInt_UseVirtualClock     (struct tsint_reactor*);
+extern unsigned int TSInt_ReadReactorClock    (struct tsint_reactor*);
+extern int          TSInt_AdvanceVirtualClock (struct tsint_reactor*);
+
+extern void* TSInt_WatchHandle        (
+                                       struct tsint_module_sync_data*,
+                                       tsffi_wait_handle,
+                                       tsffi_reactor_callback,
+                                       void*
+                                      );
+extern void* TSInt_StartTimer         (
+                                       struct tsint_module_sync_data*,
+                                       unsigned int,
+                                       unsigned int,
+                                       tsffi_reactor_callback,
+                                       void*
+                                      );
+extern void  TSInt_CancelRegistration (struct tsint_module_sync_data*, void*);
+
+extern unsigned int TSInt_GetReactorTimeout    (struct tsint_reactor*);
+extern void         TSInt_BeginReactorDispatch (struct tsint_reactor*);
+extern void         TSInt_EndReactorDispatch   (struct tsint_reactor*);
+extern void         TSInt_DispatchWatch        (struct tsint_reactor_entry*);
+extern unsigned int TSInt_DispatchTimers       (struct tsint_reactor*);
+
+
+#endif
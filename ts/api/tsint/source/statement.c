@@ -14,6 +14,8 @@
 #include "expeval.h"
 #include "expop.h"
 #include "ffi.h"
+#include "async.h"
+#include "dispatch.h"
 
 #include <tsdef/module.h>
 #include <tsffi/register.h>
@@ -170,6 +172,10 @@ static int ProcessFunctionCall (
         int                original_mode;
         int                exception;
 
+        exception = TSInt_ResolveDeferredUnit(module_object, unit_state->module_state);
+        if(exception != TSINT_EXCEPTION_NONE)
+            return exception;
+
         unit = module_object->type.unit;
 
         exception = TSInt_ExpListToValueArray(
@@ -189,7 +195,8 @@ static int ProcessFunctionCall (
                                      arguments,
                                      NULL,
                                      &mode,
-                                     unit_state->module_state
+                                     unit_state->module_state,
+                                     unit_state
                                     );
         if(original_mode != mode)
             unit_state->mode = mode;
@@ -199,6 +206,14 @@ static int ProcessFunctionCall (
         if(exception != TSINT_EXCEPTION_NONE)
             return exception;
     }
+    else if(module_object->type.ffi.function_definition->async_function != NULL)
+    {
+        int exception;
+
+        exception = TSInt_StartAsyncCall(function_call, NULL, unit_state);
+        if(exception != TSINT_EXCEPTION_NONE)
+            return exception;
+    }
     else
     {
         struct tsffi_invocation_data      invocation_data;
@@ -233,6 +248,10 @@ static int ProcessFunctionCall (
         else
             invocation_data.unit_location = 0;
 
+        invocation_data.suspend_data = unit_state;
+
+        TSInt_LockFFIGroup(module_state, ffi_group);
+
         exception = ffi_function->function(
                                            &invocation_data,
                                            module_state->ffi_group_data[ffi_group->group_id],
@@ -240,6 +259,8 @@ static int ProcessFunctionCall (
                                            ffi_arguments
                                           );
 
+        TSInt_UnlockFFIGroup(module_state, ffi_group);
+
         TSInt_DestroyFFIArguments(
                                   ffi_function->argument_types,
                                   ffi_function->argument_count,
@@ -260,12 +281,19 @@ static int ProcessFunctionCall (
 
 static int ProcessAssignment (struct tsdef_statement** statement, struct tsint_unit_state* state)
 {
-    struct tsdef_statement* assignment;
-    int                     exception;
+    struct tsdef_statement*     assignment;
+    struct tsdef_function_call* async_call;
+    int                         exception;
 
     assignment = *statement;
 
-    exception = TSInt_PerformAssignment(assignment->data.assignment, state);
+    /* An assignment of a single async call waits without blocking, the
+       variable is set when the unit resumes */
+    async_call = TSInt_AsyncCallOfExp(assignment->data.assignment->rvalue);
+    if(async_call != NULL)
+        exception = TSInt_StartAsyncCall(async_call, assignment->data.assignment, state);
+    else
+        exception = TSInt_PerformAssignment(assignment->data.assignment, state);
     if(exception != TSINT_EXCEPTION_NONE)
         return exception;
 
@@ -593,6 +621,20 @@ int TSInt_ProcessStatement (struct tsdef_statement** statement, struct tsint_uni
     if(exception != TSINT_EXCEPTION_NONE)
         return exception;
 
+    /* A suspended unit stops short of leaving finished blocks, loop
+       conditions must only be evaluated once it resumes */
+    if(state->flags&TSINT_UNIT_STATE_FLAG_SUSPENDED)
+        return TSINT_EXCEPTION_NONE;
+
+    exception = TSInt_ResumeStatement(statement, state);
+
+    return exception;
+}
+
+int TSInt_ResumeStatement (struct tsdef_statement** statement, struct tsint_unit_state* state)
+{
+    int exception;
+
     while(*statement == NULL && state->current_execution_depth > 0)
     {
         struct tsdef_statement* parent_statement;
@@ -14,7 +14,8 @@
 #include <tsint/module.h>
 
 
-extern int TSInt_ProcessStatement  (struct tsdef_statement**, struct tsint_unit_state*);
+extern int TSInt_ProcessStatement (struct tsdef_statement**, struct tsint_unit_state*);
+extern int TSInt_ResumeStatement  (struct tsdef_statement**, struct tsint_unit_state*);
 
 
 #endif
@@ -10,29 +10,60 @@
 #define _TSINT_SYNC_H_
 
 
+#include "reactor.h"
+
+
 #ifdef PLATFORM_WIN32
     #include <windows.h>
 
     typedef HANDLE           tsint_event;
     typedef CRITICAL_SECTION tsint_mutex;
+    typedef HANDLE           tsint_semaphore;
+    typedef HANDLE           tsint_thread;
+#elif defined(PLATFORM_LINUX)
+    #include <pthread.h>
+    #include <semaphore.h>
+
+    typedef int             tsint_event;
+    typedef pthread_mutex_t tsint_mutex;
+    typedef sem_t           tsint_semaphore;
+    typedef pthread_t       tsint_thread;
 #else
     #error "Unsupported platform selected"
 #endif
 
 
+/* Only the module loop lets a listen jump the virtual clock, a nested
+   wait must not move time for the units it isn't running */
+#define TSINT_LISTEN_FLAG_ADVANCE_CLOCK 0x01
+
+
 struct tsint_module_abort_signal
 {
     tsint_event abort_signal;
+
+#ifdef PLATFORM_LINUX
+    volatile int aborted;
+#endif
 };
 
 struct tsint_module_sync_data
 {
     tsint_event action_signal;
-    tsint_mutex action_state_sync;
+
+    struct tsint_reactor reactor;
+
+#ifdef PLATFORM_LINUX
+    int           wait_set;
+    volatile long signaled;
+    volatile long sleeping;
+#endif
 
     struct tsint_module_abort_signal* abort_signal;
 };
 
+typedef void (*tsint_thread_function) (void*);
+
 
 extern int  TSInt_InitializeSyncData (
                                       struct tsint_module_sync_data*,
@@ -40,12 +71,35 @@ extern int  TSInt_InitializeSyncData (
                                      );
 extern void TSInt_DestroySyncData    (struct tsint_module_sync_data*);
 
-extern void TSInt_LockActionStateSync   (struct tsint_module_sync_data*);
-extern void TSInt_UnlockActionStateSync (struct tsint_module_sync_data*);
+extern long  TSInt_AtomicAdd                    (volatile long*, long);
+extern long  TSInt_AtomicExchange               (volatile long*, long);
+extern long  TSInt_AtomicCompareExchange        (volatile long*, long, long);
+extern void* TSInt_AtomicExchangePointer        (void* volatile*, void*);
+extern void* TSInt_AtomicCompareExchangePointer (void* volatile*, void*, void*);
+
+extern int  TSInt_InitializeMutex (tsint_mutex*);
+extern void TSInt_DestroyMutex    (tsint_mutex*);
+extern void TSInt_LockMutex       (tsint_mutex*);
+extern void TSInt_UnlockMutex     (tsint_mutex*);
+
+extern int  TSInt_InitializeSemaphore (tsint_semaphore*);
+extern void TSInt_DestroySemaphore    (tsint_semaphore*);
+extern void TSInt_PostSemaphore       (tsint_semaphore*, unsigned int);
+extern void TSInt_WaitSemaphore       (tsint_semaphore*);
+
+extern int  TSInt_StartThread (tsint_thread_function, void*, tsint_thread*);
+extern void TSInt_JoinThread  (tsint_thread);
+
+extern int                TSInt_AttachWatch      (struct tsint_module_sync_data*, struct tsint_reactor_entry*);
+extern void               TSInt_DetachWatch      (struct tsint_module_sync_data*, struct tsint_reactor_entry*);
+extern unsigned int       TSInt_ReadClock        (void);
+extern unsigned long long TSInt_ReadPreciseClock (void);
 
-extern int  TSInt_ListenForAction (struct tsint_module_sync_data*);
+extern int  TSInt_ListenForAction (struct tsint_module_sync_data*, unsigned int);
+extern int  TSInt_PollForAction   (struct tsint_module_sync_data*);
 extern void TSInt_SignalAction    (struct tsint_module_sync_data*);
 extern void TSInt_ClearSignal     (struct tsint_module_sync_data*);
+extern void TSInt_PauseProcessor  (void);
 
 extern int  TSInt_InitializeAbortSignal (struct tsint_module_abort_signal*);
 extern void TSInt_DestroyAbortSignal    (struct tsint_module_abort_signal*);
@@ -0,0 +1,491 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#include "sync.h"
+
+#include <tsint/error.h>
+#include <tsint/exception.h>
+
+#include <sys/eventfd.h>
+#include <sys/epoll.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+
+
+#define LISTEN_EVENT_COUNT 16
+
+
+struct thread_start_data
+{
+    tsint_thread_function thread_function;
+    void*                 thread_data;
+};
+
+
+static void  DrainEvent    (tsint_event);
+static int   WaitForEvents (struct tsint_module_sync_data*, int, int*);
+static void* ThreadEntry   (void*);
+
+
+static void DrainEvent (tsint_event event)
+{
+    uint64_t count;
+    ssize_t  result;
+
+    do
+    {
+        result = read(event, &count, sizeof(count));
+    }while(result < 0 && errno == EINTR);
+}
+
+static int WaitForEvents (
+                          struct tsint_module_sync_data* sync_data,
+                          int                            timeout,
+                          int*                           woken
+                         )
+{
+    struct epoll_event    wait_events[LISTEN_EVENT_COUNT];
+    struct tsint_reactor* reactor;
+    unsigned int          dispatch_count;
+    unsigned int          fired_count;
+    int                   event_count;
+    int                   exception;
+    int                   index;
+
+    do
+    {
+        event_count = epoll_wait(sync_data->wait_set, wait_events, LISTEN_EVENT_COUNT, timeout);
+    }while(event_count < 0 && errno == EINTR);
+
+    if(event_count < 0)
+        return TSINT_EXCEPTION_WAIT;
+
+    reactor        = &sync_data->reactor;
+    dispatch_count = 0;
+    exception      = TSINT_EXCEPTION_NONE;
+
+    TSInt_BeginReactorDispatch(reactor);
+
+    for(index = 0; index < event_count; index++)
+    {
+        void* event_data;
+
+        event_data = wait_events[index].data.ptr;
+
+        if(event_data == &sync_data->action_signal)
+        {
+            DrainEvent(sync_data->action_signal);
+
+            *woken = 1;
+        }
+        else if(event_data == sync_data->abort_signal)
+        {
+            exception = TSINT_EXCEPTION_HALT;
+            *woken    = 1;
+        }
+        else
+        {
+            TSInt_DispatchWatch(event_data);
+
+            dispatch_count++;
+        }
+    }
+
+    TSInt_EndReactorDispatch(reactor);
+    fired_count = TSInt_DispatchTimers(reactor);
+
+    /* A virtual clock only jumps once the module finds nothing to do, so
+       it must see what the dispatched watches and timers signaled first */
+    if(dispatch_count+fired_count != 0 && reactor->flags&TSINT_REACTOR_FLAG_VIRTUAL_TIME)
+        *woken = 1;
+
+    return exception;
+}
+
+static void* ThreadEntry (void* user_data)
+{
+    struct thread_start_data start_data;
+
+    start_data = *(struct thread_start_data*)user_data;
+
+    free(user_data);
+
+    start_data.thread_function(start_data.thread_data);
+
+    return NULL;
+}
+
+
+int TSInt_InitializeSyncData (
+                              struct tsint_module_sync_data*    sync_data,
+                              struct tsint_module_abort_signal* abort_signal
+                             )
+{
+    struct epoll_event wait_event;
+    int                result;
+
+    sync_data->action_signal = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+    if(sync_data->action_signal < 0)
+        goto create_action_signal_failed;
+
+    sync_data->wait_set = epoll_create1(EPOLL_CLOEXEC);
+    if(sync_data->wait_set < 0)
+        goto create_wait_set_failed;
+
+    wait_event.events   = EPOLLIN;
+    wait_event.data.ptr = &sync_data->action_signal;
+
+    result = epoll_ctl(sync_data->wait_set, EPOLL_CTL_ADD, sync_data->action_signal, &wait_event);
+    if(result != 0)
+        goto add_action_signal_failed;
+
+    if(abort_signal != NULL)
+    {
+        wait_event.events   = EPOLLIN;
+        wait_event.data.ptr = abort_signal;
+
+        result = epoll_ctl(sync_data->wait_set, EPOLL_CTL_ADD, abort_signal->abort_signal, &wait_event);
+        if(result != 0)
+            goto add_abort_signal_failed;
+    }
+
+    TSInt_InitializeReactor(&sync_data->reactor);
+
+    sync_data->signaled     = 0;
+    sync_data->sleeping     = 0;
+    sync_data->abort_signal = abort_signal;
+
+    return TSINT_ERROR_NONE;
+
+add_abort_signal_failed:
+add_action_signal_failed:
+    close(sync_data->wait_set);
+create_wait_set_failed:
+    close(sync_data->action_signal);
+
+create_action_signal_failed:
+    return TSINT_ERROR_SYSTEM_CALL;
+}
+
+void TSInt_DestroySyncData (struct tsint_module_sync_data* sync_data)
+{
+    TSInt_DestroyReactor(&sync_data->reactor);
+    close(sync_data->wait_set);
+    close(sync_data->action_signal);
+}
+
+long TSInt_AtomicAdd (volatile long* target, long value)
+{
+    return __sync_fetch_and_add(target, value);
+}
+
+long TSInt_AtomicExchange (volatile long* target, long value)
+{
+    return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+}
+
+long TSInt_AtomicCompareExchange (volatile long* target, long value, long comparand)
+{
+    return __sync_val_compare_and_swap(target, comparand, value);
+}
+
+void* TSInt_AtomicExchangePointer (void* volatile* target, void* value)
+{
+    return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+}
+
+void* TSInt_AtomicCompareExchangePointer (void* volatile* target, void* value, void* comparand)
+{
+    return __sync_val_compare_and_swap(target, comparand, value);
+}
+
+int TSInt_InitializeMutex (tsint_mutex* mutex)
+{
+    pthread_mutexattr_t attributes;
+    int                 result;
+
+    /* Match the recursive behaviour of a Win32 critical section */
+    pthread_mutexattr_init(&attributes);
+    pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+
+    result = pthread_mutex_init(mutex, &attributes);
+
+    pthread_mutexattr_destroy(&attributes);
+
+    if(result != 0)
+        return TSINT_ERROR_SYSTEM_CALL;
+
+    return TSINT_ERROR_NONE;
+}
+
+void TSInt_DestroyMutex (tsint_mutex* mutex)
+{
+    pthread_mutex_destroy(mutex);
+}
+
+void TSInt_LockMutex (tsint_mutex* mutex)
+{
+    pthread_mutex_lock(mutex);
+}
+
+void TSInt_UnlockMutex (tsint_mutex* mutex)
+{
+    pthread_mutex_unlock(mutex);
+}
+
+int TSInt_InitializeSemaphore (tsint_semaphore* semaphore)
+{
+    int result;
+
+    result = sem_init(semaphore, 0, 0);
+    if(result != 0)
+        return TSINT_ERROR_SYSTEM_CALL;
+
+    return TSINT_ERROR_NONE;
+}
+
+void TSInt_DestroySemaphore (tsint_semaphore* semaphore)
+{
+    sem_destroy(semaphore);
+}
+
+void TSInt_PostSemaphore (tsint_semaphore* semaphore, unsigned int count)
+{
+    while(count--)
+        sem_post(semaphore);
+}
+
+void TSInt_WaitSemaphore (tsint_semaphore* semaphore)
+{
+    int result;
+
+    do
+    {
+        result = sem_wait(semaphore);
+    }while(result != 0 && errno == EINTR);
+}
+
+int TSInt_StartThread (
+                       tsint_thread_function thread_function,
+                       void*                 thread_data,
+                       tsint_thread*         thread
+                      )
+{
+    struct thread_start_data* start_data;
+    int                       result;
+
+    start_data = malloc(sizeof(struct thread_start_data));
+    if(start_data == NULL)
+        return TSINT_ERROR_MEMORY;
+
+    start_data->thread_function = thread_function;
+    start_data->thread_data     = thread_data;
+
+    result = pthread_create(thread, NULL, &ThreadEntry, start_data);
+    if(result != 0)
+        goto create_thread_failed;
+
+    return TSINT_ERROR_NONE;
+
+create_thread_failed:
+    free(start_data);
+
+    return TSINT_ERROR_SYSTEM_CALL;
+}
+
+void TSInt_JoinThread (tsint_thread thread)
+{
+    pthread_join(thread, NULL);
+}
+
+int TSInt_AttachWatch (
+                       struct tsint_module_sync_data* sync_data,
+                       struct tsint_reactor_entry*    entry
+                      )
+{
+    struct epoll_event wait_event;
+    int                result;
+
+    wait_event.events   = EPOLLIN;
+    wait_event.data.ptr = entry;
+
+    result = epoll_ctl(sync_data->wait_set, EPOLL_CTL_ADD, entry->handle, &wait_event);
+    if(result != 0)
+        return TSINT_ERROR_SYSTEM_CALL;
+
+    return TSINT_ERROR_NONE;
+}
+
+void TSInt_DetachWatch (
+                        struct tsint_module_sync_data* sync_data,
+                        struct tsint_reactor_entry*    entry
+                       )
+{
+    epoll_ctl(sync_data->wait_set, EPOLL_CTL_DEL, entry->handle, NULL);
+}
+
+unsigned int TSInt_ReadClock (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (unsigned int)(now.tv_sec*1000+now.tv_nsec/1000000);
+}
+
+unsigned long long TSInt_ReadPreciseClock (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (unsigned long long)now.tv_sec*1000000+now.tv_nsec/1000;
+}
+
+int TSInt_ListenForAction (struct tsint_module_sync_data* sync_data, unsigned int listen_flags)
+{
+    struct tsint_reactor* reactor;
+    int                   woken;
+    int                   exception;
+
+    TSInt_AtomicExchange(&sync_data->sleeping, 1);
+
+    reactor   = &sync_data->reactor;
+    woken     = 0;
+    exception = TSINT_EXCEPTION_NONE;
+
+    /* Already signaled, the module still services ready watches and due
+       timers without sleeping */
+    if(sync_data->signaled)
+    {
+        if(TSInt_AtomicExchange(&sync_data->sleeping, 0) == 0)
+            DrainEvent(sync_data->action_signal);
+
+        return WaitForEvents(sync_data, 0, &woken);
+    }
+
+    while(!woken && exception == TSINT_EXCEPTION_NONE)
+    {
+        unsigned int timeout;
+        int          advance;
+
+        /* Virtual time may only move on after a sweep finds nothing
+           signaled or ready */
+        timeout = TSInt_GetReactorTimeout(reactor);
+        advance = timeout == TSINT_REACTOR_NO_TIMEOUT &&
+                  listen_flags&TSINT_LISTEN_FLAG_ADVANCE_CLOCK &&
+                  reactor->timers != NULL;
+
+        if(advance)
+            timeout = 0;
+
+        exception = WaitForEvents(
+                                  sync_data,
+                                  timeout == TSINT_REACTOR_NO_TIMEOUT ? -1 : (int)timeout,
+                                  &woken
+                                 );
+
+        if(advance && !woken && exception == TSINT_EXCEPTION_NONE)
+            TSInt_AdvanceVirtualClock(reactor);
+    }
+
+    TSInt_AtomicExchange(&sync_data->sleeping, 0);
+
+    return exception;
+}
+
+int TSInt_PollForAction (struct tsint_module_sync_data* sync_data)
+{
+    int woken;
+
+    woken = 0;
+
+    return WaitForEvents(sync_data, 0, &woken);
+}
+
+void TSInt_SignalAction (struct tsint_module_sync_data* sync_data)
+{
+    uint64_t increment;
+    ssize_t  result;
+
+    if(TSInt_AtomicExchange(&sync_data->signaled, 1) != 0)
+        return;
+
+    if(TSInt_AtomicExchange(&sync_data->sleeping, 0) == 0)
+        return;
+
+    increment = 1;
+
+    do
+    {
+        result = write(sync_data->action_signal, &increment, sizeof(increment));
+    }while(result < 0 && errno == EINTR);
+}
+
+void TSInt_ClearSignal (struct tsint_module_sync_data* sync_data)
+{
+    TSInt_AtomicExchange(&sync_data->signaled, 0);
+}
+
+void TSInt_PauseProcessor (void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#else
+    __sync_synchronize();
+#endif
+}
+
+int TSInt_InitializeAbortSignal (struct tsint_module_abort_signal* signal_data)
+{
+    signal_data->abort_signal = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+    if(signal_data->abort_signal < 0)
+        return TSINT_ERROR_SYSTEM_CALL;
+
+    signal_data->aborted = 0;
+
+    return TSINT_ERROR_NONE;
+}
+
+void TSInt_DestroyAbortSignal (struct tsint_module_abort_signal* signal_data)
+{
+    close(signal_data->abort_signal);
+}
+
+void TSInt_SetAbortSignal (struct tsint_module_abort_signal* signal_data)
+{
+    uint64_t increment;
+    ssize_t  result;
+
+    signal_data->aborted = 1;
+
+    increment = 1;
+
+    do
+    {
+        result = write(signal_data->abort_signal, &increment, sizeof(increment));
+    }while(result < 0 && errno == EINTR);
+}
+
+void TSInt_ClearAbortSignal (struct tsint_module_abort_signal* signal_data)
+{
+    signal_data->aborted = 0;
+
+    DrainEvent(signal_data->abort_signal);
+}
+
+int TSInt_TestAbortSignal (struct tsint_module_sync_data* sync_data)
+{
+    if(sync_data->abort_signal != NULL && sync_data->abort_signal->aborted)
+        return TSINT_EXCEPTION_HALT;
+
+    return TSINT_EXCEPTION_NONE;
+}
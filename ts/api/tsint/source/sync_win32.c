@@ -11,6 +11,150 @@
 #include <tsint/error.h>
 #include <tsint/exception.h>
 
+#include <stdlib.h>
+#include <malloc.h>
+#include <limits.h>
+
+
+struct thread_start_data
+{
+    tsint_thread_function thread_function;
+    void*                 thread_data;
+};
+
+
+static unsigned int SweepWatches  (HANDLE*, struct tsint_reactor_entry**, DWORD, DWORD);
+static int          WaitForEvents (struct tsint_module_sync_data*, DWORD, int*);
+static DWORD WINAPI ThreadEntry   (LPVOID);
+
+
+static unsigned int SweepWatches (
+                                  HANDLE*                      wait_handles,
+                                  struct tsint_reactor_entry** wait_entries,
+                                  DWORD                        sweep_index,
+                                  DWORD                        wait_count
+                                 )
+{
+    DWORD        signaled_index;
+    unsigned int dispatch_count;
+
+    dispatch_count = 0;
+
+    /* A wait only reports the first ready handle, so keep polling the
+       handles after it until none of them are ready */
+    while(sweep_index < wait_count)
+    {
+        signaled_index = WaitForMultipleObjects(
+                                                wait_count-sweep_index,
+                                                wait_handles+sweep_index,
+                                                FALSE,
+                                                0
+                                               );
+        if(signaled_index-WAIT_OBJECT_0 >= wait_count-sweep_index)
+            break;
+
+        sweep_index += signaled_index-WAIT_OBJECT_0;
+
+        TSInt_DispatchWatch(wait_entries[sweep_index]);
+
+        sweep_index++;
+        dispatch_count++;
+    }
+
+    return dispatch_count;
+}
+
+
+static int WaitForEvents (
+                          struct tsint_module_sync_data* sync_data,
+                          DWORD                          timeout,
+                          int*                           woken
+                         )
+{
+    HANDLE                      wait_handles[MAXIMUM_WAIT_OBJECTS];
+    struct tsint_reactor_entry* wait_entries[MAXIMUM_WAIT_OBJECTS];
+    struct tsint_reactor*       reactor;
+    struct tsint_reactor_entry* entry;
+    DWORD                       wait_count;
+    DWORD                       watch_index;
+    DWORD                       signaled_index;
+    DWORD                       sweep_index;
+    unsigned int                dispatch_count;
+    unsigned int                fired_count;
+
+    reactor = &sync_data->reactor;
+
+    wait_handles[0] = sync_data->action_signal;
+    wait_count      = 1;
+
+    if(sync_data->abort_signal != NULL)
+        wait_handles[wait_count++] = sync_data->abort_signal->abort_signal;
+
+    watch_index = wait_count;
+
+    for(entry = reactor->entries; entry != NULL; entry = entry->next_entry)
+    {
+        if(entry->type != TSINT_REACTOR_ENTRY_WATCH)
+            continue;
+
+        wait_entries[wait_count]   = entry;
+        wait_handles[wait_count++] = entry->handle;
+    }
+
+    signaled_index = WaitForMultipleObjects(wait_count, wait_handles, FALSE, timeout);
+    if(signaled_index == WAIT_FAILED)
+        return TSINT_EXCEPTION_WAIT;
+
+    if(sync_data->abort_signal != NULL && signaled_index == WAIT_OBJECT_0+1)
+        return TSINT_EXCEPTION_HALT;
+
+    /* Whatever ended the wait, the watches that are ready and the timers
+       that are due are serviced before the module runs its actions */
+    sweep_index    = wait_count;
+    dispatch_count = 0;
+    if(signaled_index == WAIT_OBJECT_0)
+    {
+        *woken = 1;
+
+        sweep_index = watch_index;
+    }
+
+    TSInt_BeginReactorDispatch(reactor);
+
+    if(signaled_index >= WAIT_OBJECT_0+watch_index && signaled_index < WAIT_OBJECT_0+wait_count)
+    {
+        TSInt_DispatchWatch(wait_entries[signaled_index-WAIT_OBJECT_0]);
+
+        sweep_index    = signaled_index-WAIT_OBJECT_0+1;
+        dispatch_count = 1;
+    }
+
+    dispatch_count += SweepWatches(wait_handles, wait_entries, sweep_index, wait_count);
+
+    TSInt_EndReactorDispatch(reactor);
+    fired_count = TSInt_DispatchTimers(reactor);
+
+    /* A virtual clock only jumps once the module finds nothing to do, so
+       it must see what the dispatched watches and timers signaled first */
+    if(dispatch_count+fired_count != 0 && reactor->flags&TSINT_REACTOR_FLAG_VIRTUAL_TIME)
+        *woken = 1;
+
+    return TSINT_EXCEPTION_NONE;
+}
+
+static DWORD WINAPI ThreadEntry (LPVOID user_data)
+{
+    struct thread_start_data start_data;
+
+    start_data = *(struct thread_start_data*)user_data;
+
+    free(user_data);
+
+    start_data.thread_function(start_data.thread_data);
+
+    return 0;
+}
+
 
 int TSInt_InitializeSyncData (
                               struct tsint_module_sync_data*    sync_data,
@@ -21,7 +165,7 @@ int TSInt_InitializeSyncData (
     if(sync_data->action_signal == NULL)
         return TSINT_ERROR_SYSTEM_CALL;
 
-    InitializeCriticalSection(&sync_data->action_state_sync);
+    TSInt_InitializeReactor(&sync_data->reactor);
 
     sync_data->abort_signal = abort_signal;
 
@@ -30,40 +174,203 @@ int TSInt_InitializeSyncData (
 
 void TSInt_DestroySyncData (struct tsint_module_sync_data* sync_data)
 {
-    DeleteCriticalSection(&sync_data->action_state_sync);
+    TSInt_DestroyReactor(&sync_data->reactor);
     CloseHandle(sync_data->action_signal);
 }
 
-void TSInt_LockActionStateSync (struct tsint_module_sync_data* sync_data)
+long TSInt_AtomicAdd (volatile long* target, long value)
 {
-    EnterCriticalSection(&sync_data->action_state_sync);
+    return InterlockedExchangeAdd(target, value);
 }
 
-void TSInt_UnlockActionStateSync (struct tsint_module_sync_data* sync_data)
+long TSInt_AtomicExchange (volatile long* target, long value)
 {
-    LeaveCriticalSection(&sync_data->action_state_sync);
+    return InterlockedExchange(target, value);
 }
 
-int TSInt_ListenForAction (struct tsint_module_sync_data* sync_data)
+long TSInt_AtomicCompareExchange (volatile long* target, long value, long comparand)
 {
-    if(sync_data->abort_signal != NULL)
+    return InterlockedCompareExchange(target, value, comparand);
+}
+
+void* TSInt_AtomicExchangePointer (void* volatile* target, void* value)
+{
+    return InterlockedExchangePointer(target, value);
+}
+
+void* TSInt_AtomicCompareExchangePointer (void* volatile* target, void* value, void* comparand)
+{
+    return InterlockedCompareExchangePointer(target, value, comparand);
+}
+
+int TSInt_InitializeMutex (tsint_mutex* mutex)
+{
+    InitializeCriticalSection(mutex);
+
+    return TSINT_ERROR_NONE;
+}
+
+void TSInt_DestroyMutex (tsint_mutex* mutex)
+{
+    DeleteCriticalSection(mutex);
+}
+
+void TSInt_LockMutex (tsint_mutex* mutex)
+{
+    EnterCriticalSection(mutex);
+}
+
+void TSInt_UnlockMutex (tsint_mutex* mutex)
+{
+    LeaveCriticalSection(mutex);
+}
+
+int TSInt_InitializeSemaphore (tsint_semaphore* semaphore)
+{
+    *semaphore = CreateSemaphore(NULL, 0, LONG_MAX, NULL);
+    if(*semaphore == NULL)
+        return TSINT_ERROR_SYSTEM_CALL;
+
+    return TSINT_ERROR_NONE;
+}
+
+void TSInt_DestroySemaphore (tsint_semaphore* semaphore)
+{
+    CloseHandle(*semaphore);
+}
+
+void TSInt_PostSemaphore (tsint_semaphore* semaphore, unsigned int count)
+{
+    if(count > 0)
+        ReleaseSemaphore(*semaphore, count, NULL);
+}
+
+void TSInt_WaitSemaphore (tsint_semaphore* semaphore)
+{
+    WaitForSingleObject(*semaphore, INFINITE);
+}
+
+int TSInt_StartThread (
+                       tsint_thread_function thread_function,
+                       void*                 thread_data,
+                       tsint_thread*         thread
+                      )
+{
+    struct thread_start_data* start_data;
+
+    start_data = malloc(sizeof(struct thread_start_data));
+    if(start_data == NULL)
+        return TSINT_ERROR_MEMORY;
+
+    start_data->thread_function = thread_function;
+    start_data->thread_data     = thread_data;
+
+    *thread = CreateThread(NULL, 0, &ThreadEntry, start_data, 0, NULL);
+    if(*thread == NULL)
+        goto create_thread_failed;
+
+    return TSINT_ERROR_NONE;
+
+create_thread_failed:
+    free(start_data);
+
+    return TSINT_ERROR_SYSTEM_CALL;
+}
+
+void TSInt_JoinThread (tsint_thread thread)
+{
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+int TSInt_AttachWatch (
+                       struct tsint_module_sync_data* sync_data,
+                       struct tsint_reactor_entry*    entry
+                      )
+{
+    /* The action and abort signals take two of the wait slots */
+    if(sync_data->reactor.watch_count >= MAXIMUM_WAIT_OBJECTS-2)
+        return TSINT_ERROR_SYSTEM_CALL;
+
+    return TSINT_ERROR_NONE;
+}
+
+void TSInt_DetachWatch (
+                        struct tsint_module_sync_data* sync_data,
+                        struct tsint_reactor_entry*    entry
+                       )
+{
+}
+
+unsigned int TSInt_ReadClock (void)
+{
+    return GetTickCount();
+}
+
+unsigned long long TSInt_ReadPreciseClock (void)
+{
+    static LARGE_INTEGER frequency;
+
+    LARGE_INTEGER counter;
+
+    /* The frequency is fixed at boot, so a racing first read stores the
+       same value */
+    if(frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+
+    QueryPerformanceCounter(&counter);
+
+    /* Split the conversion so the multiply can't overflow */
+    return (unsigned long long)(counter.QuadPart/frequency.QuadPart)*1000000+
+           (unsigned long long)(counter.QuadPart%frequency.QuadPart)*1000000/frequency.QuadPart;
+}
+
+int TSInt_ListenForAction (struct tsint_module_sync_data* sync_data, unsigned int listen_flags)
+{
+    struct tsint_reactor* reactor;
+    int                   woken;
+
+    reactor = &sync_data->reactor;
+    woken   = 0;
+
+    while(!woken)
     {
-        HANDLE events[2];
-        DWORD  signaled_event;
+        DWORD timeout;
+        int   advance;
+        int   exception;
 
-        events[0] = sync_data->action_signal;
-        events[1] = sync_data->abort_signal->abort_signal;
+        /* Virtual time may only move on after a sweep finds nothing
+           signaled or ready */
+        timeout = TSInt_GetReactorTimeout(reactor);
+        advance = timeout == TSINT_REACTOR_NO_TIMEOUT &&
+                  listen_flags&TSINT_LISTEN_FLAG_ADVANCE_CLOCK &&
+                  reactor->timers != NULL;
 
-        signaled_event = WaitForMultipleObjects(2, events, FALSE, INFINITE);
-        if(signaled_event == 1)
-            return TSINT_EXCEPTION_HALT;
+        if(advance)
+            timeout = 0;
+        else if(timeout == TSINT_REACTOR_NO_TIMEOUT)
+            timeout = INFINITE;
+
+        exception = WaitForEvents(sync_data, timeout, &woken);
+        if(exception != TSINT_EXCEPTION_NONE)
+            return exception;
+
+        if(advance && !woken)
+            TSInt_AdvanceVirtualClock(reactor);
     }
-    else
-        WaitForSingleObject(sync_data->action_signal, INFINITE);
 
     return TSINT_EXCEPTION_NONE;
 }
 
+int TSInt_PollForAction (struct tsint_module_sync_data* sync_data)
+{
+    int woken;
+
+    woken = 0;
+
+    return WaitForEvents(sync_data, 0, &woken);
+}
+
 void TSInt_SignalAction (struct tsint_module_sync_data* sync_data)
 {
     SetEvent(sync_data->action_signal);
@@ -74,6 +381,11 @@ void TSInt_ClearSignal (struct tsint_module_sync_data* sync_data)
     ResetEvent(sync_data->action_signal);
 }
 
+void TSInt_PauseProcessor (void)
+{
+    YieldProcessor();
+}
+
 int TSInt_InitializeAbortSignal (struct tsint_module_abort_signal* signal_data)
 {
     signal_data->abort_signal = CreateEvent(NULL, TRUE, FALSE, NULL);
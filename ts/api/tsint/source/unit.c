@@ -12,12 +12,17 @@
 #include "block.h"
 #include "statement.h"
 #include "action.h"
+#include "async.h"
+#include "dispatch.h"
 #include "sync.h"
 
 #include <tsint/error.h>
 #include <tsint/exception.h>
 #include <tsint/variable.h>
 #include <tsint/value.h>
+#include <tsdef/resolve.h>
+#include <tsdef/error.h>
+#include <tsffi/error.h>
 
 #include <malloc.h>
 #include <stdlib.h>
@@ -30,6 +35,12 @@ static int RunBlock (
                      struct tsint_controller_data*
                     );
 
+static void ActivateUnit           (struct tsint_unit_state*);
+static void RestoreDeferredActions (struct tsint_unit_state*);
+static int  ResumeBlock            (struct tsint_unit_state*, struct tsint_controller_data*);
+static int  CompleteInvocation     (struct tsint_unit_state*);
+static int  CompleteActionRun      (struct tsint_action_state*, int*);
+
 
 static int RunBlock (
                      struct tsint_unit_state*      unit_state,
@@ -73,6 +84,13 @@ static int RunBlock (
         unit_state->exception = TSInt_ProcessStatement(&statement, unit_state);
         if(unit_state->exception != TSINT_EXCEPTION_NONE)
             goto exception_encountered;
+
+        if(unit_state->flags&TSINT_UNIT_STATE_FLAG_SUSPENDED)
+        {
+            unit_state->resume_statement = statement;
+
+            break;
+        }
     }
 
     return TSINT_EXCEPTION_NONE;
@@ -81,6 +99,134 @@ exception_encountered:
     return unit_state->exception;
 }
 
+static void ActivateUnit (struct tsint_unit_state* unit_state)
+{
+    struct tsint_module_state* module_state;
+
+    module_state = unit_state->module_state;
+
+    TSInt_LockModuleState(module_state);
+
+    unit_state->next_active_unit     = module_state->active_units;
+    unit_state->previous_active_unit = NULL;
+    if(unit_state->next_active_unit != NULL)
+        unit_state->next_active_unit->previous_active_unit = unit_state;
+
+    module_state->active_units = unit_state;
+
+    TSInt_UnlockModuleState(module_state);
+}
+
+static void RestoreDeferredActions (struct tsint_unit_state* unit_state)
+{
+    struct tsint_action_state* action_state;
+
+    action_state = unit_state->deferred_actions;
+
+    unit_state->deferred_actions = NULL;
+
+    while(action_state != NULL)
+    {
+        struct tsint_action_state* next_action;
+
+        next_action = action_state->next_queued_action;
+
+        TSInt_RequeueAction(action_state);
+
+        action_state = next_action;
+    }
+}
+
+static int ResumeBlock (
+                        struct tsint_unit_state*      unit_state,
+                        struct tsint_controller_data* controller_data
+                       )
+{
+    struct tsdef_statement* statement;
+    int                     exception;
+
+    unit_state->resume_state.flags &= ~TSINT_ACTION_STATE_FLAG_COLLECTED;
+
+    TSInt_AtomicExchange(&unit_state->resume_state.signal_state, TSINT_ACTION_SIGNAL_IDLE);
+
+    unit_state->flags         &= ~TSINT_UNIT_STATE_FLAG_SUSPENDED;
+    unit_state->suspend_cancel = NULL;
+
+    if(unit_state->async_call != NULL)
+    {
+        exception = TSInt_FinishAsyncCall(unit_state);
+        if(exception != TSINT_EXCEPTION_NONE)
+            return exception;
+    }
+
+    statement = unit_state->resume_statement;
+
+    exception = TSInt_ResumeStatement(&statement, unit_state);
+    if(exception != TSINT_EXCEPTION_NONE)
+        return exception;
+
+    exception = RunBlock(unit_state, statement, controller_data);
+    if(exception != TSINT_EXCEPTION_NONE)
+        return exception;
+
+    /* Requeue what arrived while suspended before the block's own action
+       is updated, so that its stale signal is discarded as usual */
+    if(!(unit_state->flags&TSINT_UNIT_STATE_FLAG_SUSPENDED))
+        RestoreDeferredActions(unit_state);
+
+    return TSINT_EXCEPTION_NONE;
+}
+
+static int CompleteInvocation (struct tsint_unit_state* unit_state)
+{
+    struct tsint_unit_state* calling_unit;
+
+    calling_unit = unit_state->calling_unit;
+
+    if(unit_state->unit->actions != NULL && !(unit_state->flags&TSINT_UNIT_STATE_FLAG_FINISH))
+    {
+        struct tsdef_action* exception_action;
+        int                  exception;
+
+        unit_state->active_action_count = 0;
+
+        exception = TSInt_InitActions(unit_state, &exception_action);
+        if(exception != TSINT_EXCEPTION_NONE)
+        {
+            unit_state->current_location = exception_action->location;
+
+            return exception;
+        }
+
+        unit_state->flags |= TSINT_UNIT_STATE_FLAG_INITIALIZED;
+    }
+    else
+        TSInt_StopUnit(unit_state);
+
+    if(calling_unit != NULL)
+        TSInt_ResumeUnit(calling_unit);
+
+    return TSINT_EXCEPTION_NONE;
+}
+
+static int CompleteActionRun (struct tsint_action_state* action_state, int* mode)
+{
+    struct tsint_unit_state* unit_state;
+
+    unit_state = action_state->unit_state;
+
+    *mode = unit_state->mode;
+
+    if(unit_state->flags&TSINT_UNIT_STATE_FLAG_FINISH)
+    {
+        TSInt_StopUnit(unit_state);
+
+        return TSINT_EXCEPTION_NONE;
+    }
+
+    return TSInt_UpdateAction(action_state);
+}
+
 
 int TSInt_ControlModeForInvokedUnit (int mode)
 {
@@ -113,13 +259,12 @@ int TSInt_ExpListToValueArray (
                                union tsint_value**      created_value_array
                               )
 {
-    union tsint_value*               value_array;
-    union tsint_value*               original_value_array;
-    struct tsdef_exp_list_node*      exp_node;
-    struct tsdef_variable_list_node* input_node;
-    struct tsdef_variable_list_node* unwind_node;
-    size_t                           alloc_size;
-    int                              exception;
+    union tsint_value*                value_array;
+    struct tsdef_exp**                exps;
+    struct tsdef_variable_reference** input_variables;
+    size_t                            alloc_size;
+    unsigned int                      index;
+    int                               exception;
 
     if(exp_list == NULL)
     {
@@ -133,68 +278,139 @@ int TSInt_ExpListToValueArray (
     if(value_array == NULL)
         return TSINT_EXCEPTION_OUT_OF_MEMORY;
 
-    original_value_array = value_array;
-
-    input_node = input->input_variables->start;
-    for(exp_node = exp_list->start; exp_node != NULL; exp_node = exp_node->next_exp)
+    exps            = exp_list->exps;
+    input_variables = input->input_variables->variables;
+    for(index = 0; index < exp_list->count; index++)
     {
         exception = TSInt_EvaluateExp(
-                                      input_node->variable->variable->primitive_type,
-                                      exp_node->exp,
+                                      input_variables[index]->variable->primitive_type,
+                                      exps[index],
                                       state,
-                                      value_array
+                                      &value_array[index]
                                      );
         if(exception != TSINT_EXCEPTION_NONE)
             goto evaluate_exp_failed;
-
-        value_array++;
-        input_node = input_node->next_variable;
     }
 
-    *created_value_array = original_value_array;
+    *created_value_array = value_array;
 
     return TSINT_EXCEPTION_NONE;
 
 evaluate_exp_failed:
-    value_array = original_value_array;
+    while(index--)
+        TSInt_DestroyValue(value_array[index], input_variables[index]->variable->primitive_type);
 
-    for(
-        unwind_node = input->input_variables->start;
-        unwind_node != input_node;
-        unwind_node = unwind_node->next_variable
-       )
-    {
-        TSInt_DestroyValue(*value_array, unwind_node->variable->variable->primitive_type);
-
-        value_array++;
-    }
-
-    free(original_value_array);
+    free(value_array);
 
     return exception;
 }
 
 void TSInt_DestroyValueArray (struct tsdef_input* input, union tsint_value* value_array)
 {
-    struct tsdef_variable_list_node* input_node;
-    union tsint_value*               current_value;
+    struct tsdef_variable_reference** input_variables;
+    unsigned int                      index;
 
     if(value_array == NULL)
         return;
 
-    current_value = value_array;
-    for(
-        input_node = input->input_variables->start;
-        input_node != NULL;
-        input_node = input_node->next_variable
-       )
+    input_variables = input->input_variables->variables;
+    for(index = 0; index < input->input_variables->count; index++)
+        TSInt_DestroyValue(value_array[index], input_variables[index]->variable->primitive_type);
+
+    free(value_array);
+}
+
+int TSInt_ResolveDeferredUnit (
+                               struct tsdef_module_object* module_object,
+                               struct tsint_module_state*  module_state
+                              )
+{
+    struct tsdef_module*           module;
+    struct tsdef_module_ffi_group* module_group;
+    int                            error;
+    int                            exception;
+
+    if(module_object->flags&TSDEF_MODULE_OBJECT_FLAG_REFERENCED)
+        return TSINT_EXCEPTION_NONE;
+
+    module = module_state->module;
+
+    /* Starting the newly referenced groups calls into plugins, so it is
+       serialized with every other FFI call rather than under the state
+       lock the plugins' own requests take */
+    TSInt_LockFFIGroups(module_state);
+    TSInt_LockModuleState(module_state);
+
+    if(module_object->flags&TSDEF_MODULE_OBJECT_FLAG_REFERENCED)
     {
-        TSInt_DestroyValue(*current_value, input_node->variable->variable->primitive_type);
+        TSInt_UnlockModuleState(module_state);
+
+        exception = TSINT_EXCEPTION_NONE;
 
-        current_value++;
+        goto already_resolved;
     }
 
-    free(value_array);
+    error = TSDef_ResolveDeferredUnit(module_object, module);
+
+    TSInt_UnlockModuleState(module_state);
+
+    if(error != TSDEF_ERROR_NONE && error != TSDEF_ERROR_RESOLVE_WARNING)
+    {
+        if(error == TSDEF_ERROR_MEMORY)
+            exception = TSINT_EXCEPTION_OUT_OF_MEMORY;
+        else
+            exception = TSINT_EXCEPTION_RESOLVE;
+
+        goto resolve_failed;
+    }
+
+    module_group = module_state->started_ffi_groups;
+    if(module_group == NULL)
+    {
+        module_group = module->referenced_ffi_groups;
+        while(module_group != NULL && module_group->next_group != NULL)
+            module_group = module_group->next_group;
+    }
+    else
+        module_group = module_group->previous_group;
+
+    while(module_group != NULL)
+    {
+        struct tsffi_registration_group* group;
+
+        group = module_group->group;
+
+        if(group->begin_function != NULL)
+        {
+            error = group->begin_function(
+                                          module_state->module_execif,
+                                          module_state,
+                                          group,
+                                          &module_state->ffi_group_data[module_group->group_id]
+                                         );
+            if(error != TSFFI_ERROR_NONE)
+            {
+                exception = TSINT_EXCEPTION_FFI;
+
+                goto begin_group_failed;
+            }
+        }
+        else
+            module_state->ffi_group_data[module_group->group_id] = NULL;
+
+        module_state->started_ffi_groups = module_group;
+
+        module_group = module_group->previous_group;
+    }
+
+    exception = TSINT_EXCEPTION_NONE;
+
+begin_group_failed:
+resolve_failed:
+already_resolved:
+    TSInt_UnlockFFIGroups(module_state);
+
+    return exception;
 }
 
 int TSInt_InvokeUnit (
@@ -202,7 +418,8 @@ int TSInt_InvokeUnit (
                       union tsint_value*         arguments,
                       union tsint_value*         output_value,
                       int*                       mode,
-                      struct tsint_module_state* module_state
+                      struct tsint_module_state* module_state,
+                      struct tsint_unit_state*   calling_unit
                      )
 {
     struct tsint_unit_state*         unit_state;
@@ -210,11 +427,11 @@ int TSInt_InvokeUnit (
     struct tsdef_block*              block;
     struct tsdef_statement*          statement;
     struct tsdef_input*              input;
-    struct tsdef_variable_list_node* input_node;
     struct tsdef_output*             output;
     struct tsdef_action*             action;
     void**                           trigger_user_data;
     size_t                           alloc_size;
+    unsigned int                     trigger_count;
     int                              exception;
 
     alloc_size = sizeof(struct tsint_unit_state)+sizeof(struct tsint_action_state)*unit->action_count;
@@ -222,19 +439,25 @@ int TSInt_InvokeUnit (
     if(unit_state == NULL)
         goto allocate_unit_state_failed;
 
-    alloc_size = 0;
+    trigger_count = 0;
     for(action = unit->actions; action != NULL; action = action->next_action)
-        alloc_size += sizeof(void*)*action->trigger_list->count;
+        trigger_count += action->trigger_list->count;
 
-    if(alloc_size != 0)
+    if(trigger_count != 0)
     {
         struct tsint_action_state* action_state;
+        volatile long*             trigger_states;
         unsigned int               data_offset;
 
+        /* Trigger states share the allocation, placed after the user
+           data slots */
+        alloc_size        = (sizeof(void*)+sizeof(long))*trigger_count;
         trigger_user_data = malloc(alloc_size);
         if(trigger_user_data == NULL)
             goto allocate_trigger_user_data_failed;
 
+        trigger_states = (volatile long*)&trigger_user_data[trigger_count];
+
         unit_state->trigger_user_data = trigger_user_data;
 
         action_state = unit_state->action_state;
@@ -242,30 +465,74 @@ int TSInt_InvokeUnit (
         for(action = unit->actions; action != NULL; action = action->next_action)
         {
             action_state->trigger_user_data = &trigger_user_data[data_offset];
+            action_state->trigger_states    = &trigger_states[data_offset];
 
             data_offset += action->trigger_list->count;
             action_state++;
         }
     }
     else
+    {
         trigger_user_data = NULL;
 
+        unit_state->trigger_user_data = NULL;
+    }
+
     block = &unit->global_block;
 
-    unit_state->unit                  = unit;
-    unit_state->current_statement     = NULL;
-    unit_state->current_block         = NULL;
-    unit_state->current_location      = 0;
-    unit_state->execution_stack       = NULL;
-    unit_state->execution_stack_depth = 0;
-    unit_state->unit_id               = module_state->next_unit_id;
-    unit_state->flags                 = 0;
-    unit_state->module_state          = module_state;
-    unit_state->mode                  = *mode;
-    unit_state->exception             = TSINT_EXCEPTION_NONE;
+    unit_state->unit                   = unit;
+    unit_state->current_statement      = NULL;
+    unit_state->current_block          = NULL;
+    unit_state->current_location       = 0;
+    unit_state->execution_stack        = NULL;
+    unit_state->execution_stack_depth  = 0;
+    unit_state->flags                  = 0;
+    unit_state->module_state           = module_state;
+    unit_state->mode                   = *mode;
+    unit_state->exception              = TSINT_EXCEPTION_NONE;
+    unit_state->dispatched_actions     = NULL;
+    unit_state->last_dispatched_action = NULL;
+    unit_state->next_retired_unit      = NULL;
+    unit_state->resume_statement       = NULL;
+    unit_state->suspended_action       = NULL;
+    unit_state->calling_unit           = NULL;
+    unit_state->deferred_actions       = NULL;
+    unit_state->suspend_cancel         = NULL;
+    unit_state->suspend_cancel_data    = NULL;
+    unit_state->async_call             = NULL;
+
+    unit_state->resume_state.action             = NULL;
+    unit_state->resume_state.unit_state         = unit_state;
+    unit_state->resume_state.flags              = 0;
+    unit_state->resume_state.signal_state       = TSINT_ACTION_SIGNAL_IDLE;
+    unit_state->resume_state.trigger_user_data  = NULL;
+    unit_state->resume_state.trigger_states     = NULL;
+    unit_state->resume_state.next_queued_action = NULL;
+    unit_state->resume_state.next_action        = NULL;
+    unit_state->resume_state.previous_action    = NULL;
+
+    /* Only a call whose result isn't needed right away can be suspended,
+       and only if whoever called it can wait as well */
+    if(output_value == NULL)
+    {
+        if(calling_unit == NULL)
+            unit_state->flags |= TSINT_UNIT_STATE_FLAG_SUSPENDABLE;
+        else if(
+                calling_unit->flags&TSINT_UNIT_STATE_FLAG_SUSPENDABLE &&
+                calling_unit->mode == TSINT_CONTROL_RUN
+               )
+        {
+            unit_state->flags |= TSINT_UNIT_STATE_FLAG_SUSPENDABLE;
+        }
+    }
 
+    TSInt_LockModuleState(module_state);
+
+    unit_state->unit_id = module_state->next_unit_id;
     module_state->next_unit_id++;
 
+    TSInt_UnlockModuleState(module_state);
+
     controller_data = module_state->controller_data;
 
     unit_state->exception = TSInt_StartBlock(block, NULL, unit_state, &statement);
@@ -275,22 +542,21 @@ int TSInt_InvokeUnit (
     input = unit->input;
     if(input != NULL)
     {
-        union tsint_value* current_argument;
+        struct tsdef_variable_reference** input_variables;
+        union tsint_value*                current_argument;
+        unsigned int                      index;
 
         unit_state->current_location = input->location;
 
         current_argument = arguments;
-        for(
-            input_node = input->input_variables->start;
-            input_node != NULL;
-            input_node = input_node->next_variable
-           )
+        input_variables  = input->input_variables->variables;
+        for(index = 0; index < input->input_variables->count; index++)
         {
             struct tsint_variable* variable;
             struct tsdef_variable* variable_def;
 
-            variable_def = input_node->variable->variable;
-            variable     = TSInt_LookupVariableAddress(input_node->variable->variable, unit_state);
+            variable_def = input_variables[index]->variable;
+            variable     = TSInt_LookupVariableAddress(variable_def, unit_state);
 
             if(variable_def->primitive_type == TSDEF_PRIMITIVE_TYPE_STRING)
             {
@@ -327,6 +593,24 @@ int TSInt_InvokeUnit (
     if(unit_state->exception != TSINT_EXCEPTION_NONE)
         goto exception_encountered;
 
+    if(unit_state->flags&TSINT_UNIT_STATE_FLAG_SUSPENDED)
+    {
+        /* The rest of the invocation runs once the unit resumes, and a
+           calling unit waits on it in turn */
+        unit_state->calling_unit = calling_unit;
+        if(calling_unit != NULL)
+        {
+            calling_unit->flags         |= TSINT_UNIT_STATE_FLAG_SUSPENDED;
+            calling_unit->suspend_cancel = NULL;
+        }
+
+        *mode = unit_state->mode;
+
+        ActivateUnit(unit_state);
+
+        return TSINT_EXCEPTION_NONE;
+    }
+
     if(output != NULL && output_value != NULL)
     {
         struct tsint_variable* variable;
@@ -369,12 +653,9 @@ int TSInt_InvokeUnit (
             goto exception_encountered;
         }
 
-        unit_state->next_active_unit     = module_state->active_units;
-        unit_state->previous_active_unit = NULL;
-        if(unit_state->next_active_unit != NULL)
-            unit_state->next_active_unit->previous_active_unit = unit_state;
+        unit_state->flags |= TSINT_UNIT_STATE_FLAG_INITIALIZED;
 
-        module_state->active_units = unit_state;
+        ActivateUnit(unit_state);
     }
     else
     {
@@ -391,10 +672,15 @@ int TSInt_InvokeUnit (
 exception_encountered:
     if(unit_state->mode != TSINT_CONTROL_HALT && controller_data != NULL)
     {
+        TSInt_LockController(module_state);
+
         controller_data->function(
                                   unit_state,
                                   controller_data->user_data
                                  );
+
+        TSInt_UnlockController(module_state);
+
         unit_state->mode = TSINT_CONTROL_HALT;
     }
 
@@ -429,12 +715,26 @@ int TSInt_ProcessUnitAction (struct tsint_action_state* action_state, int* mode)
     unsigned int                  status;
     int                           exception;
 
+    unit_state       = action_state->unit_state;
+    unit_state->mode = *mode;
+    module_state     = unit_state->module_state;
+    controller_data  = module_state->controller_data;
+
+    if(action_state == &unit_state->resume_state)
+        goto resume_unit;
+
+    /* Actions of a suspended unit wait until it has finished the block it
+       was running */
+    if(unit_state->flags&TSINT_UNIT_STATE_FLAG_SUSPENDED)
+    {
+        action_state->next_queued_action = unit_state->deferred_actions;
+        unit_state->deferred_actions     = action_state;
+
+        return TSINT_EXCEPTION_NONE;
+    }
+
     action                       = action_state->action;
-    unit_state                   = action_state->unit_state;
     unit_state->current_location = action->location;
-    unit_state->mode             = *mode;
-    module_state                 = unit_state->module_state;
-    controller_data              = module_state->controller_data;
 
     unit_state->exception = TSInt_EvaluateAction(action_state, &status);
     if(unit_state->exception != TSINT_EXCEPTION_NONE)
@@ -456,21 +756,25 @@ int TSInt_ProcessUnitAction (struct tsint_action_state* action_state, int* mode)
         if(unit_state->exception != TSINT_EXCEPTION_NONE)
             goto start_block_failed;
 
+        unit_state->flags |= TSINT_UNIT_STATE_FLAG_SUSPENDABLE;
+
         unit_state->exception = RunBlock(unit_state, statement, controller_data);
         if(unit_state->exception != TSINT_EXCEPTION_NONE)
             goto run_block_failed;
 
-        *mode = unit_state->mode;
-
-        if(unit_state->flags&TSINT_UNIT_STATE_FLAG_FINISH)
-            TSInt_StopUnit(unit_state);
-        else
+        if(unit_state->flags&TSINT_UNIT_STATE_FLAG_SUSPENDED)
         {
-            unit_state->exception = TSInt_UpdateAction(action_state);
-            if(unit_state->exception != TSINT_EXCEPTION_NONE)
-                goto update_action_failed;
+            unit_state->suspended_action = action_state;
+
+            *mode = unit_state->mode;
+
+            break;
         }
 
+        unit_state->exception = CompleteActionRun(action_state, mode);
+        if(unit_state->exception != TSINT_EXCEPTION_NONE)
+            goto update_action_failed;
+
         break;
 
     case TSINT_ACTION_FINISHED:
@@ -484,6 +788,37 @@ int TSInt_ProcessUnitAction (struct tsint_action_state* action_state, int* mode)
 
     return TSINT_EXCEPTION_NONE;
 
+resume_unit:
+    unit_state->exception = ResumeBlock(unit_state, controller_data);
+    if(unit_state->exception != TSINT_EXCEPTION_NONE)
+        goto resume_block_failed;
+
+    *mode = unit_state->mode;
+
+    if(unit_state->flags&TSINT_UNIT_STATE_FLAG_SUSPENDED)
+        return TSINT_EXCEPTION_NONE;
+
+    if(unit_state->suspended_action == NULL)
+    {
+        unit_state->exception = CompleteInvocation(unit_state);
+        if(unit_state->exception != TSINT_EXCEPTION_NONE)
+            goto complete_invocation_failed;
+
+        return TSINT_EXCEPTION_NONE;
+    }
+
+    action_state = unit_state->suspended_action;
+
+    unit_state->suspended_action = NULL;
+
+    unit_state->exception = CompleteActionRun(action_state, mode);
+    if(unit_state->exception != TSINT_EXCEPTION_NONE)
+        goto update_action_failed;
+
+    return TSINT_EXCEPTION_NONE;
+
+complete_invocation_failed:
+resume_block_failed:
 update_action_failed:
 run_block_failed:
 start_block_failed:
@@ -491,10 +826,15 @@ wait_action_failed:
 evaluation_failed:
     if(unit_state->mode != TSINT_CONTROL_HALT && controller_data != NULL)
     {
+        TSInt_LockController(module_state);
+
         controller_data->function(
                                   unit_state,
                                   controller_data->user_data
                                  );
+
+        TSInt_UnlockController(module_state);
+
         unit_state->mode = TSINT_CONTROL_HALT;
     }
 
@@ -510,11 +850,31 @@ void TSInt_StopUnit (struct tsint_unit_state* unit_state)
 {
     struct tsint_module_state* module_state;
     struct tsdef_statement*    statement;
-
-    TSInt_StopActions(unit_state);
+    long                       resume_state;
+
+    if(unit_state->flags&TSINT_UNIT_STATE_FLAG_INITIALIZED)
+        TSInt_StopActions(unit_state);
+
+    /* An outstanding call is abandoned first, so that once it can no
+       longer queue the resume the resume state is taken off the queue */
+    TSInt_AbandonAsyncCall(unit_state);
+
+    /* A unit stopped while waiting tells whoever would resume it that the
+       wait is abandoned */
+    resume_state = TSInt_RemoveAction(&unit_state->resume_state);
+    if(
+       resume_state == TSINT_ACTION_SIGNAL_IDLE &&
+       unit_state->flags&TSINT_UNIT_STATE_FLAG_SUSPENDED &&
+       unit_state->suspend_cancel != NULL
+      )
+    {
+        unit_state->suspend_cancel(unit_state->suspend_cancel_data);
+    }
 
     module_state = unit_state->module_state;
 
+    TSInt_LockModuleState(module_state);
+
     if(unit_state->next_active_unit != NULL)
         unit_state->next_active_unit->previous_active_unit = unit_state->previous_active_unit;
     if(unit_state->previous_active_unit != NULL)
@@ -522,10 +882,50 @@ void TSInt_StopUnit (struct tsint_unit_state* unit_state)
     else
         module_state->active_units = unit_state->next_active_unit;
 
+    TSInt_UnlockModuleState(module_state);
+
     while(unit_state->execution_stack_depth > 0)
         TSInt_FinishBlock(unit_state, &statement);
 
+    /* A dispatch worker may still be walking this unit's actions, so
+       during a batch the pool releases it once the batch is done */
+    if(module_state->dispatch_pool != NULL)
+    {
+        TSInt_RetireUnit(module_state->dispatch_pool, unit_state);
+
+        return;
+    }
+
     free(unit_state->trigger_user_data);
     free(unit_state);
 }
 
+void* TSInt_SuspendUnit (
+                         struct tsint_unit_state* unit_state,
+                         tsffi_suspend_cancel     cancel,
+                         void*                    cancel_data
+                        )
+{
+    if(unit_state == NULL)
+        return NULL;
+
+    /* Stepping through a unit needs it to stay on the controller's
+       thread, so it only suspends while running freely */
+    if(!(unit_state->flags&TSINT_UNIT_STATE_FLAG_SUSPENDABLE))
+        return NULL;
+    if(unit_state->flags&TSINT_UNIT_STATE_FLAG_SUSPENDED)
+        return NULL;
+    if(unit_state->mode != TSINT_CONTROL_RUN)
+        return NULL;
+
+    unit_state->flags              |= TSINT_UNIT_STATE_FLAG_SUSPENDED;
+    unit_state->suspend_cancel      = cancel;
+    unit_state->suspend_cancel_data = cancel_data;
+
+    return unit_state;
+}
+
+void TSInt_ResumeUnit (struct tsint_unit_state* unit_state)
+{
+    TSInt_QueueAction(&unit_state->resume_state);
+}
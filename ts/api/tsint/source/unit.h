@@ -24,17 +24,23 @@ extern int  TSInt_ExpListToValueArray (
                                       );
 extern void TSInt_DestroyValueArray   (struct tsdef_input*, union tsint_value*);
 
+extern int TSInt_ResolveDeferredUnit (struct tsdef_module_object*, struct tsint_module_state*);
+
 extern int TSInt_InvokeUnit (
                              struct tsdef_unit*,
                              union tsint_value*,
                              union tsint_value*,
                              int*,
-                             struct tsint_module_state*
+                             struct tsint_module_state*,
+                             struct tsint_unit_state*
                             );
 
 extern int  TSInt_ProcessUnitAction (struct tsint_action_state*, int*);
 extern void TSInt_StopUnit          (struct tsint_unit_state*);
 
+extern void* TSInt_SuspendUnit (struct tsint_unit_state*, tsffi_suspend_cancel, void*);
+extern void  TSInt_ResumeUnit  (struct tsint_unit_state*);
+
 
 #endif
 
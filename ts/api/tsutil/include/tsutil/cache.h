@@ -0,0 +1,61 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#ifndef _TSUTIL_CACHE_H_
+#define _TSUTIL_CACHE_H_
+
+
+#include <tsdef/def.h>
+#include <tsdef/deferror.h>
+
+
+#define TSUTIL_UNIT_CACHE_HASH_SIZE  256
+#define TSUTIL_UNIT_CACHE_SIZE_LIMIT (4*1024*1024)
+
+
+struct tsutil_cached_unit
+{
+    char*        name;
+    char*        file_name;
+    char*        content;
+    unsigned int content_hash;
+    unsigned int content_size;
+
+    struct tsdef_unit unit;
+
+    struct tsutil_cached_unit* next_cached_unit;
+    struct tsutil_cached_unit* next_used_unit;
+    struct tsutil_cached_unit* previous_used_unit;
+};
+
+/* Cached units keep their source to confirm a hit, they are charged by
+   its size and the least recently used units are evicted once the cache
+   passes its limit */
+struct tsutil_unit_cache
+{
+    struct tsutil_cached_unit* hash_map[TSUTIL_UNIT_CACHE_HASH_SIZE];
+
+    struct tsutil_cached_unit* most_recent_unit;
+    struct tsutil_cached_unit* least_recent_unit;
+    unsigned int               cached_size;
+};
+
+
+extern void TSUtil_InitializeUnitCache (struct tsutil_unit_cache*);
+extern void TSUtil_DestroyUnitCache    (struct tsutil_unit_cache*);
+
+extern int TSUtil_ConstructCachedUnit (
+                                       char*,
+                                       char*,
+                                       struct tsdef_unit*,
+                                       struct tsdef_def_error_list*,
+                                       struct tsutil_unit_cache*
+                                      );
+
+
+#endif
@@ -13,9 +13,12 @@
 #include <tsdef/module.h>
 #include <tsdef/deferror.h>
 #include <tsutil/path.h>
+#include <tsutil/cache.h>
+#include <tsutil/stats.h>
 
 
 #define TSUTIL_COMPILE_FLAG_CAPTURE_OUTPUT 0x01
+#define TSUTIL_COMPILE_FLAG_DEFER_RESOLVE  0x02
 
 
 typedef void (*notify_lookup_function) (char*);
@@ -26,6 +29,8 @@ extern int TSUtil_CompileUnit (
                                unsigned int,
                                struct tsutil_path_collection*,
                                char*,
+                               struct tsutil_unit_cache*,
+                               struct tsutil_compile_stats*,
                                notify_lookup_function,
                                struct tsdef_def_error_list*,
                                struct tsdef_module*
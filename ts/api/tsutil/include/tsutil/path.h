@@ -13,10 +13,14 @@
 #include <stddef.h>
 
 
+struct tsutil_path_index;
+
 struct tsutil_path
 {
     char* path;
 
+    struct tsutil_path_index* index;
+
     struct tsutil_path* next_path;
 };
 
@@ -35,7 +39,8 @@ extern void TSUtil_DestroyPathCollection    (struct tsutil_path_collection*);
 extern int TSUtil_AppendPath  (char*, struct tsutil_path_collection*);
 extern int TSUtil_PrependPath (char*, struct tsutil_path_collection*);
 
-extern int TSUtil_FindUnitFile (char*, char*, struct tsutil_path_collection*, char**);
+extern void TSUtil_ExpirePathIndices (struct tsutil_path_collection*);
+extern int  TSUtil_FindUnitFile      (char*, char*, struct tsutil_path_collection*, char**);
 
 
 #endif
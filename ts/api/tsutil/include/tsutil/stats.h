@@ -0,0 +1,58 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#ifndef _TSUTIL_STATS_H_
+#define _TSUTIL_STATS_H_
+
+
+#include <tsdef/module.h>
+
+#include <stddef.h>
+
+
+struct tsutil_unit_stats
+{
+    char* name;
+
+    double parse_time;
+    double resolve_time;
+
+    unsigned int specialization_count;
+    unsigned int node_count;
+    size_t       estimated_bytes;
+
+    struct tsutil_unit_stats* next_unit_stats;
+};
+
+struct tsutil_compile_stats
+{
+    struct tsutil_unit_stats* unit_stats;
+    struct tsutil_unit_stats* last_unit_stats;
+    unsigned int              unit_count;
+
+    unsigned int lookup_count;
+    double       lookup_time;
+    double       compile_time;
+
+    double resolve_start_time;
+    double resolve_start_lookup_time;
+};
+
+
+extern void TSUtil_InitializeCompileStats (struct tsutil_compile_stats*);
+extern void TSUtil_DestroyCompileStats    (struct tsutil_compile_stats*);
+
+extern int TSUtil_AcquireUnitStats   (
+                                      char*,
+                                      struct tsutil_compile_stats*,
+                                      struct tsutil_unit_stats**
+                                     );
+extern int TSUtil_CollectModuleStats (struct tsdef_module*, struct tsutil_compile_stats*);
+
+
+#endif
@@ -0,0 +1,305 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#include <tsutil/cache.h>
+#include <tsutil/error.h>
+
+#include <tsdef/construct.h>
+#include <tsdef/error.h>
+
+#include <stdlib.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+
+#define HASH_FNV_PRIME  16777619
+#define HASH_FNV_OFFSET 2166136261
+
+
+static unsigned int ComputeHash (char*);
+static unsigned int HashContent (char*, unsigned int);
+static char*        ReadSource  (char*, unsigned int*);
+
+static void UseCachedUnit    (struct tsutil_unit_cache*, struct tsutil_cached_unit*);
+static void RemoveCachedUnit (struct tsutil_unit_cache*, struct tsutil_cached_unit*);
+static void FreeCachedUnit   (struct tsutil_cached_unit*);
+
+
+static unsigned int ComputeHash (char* name)
+{
+    unsigned int hash;
+
+    hash = 0;
+    while(*name != 0)
+    {
+        hash *= HASH_FNV_PRIME;
+        hash ^= *name;
+
+        name++;
+    }
+
+    hash = hash%TSUTIL_UNIT_CACHE_HASH_SIZE;
+
+    return hash;
+}
+
+static unsigned int HashContent (char* content, unsigned int content_size)
+{
+    unsigned int hash;
+    unsigned int index;
+
+    hash = HASH_FNV_OFFSET;
+    for(index = 0; index < content_size; index++)
+    {
+        hash ^= (unsigned char)content[index];
+        hash *= HASH_FNV_PRIME;
+    }
+
+    return hash;
+}
+
+static char* ReadSource (char* file_name, unsigned int* content_size)
+{
+    struct stat stat_data;
+    FILE*       file;
+    char*       content;
+    size_t      read_size;
+    int         result;
+
+    result = stat(file_name, &stat_data);
+    if(result != 0)
+        goto stat_file_failed;
+
+    file = fopen(file_name, "rt");
+    if(file == NULL)
+        goto open_file_failed;
+
+    content = malloc((size_t)stat_data.st_size+1);
+    if(content == NULL)
+        goto allocate_content_failed;
+
+    /* Text mode may read fewer bytes than the file holds */
+    read_size = fread(content, 1, (size_t)stat_data.st_size, file);
+    if(ferror(file))
+        goto read_file_failed;
+
+    fclose(file);
+
+    content[read_size] = 0;
+    *content_size      = (unsigned int)read_size;
+
+    return content;
+
+read_file_failed:
+    free(content);
+allocate_content_failed:
+    fclose(file);
+open_file_failed:
+stat_file_failed:
+    return NULL;
+}
+
+static void UseCachedUnit (struct tsutil_unit_cache* cache, struct tsutil_cached_unit* cached_unit)
+{
+    if(cache->most_recent_unit == cached_unit)
+        return;
+
+    if(cached_unit->previous_used_unit != NULL || cache->least_recent_unit == cached_unit)
+    {
+        if(cached_unit->next_used_unit != NULL)
+            cached_unit->next_used_unit->previous_used_unit = cached_unit->previous_used_unit;
+        else
+            cache->least_recent_unit = cached_unit->previous_used_unit;
+
+        cached_unit->previous_used_unit->next_used_unit = cached_unit->next_used_unit;
+    }
+
+    cached_unit->previous_used_unit = NULL;
+    cached_unit->next_used_unit     = cache->most_recent_unit;
+
+    if(cache->most_recent_unit != NULL)
+        cache->most_recent_unit->previous_used_unit = cached_unit;
+    else
+        cache->least_recent_unit = cached_unit;
+
+    cache->most_recent_unit = cached_unit;
+}
+
+static void RemoveCachedUnit (struct tsutil_unit_cache* cache, struct tsutil_cached_unit* cached_unit)
+{
+    struct tsutil_cached_unit** link;
+
+    link = &cache->hash_map[ComputeHash(cached_unit->name)];
+    while(*link != cached_unit)
+        link = &(*link)->next_cached_unit;
+
+    *link = cached_unit->next_cached_unit;
+
+    if(cached_unit->previous_used_unit != NULL)
+        cached_unit->previous_used_unit->next_used_unit = cached_unit->next_used_unit;
+    else
+        cache->most_recent_unit = cached_unit->next_used_unit;
+
+    if(cached_unit->next_used_unit != NULL)
+        cached_unit->next_used_unit->previous_used_unit = cached_unit->previous_used_unit;
+    else
+        cache->least_recent_unit = cached_unit->previous_used_unit;
+
+    cache->cached_size -= cached_unit->content_size;
+
+    FreeCachedUnit(cached_unit);
+}
+
+static void FreeCachedUnit (struct tsutil_cached_unit* cached_unit)
+{
+    TSDef_DestroyUnit(&cached_unit->unit);
+
+    free(cached_unit->content);
+    free(cached_unit->file_name);
+    free(cached_unit->name);
+    free(cached_unit);
+}
+
+
+void TSUtil_InitializeUnitCache (struct tsutil_unit_cache* cache)
+{
+    unsigned int index;
+
+    for(index = 0; index < TSUTIL_UNIT_CACHE_HASH_SIZE; index++)
+        cache->hash_map[index] = NULL;
+
+    cache->most_recent_unit  = NULL;
+    cache->least_recent_unit = NULL;
+    cache->cached_size       = 0;
+}
+
+void TSUtil_DestroyUnitCache (struct tsutil_unit_cache* cache)
+{
+    while(cache->most_recent_unit != NULL)
+        RemoveCachedUnit(cache, cache->most_recent_unit);
+}
+
+int TSUtil_ConstructCachedUnit (
+                                char*                        file_name,
+                                char*                        name,
+                                struct tsdef_unit*           unit,
+                                struct tsdef_def_error_list* errors,
+                                struct tsutil_unit_cache*    cache
+                               )
+{
+    struct tsutil_cached_unit*  cached_unit;
+    struct tsutil_cached_unit** bucket;
+    char*                       content;
+    unsigned int                content_size;
+    unsigned int                content_hash;
+    int                         error;
+
+    /* The source is hashed on every lookup, a modification time can miss
+       an edit made within its granularity */
+    content = ReadSource(file_name, &content_size);
+    if(content == NULL)
+        return TSDef_ConstructUnitFromFile(file_name, name, unit, errors);
+
+    content_hash = HashContent(content, content_size);
+
+    cached_unit = cache->hash_map[ComputeHash(name)];
+    while(cached_unit != NULL)
+    {
+        if(strcmp(cached_unit->name, name) == 0)
+            break;
+
+        cached_unit = cached_unit->next_cached_unit;
+    }
+
+    /* The hash only rules a hit out quickly, a hash collision must not
+       serve a stale tree so the source itself is compared */
+    if(
+       cached_unit != NULL &&
+       cached_unit->content_hash == content_hash &&
+       cached_unit->content_size == content_size &&
+       strcmp(cached_unit->file_name, file_name) == 0 &&
+       memcmp(cached_unit->content, content, content_size) == 0
+      )
+    {
+        free(content);
+
+        error = TSDef_CloneUnit(&cached_unit->unit, unit);
+        if(error != TSDEF_ERROR_NONE)
+            return TSDEF_ERROR_MEMORY;
+
+        UseCachedUnit(cache, cached_unit);
+
+        return TSDEF_ERROR_NONE;
+    }
+
+    if(cached_unit != NULL)
+        RemoveCachedUnit(cache, cached_unit);
+
+    /* The tree is parsed from the same bytes the cache keeps, so the two
+       match even if the file changes again while it is read */
+    error = TSDef_ConstructUnitFromString(content, name, unit, errors);
+    if(error != TSDEF_ERROR_NONE)
+    {
+        free(content);
+
+        return error;
+    }
+
+    if(content_size > TSUTIL_UNIT_CACHE_SIZE_LIMIT)
+        goto check_size_failed;
+
+    cached_unit = malloc(sizeof(struct tsutil_cached_unit));
+    if(cached_unit == NULL)
+        goto allocate_cached_unit_failed;
+
+    cached_unit->name = strdup(name);
+    if(cached_unit->name == NULL)
+        goto duplicate_name_failed;
+
+    cached_unit->file_name = strdup(file_name);
+    if(cached_unit->file_name == NULL)
+        goto duplicate_file_name_failed;
+
+    error = TSDef_CloneUnit(unit, &cached_unit->unit);
+    if(error != TSDEF_ERROR_NONE)
+        goto clone_unit_failed;
+
+    while(cache->cached_size+content_size > TSUTIL_UNIT_CACHE_SIZE_LIMIT)
+        RemoveCachedUnit(cache, cache->least_recent_unit);
+
+    cached_unit->content            = content;
+    cached_unit->content_hash       = content_hash;
+    cached_unit->content_size       = content_size;
+    cached_unit->previous_used_unit = NULL;
+    cached_unit->next_used_unit     = NULL;
+
+    bucket = &cache->hash_map[ComputeHash(name)];
+
+    cached_unit->next_cached_unit  = *bucket;
+    *bucket                        = cached_unit;
+    cache->cached_size            += content_size;
+
+    UseCachedUnit(cache, cached_unit);
+
+    return TSDEF_ERROR_NONE;
+
+clone_unit_failed:
+    free(cached_unit->file_name);
+duplicate_file_name_failed:
+    free(cached_unit->name);
+duplicate_name_failed:
+    free(cached_unit);
+
+allocate_cached_unit_failed:
+check_size_failed:
+    free(content);
+
+    return TSDEF_ERROR_NONE;
+}
@@ -9,6 +9,8 @@
 #include <tsutil/compile.h>
 #include <tsutil/error.h>
 
+#include "timer.h"
+
 #include <tsdef/def.h>
 #include <tsdef/construct.h>
 #include <tsdef/resolve.h>
@@ -25,12 +27,49 @@ struct lookup_data
     unsigned int                   warning_count;
     char*                          unit_extension;
     struct tsutil_path_collection* path_collection;
+    struct tsutil_unit_cache*      unit_cache;
+    struct tsutil_compile_stats*   stats;
     struct tsdef_def_error_list*   def_errors;
 
     notify_lookup_function notify_lookup;
 };
 
 
+static void ResolveNotify (
+                           unsigned int                event,
+                           struct tsdef_module_object* module_object,
+                           void*                       user_data
+                          )
+{
+    struct lookup_data*          lookup_user_data;
+    struct tsutil_compile_stats* stats;
+    struct tsutil_unit_stats*    unit_stats;
+    double                       elapsed_time;
+    int                          error;
+
+    lookup_user_data = user_data;
+    stats            = lookup_user_data->stats;
+    if(stats == NULL)
+        return;
+
+    if(event == TSDEF_RESOLVE_NOTIFY_BEGIN)
+    {
+        stats->resolve_start_time        = TSUtil_ReadTimer();
+        stats->resolve_start_lookup_time = stats->lookup_time;
+
+        return;
+    }
+
+    error = TSUtil_AcquireUnitStats(module_object->type.unit->name, stats, &unit_stats);
+    if(error != TSUTIL_ERROR_NONE)
+        return;
+
+    elapsed_time  = TSUtil_ReadTimer()-stats->resolve_start_time;
+    elapsed_time -= stats->lookup_time-stats->resolve_start_lookup_time;
+
+    unit_stats->resolve_time += elapsed_time;
+}
+
 static int ModuleObjectLookup (
                                char*                        name,
                                struct tsdef_argument_types* types,
@@ -42,10 +81,15 @@ static int ModuleObjectLookup (
     struct tsdef_module_object* module_object;
     char*                       file_name;
     struct tsdef_unit*          unit;
+    double                      start_time;
+    double                      parse_start_time;
     int                         error;
 
     lookup_user_data = user_data;
 
+    if(lookup_user_data->stats != NULL)
+        start_time = TSUtil_ReadTimer();
+
     if(lookup_user_data->notify_lookup != NULL)
         lookup_user_data->notify_lookup(name);
 
@@ -58,9 +102,11 @@ static int ModuleObjectLookup (
     if(error != TSUTIL_ERROR_NONE)
     {
         if(error == TSUTIL_ERROR_NOT_FOUND)
-            return TSDEF_ERROR_MODULE_OBJECT_NOT_FOUND;
+            error = TSDEF_ERROR_MODULE_OBJECT_NOT_FOUND;
         else
-            return TSDEF_ERROR_MEMORY;
+            error = TSDEF_ERROR_MEMORY;
+
+        goto find_unit_file_failed;
     }
 
     unit = malloc(sizeof(struct tsdef_unit));
@@ -68,25 +114,55 @@ static int ModuleObjectLookup (
     {
         free(file_name);
 
-        return TSDEF_ERROR_MEMORY;
+        error = TSDEF_ERROR_MEMORY;
+
+        goto allocate_unit_failed;
     }
 
-    error = TSDef_ConstructUnitFromFile(
-                                        file_name,
-                                        name,
-                                        unit,
-                                        lookup_user_data->def_errors
-                                       );
+    if(lookup_user_data->stats != NULL)
+        parse_start_time = TSUtil_ReadTimer();
+
+    if(lookup_user_data->unit_cache != NULL)
+    {
+        error = TSUtil_ConstructCachedUnit(
+                                           file_name,
+                                           name,
+                                           unit,
+                                           lookup_user_data->def_errors,
+                                           lookup_user_data->unit_cache
+                                          );
+    }
+    else
+    {
+        error = TSDef_ConstructUnitFromFile(
+                                            file_name,
+                                            name,
+                                            unit,
+                                            lookup_user_data->def_errors
+                                           );
+    }
 
     free(file_name);
 
+    if(lookup_user_data->stats != NULL)
+    {
+        struct tsutil_unit_stats* unit_stats;
+        int                       stats_error;
+
+        stats_error = TSUtil_AcquireUnitStats(name, lookup_user_data->stats, &unit_stats);
+        if(stats_error == TSUTIL_ERROR_NONE)
+            unit_stats->parse_time += TSUtil_ReadTimer()-parse_start_time;
+    }
+
     if(error != TSDEF_ERROR_NONE)
     {
         if(error != TSDEF_ERROR_CONSTRUCT_WARNING)
         {
             free(unit);
 
-            return TSDEF_ERROR_MODULE_OBJECT_NOT_FOUND;
+            error = TSDEF_ERROR_MODULE_OBJECT_NOT_FOUND;
+
+            goto construct_unit_failed;
         }
 
         lookup_user_data->warning_count++;
@@ -98,12 +174,26 @@ static int ModuleObjectLookup (
         TSDef_DestroyUnit(unit);
         free(unit);
 
-        return TSDEF_ERROR_MEMORY;
+        error = TSDEF_ERROR_MEMORY;
+
+        goto allocate_module_object_failed;
     }
 
     *found_module_object = module_object;
 
-    return TSDEF_ERROR_NONE;
+    error = TSDEF_ERROR_NONE;
+
+allocate_module_object_failed:
+construct_unit_failed:
+allocate_unit_failed:
+find_unit_file_failed:
+    if(lookup_user_data->stats != NULL)
+    {
+        lookup_user_data->stats->lookup_count++;
+        lookup_user_data->stats->lookup_time += TSUtil_ReadTimer()-start_time;
+    }
+
+    return error;
 }
 
 
@@ -112,17 +202,21 @@ int TSUtil_CompileUnit (
                         unsigned int                   flags,
                         struct tsutil_path_collection* search_paths,
                         char*                          unit_extension,
+                        struct tsutil_unit_cache*      unit_cache,
+                        struct tsutil_compile_stats*   stats,
                         notify_lookup_function         notify_lookup,
                         struct tsdef_def_error_list*   def_errors,
                         struct tsdef_module*           module
                        )
 {
-    struct lookup_data            lookup_user_data;
+    struct lookup_data            local_lookup_data;
+    struct lookup_data*           lookup_user_data;
     struct tsdef_argument_types   argument_types;
     struct tsdef_unit*            main_unit;
     struct tsdef_module_object*   existing_object;
     char*                         main_source;
     size_t                        main_source_length;
+    double                        start_time;
     int                           error;
     int                           return_error;
 
@@ -130,12 +224,27 @@ int TSUtil_CompileUnit (
     if(existing_object != NULL)
         goto module_main_name_not_unique;
 
+    if(stats != NULL)
+        start_time = TSUtil_ReadTimer();
+
     return_error = TSUTIL_ERROR_MEMORY;
 
     main_unit = malloc(sizeof(struct tsdef_unit));
     if(main_unit == NULL)
         goto allocate_main_unit_failed;
 
+    if(flags&TSUTIL_COMPILE_FLAG_DEFER_RESOLVE)
+    {
+        lookup_user_data = malloc(sizeof(struct lookup_data));
+        if(lookup_user_data == NULL)
+            goto allocate_lookup_data_failed;
+
+        module->flags                |= TSDEF_MODULE_FLAG_DEFER_RESOLVE|TSDEF_MODULE_FLAG_FREE_LOOKUP_DATA;
+        module->deferred_lookup_data  = lookup_user_data;
+    }
+    else
+        lookup_user_data = &local_lookup_data;
+
     main_source_length = strlen(invocation);
 
     if(flags&TSUTIL_COMPILE_FLAG_CAPTURE_OUTPUT)
@@ -155,16 +264,32 @@ int TSUtil_CompileUnit (
     strcat(main_source, invocation);
     strcat(main_source, "\n");
 
-    lookup_user_data.warning_count   = 0;
-    lookup_user_data.unit_extension  = unit_extension;
-    lookup_user_data.path_collection = search_paths;
-    lookup_user_data.def_errors      = def_errors;
-    lookup_user_data.notify_lookup   = notify_lookup;
+    /* Directories are checked for changes once per compile rather than on
+       every unit lookup */
+    TSUtil_ExpirePathIndices(search_paths);
+
+    lookup_user_data->warning_count   = 0;
+    lookup_user_data->unit_extension  = unit_extension;
+    lookup_user_data->path_collection = search_paths;
+    lookup_user_data->unit_cache      = unit_cache;
+    lookup_user_data->stats           = stats;
+    lookup_user_data->def_errors      = def_errors;
+    lookup_user_data->notify_lookup   = notify_lookup;
 
     error = TSDef_ConstructUnitFromString(main_source, "_module_main", main_unit, def_errors);
 
     free(main_source);
 
+    if(stats != NULL)
+    {
+        struct tsutil_unit_stats* unit_stats;
+        int                       stats_error;
+
+        stats_error = TSUtil_AcquireUnitStats("_module_main", stats, &unit_stats);
+        if(stats_error == TSUTIL_ERROR_NONE)
+            unit_stats->parse_time += TSUtil_ReadTimer()-start_time;
+    }
+
     if(error != TSDEF_ERROR_NONE)
     {
         if(error != TSDEF_ERROR_CONSTRUCT_WARNING)
@@ -174,7 +299,15 @@ int TSUtil_CompileUnit (
             goto construct_main_unit_failed;
         }
         else
-            lookup_user_data.warning_count++;
+            lookup_user_data->warning_count++;
+    }
+
+    /* The hook is only installed once nothing but the resolve below can
+       fail, since it is cleared again right after it */
+    if(stats != NULL)
+    {
+        module->resolve_notify      = &ResolveNotify;
+        module->resolve_notify_data = lookup_user_data;
     }
 
     TSDef_SetModuleMain(main_unit, module);
@@ -188,9 +321,21 @@ int TSUtil_CompileUnit (
                               TSDEF_MODULE_OBJECT_FLAG_FREE_UNIT,
                               module,
                               &ModuleObjectLookup,
-                              &lookup_user_data,
+                              lookup_user_data,
                               def_errors
                              );
+
+    if(stats != NULL)
+    {
+        module->resolve_notify      = NULL;
+        module->resolve_notify_data = NULL;
+        lookup_user_data->stats     = NULL;
+
+        TSUtil_CollectModuleStats(module, stats);
+
+        stats->compile_time = TSUtil_ReadTimer()-start_time;
+    }
+
     if(error != TSDEF_ERROR_NONE)
     {
         if(error != TSDEF_ERROR_RESOLVE_WARNING)
@@ -205,10 +350,10 @@ int TSUtil_CompileUnit (
             return TSUTIL_ERROR_COMPILATION_ERROR;
         }
         else
-            lookup_user_data.warning_count++;
+            lookup_user_data->warning_count++;
     }
 
-    if(lookup_user_data.warning_count != 0)
+    if(lookup_user_data->warning_count != 0)
         return TSUTIL_ERROR_COMPILATION_WARNING;
 
     return TSUTIL_ERROR_NONE;
@@ -216,6 +361,7 @@ int TSUtil_CompileUnit (
 construct_main_unit_failed:
     TSDef_DestroyUnit(main_unit);
 allocate_main_source_failed:
+allocate_lookup_data_failed:
     free(main_unit);
 
 allocate_main_unit_failed:
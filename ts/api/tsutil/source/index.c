@@ -0,0 +1,257 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#include "index.h"
+
+#include <tsutil/error.h>
+
+#include <stdlib.h>
+#include <malloc.h>
+#include <string.h>
+#include <ctype.h>
+
+
+#define HASH_FNV_PRIME 16777619
+
+/* Win32 file names are case insensitive, elsewhere a unit name has to
+   match its file name exactly */
+#ifdef PLATFORM_WIN32
+    #define FOLD_CASE(character) tolower((unsigned char)(character))
+#else
+    #define FOLD_CASE(character) ((unsigned char)(character))
+#endif
+
+
+static unsigned int ComputeHash  (char*, size_t);
+static int          CompareNames (char*, char*, size_t);
+
+static void ClearPathIndex (struct tsutil_path_index*);
+static int  IndexFile      (char*, void*);
+
+
+static unsigned int ComputeHash (char* name, size_t length)
+{
+    unsigned int hash;
+
+    hash = 0;
+    while(length--)
+    {
+        hash *= HASH_FNV_PRIME;
+        hash ^= FOLD_CASE(*name);
+
+        name++;
+    }
+
+    hash = hash%TSUTIL_PATH_INDEX_HASH_SIZE;
+
+    return hash;
+}
+
+static int CompareNames (char* first_name, char* second_name, size_t length)
+{
+    while(length--)
+    {
+        if(FOLD_CASE(*first_name) != FOLD_CASE(*second_name))
+            return 1;
+
+        first_name++;
+        second_name++;
+    }
+
+    return 0;
+}
+
+static void ClearPathIndex (struct tsutil_path_index* index)
+{
+    unsigned int hash;
+
+    for(hash = 0; hash < TSUTIL_PATH_INDEX_HASH_SIZE; hash++)
+    {
+        struct tsutil_indexed_file* file;
+
+        file = index->hash_map[hash];
+        while(file != NULL)
+        {
+            struct tsutil_indexed_file* free_file;
+
+            free_file = file;
+            file      = file->next_file;
+
+            free(free_file->name);
+            free(free_file);
+        }
+
+        index->hash_map[hash] = NULL;
+    }
+
+    index->flags &= ~(TSUTIL_PATH_INDEX_FLAG_BUILT|TSUTIL_PATH_INDEX_FLAG_CURRENT);
+}
+
+static int IndexFile (char* file_name, void* user_data)
+{
+    struct tsutil_path_index*   index;
+    struct tsutil_indexed_file* file;
+    size_t                      file_name_length;
+    size_t                      extension_length;
+    size_t                      name_length;
+    unsigned int                hash;
+    int                         result;
+
+    index = user_data;
+
+    file_name_length = strlen(file_name);
+    extension_length = strlen(index->extension);
+    if(file_name_length <= extension_length)
+        return TSUTIL_ERROR_NONE;
+
+    name_length = file_name_length-extension_length;
+
+    result = CompareNames(&file_name[name_length], index->extension, extension_length);
+    if(result != 0)
+        return TSUTIL_ERROR_NONE;
+
+    file = malloc(sizeof(struct tsutil_indexed_file));
+    if(file == NULL)
+        goto allocate_file_failed;
+
+    file->name = malloc(name_length+1);
+    if(file->name == NULL)
+        goto allocate_name_failed;
+
+    memcpy(file->name, file_name, name_length);
+    file->name[name_length] = 0;
+
+    hash = ComputeHash(file->name, name_length);
+
+    file->next_file       = index->hash_map[hash];
+    index->hash_map[hash] = file;
+
+    return TSUTIL_ERROR_NONE;
+
+allocate_name_failed:
+    free(file);
+
+allocate_file_failed:
+    return TSUTIL_ERROR_MEMORY;
+}
+
+
+int TSUtil_AllocPathIndex (struct tsutil_path_index** index)
+{
+    struct tsutil_path_index* allocated_index;
+    unsigned int              hash;
+
+    allocated_index = malloc(sizeof(struct tsutil_path_index));
+    if(allocated_index == NULL)
+        return TSUTIL_ERROR_MEMORY;
+
+    allocated_index->extension = NULL;
+    allocated_index->flags     = 0;
+
+    for(hash = 0; hash < TSUTIL_PATH_INDEX_HASH_SIZE; hash++)
+        allocated_index->hash_map[hash] = NULL;
+
+    *index = allocated_index;
+
+    return TSUTIL_ERROR_NONE;
+}
+
+void TSUtil_FreePathIndex (struct tsutil_path_index* index)
+{
+    ClearPathIndex(index);
+
+    if(index->flags&TSUTIL_PATH_INDEX_FLAG_WATCHED)
+        TSUtil_CloseDirectoryWatch(index->watch);
+
+    free(index->extension);
+    free(index);
+}
+
+void TSUtil_ExpirePathIndex (struct tsutil_path_index* index)
+{
+    index->flags &= ~TSUTIL_PATH_INDEX_FLAG_CURRENT;
+}
+
+int TSUtil_RefreshPathIndex (char* path, char* extension, struct tsutil_path_index* index)
+{
+    int error;
+
+    /* An index is checked at most once per compile, after that lookups
+       trust it until it is expired again */
+    if(index->flags&TSUTIL_PATH_INDEX_FLAG_BUILT && strcmp(index->extension, extension) == 0)
+    {
+        if(index->flags&TSUTIL_PATH_INDEX_FLAG_CURRENT)
+            return TSUTIL_ERROR_NONE;
+
+        if(index->flags&TSUTIL_PATH_INDEX_FLAG_WATCHED)
+        {
+            error = TSUtil_TestDirectoryWatch(index->watch);
+            if(error == TSUTIL_DIRECTORY_UNCHANGED)
+            {
+                index->flags |= TSUTIL_PATH_INDEX_FLAG_CURRENT;
+
+                return TSUTIL_ERROR_NONE;
+            }
+        }
+    }
+
+    ClearPathIndex(index);
+
+    if(index->extension == NULL || strcmp(index->extension, extension) != 0)
+    {
+        char* duplicate_extension;
+
+        duplicate_extension = strdup(extension);
+        if(duplicate_extension == NULL)
+            return TSUTIL_ERROR_MEMORY;
+
+        free(index->extension);
+
+        index->extension = duplicate_extension;
+    }
+
+    if(!(index->flags&TSUTIL_PATH_INDEX_FLAG_WATCHED))
+    {
+        error = TSUtil_OpenDirectoryWatch(path, &index->watch);
+        if(error == TSUTIL_ERROR_NONE)
+            index->flags |= TSUTIL_PATH_INDEX_FLAG_WATCHED;
+    }
+
+    error = TSUtil_ScanDirectory(path, extension, &IndexFile, index);
+    if(error != TSUTIL_ERROR_NONE)
+    {
+        ClearPathIndex(index);
+
+        return error;
+    }
+
+    index->flags |= TSUTIL_PATH_INDEX_FLAG_BUILT|TSUTIL_PATH_INDEX_FLAG_CURRENT;
+
+    return TSUTIL_ERROR_NONE;
+}
+
+int TSUtil_LookupPathIndex (char* name, struct tsutil_path_index* index)
+{
+    struct tsutil_indexed_file* file;
+    size_t                      name_length;
+    unsigned int                hash;
+
+    name_length = strlen(name);
+    hash        = ComputeHash(name, name_length);
+
+    for(file = index->hash_map[hash]; file != NULL; file = file->next_file)
+    {
+        int result;
+
+        result = CompareNames(file->name, name, name_length+1);
+        if(result == 0)
+            return TSUTIL_ERROR_NONE;
+    }
+
+    return TSUTIL_ERROR_NOT_FOUND;
+}
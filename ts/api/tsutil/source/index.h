@@ -0,0 +1,75 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#ifndef _TSUTIL_INDEX_H_
+#define _TSUTIL_INDEX_H_
+
+
+#ifdef PLATFORM_WIN32
+    #include <windows.h>
+
+    typedef HANDLE tsutil_directory_watch;
+#else
+    /* Without a notification backend no directory can be watched, so
+       each index is rescanned once per compile */
+    typedef int tsutil_directory_watch;
+#endif
+
+
+#define TSUTIL_PATH_INDEX_HASH_SIZE 256
+
+#define TSUTIL_PATH_INDEX_FLAG_BUILT   0x01
+#define TSUTIL_PATH_INDEX_FLAG_WATCHED 0x02
+#define TSUTIL_PATH_INDEX_FLAG_CURRENT 0x04
+
+#define TSUTIL_DIRECTORY_UNCHANGED 0
+#define TSUTIL_DIRECTORY_CHANGED   1
+
+
+typedef int (*tsutil_directory_entry_function) (char*, void*);
+
+
+struct tsutil_indexed_file
+{
+    char* name;
+
+    struct tsutil_indexed_file* next_file;
+};
+
+struct tsutil_path_index
+{
+    char* extension;
+
+    unsigned int flags;
+
+    tsutil_directory_watch watch;
+
+    struct tsutil_indexed_file* hash_map[TSUTIL_PATH_INDEX_HASH_SIZE];
+};
+
+
+extern int  TSUtil_AllocPathIndex (struct tsutil_path_index**);
+extern void TSUtil_FreePathIndex  (struct tsutil_path_index*);
+
+extern void TSUtil_ExpirePathIndex  (struct tsutil_path_index*);
+extern int  TSUtil_RefreshPathIndex (char*, char*, struct tsutil_path_index*);
+extern int  TSUtil_LookupPathIndex  (char*, struct tsutil_path_index*);
+
+extern int  TSUtil_OpenDirectoryWatch  (char*, tsutil_directory_watch*);
+extern void TSUtil_CloseDirectoryWatch (tsutil_directory_watch);
+extern int  TSUtil_TestDirectoryWatch  (tsutil_directory_watch);
+
+extern int TSUtil_ScanDirectory (
+                                 char*,
+                                 char*,
+                                 tsutil_directory_entry_function,
+                                 void*
+                                );
+
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#include "index.h"
+
+#include <tsutil/error.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+
+int TSUtil_OpenDirectoryWatch (char* path, tsutil_directory_watch* watch)
+{
+    return TSUTIL_ERROR_NOT_FOUND;
+}
+
+void TSUtil_CloseDirectoryWatch (tsutil_directory_watch watch)
+{
+}
+
+int TSUtil_TestDirectoryWatch (tsutil_directory_watch watch)
+{
+    return TSUTIL_DIRECTORY_CHANGED;
+}
+
+int TSUtil_ScanDirectory (
+                          char*                           path,
+                          char*                           extension,
+                          tsutil_directory_entry_function entry_function,
+                          void*                           user_data
+                         )
+{
+    DIR*           directory;
+    struct dirent* entry;
+    char*          entry_path;
+    size_t         path_length;
+    int            error;
+
+    directory = opendir(path);
+    if(directory == NULL)
+        return TSUTIL_ERROR_NONE;
+
+    path_length = strlen(path);
+
+    while((entry = readdir(directory)) != NULL)
+    {
+        struct stat stat_data;
+        int         result;
+
+        entry_path = malloc(path_length+strlen(entry->d_name)+sizeof("/"));
+        if(entry_path == NULL)
+        {
+            error = TSUTIL_ERROR_MEMORY;
+
+            goto allocate_entry_path_failed;
+        }
+
+        strcpy(entry_path, path);
+        strcat(entry_path, "/");
+        strcat(entry_path, entry->d_name);
+
+        result = stat(entry_path, &stat_data);
+
+        free(entry_path);
+
+        if(result != 0 || S_ISDIR(stat_data.st_mode))
+            continue;
+
+        error = entry_function(entry->d_name, user_data);
+        if(error != TSUTIL_ERROR_NONE)
+            goto entry_function_failed;
+    }
+
+    closedir(directory);
+
+    return TSUTIL_ERROR_NONE;
+
+entry_function_failed:
+allocate_entry_path_failed:
+    closedir(directory);
+
+    return error;
+}
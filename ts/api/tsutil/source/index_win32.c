@@ -0,0 +1,94 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#include "index.h"
+
+#include <tsutil/error.h>
+
+#include <stdlib.h>
+#include <malloc.h>
+#include <string.h>
+
+
+int TSUtil_OpenDirectoryWatch (char* path, tsutil_directory_watch* watch)
+{
+    HANDLE notification;
+
+    notification = FindFirstChangeNotificationA(path, FALSE, FILE_NOTIFY_CHANGE_FILE_NAME);
+    if(notification == INVALID_HANDLE_VALUE)
+        return TSUTIL_ERROR_NOT_FOUND;
+
+    *watch = notification;
+
+    return TSUTIL_ERROR_NONE;
+}
+
+void TSUtil_CloseDirectoryWatch (tsutil_directory_watch watch)
+{
+    FindCloseChangeNotification(watch);
+}
+
+int TSUtil_TestDirectoryWatch (tsutil_directory_watch watch)
+{
+    DWORD result;
+
+    result = WaitForSingleObject(watch, 0);
+    if(result == WAIT_TIMEOUT)
+        return TSUTIL_DIRECTORY_UNCHANGED;
+
+    FindNextChangeNotification(watch);
+
+    return TSUTIL_DIRECTORY_CHANGED;
+}
+
+int TSUtil_ScanDirectory (
+                          char*                           path,
+                          char*                           extension,
+                          tsutil_directory_entry_function entry_function,
+                          void*                           user_data
+                         )
+{
+    WIN32_FIND_DATAA find_data;
+    HANDLE           find_handle;
+    char*            pattern;
+    int              error;
+
+    pattern = malloc(strlen(path)+sizeof("\\*")+strlen(extension));
+    if(pattern == NULL)
+        return TSUTIL_ERROR_MEMORY;
+
+    strcpy(pattern, path);
+    strcat(pattern, "\\*");
+    strcat(pattern, extension);
+
+    find_handle = FindFirstFileA(pattern, &find_data);
+
+    free(pattern);
+
+    if(find_handle == INVALID_HANDLE_VALUE)
+        return TSUTIL_ERROR_NONE;
+
+    do
+    {
+        if(find_data.dwFileAttributes&FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+
+        error = entry_function(find_data.cFileName, user_data);
+        if(error != TSUTIL_ERROR_NONE)
+            goto entry_function_failed;
+    }while(FindNextFileA(find_handle, &find_data));
+
+    FindClose(find_handle);
+
+    return TSUTIL_ERROR_NONE;
+
+entry_function_failed:
+    FindClose(find_handle);
+
+    return error;
+}
@@ -9,10 +9,11 @@
 #include <tsutil/path.h>
 #include <tsutil/error.h>
 
+#include "index.h"
+
 #include <stdlib.h>
 #include <malloc.h>
 #include <string.h>
-#include <sys/stat.h>
 
 
 void TSUtil_InitializePathCollection (struct tsutil_path_collection* collection)
@@ -31,6 +32,9 @@ void TSUtil_DestroyPathCollection (struct tsutil_path_collection* collection)
     {
         struct tsutil_path* free_path;
 
+        if(path->index != NULL)
+            TSUtil_FreePathIndex(path->index);
+
         free(path->path);
 
         free_path = path;
@@ -53,6 +57,8 @@ int TSUtil_AppendPath (char* path_name, struct tsutil_path_collection* collectio
     if(path->path == NULL)
         goto duplicate_path_name_failed;
 
+    path->index = NULL;
+
     path->next_path = NULL;
     if(collection->last_path != NULL)
         collection->last_path->next_path = path;
@@ -87,6 +93,8 @@ int TSUtil_PrependPath (char* path_name, struct tsutil_path_collection* collecti
     if(path->path == NULL)
         goto duplicate_path_name_failed;
 
+    path->index = NULL;
+
     path->next_path = collection->first_path;
     if(collection->first_path == NULL)
         collection->last_path = path;
@@ -113,6 +121,17 @@ allocated_path_failed:
     return TSUTIL_ERROR_MEMORY;
 }
 
+void TSUtil_ExpirePathIndices (struct tsutil_path_collection* collection)
+{
+    struct tsutil_path* path;
+
+    for(path = collection->first_path; path != NULL; path = path->next_path)
+    {
+        if(path->index != NULL)
+            TSUtil_ExpirePathIndex(path->index);
+    }
+}
+
 int TSUtil_FindUnitFile (
                          char*                          name,
                          char*                          extension,
@@ -120,36 +139,41 @@ int TSUtil_FindUnitFile (
                          char**                         found_path
                         )
 {
-    struct stat         stat_data;
     char*               search_path;
     struct tsutil_path* path;
-    size_t              file_name_length;
-    int                 result;
-
-    file_name_length = sizeof("/")+strlen(name)+strlen(extension)+sizeof("/")+1;
-
-    search_path = malloc(path_collection->max_path_length+file_name_length);
-    if(search_path == NULL)
-        return TSUTIL_ERROR_MEMORY;
+    int                 error;
 
     for(path = path_collection->first_path; path != NULL; path = path->next_path)
     {
-        strcpy(search_path, path->path);
-        strcat(search_path, "/");
-        strcat(search_path, name);
-        strcat(search_path, extension);
-
-        result = stat(search_path, &stat_data);
-        if(result == 0)
+        if(path->index == NULL)
         {
-            *found_path = search_path;
-
-            return TSUTIL_ERROR_NONE;
+            error = TSUtil_AllocPathIndex(&path->index);
+            if(error != TSUTIL_ERROR_NONE)
+                return error;
         }
+
+        error = TSUtil_RefreshPathIndex(path->path, extension, path->index);
+        if(error != TSUTIL_ERROR_NONE)
+            return error;
+
+        error = TSUtil_LookupPathIndex(name, path->index);
+        if(error == TSUTIL_ERROR_NONE)
+            break;
     }
 
-    free(search_path);
+    if(path == NULL)
+        return TSUTIL_ERROR_NOT_FOUND;
 
-    return TSUTIL_ERROR_NOT_FOUND;
-}
+    search_path = malloc(strlen(path->path)+sizeof("/")+strlen(name)+strlen(extension));
+    if(search_path == NULL)
+        return TSUTIL_ERROR_MEMORY;
+
+    strcpy(search_path, path->path);
+    strcat(search_path, "/");
+    strcat(search_path, name);
+    strcat(search_path, extension);
 
+    *found_path = search_path;
+
+    return TSUTIL_ERROR_NONE;
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#include <tsutil/stats.h>
+#include <tsutil/error.h>
+
+#include <tsdef/def.h>
+
+#include <stdlib.h>
+#include <malloc.h>
+#include <string.h>
+
+
+void TSUtil_InitializeCompileStats (struct tsutil_compile_stats* stats)
+{
+    stats->unit_stats                = NULL;
+    stats->last_unit_stats           = NULL;
+    stats->unit_count                = 0;
+    stats->lookup_count              = 0;
+    stats->lookup_time               = 0.0;
+    stats->compile_time              = 0.0;
+    stats->resolve_start_time        = 0.0;
+    stats->resolve_start_lookup_time = 0.0;
+}
+
+void TSUtil_DestroyCompileStats (struct tsutil_compile_stats* stats)
+{
+    struct tsutil_unit_stats* unit_stats;
+
+    unit_stats = stats->unit_stats;
+    while(unit_stats != NULL)
+    {
+        struct tsutil_unit_stats* free_unit_stats;
+
+        free_unit_stats = unit_stats;
+        unit_stats      = unit_stats->next_unit_stats;
+
+        free(free_unit_stats->name);
+        free(free_unit_stats);
+    }
+
+    stats->unit_stats      = NULL;
+    stats->last_unit_stats = NULL;
+    stats->unit_count      = 0;
+}
+
+int TSUtil_AcquireUnitStats (
+                             char*                        name,
+                             struct tsutil_compile_stats* stats,
+                             struct tsutil_unit_stats**   acquired_unit_stats
+                            )
+{
+    struct tsutil_unit_stats* unit_stats;
+
+    for(unit_stats = stats->unit_stats; unit_stats != NULL; unit_stats = unit_stats->next_unit_stats)
+    {
+        if(strcmp(unit_stats->name, name) == 0)
+        {
+            *acquired_unit_stats = unit_stats;
+
+            return TSUTIL_ERROR_NONE;
+        }
+    }
+
+    unit_stats = malloc(sizeof(struct tsutil_unit_stats));
+    if(unit_stats == NULL)
+        goto allocate_unit_stats_failed;
+
+    unit_stats->name = strdup(name);
+    if(unit_stats->name == NULL)
+        goto duplicate_name_failed;
+
+    unit_stats->parse_time           = 0.0;
+    unit_stats->resolve_time         = 0.0;
+    unit_stats->specialization_count = 0;
+    unit_stats->node_count           = 0;
+    unit_stats->estimated_bytes      = 0;
+    unit_stats->next_unit_stats      = NULL;
+
+    if(stats->last_unit_stats != NULL)
+        stats->last_unit_stats->next_unit_stats = unit_stats;
+    else
+        stats->unit_stats = unit_stats;
+
+    stats->last_unit_stats = unit_stats;
+    stats->unit_count++;
+
+    *acquired_unit_stats = unit_stats;
+
+    return TSUTIL_ERROR_NONE;
+
+duplicate_name_failed:
+    free(unit_stats);
+
+allocate_unit_stats_failed:
+    return TSUTIL_ERROR_MEMORY;
+}
+
+int TSUtil_CollectModuleStats (struct tsdef_module* module, struct tsutil_compile_stats* stats)
+{
+    struct tsdef_module_object* unit_groups[3];
+    unsigned int                index;
+
+    unit_groups[0] = module->referenced_unit_objects;
+    unit_groups[1] = module->unresolved_unit_objects;
+    unit_groups[2] = module->template_unit_objects;
+
+    for(index = 0; index < sizeof(unit_groups)/sizeof(unit_groups[0]); index++)
+    {
+        struct tsdef_module_object* module_object;
+
+        for(
+            module_object = unit_groups[index];
+            module_object != NULL;
+            module_object = module_object->next_module_object
+           )
+        {
+            struct tsutil_unit_stats* unit_stats;
+            struct tsdef_unit_measure measure;
+            int                       error;
+
+            error = TSUtil_AcquireUnitStats(module_object->type.unit->name, stats, &unit_stats);
+            if(error != TSUTIL_ERROR_NONE)
+                return error;
+
+            if(module_object->flags&TSDEF_MODULE_OBJECT_FLAG_TYPED_UNIT)
+                unit_stats->specialization_count++;
+
+            if(module_object->flags&TSDEF_MODULE_OBJECT_FLAG_SHARED_OBJECT)
+                continue;
+
+            TSDef_MeasureUnit(module_object->type.unit, &measure);
+
+            unit_stats->node_count += measure.node_count;
+            unit_stats->estimated_bytes += measure.estimated_bytes;
+        }
+    }
+
+    return TSUTIL_ERROR_NONE;
+}
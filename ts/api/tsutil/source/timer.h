@@ -0,0 +1,16 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#ifndef _TSUTIL_TIMER_H_
+#define _TSUTIL_TIMER_H_
+
+
+extern double TSUtil_ReadTimer (void);
+
+
+#endif
@@ -0,0 +1,21 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#include "timer.h"
+
+#include <time.h>
+
+
+double TSUtil_ReadTimer (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec+(double)now.tv_nsec/1000000000.0;
+}
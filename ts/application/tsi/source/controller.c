@@ -132,6 +132,16 @@ unsigned int TSI_Controller (struct tsint_unit_state* state, void* user_data)
         case TSINT_EXCEPTION_HALT:
             printf("Instructed to halt");
 
+            break;
+
+        case TSINT_EXCEPTION_RESOLVE:
+            printf("Failed to resolve function");
+
+            break;
+
+        case TSINT_EXCEPTION_WAIT:
+            printf("Failed to wait for an action");
+
             break;
         }
 
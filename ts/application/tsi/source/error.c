@@ -227,6 +227,19 @@ void TSI_ReportDefErrors (struct tsdef_def_error_list* error_list)
 
             break;
 
+        case TSDEF_DEF_ERROR_ASYNC_FUNCTION_IN_EXPRESSION:
+            if(def_error->flags&TSDEF_DEF_ERROR_FLAG_INFO_VALID)
+            {
+                printf(
+                       "Function '%s' must make up a whole statement or assignment",
+                       def_error->info.data.async_function_in_expression.name
+                      );
+            }
+            else
+                printf("Background function used inside an expression");
+
+            break;
+
         default:
             printf("Unknown error");
 
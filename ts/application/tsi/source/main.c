@@ -11,6 +11,7 @@
 #include "controller.h"
 #include "execif.h"
 #include "register.h"
+#include "stats.h"
 
 #include <tsdef/def.h>
 #include <tsdef/deferror.h>
@@ -47,15 +48,20 @@ struct tsutil_path_collection tsi_search_paths;
 char*                         tsi_unit_invocation;
 struct tsi_variable*          tsi_set_variables;
 unsigned int                  tsi_flags;
+unsigned int                  tsi_worker_count;
+struct tsint_wait_policy      tsi_wait_policy;
 
 
 int main (int argument_count, char* argument_list[])
 {
-    struct tsdef_def_error_list def_errors;
-    char*                       program_directory;
-    char*                       program_path;
-    int                         error;
-    errno_t                     std_error;
+    struct tsdef_def_error_list  def_errors;
+    struct tsutil_compile_stats  compile_stats;
+    struct tsutil_compile_stats* stats;
+    char*                        program_directory;
+    char*                        program_path;
+    unsigned int                 compile_flags;
+    int                          error;
+    errno_t                      std_error;
 
     signal(SIGINT, NullSignalHandler);
 
@@ -80,6 +86,10 @@ int main (int argument_count, char* argument_list[])
     tsi_unit_invocation = NULL;
     tsi_set_variables   = NULL;
     tsi_flags           = 0;
+    tsi_worker_count    = 0;
+
+    tsi_wait_policy.mode      = TSINT_WAIT_BLOCK;
+    tsi_wait_policy.spin_time = 0;
 
     error = ProcessCommandLine(argument_count, argument_list);
     if(error < 0)
@@ -131,15 +141,36 @@ int main (int argument_count, char* argument_list[])
 
     printf("Compiling trigger script...\n");
 
+    compile_flags = 0;
+    if(tsi_flags&TSI_FLAG_LAZY_RESOLVE)
+        compile_flags |= TSUTIL_COMPILE_FLAG_DEFER_RESOLVE;
+
+    TSUtil_InitializeCompileStats(&compile_stats);
+
+    if(tsi_flags&(TSI_FLAG_STATS_TABLE|TSI_FLAG_STATS_JSON))
+        stats = &compile_stats;
+    else
+        stats = NULL;
+
     error = TSUtil_CompileUnit(
                                tsi_unit_invocation,
-                               0,
+                               compile_flags,
                                &tsi_search_paths,
                                TSI_SOURCE_EXTENSION,
+                               NULL,
+                               stats,
                                &NotifyLookup,
                                &def_errors,
                                &tsi_module
                               );
+
+    if(tsi_flags&TSI_FLAG_STATS_TABLE)
+        TSI_ReportCompileStats(&compile_stats);
+    if(tsi_flags&TSI_FLAG_STATS_JSON)
+        TSI_ReportCompileStatsJSON(&compile_stats);
+
+    TSUtil_DestroyCompileStats(&compile_stats);
+
     if(error != TSDEF_ERROR_NONE)
     {
         if(error == TSUTIL_ERROR_COMPILATION_ERROR || error == TSUTIL_ERROR_COMPILATION_WARNING)
@@ -152,6 +183,7 @@ int main (int argument_count, char* argument_list[])
     }
 
     TSDef_DestroyDefErrorList(&def_errors);
+    TSDef_InitializeDefErrorList(&def_errors);
 
     printf("Compilation successful\n");
 
@@ -209,10 +241,17 @@ int main (int argument_count, char* argument_list[])
                                           NULL,
                                           &controller,
                                           &execif,
-                                          abort_signal
+                                          abort_signal,
+                                          tsi_worker_count,
+                                          &tsi_wait_policy
                                          );
             if(error != TSINT_ERROR_NONE)
+            {
+                if(def_errors.encountered_errors != NULL)
+                    TSI_ReportDefErrors(&def_errors);
+
                 printf("Trigger script halted due to exception\n");
+            }
 
             signal(SIGINT, NullSignalHandler);
 
@@ -220,6 +259,8 @@ int main (int argument_count, char* argument_list[])
         }
     }
 
+    TSDef_DestroyDefErrorList(&def_errors);
+
 exit_gracefully:
     DestroyVariables();
     TSDef_DestroyModule(&tsi_module);
@@ -227,9 +268,9 @@ exit_gracefully:
 
     return 0;
 
+alloc_abort_signal_failed:
 compilation_failed:
     TSDef_DestroyDefErrorList(&def_errors);
-alloc_abort_signal_failed:
 register_ffi_failed:
 allocate_program_directory_failed:
 get_program_path_failed:
@@ -289,6 +330,26 @@ static int ProcessCommandLine (int argument_count, char* argument_list[])
             tsi_flags |= TSI_FLAG_COMPILE_ONLY;
         else if(strncmp(argument, "-d", sizeof("-d")-1) == 0)
             tsi_flags |= TSI_FLAG_DEBUG;
+        else if(strncmp(argument, "-l", sizeof("-l")-1) == 0)
+            tsi_flags |= TSI_FLAG_LAZY_RESOLVE;
+        else if(strncmp(argument, "-s", sizeof("-s")-1) == 0)
+            tsi_flags |= TSI_FLAG_STATS_TABLE;
+        else if(strncmp(argument, "-j", sizeof("-j")-1) == 0)
+            tsi_flags |= TSI_FLAG_STATS_JSON;
+        else if(strncmp(argument, "-t", sizeof("-t")-1) == 0)
+            tsi_worker_count = strtoul(&argument[sizeof("-t")-1], NULL, 10);
+        else if(strcmp(argument, "-wpoll") == 0)
+            tsi_wait_policy.mode = TSINT_WAIT_POLL;
+        else if(strcmp(argument, "-wvirtual") == 0)
+            tsi_wait_policy.mode = TSINT_WAIT_VIRTUAL_TIME;
+        else if(strncmp(argument, "-w", sizeof("-w")-1) == 0)
+        {
+            tsi_wait_policy.mode      = TSINT_WAIT_SPIN;
+            tsi_wait_policy.spin_time = strtoul(&argument[sizeof("-w")-1], NULL, 10);
+
+            if(tsi_wait_policy.spin_time == 0)
+                tsi_wait_policy.mode = TSINT_WAIT_BLOCK;
+        }
         else if(strcmp(argument, "--help") == 0)
             goto print_help;
         else
@@ -448,6 +509,13 @@ print_help:
            "    -v<name>=<value>\tSpecify a variable to be communicated to all loaded TS plugins\n"
            "    -c\t\t\tCompile but don't execute\n"
            "    -d\t\t\tStep into source and debug upon beginning execution \n"
+           "    -l\t\t\tDefer resolving called functions until they are first executed\n"
+           "    -s\t\t\tPrint a table of per function compile statistics\n"
+           "    -j\t\t\tPrint per function compile statistics as JSON\n"
+           "    -t<count>\t\tRun independent units on up to <count> threads\n"
+           "    -w<ms>\t\tSpin for up to <ms> milliseconds before sleeping on an action\n"
+           "    -wpoll\t\tPoll for actions without ever sleeping\n"
+           "    -wvirtual\t\tRun timers in virtual time, skipping ahead whenever idle\n"
            "\n"
            "Options specifying search paths are listed in priority order.  Paths listed first will\n"
            " be searched first.  If multiple functions are specified, the last specified function\n"
@@ -18,6 +18,9 @@
 
 #define TSI_FLAG_COMPILE_ONLY 0x01
 #define TSI_FLAG_DEBUG        0x02
+#define TSI_FLAG_LAZY_RESOLVE 0x04
+#define TSI_FLAG_STATS_TABLE  0x08
+#define TSI_FLAG_STATS_JSON   0x10
 
 
 struct tsi_variable
@@ -34,6 +37,8 @@ extern struct tsutil_path_collection tsi_search_paths;
 extern char*                         tsi_unit_invocation;
 extern struct tsi_variable*          tsi_set_variables;
 extern unsigned int                  tsi_flags;
+extern unsigned int                  tsi_worker_count;
+extern struct tsint_wait_policy      tsi_wait_policy;
 
 
 #endif
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#include "stats.h"
+
+#include <stdio.h>
+
+
+#define MILLISECONDS_PER_SECOND 1000.0
+
+
+void TSI_ReportCompileStats (struct tsutil_compile_stats* stats)
+{
+    struct tsutil_unit_stats* unit_stats;
+    double                    parse_time;
+    double                    resolve_time;
+    unsigned int              node_count;
+    size_t                    estimated_bytes;
+
+    parse_time      = 0.0;
+    resolve_time    = 0.0;
+    node_count      = 0;
+    estimated_bytes = 0;
+
+    printf(
+           "\n"
+           "%-32s %10s %10s %8s %8s %10s\n",
+           "Function",
+           "Parse ms",
+           "Resolve ms",
+           "Typed",
+           "Nodes",
+           "Est. bytes"
+          );
+
+    for(unit_stats = stats->unit_stats; unit_stats != NULL; unit_stats = unit_stats->next_unit_stats)
+    {
+        printf(
+               "%-32s %10.3f %10.3f %8u %8u %10lu\n",
+               unit_stats->name,
+               unit_stats->parse_time*MILLISECONDS_PER_SECOND,
+               unit_stats->resolve_time*MILLISECONDS_PER_SECOND,
+               unit_stats->specialization_count,
+               unit_stats->node_count,
+               (unsigned long)unit_stats->estimated_bytes
+              );
+
+        parse_time      += unit_stats->parse_time;
+        resolve_time    += unit_stats->resolve_time;
+        node_count      += unit_stats->node_count;
+        estimated_bytes += unit_stats->estimated_bytes;
+    }
+
+    printf(
+           "%-32s %10.3f %10.3f %8s %8u %10lu\n"
+           "\n"
+           "Lookups: %u (%.3f ms)  Total compile: %.3f ms\n",
+           "Total",
+           parse_time*MILLISECONDS_PER_SECOND,
+           resolve_time*MILLISECONDS_PER_SECOND,
+           "",
+           node_count,
+           (unsigned long)estimated_bytes,
+           stats->lookup_count,
+           stats->lookup_time*MILLISECONDS_PER_SECOND,
+           stats->compile_time*MILLISECONDS_PER_SECOND
+          );
+}
+
+void TSI_ReportCompileStatsJSON (struct tsutil_compile_stats* stats)
+{
+    struct tsutil_unit_stats* unit_stats;
+
+    printf(
+           "\n"
+           "{\"compile_ms\": %.3f, \"lookup_count\": %u, \"lookup_ms\": %.3f, \"functions\": [",
+           stats->compile_time*MILLISECONDS_PER_SECOND,
+           stats->lookup_count,
+           stats->lookup_time*MILLISECONDS_PER_SECOND
+          );
+
+    for(unit_stats = stats->unit_stats; unit_stats != NULL; unit_stats = unit_stats->next_unit_stats)
+    {
+        printf(
+               "%s\n  {\"name\": \"%s\", \"parse_ms\": %.3f, \"resolve_ms\": %.3f, "
+               "\"specializations\": %u, \"nodes\": %u, \"estimated_bytes\": %lu}",
+               unit_stats == stats->unit_stats ? "" : ",",
+               unit_stats->name,
+               unit_stats->parse_time*MILLISECONDS_PER_SECOND,
+               unit_stats->resolve_time*MILLISECONDS_PER_SECOND,
+               unit_stats->specialization_count,
+               unit_stats->node_count,
+               (unsigned long)unit_stats->estimated_bytes
+              );
+    }
+
+    printf("\n]}\n");
+}
@@ -0,0 +1,20 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#ifndef _TSI_STATS_H_
+#define _TSI_STATS_H_
+
+
+#include <tsutil/stats.h>
+
+
+extern void TSI_ReportCompileStats     (struct tsutil_compile_stats*);
+extern void TSI_ReportCompileStatsJSON (struct tsutil_compile_stats*);
+
+
+#endif
@@ -413,6 +413,31 @@ struct tside_alert* TSIDE_AlertFromDefError (
 
         break;
 
+    case TSDEF_DEF_ERROR_ASYNC_FUNCTION_IN_EXPRESSION:
+        if(def_error->flags&TSDEF_DEF_ERROR_FLAG_INFO_VALID)
+        {
+            _snprintf(
+                      alert->alert_text,
+                      TSIDE_MAX_ALERT_LENGTH-1,
+                      "%s[%d] Function '%s' must make up a whole statement or assignment",
+                      type_text,
+                      def_error->error,
+                      def_error->info.data.async_function_in_expression.name
+                     );
+        }
+        else
+        {
+            _snprintf(
+                      alert->alert_text,
+                      TSIDE_MAX_ALERT_LENGTH-1,
+                      "%s[%d] This function must make up a whole statement or assignment",
+                      type_text,
+                      def_error->error
+                     );
+        }
+
+        break;
+
     default:
         _snprintf(
                   alert->alert_text,
@@ -28,6 +28,7 @@
 #include <tsint/error.h>
 #include <tsutil/compile.h>
 #include <tsutil/path.h>
+#include <tsutil/cache.h>
 #include <tsutil/error.h>
 
 #include <stdio.h>
@@ -109,6 +110,7 @@ static struct run_module_data*           current_run_module;
 static struct run_module_data            run_module;
 static struct tsint_module_abort_signal* abort_signal;
 static HANDLE                            control_mode_signal;
+static struct tsutil_unit_cache          run_unit_cache;
 
 static struct tsffi_execif module_execif = {NULL, &Alert, &SetExceptionText, NULL, NULL};
 
@@ -362,6 +364,16 @@ static unsigned int Controller (struct tsint_unit_state* state, void* user_data)
 
             break;
 
+        case TSINT_EXCEPTION_RESOLVE:
+            exception_text = "Failed to resolve function";
+
+            break;
+
+        case TSINT_EXCEPTION_WAIT:
+            exception_text = "Failed to wait for an action";
+
+            break;
+
         default:
         case TSINT_EXCEPTION_HALT:
             exception_text= "Instructed to halt";
@@ -427,6 +439,8 @@ static DWORD WINAPI CompileThread (LPVOID user_data)
                                                    0,
                                                    &tside_unit_paths,
                                                    ".ts",
+                                                   &run_unit_cache,
+                                                   NULL,
                                                    NULL,
                                                    &run_module.module_errors,
                                                    &run_module.module_def
@@ -462,7 +476,9 @@ static DWORD WINAPI ExecuteThread (LPVOID user_data)
                                   NULL,
                                   &controller,
                                   &execif,
-                                  abort_signal
+                                  abort_signal,
+                                  0,
+                                  NULL
                                  );
 
     run_module.execution_result = error;
@@ -797,6 +813,8 @@ int TSIDE_InitializeRun (void)
     if(control_mode_signal == NULL)
         goto create_control_mode_signal_failed;
 
+    TSUtil_InitializeUnitCache(&run_unit_cache);
+
     return TSIDE_ERROR_NONE;
 
 create_control_mode_signal_failed:
@@ -807,6 +825,8 @@ allocate_abort_signal_failed:
 
 void TSIDE_ShutdownRun (void)
 {
+    TSUtil_DestroyUnitCache(&run_unit_cache);
+
     CloseHandle(control_mode_signal);
     TSInt_FreeAbortSignal(abort_signal);
 }
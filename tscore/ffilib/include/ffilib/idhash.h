@@ -13,25 +13,39 @@
 #include <stdlib.h>
 
 
-#define FFILIB_ID_HASH_SIZE 256
+#define FFILIB_ID_HASH_INITIAL_CAPACITY 16
 
+#define FFILIB_ID_HASH_ENTRY_FLAG_USED 0x01
 
-struct ffilib_id_hash_node
+
+struct ffilib_id_hash_entry
 {
     unsigned int id;
+    unsigned int flags;
     void*        data;
+};
+
+/* A table is never freed while the hash lives, since a reader on another
+   thread may still be probing it after the table has grown */
+struct ffilib_id_hash_table
+{
+    unsigned int                 capacity;
+    struct ffilib_id_hash_entry* entries;
 
-    struct ffilib_id_hash_node* next_node;
-    struct ffilib_id_hash_node* previous_node;
+    struct ffilib_id_hash_table* retired_table;
 };
 
+/* Writers hold the sequence odd while they change the table, readers
+   retry any lookup that overlapped a change */
 struct ffilib_id_hash
 {
-    struct ffilib_id_hash_node* id_hash[FFILIB_ID_HASH_SIZE];
+    volatile long                         sequence;
+    struct ffilib_id_hash_table* volatile table;
+    unsigned int                          entry_count;
 };
 
 
-#define FFILIB_DECLARE_STATIC_ID_HASH(name) static struct ffilib_id_hash name = {NULL}
+#define FFILIB_DECLARE_STATIC_ID_HASH(name) static struct ffilib_id_hash name = {0, NULL, 0}
 
 
 extern void FFILib_InitializeHash (struct ffilib_id_hash*);
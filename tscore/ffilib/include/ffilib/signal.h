@@ -0,0 +1,22 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#ifndef _FFILIB_SIGNAL_H_
+#define _FFILIB_SIGNAL_H_
+
+
+#include <tsffi/function.h>
+
+
+extern void FFILib_BeginSignalBatch (void);
+extern void FFILib_EndSignalBatch   (void);
+
+extern void FFILib_SignalAction (struct tsffi_invocation_data*);
+
+
+#endif
@@ -28,6 +28,79 @@ char ffilib_doc_pipe[] = "Pipes\n"
                          "    print(read_pipe(0))\n"
                          "end\n";
 
+char ffilib_doc_named_pipe[] = "Pipes\n"
+                               "named_pipe(pipe_name)\n"
+                               "# Create a named pipe that other programs on this machine\n"
+                               "# can connect to and write lines of text into.  The pipe is\n"
+                               "# read like a stream, each line written triggers the listen\n"
+                               "# actions in the same way as a line appended to a file opened\n"
+                               "# with pipe().  Any number of writers may be connected at\n"
+                               "# once, their lines are never mixed.  Writers block once the\n"
+                               "# script falls behind.\n"
+                               "# \n"
+                               "# Syntax:\n"
+                               "# handle = named_pipe(pipe_name)\n"
+                               "# \n"
+                               "# pipe_name: The name of the pipe, created under \\\\.\\pipe\\\n"
+                               "# unless a full pipe path is given\n"
+                               "# \n"
+                               "# Example:\n"
+                               "named_pipe(\"events\")\n"
+                               "\n"
+                               "action listen_pipe()\n"
+                               "    print(read_pipe(0))\n"
+                               "end\n";
+
+char ffilib_doc_message_pipe[] = "Pipes\n"
+                                 "message_pipe(pipe_name)\n"
+                                 "# Create a named pipe that other programs on this machine\n"
+                                 "# can connect to and write messages into.  Each message\n"
+                                 "# written to the pipe is treated as one line and triggers\n"
+                                 "# the listen actions.  Any number of writers may be\n"
+                                 "# connected at once.  Writers block once the script falls\n"
+                                 "# behind.\n"
+                                 "# \n"
+                                 "# Syntax:\n"
+                                 "# handle = message_pipe(pipe_name)\n"
+                                 "# \n"
+                                 "# pipe_name: The name of the pipe, created under \\\\.\\pipe\\\n"
+                                 "# unless a full pipe path is given\n"
+                                 "# \n"
+                                 "# Example:\n"
+                                 "message_pipe(\"events\")\n"
+                                 "\n"
+                                 "action listen_pipe()\n"
+                                 "    print(read_pipe(0))\n"
+                                 "end\n";
+
+char ffilib_doc_frame_pipe[] = "Pipes\n"
+                               "frame_pipe(handle, schema)\n"
+                               "# Switch a pipe from text lines to binary records.  Each\n"
+                               "# record starts with its length in bytes as a 4 byte little\n"
+                               "# endian integer, followed by its fields in the order the\n"
+                               "# schema lists them.  'i' fields are 8 byte integers, 'r'\n"
+                               "# fields are 8 byte doubles and 's' fields are a 4 byte\n"
+                               "# length followed by the text.  read_pipe_int() and\n"
+                               "# read_pipe_real() return framed numbers without parsing\n"
+                               "# them, while the other read functions return them as text.\n"
+                               "# Call it before listening to the pipe.\n"
+                               "# \n"
+                               "# Syntax:\n"
+                               "# frame_pipe(handle, schema)\n"
+                               "# \n"
+                               "# handle: A handle to a pipe returned by pipe(), named_pipe()\n"
+                               "# or message_pipe()\n"
+                               "# \n"
+                               "# schema: The field types of a record, such as \"iir\"\n"
+                               "# \n"
+                               "# Example:\n"
+                               "p = named_pipe(\"telemetry\")\n"
+                               "frame_pipe(p, \"irs\")\n"
+                               "\n"
+                               "action hlisten_pipe(p)\n"
+                               "    print(hread_pipe(p, 2) + \" \" + hread_pipe_real(p, 1))\n"
+                               "end\n";
+
 char ffilib_doc_read_pipe[] = "Pipes\n"
                               "read_pipe(argument_number)\n"
                               "# Read from the currently selected pipe, picking the\n"
@@ -70,12 +143,185 @@ char ffilib_doc_hread_pipe[] = "Pipes\n"
                                "    print(hread_pipe(p, 0))\n"
                                "end\n";
 
+char ffilib_doc_read_pipe_int[] = "Pipes\n"
+                                  "read_pipe_int(argument_number)\n"
+                                  "# Read an argument from the currently selected pipe as an\n"
+                                  "# integer.  Framed integer fields are returned as they were\n"
+                                  "# written, text arguments are converted.  Missing arguments\n"
+                                  "# read as 0.\n"
+                                  "# \n"
+                                  "# Syntax:\n"
+                                  "# value = read_pipe_int(argument_number)\n"
+                                  "# \n"
+                                  "# value: The returned argument as an integer\n"
+                                  "# \n"
+                                  "# argument_number: The 0 based index of the argument to read\n"
+                                  "# \n"
+                                  "# Example:\n"
+                                  "pipe(\"C:\\\\foo.txt\")\n"
+                                  "\n"
+                                  "action listen_pipe()\n"
+                                  "    print(\"next \" + (read_pipe_int(0) + 1))\n"
+                                  "end\n";
+
+char ffilib_doc_hread_pipe_int[] = "Pipes\n"
+                                   "hread_pipe_int(handle, argument_number)\n"
+                                   "# Read an argument from the pipe specified by the handle as\n"
+                                   "# an integer.  Framed integer fields are returned as they\n"
+                                   "# were written, text arguments are converted.  Missing\n"
+                                   "# arguments read as 0.\n"
+                                   "# \n"
+                                   "# Syntax:\n"
+                                   "# value = hread_pipe_int(handle, argument_number)\n"
+                                   "# \n"
+                                   "# value: The returned argument as an integer\n"
+                                   "# \n"
+                                   "# handle: A handle to a pipe returned by pipe()\n"
+                                   "# \n"
+                                   "# argument_number: The 0 based index of the argument to read\n"
+                                   "# \n"
+                                   "# Example:\n"
+                                   "p = pipe(\"C:\\\\foo.txt\")\n"
+                                   "\n"
+                                   "action hlisten_pipe(p)\n"
+                                   "    print(\"next \" + (hread_pipe_int(p, 0) + 1))\n"
+                                   "end\n";
+
+char ffilib_doc_read_pipe_real[] = "Pipes\n"
+                                   "read_pipe_real(argument_number)\n"
+                                   "# Read an argument from the currently selected pipe as a\n"
+                                   "# real.  Framed real fields are returned as they were\n"
+                                   "# written, text arguments are converted.  Missing arguments\n"
+                                   "# read as 0.0.\n"
+                                   "# \n"
+                                   "# Syntax:\n"
+                                   "# value = read_pipe_real(argument_number)\n"
+                                   "# \n"
+                                   "# value: The returned argument as a real\n"
+                                   "# \n"
+                                   "# argument_number: The 0 based index of the argument to read\n"
+                                   "# \n"
+                                   "# Example:\n"
+                                   "pipe(\"C:\\\\foo.txt\")\n"
+                                   "\n"
+                                   "action listen_pipe()\n"
+                                   "    plot(read_pipe_real(0), read_pipe_real(1))\n"
+                                   "end\n";
+
+char ffilib_doc_hread_pipe_real[] = "Pipes\n"
+                                    "hread_pipe_real(handle, argument_number)\n"
+                                    "# Read an argument from the pipe specified by the handle as\n"
+                                    "# a real.  Framed real fields are returned as they were\n"
+                                    "# written, text arguments are converted.  Missing arguments\n"
+                                    "# read as 0.0.\n"
+                                    "# \n"
+                                    "# Syntax:\n"
+                                    "# value = hread_pipe_real(handle, argument_number)\n"
+                                    "# \n"
+                                    "# value: The returned argument as a real\n"
+                                    "# \n"
+                                    "# handle: A handle to a pipe returned by pipe()\n"
+                                    "# \n"
+                                    "# argument_number: The 0 based index of the argument to read\n"
+                                    "# \n"
+                                    "# Example:\n"
+                                    "p = pipe(\"C:\\\\foo.txt\")\n"
+                                    "\n"
+                                    "action hlisten_pipe(p)\n"
+                                    "    plot(hread_pipe_real(p, 0), hread_pipe_real(p, 1))\n"
+                                    "end\n";
+
+char ffilib_doc_pipe_lines[] = "Pipes\n"
+                               "pipe_lines()\n"
+                               "# Return the number of lines delivered to the currently\n"
+                               "# selected pipe's listen action.  A listen_pipe() action\n"
+                               "# always receives one line, a listen_pipe_batch() action\n"
+                               "# may receive several.\n"
+                               "# \n"
+                               "# Syntax:\n"
+                               "# count = pipe_lines()\n"
+                               "# \n"
+                               "# count: The number of lines available to read_pipe_line()\n"
+                               "# \n"
+                               "# Example:\n"
+                               "pipe(\"C:\\\\foo.txt\")\n"
+                               "\n"
+                               "action listen_pipe_batch(100, 0.5)\n"
+                               "    print(pipe_lines())\n"
+                               "end\n";
+
+char ffilib_doc_hpipe_lines[] = "Pipes\n"
+                                "hpipe_lines(handle)\n"
+                                "# Return the number of lines delivered to the listen action\n"
+                                "# of the pipe specified by the handle.\n"
+                                "# \n"
+                                "# Syntax:\n"
+                                "# count = hpipe_lines(handle)\n"
+                                "# \n"
+                                "# count: The number of lines available to hread_pipe_line()\n"
+                                "# \n"
+                                "# handle: A handle to a pipe returned by pipe()\n"
+                                "# \n"
+                                "# Example:\n"
+                                "p = pipe(\"C:\\\\foo.txt\")\n"
+                                "\n"
+                                "action hlisten_pipe_batch(p, 100, 0.5)\n"
+                                "    print(hpipe_lines(p))\n"
+                                "end\n";
+
+char ffilib_doc_read_pipe_line[] = "Pipes\n"
+                                   "read_pipe_line(line_number, argument_number)\n"
+                                   "# Read an argument from one of the lines delivered to the\n"
+                                   "# currently selected pipe's listen action.  Both the line\n"
+                                   "# number and the argument number are 0 based indices.\n"
+                                   "# \n"
+                                   "# Syntax:\n"
+                                   "# argument = read_pipe_line(line_number, argument_number)\n"
+                                   "# \n"
+                                   "# argument: The returned argument as a string\n"
+                                   "# \n"
+                                   "# line_number: The 0 based index of the line to read\n"
+                                   "# \n"
+                                   "# argument_number: The 0 based index of the argument to read\n"
+                                   "# \n"
+                                   "# Example:\n"
+                                   "pipe(\"C:\\\\foo.txt\")\n"
+                                   "\n"
+                                   "action listen_pipe_batch(100, 0.5)\n"
+                                   "    print(read_pipe_line(pipe_lines()-1, 0))\n"
+                                   "end\n";
+
+char ffilib_doc_hread_pipe_line[] = "Pipes\n"
+                                    "hread_pipe_line(handle, line_number, argument_number)\n"
+                                    "# Read an argument from one of the lines delivered to the\n"
+                                    "# listen action of the pipe specified by the handle.  Both\n"
+                                    "# the line number and the argument number are 0 based indices.\n"
+                                    "# \n"
+                                    "# Syntax:\n"
+                                    "# argument = hread_pipe_line(handle, line_number, argument_number)\n"
+                                    "# \n"
+                                    "# argument: The returned argument as a string\n"
+                                    "# \n"
+                                    "# handle: A handle to a pipe returned by pipe()\n"
+                                    "# \n"
+                                    "# line_number: The 0 based index of the line to read\n"
+                                    "# \n"
+                                    "# argument_number: The 0 based index of the argument to read\n"
+                                    "# \n"
+                                    "# Example:\n"
+                                    "p = pipe(\"C:\\\\foo.txt\")\n"
+                                    "\n"
+                                    "action hlisten_pipe_batch(p, 100, 0.5)\n"
+                                    "    print(hread_pipe_line(p, hpipe_lines(p)-1, 0))\n"
+                                    "end\n";
+
 char ffilib_doc_listen_pipe[] = "Pipes\n"
                                 "listen_pipe()\n"
                                 "# Listen to the current pipe, waiting for a line of text to be\n"
                                 "# written to the pipe.  Once the action is triggered, the\n"
                                 "# next line of text won't be read again until the action\n"
-                                "# completes\n"
+                                "# completes.  Every action listening to the pipe sees each\n"
+                                "# line\n"
                                 "# \n"
                                 "# Syntax:\n"
                                 "# listen_pipe()\n"
@@ -92,7 +338,8 @@ char ffilib_doc_hlisten_pipe[] = "Pipes\n"
                                  "# Listen to the specified pipe, waiting for a line of text to be\n"
                                  "# written to the pipe.  Once the action is triggered, the\n"
                                  "# next line of text won't be read again until the action\n"
-                                 "# completes\n"
+                                 "# completes.  Every action listening to the pipe sees each\n"
+                                 "# line\n"
                                  "# \n"
                                  "# Syntax:\n"
                                  "# hlisten_pipe(handle)\n"
@@ -106,6 +353,56 @@ char ffilib_doc_hlisten_pipe[] = "Pipes\n"
                                  "    print(hread_pipe(p, 0))\n"
                                  "end\n";
 
+char ffilib_doc_listen_pipe_batch[] = "Pipes\n"
+                                      "listen_pipe_batch(max_lines, max_latency)\n"
+                                      "# Listen to the current pipe, triggering once for a batch\n"
+                                      "# of lines rather than once per line.  The action triggers\n"
+                                      "# when max_lines lines are waiting, or when the oldest\n"
+                                      "# waiting line has waited max_latency seconds.  The lines\n"
+                                      "# are read with pipe_lines() and read_pipe_line(), and no\n"
+                                      "# further lines are read until the action completes\n"
+                                      "# \n"
+                                      "# Syntax:\n"
+                                      "# listen_pipe_batch(max_lines, max_latency)\n"
+                                      "# \n"
+                                      "# max_lines: The most lines delivered in one batch\n"
+                                      "# \n"
+                                      "# max_latency: The longest time in seconds a line waits for its\n"
+                                      "# batch to fill\n"
+                                      "# \n"
+                                      "# Example:\n"
+                                      "pipe(\"C:\\\\foo.txt\")\n"
+                                      "\n"
+                                      "action listen_pipe_batch(100, 0.5)\n"
+                                      "    print(read_pipe_line(0, 0))\n"
+                                      "end\n";
+
+char ffilib_doc_hlisten_pipe_batch[] = "Pipes\n"
+                                       "hlisten_pipe_batch(handle, max_lines, max_latency)\n"
+                                       "# Listen to the specified pipe, triggering once for a batch\n"
+                                       "# of lines rather than once per line.  The action triggers\n"
+                                       "# when max_lines lines are waiting, or when the oldest\n"
+                                       "# waiting line has waited max_latency seconds.  The lines\n"
+                                       "# are read with hpipe_lines() and hread_pipe_line(), and no\n"
+                                       "# further lines are read until the action completes\n"
+                                       "# \n"
+                                       "# Syntax:\n"
+                                       "# hlisten_pipe_batch(handle, max_lines, max_latency)\n"
+                                       "# \n"
+                                       "# handle: A handle to a pipe returned by pipe()\n"
+                                       "# \n"
+                                       "# max_lines: The most lines delivered in one batch\n"
+                                       "# \n"
+                                       "# max_latency: The longest time in seconds a line waits for its\n"
+                                       "# batch to fill\n"
+                                       "# \n"
+                                       "# Example:\n"
+                                       "p = pipe(\"C:\\\\foo.txt\")\n"
+                                       "\n"
+                                       "action hlisten_pipe_batch(p, 100, 0.5)\n"
+                                       "    print(hread_pipe_line(p, 0, 0))\n"
+                                       "end\n";
+
 char ffilib_doc_print[] = "Messages\n"
                           "print(message_text)\n"
                           "# Prints the specified message text to the display\n"
@@ -160,6 +457,24 @@ char ffilib_doc_choice[] = "Messages\n"
                            "    end\n"
                            "end\n";
 
+char ffilib_doc_read_file[] = "Files\n"
+                              "read_file(file_name)\n"
+                              "# Reads the entire contents of the specified file.\n"
+                              "# The file is read in the background; when the call\n"
+                              "# makes up a whole statement or assignment, other\n"
+                              "# actions keep running until the read completes.\n"
+                              "# \n"
+                              "# Syntax:\n"
+                              "#   contents = read_file(file_name)\n"
+                              "# \n"
+                              "# contents: The contents of the file as a string\n"
+                              "# \n"
+                              "# file_name: The path of the file to read\n"
+                              "# \n"
+                              "# Example:\n"
+                              "settings = read_file(\"C:\\\\settings.txt\")\n"
+                              "print(settings)\n";
+
 char ffilib_doc_uniform_random[] = "Math (Statistics)\n"
                                    "uniform_random()\n"
                                    "# Generates a uniform random variable in the range\n"
@@ -351,8 +666,12 @@ char ffilib_doc_vtimer[] = "Time\n"
 
 char ffilib_doc_time[] = "Time\n"
                          "time()\n"
-                         "# Returns the current time, in milliseconds, as a real\n"
-                         "# number.\n"
+                         "# Returns a monotonic time, in milliseconds, as a real\n"
+                         "# number with sub-millisecond precision.  The time has\n"
+                         "# no fixed origin and is meant for measuring intervals;\n"
+                         "# use wall_time() for the calendar time.  When the module\n"
+                         "# runs in virtual time the result counts from zero at the\n"
+                         "# start of the module.\n"
                          "# \n"
                          "# Syntax:\n"
                          "#   real = time()\n"
@@ -360,10 +679,22 @@ char ffilib_doc_time[] = "Time\n"
                          "# Example:\n"
                          "time_in_ms = time()\n";
 
+char ffilib_doc_wall_time[] = "Time\n"
+                              "wall_time()\n"
+                              "# Returns the current calendar time, in milliseconds since\n"
+                              "# January 1, 1601 UTC, as a real number.\n"
+                              "# \n"
+                              "# Syntax:\n"
+                              "#   real = wall_time()\n"
+                              "# \n"
+                              "# Example:\n"
+                              "now_in_ms = wall_time()\n";
+
 char ffilib_doc_delay[] = "Time\n"
                           "delay(wait_milliseconds)\n"
                           "# Delay the execution of the program by the specified\n"
-                          "# number of milliseconds.\n"
+                          "# number of milliseconds.  Other actions keep running\n"
+                          "# while the calling function waits.\n"
                           "# \n"
                           "# Syntax:\n"
                           "#   delay(wait_milliseconds)\n"
@@ -838,3 +1169,115 @@ char ffilib_doc_hplot[] = "Graphing\n"
                           "g = graph(\"A graph to be plotted on\")\n"
                           "hplot(g, 1.0, 100.0)\n";
 
+char ffilib_doc_ring[] = "Rings\n"
+                         "ring(name, record_size, record_count)\n"
+                         "# Open a shared memory ring that other processes write\n"
+                         "# fixed size records into.  The ring is created if no ring\n"
+                         "# with the name exists yet, otherwise the existing ring is\n"
+                         "# opened and must have the same layout.  A ring has a single\n"
+                         "# reader, opening a ring that another script is still\n"
+                         "# reading raises an exception.  Producers open the ring by\n"
+                         "# name with the ring library and write records without any\n"
+                         "# system call, they only wake the script when it is waiting\n"
+                         "# for a record.  The function returns a handle for use with\n"
+                         "# the other ring functions.\n"
+                         "# \n"
+                         "# Syntax:\n"
+                         "#   handle = ring(name, record_size, record_count)\n"
+                         "# \n"
+                         "# name: The name of the shared memory mapping\n"
+                         "# \n"
+                         "# record_size: The size of a record in bytes, rounded up to\n"
+                         "#   a multiple of 8.  A record is read as 8 byte slots\n"
+                         "# \n"
+                         "# record_count: The number of records the ring holds, rounded\n"
+                         "#   up to a power of two.  Producers fail to write while the\n"
+                         "#   ring is full.  A ring may hold at most 256 MB of records\n"
+                         "# \n"
+                         "# Example:\n"
+                         "r = ring(\"prices\", 32, 1024)\n"
+                         "\n"
+                         "action listen_ring(r)\n"
+                         "    print(ring_string(r, 0) + \" \" + ring_real(r, 2))\n"
+                         "end\n";
+
+char ffilib_doc_listen_ring[] = "Rings\n"
+                                "listen_ring(handle)\n"
+                                "# Listen to a ring, triggering once for each record written\n"
+                                "# to it.  The record stays readable with ring_int(),\n"
+                                "# ring_real() and ring_string() until the action completes.\n"
+                                "# Only one action may listen to a ring at a time.\n"
+                                "# \n"
+                                "# Syntax:\n"
+                                "#   listen_ring(handle)\n"
+                                "# \n"
+                                "# handle: A ring handle returned by 'ring()'\n"
+                                "# \n"
+                                "# Example:\n"
+                                "r = ring(\"events\", 64, 256)\n"
+                                "\n"
+                                "action listen_ring(r)\n"
+                                "    print(ring_string(r, 0))\n"
+                                "end\n";
+
+char ffilib_doc_ring_int[] = "Rings\n"
+                             "ring_int(handle, slot)\n"
+                             "# Read a 64 bit integer from a slot of the record that\n"
+                             "# triggered 'listen_ring()'.  Slot n starts at byte n*8 of\n"
+                             "# the record.  Returns 0 if the slot lies past the end of the\n"
+                             "# record or no record has triggered.\n"
+                             "# \n"
+                             "# Syntax:\n"
+                             "#   value = ring_int(handle, slot)\n"
+                             "# \n"
+                             "# handle: A ring handle returned by 'ring()'\n"
+                             "# \n"
+                             "# slot: The index of the slot to read\n"
+                             "# \n"
+                             "# Example:\n"
+                             "r = ring(\"counts\", 16, 64)\n"
+                             "\n"
+                             "action listen_ring(r)\n"
+                             "    print(ring_int(r, 1))\n"
+                             "end\n";
+
+char ffilib_doc_ring_real[] = "Rings\n"
+                              "ring_real(handle, slot)\n"
+                              "# Read a double from a slot of the record that triggered\n"
+                              "# 'listen_ring()'.  Returns 0.0 if the slot lies past the end\n"
+                              "# of the record or no record has triggered.\n"
+                              "# \n"
+                              "# Syntax:\n"
+                              "#   value = ring_real(handle, slot)\n"
+                              "# \n"
+                              "# handle: A ring handle returned by 'ring()'\n"
+                              "# \n"
+                              "# slot: The index of the slot to read\n"
+                              "# \n"
+                              "# Example:\n"
+                              "r = ring(\"samples\", 16, 64)\n"
+                              "\n"
+                              "action listen_ring(r)\n"
+                              "    plot(ring_real(r, 0), ring_real(r, 1))\n"
+                              "end\n";
+
+char ffilib_doc_ring_string[] = "Rings\n"
+                                "ring_string(handle, slot)\n"
+                                "# Read a string starting at a slot of the record that\n"
+                                "# triggered 'listen_ring()'.  The string runs to a NUL or the\n"
+                                "# end of the record.  Returns an empty string if the slot lies\n"
+                                "# past the end of the record or no record has triggered.\n"
+                                "# \n"
+                                "# Syntax:\n"
+                                "#   text = ring_string(handle, slot)\n"
+                                "# \n"
+                                "# handle: A ring handle returned by 'ring()'\n"
+                                "# \n"
+                                "# slot: The index of the slot the string starts at\n"
+                                "# \n"
+                                "# Example:\n"
+                                "r = ring(\"log\", 128, 256)\n"
+                                "\n"
+                                "action listen_ring(r)\n"
+                                "    print(ring_string(r, 0))\n"
+                                "end\n";
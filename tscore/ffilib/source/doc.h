@@ -11,13 +11,27 @@
 
 
 extern char ffilib_doc_pipe[];
+extern char ffilib_doc_named_pipe[];
+extern char ffilib_doc_message_pipe[];
+extern char ffilib_doc_frame_pipe[];
 extern char ffilib_doc_read_pipe[];
 extern char ffilib_doc_hread_pipe[];
+extern char ffilib_doc_read_pipe_int[];
+extern char ffilib_doc_hread_pipe_int[];
+extern char ffilib_doc_read_pipe_real[];
+extern char ffilib_doc_hread_pipe_real[];
+extern char ffilib_doc_pipe_lines[];
+extern char ffilib_doc_hpipe_lines[];
+extern char ffilib_doc_read_pipe_line[];
+extern char ffilib_doc_hread_pipe_line[];
 extern char ffilib_doc_listen_pipe[];
 extern char ffilib_doc_hlisten_pipe[];
+extern char ffilib_doc_listen_pipe_batch[];
+extern char ffilib_doc_hlisten_pipe_batch[];
 extern char ffilib_doc_print[];
 extern char ffilib_doc_message[];
 extern char ffilib_doc_choice[];
+extern char ffilib_doc_read_file[];
 
 extern char ffilib_doc_uniform_random[];
 extern char ffilib_doc_gaussian_random[];
@@ -32,6 +46,7 @@ extern char ffilib_doc_timer[];
 extern char ffilib_doc_ptimer[];
 extern char ffilib_doc_vtimer[];
 extern char ffilib_doc_time[];
+extern char ffilib_doc_wall_time[];
 extern char ffilib_doc_delay[];
 
 extern char ffilib_doc_graph[];
@@ -58,6 +73,12 @@ extern char ffilib_doc_hset_plot_color[];
 extern char ffilib_doc_plot[];
 extern char ffilib_doc_hplot[];
 
+extern char ffilib_doc_ring[];
+extern char ffilib_doc_listen_ring[];
+extern char ffilib_doc_ring_int[];
+extern char ffilib_doc_ring_real[];
+extern char ffilib_doc_ring_string[];
+
 
 #endif
 
@@ -12,6 +12,7 @@
 #include <ffilib/module.h>
 #include <notify/init.h>
 #include <notify/pipe.h>
+#include <notify/file.h>
 #include <notify/message.h>
 #include <math/random.h>
 #include <math/basic.h>
@@ -20,19 +21,35 @@
 #include <graph/gui.h>
 #include <graph/definition.h>
 #include <graph/render.h>
+#include <ring/init.h>
+#include <ring/ring.h>
 
 #include <stdlib.h>
 
 
 struct tsffi_function_definition notify_functions[] = {
-                                                          {"pipe",         ffilib_doc_pipe,         &Notify_Pipe,      NULL,                       TSFFI_PRIMITIVE_TYPE_INT,    1, {TSFFI_PRIMITIVE_TYPE_STRING}},
-                                                          {"read_pipe",    ffilib_doc_read_pipe,    &Notify_ReadPipe,  NULL,                       TSFFI_PRIMITIVE_TYPE_STRING, 1, {TSFFI_PRIMITIVE_TYPE_INT}},
-                                                          {"hread_pipe",   ffilib_doc_hread_pipe,   &Notify_HReadPipe, NULL,                       TSFFI_PRIMITIVE_TYPE_STRING, 2, {TSFFI_PRIMITIVE_TYPE_INT, TSFFI_PRIMITIVE_TYPE_INT}},
-                                                          {"listen_pipe",  ffilib_doc_listen_pipe,  NULL,              &Notify_Action_ListenPipe,  TSFFI_PRIMITIVE_TYPE_VOID,   0},
-                                                          {"hlisten_pipe", ffilib_doc_hlisten_pipe, NULL,              &Notify_Action_HListenPipe, TSFFI_PRIMITIVE_TYPE_VOID,   1, {TSFFI_PRIMITIVE_TYPE_INT}},
-                                                          {"print",        ffilib_doc_print,        &Notify_Print,     NULL,                       TSFFI_PRIMITIVE_TYPE_VOID,   1, {TSFFI_PRIMITIVE_TYPE_STRING}},
-                                                          {"message",      ffilib_doc_message,      &Notify_Message,   NULL,                       TSFFI_PRIMITIVE_TYPE_VOID,   1, {TSFFI_PRIMITIVE_TYPE_STRING}},
-                                                          {"choice",       ffilib_doc_choice,       &Notify_Choice,    NULL,                       TSFFI_PRIMITIVE_TYPE_BOOL,   1, {TSFFI_PRIMITIVE_TYPE_STRING}}
+                                                          {"pipe",               ffilib_doc_pipe,               &Notify_Pipe,          NULL,                            TSFFI_PRIMITIVE_TYPE_INT,    1, {TSFFI_PRIMITIVE_TYPE_STRING}},
+                                                          {"named_pipe",         ffilib_doc_named_pipe,         &Notify_NamedPipe,     NULL,                            TSFFI_PRIMITIVE_TYPE_INT,    1, {TSFFI_PRIMITIVE_TYPE_STRING}},
+                                                          {"message_pipe",       ffilib_doc_message_pipe,       &Notify_MessagePipe,   NULL,                            TSFFI_PRIMITIVE_TYPE_INT,    1, {TSFFI_PRIMITIVE_TYPE_STRING}},
+                                                          {"frame_pipe",         ffilib_doc_frame_pipe,         &Notify_FramePipe,     NULL,                            TSFFI_PRIMITIVE_TYPE_VOID,   2, {TSFFI_PRIMITIVE_TYPE_INT, TSFFI_PRIMITIVE_TYPE_STRING}},
+                                                          {"read_pipe",          ffilib_doc_read_pipe,          &Notify_ReadPipe,      NULL,                            TSFFI_PRIMITIVE_TYPE_STRING, 1, {TSFFI_PRIMITIVE_TYPE_INT}},
+                                                          {"hread_pipe",         ffilib_doc_hread_pipe,         &Notify_HReadPipe,     NULL,                            TSFFI_PRIMITIVE_TYPE_STRING, 2, {TSFFI_PRIMITIVE_TYPE_INT, TSFFI_PRIMITIVE_TYPE_INT}},
+                                                          {"read_pipe_int",      ffilib_doc_read_pipe_int,      &Notify_ReadPipeInt,   NULL,                            TSFFI_PRIMITIVE_TYPE_INT,    1, {TSFFI_PRIMITIVE_TYPE_INT}},
+                                                          {"hread_pipe_int",     ffilib_doc_hread_pipe_int,     &Notify_HReadPipeInt,  NULL,                            TSFFI_PRIMITIVE_TYPE_INT,    2, {TSFFI_PRIMITIVE_TYPE_INT, TSFFI_PRIMITIVE_TYPE_INT}},
+                                                          {"read_pipe_real",     ffilib_doc_read_pipe_real,     &Notify_ReadPipeReal,  NULL,                            TSFFI_PRIMITIVE_TYPE_REAL,   1, {TSFFI_PRIMITIVE_TYPE_INT}},
+                                                          {"hread_pipe_real",    ffilib_doc_hread_pipe_real,    &Notify_HReadPipeReal, NULL,                            TSFFI_PRIMITIVE_TYPE_REAL,   2, {TSFFI_PRIMITIVE_TYPE_INT, TSFFI_PRIMITIVE_TYPE_INT}},
+                                                          {"pipe_lines",         ffilib_doc_pipe_lines,         &Notify_PipeLines,     NULL,                            TSFFI_PRIMITIVE_TYPE_INT,    0},
+                                                          {"hpipe_lines",        ffilib_doc_hpipe_lines,        &Notify_HPipeLines,    NULL,                            TSFFI_PRIMITIVE_TYPE_INT,    1, {TSFFI_PRIMITIVE_TYPE_INT}},
+                                                          {"read_pipe_line",     ffilib_doc_read_pipe_line,     &Notify_ReadPipeLine,  NULL,                            TSFFI_PRIMITIVE_TYPE_STRING, 2, {TSFFI_PRIMITIVE_TYPE_INT, TSFFI_PRIMITIVE_TYPE_INT}},
+                                                          {"hread_pipe_line",    ffilib_doc_hread_pipe_line,    &Notify_HReadPipeLine, NULL,                            TSFFI_PRIMITIVE_TYPE_STRING, 3, {TSFFI_PRIMITIVE_TYPE_INT, TSFFI_PRIMITIVE_TYPE_INT, TSFFI_PRIMITIVE_TYPE_INT}},
+                                                          {"listen_pipe",        ffilib_doc_listen_pipe,        NULL,                  &Notify_Action_ListenPipe,       TSFFI_PRIMITIVE_TYPE_VOID,   0},
+                                                          {"hlisten_pipe",       ffilib_doc_hlisten_pipe,       NULL,                  &Notify_Action_HListenPipe,      TSFFI_PRIMITIVE_TYPE_VOID,   1, {TSFFI_PRIMITIVE_TYPE_INT}},
+                                                          {"listen_pipe_batch",  ffilib_doc_listen_pipe_batch,  NULL,                  &Notify_Action_ListenPipeBatch,  TSFFI_PRIMITIVE_TYPE_VOID,   2, {TSFFI_PRIMITIVE_TYPE_INT, TSFFI_PRIMITIVE_TYPE_REAL}},
+                                                          {"hlisten_pipe_batch", ffilib_doc_hlisten_pipe_batch, NULL,                  &Notify_Action_HListenPipeBatch, TSFFI_PRIMITIVE_TYPE_VOID,   3, {TSFFI_PRIMITIVE_TYPE_INT, TSFFI_PRIMITIVE_TYPE_INT, TSFFI_PRIMITIVE_TYPE_REAL}},
+                                                          {"print",              ffilib_doc_print,              &Notify_Print,         NULL,                            TSFFI_PRIMITIVE_TYPE_VOID,   1, {TSFFI_PRIMITIVE_TYPE_STRING}},
+                                                          {"message",            ffilib_doc_message,            &Notify_Message,       NULL,                            TSFFI_PRIMITIVE_TYPE_VOID,   1, {TSFFI_PRIMITIVE_TYPE_STRING}},
+                                                          {"choice",             ffilib_doc_choice,             &Notify_Choice,        NULL,                            TSFFI_PRIMITIVE_TYPE_BOOL,   1, {TSFFI_PRIMITIVE_TYPE_STRING}},
+                                                          {"read_file",          ffilib_doc_read_file,          NULL,                  NULL,                            TSFFI_PRIMITIVE_TYPE_STRING, 1, {TSFFI_PRIMITIVE_TYPE_STRING}, &Notify_ReadFile}
                                                       };
 
 struct tsffi_function_definition math_functions[] = {
@@ -50,11 +67,12 @@ struct tsffi_function_definition math_functions[] = {
                                                     };
 
 struct tsffi_function_definition time_functions[] = {
-                                                        {"timer",  ffilib_doc_timer,  NULL,        &Time_Action_Timer,  TSFFI_PRIMITIVE_TYPE_VOID, 1, {TSFFI_PRIMITIVE_TYPE_REAL}},
-                                                        {"ptimer", ffilib_doc_ptimer, NULL,        &Time_Action_PTimer, TSFFI_PRIMITIVE_TYPE_VOID, 1, {TSFFI_PRIMITIVE_TYPE_REAL}},
-                                                        {"vtimer", ffilib_doc_vtimer, NULL,        &Time_Action_VTimer, TSFFI_PRIMITIVE_TYPE_VOID, 1, {TSFFI_PRIMITIVE_TYPE_REAL}},
-                                                        {"time",   ffilib_doc_time,   &Time_Time,  NULL,                TSFFI_PRIMITIVE_TYPE_REAL, 0},
-                                                        {"delay",  ffilib_doc_delay,  &Time_Delay, NULL,                TSFFI_PRIMITIVE_TYPE_VOID, 1, {TSFFI_PRIMITIVE_TYPE_REAL}}
+                                                        {"timer",     ffilib_doc_timer,     NULL,            &Time_Action_Timer,  TSFFI_PRIMITIVE_TYPE_VOID, 1, {TSFFI_PRIMITIVE_TYPE_REAL}, NULL, TSFFI_FUNCTION_FLAG_PUSH_STATE},
+                                                        {"ptimer",    ffilib_doc_ptimer,    NULL,            &Time_Action_PTimer, TSFFI_PRIMITIVE_TYPE_VOID, 1, {TSFFI_PRIMITIVE_TYPE_REAL}, NULL, TSFFI_FUNCTION_FLAG_PUSH_STATE},
+                                                        {"vtimer",    ffilib_doc_vtimer,    NULL,            &Time_Action_VTimer, TSFFI_PRIMITIVE_TYPE_VOID, 1, {TSFFI_PRIMITIVE_TYPE_REAL}, NULL, TSFFI_FUNCTION_FLAG_PUSH_STATE},
+                                                        {"time",      ffilib_doc_time,      &Time_Time,      NULL,                TSFFI_PRIMITIVE_TYPE_REAL, 0},
+                                                        {"wall_time", ffilib_doc_wall_time, &Time_WallTime,  NULL,                TSFFI_PRIMITIVE_TYPE_REAL, 0},
+                                                        {"delay",     ffilib_doc_delay,     &Time_Delay,     NULL,                TSFFI_PRIMITIVE_TYPE_VOID, 1, {TSFFI_PRIMITIVE_TYPE_REAL}}
                                                     };
 
 struct tsffi_function_definition graph_functions[] = {
@@ -83,11 +101,20 @@ struct tsffi_function_definition graph_functions[] = {
                                                          {"hplot",               ffilib_doc_hplot,               &Graph_HPlot,                NULL, TSFFI_PRIMITIVE_TYPE_VOID, 3, {TSFFI_PRIMITIVE_TYPE_INT, TSFFI_PRIMITIVE_TYPE_REAL, TSFFI_PRIMITIVE_TYPE_REAL}}
                                                      };
 
+struct tsffi_function_definition ring_functions[] = {
+                                                        {"ring",        ffilib_doc_ring,        &Ring_Ring,       NULL,                    TSFFI_PRIMITIVE_TYPE_INT,    3, {TSFFI_PRIMITIVE_TYPE_STRING, TSFFI_PRIMITIVE_TYPE_INT, TSFFI_PRIMITIVE_TYPE_INT}},
+                                                        {"listen_ring", ffilib_doc_listen_ring, NULL,             &Ring_Action_ListenRing, TSFFI_PRIMITIVE_TYPE_VOID,   1, {TSFFI_PRIMITIVE_TYPE_INT}},
+                                                        {"ring_int",    ffilib_doc_ring_int,    &Ring_ReadInt,    NULL,                    TSFFI_PRIMITIVE_TYPE_INT,    2, {TSFFI_PRIMITIVE_TYPE_INT, TSFFI_PRIMITIVE_TYPE_INT}},
+                                                        {"ring_real",   ffilib_doc_ring_real,   &Ring_ReadReal,   NULL,                    TSFFI_PRIMITIVE_TYPE_REAL,   2, {TSFFI_PRIMITIVE_TYPE_INT, TSFFI_PRIMITIVE_TYPE_INT}},
+                                                        {"ring_string", ffilib_doc_ring_string, &Ring_ReadString, NULL,                    TSFFI_PRIMITIVE_TYPE_STRING, 2, {TSFFI_PRIMITIVE_TYPE_INT, TSFFI_PRIMITIVE_TYPE_INT}}
+                                                    };
+
 struct tsffi_registration_group ffilib_groups[] = {
-                                                      {_countof(notify_functions), notify_functions, &Notify_BeginModule, &Notify_ModuleState, &Notify_EndModule, NULL},
-                                                      {_countof(math_functions),   math_functions,   &FFILib_BeginModule, NULL,                &FFILib_EndModule, NULL},
-                                                      {_countof(time_functions),   time_functions,   &FFILib_BeginModule, NULL,                &FFILib_EndModule, NULL},
-                                                      {_countof(graph_functions),  graph_functions,  &Graph_BeginModule,  NULL,                &Graph_EndModule,  NULL}
+                                                      {_countof(notify_functions), notify_functions, &Notify_BeginModule, &Notify_ModuleState, &Notify_EndModule, NULL, 0},
+                                                      {_countof(math_functions),   math_functions,   &FFILib_BeginModule, NULL,                &FFILib_EndModule, NULL, TSFFI_GROUP_FLAG_THREAD_SAFE},
+                                                      {_countof(time_functions),   time_functions,   &FFILib_BeginModule, NULL,                &FFILib_EndModule, NULL, 0},
+                                                      {_countof(graph_functions),  graph_functions,  &Graph_BeginModule,  NULL,                &Graph_EndModule,  NULL, 0},
+                                                      {_countof(ring_functions),   ring_functions,   &Ring_BeginModule,   NULL,                &Ring_EndModule,   NULL, 0}
                                                   };
 
 
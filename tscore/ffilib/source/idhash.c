@@ -9,135 +9,296 @@
 #include <ffilib/idhash.h>
 #include <ffilib/error.h>
 
+#include <windows.h>
 #include <stdlib.h>
 #include <malloc.h>
 #include <memory.h>
 
 
-static unsigned int ComputeHash (unsigned int);
+static unsigned int                 ComputeHash (unsigned int);
+static struct ffilib_id_hash_table* AllocTable  (unsigned int);
+static unsigned int                 FindSlot    (struct ffilib_id_hash_table*, unsigned int);
+static int                          GrowHash    (struct ffilib_id_hash*);
+static void                         LockHash    (struct ffilib_id_hash*);
+static void                         UnlockHash  (struct ffilib_id_hash*);
 
 
 
 static unsigned int ComputeHash (unsigned int id)
 {
-    return id%FFILIB_ID_HASH_SIZE;
+    /* IDs are often sequential or share their low bits, so every bit of
+       the ID is mixed into the bits the table mask keeps */
+    id ^= id>>16;
+    id *= 0x7FEB352D;
+    id ^= id>>15;
+    id *= 0x846CA68B;
+    id ^= id>>16;
+
+    return id;
 }
 
-
-void FFILib_InitializeHash (struct ffilib_id_hash* hash)
+static struct ffilib_id_hash_table* AllocTable (unsigned int capacity)
 {
-    memset(hash, 0, sizeof(struct ffilib_id_hash));
+    struct ffilib_id_hash_table* table;
+
+    table = calloc(1, sizeof(struct ffilib_id_hash_table)+capacity*sizeof(struct ffilib_id_hash_entry));
+    if(table == NULL)
+        return NULL;
+
+    table->capacity      = capacity;
+    table->entries       = (struct ffilib_id_hash_entry*)(table+1);
+    table->retired_table = NULL;
+
+    return table;
 }
 
-void FFILib_DestroyHash (struct ffilib_id_hash* hash)
+static unsigned int FindSlot (struct ffilib_id_hash_table* table, unsigned int id)
 {
+    unsigned int mask;
     unsigned int index;
 
-    index = FFILIB_ID_HASH_SIZE;
-    while(index--)
+    mask  = table->capacity-1;
+    index = ComputeHash(id)&mask;
+
+    while(table->entries[index].flags&FFILIB_ID_HASH_ENTRY_FLAG_USED)
     {
-        struct ffilib_id_hash_node* node;
+        if(table->entries[index].id == id)
+            break;
 
-        node = hash->id_hash[index];
-        while(node != NULL)
-        {
-            struct ffilib_id_hash_node* free_node;
+        index = (index+1)&mask;
+    }
 
-            free_node = node;
+    return index;
+}
 
-            node = node->next_node;
+static int GrowHash (struct ffilib_id_hash* hash_data)
+{
+    struct ffilib_id_hash_table* old_table;
+    struct ffilib_id_hash_table* new_table;
+    unsigned int                 capacity;
+    unsigned int                 index;
 
-            free(free_node);
+    old_table = hash_data->table;
+
+    if(old_table != NULL)
+        capacity = old_table->capacity*2;
+    else
+        capacity = FFILIB_ID_HASH_INITIAL_CAPACITY;
+
+    new_table = AllocTable(capacity);
+    if(new_table == NULL)
+        return FFILIB_ERROR_MEMORY;
+
+    if(old_table != NULL)
+    {
+        for(index = 0; index < old_table->capacity; index++)
+        {
+            struct ffilib_id_hash_entry* entry;
+
+            entry = &old_table->entries[index];
+            if(entry->flags&FFILIB_ID_HASH_ENTRY_FLAG_USED)
+                new_table->entries[FindSlot(new_table, entry->id)] = *entry;
         }
     }
+
+    new_table->retired_table = old_table;
+    hash_data->table         = new_table;
+
+    return FFILIB_ERROR_NONE;
+}
+
+static void LockHash (struct ffilib_id_hash* hash_data)
+{
+    while(1)
+    {
+        long sequence;
+
+        sequence = hash_data->sequence;
+        if(!(sequence&1) && InterlockedCompareExchange(&hash_data->sequence, sequence+1, sequence) == sequence)
+            break;
+
+        YieldProcessor();
+    }
 }
 
-int FFILib_AddID (unsigned int id, void* data, struct ffilib_id_hash* hash_data)
+static void UnlockHash (struct ffilib_id_hash* hash_data)
 {
-    struct ffilib_id_hash_node** node;
-    struct ffilib_id_hash_node*  entry;
-    unsigned int                 hash;
+    InterlockedIncrement(&hash_data->sequence);
+}
 
-    hash = ComputeHash(id);
-    node = &hash_data->id_hash[hash];
 
-    entry = *node;
-    while(entry != NULL)
+void FFILib_InitializeHash (struct ffilib_id_hash* hash_data)
+{
+    hash_data->sequence    = 0;
+    hash_data->table       = NULL;
+    hash_data->entry_count = 0;
+}
+
+void FFILib_DestroyHash (struct ffilib_id_hash* hash_data)
+{
+    struct ffilib_id_hash_table* table;
+
+    table = hash_data->table;
+    while(table != NULL)
     {
-        if(entry->id == id)
-            break;
+        struct ffilib_id_hash_table* free_table;
+
+        free_table = table;
 
-        entry = entry->next_node;
+        table = table->retired_table;
+
+        free(free_table);
     }
 
-    if(entry == NULL)
+    hash_data->table       = NULL;
+    hash_data->entry_count = 0;
+}
+
+int FFILib_AddID (unsigned int id, void* data, struct ffilib_id_hash* hash_data)
+{
+    struct ffilib_id_hash_table* table;
+    struct ffilib_id_hash_entry* entry;
+    int                          error;
+
+    LockHash(hash_data);
+
+    /* Probe lengths stay short while at most half the table is in use */
+    table = hash_data->table;
+    if(table == NULL || (hash_data->entry_count+1)*2 > table->capacity)
     {
-        entry = malloc(sizeof(struct ffilib_id_hash_node));
-        if(entry == NULL)
-            return FFILIB_ERROR_MEMORY;
+        error = GrowHash(hash_data);
+        if(error != FFILIB_ERROR_NONE)
+            goto grow_hash_failed;
 
-        entry->previous_node = NULL;
-        entry->next_node     = *node;
-        *node                = entry;
+        table = hash_data->table;
+    }
+
+    entry = &table->entries[FindSlot(table, id)];
 
-        if(entry->next_node != NULL)
-            entry->next_node->previous_node = entry;
+    if(!(entry->flags&FFILIB_ID_HASH_ENTRY_FLAG_USED))
+    {
+        entry->id    = id;
+        entry->flags = FFILIB_ID_HASH_ENTRY_FLAG_USED;
 
-        entry->id = id;
+        hash_data->entry_count++;
     }
 
     entry->data = data;
 
+    UnlockHash(hash_data);
+
     return FFILIB_ERROR_NONE;
+
+grow_hash_failed:
+    UnlockHash(hash_data);
+
+    return error;
 }
 
 void FFILib_RemoveID (unsigned int id, struct ffilib_id_hash* hash_data)
 {
-    struct ffilib_id_hash_node** node;
-    struct ffilib_id_hash_node*  entry;
-    unsigned int                 hash;
+    struct ffilib_id_hash_table* table;
+    unsigned int                 mask;
+    unsigned int                 hole;
+    unsigned int                 index;
+
+    LockHash(hash_data);
+
+    table = hash_data->table;
+    if(table == NULL)
+        goto remove_done;
 
-    hash = ComputeHash(id);
-    node = &hash_data->id_hash[hash];
+    hole = FindSlot(table, id);
+    if(!(table->entries[hole].flags&FFILIB_ID_HASH_ENTRY_FLAG_USED))
+        goto remove_done;
 
-    entry = *node;
+    /* Later entries of the probe run shift back into the hole, so lookups
+       never need to step over removed entries */
+    mask  = table->capacity-1;
+    index = hole;
 
-    while(entry != NULL)
+    while(1)
     {
-        if(entry->id == id)
-        {
-            if(entry->next_node != NULL)
-                entry->next_node->previous_node = entry->previous_node;
-            if(entry->previous_node != NULL)
-                entry->previous_node->next_node = entry->next_node;
-            else
-                *node = entry->next_node;
+        struct ffilib_id_hash_entry* entry;
+        unsigned int                 home;
 
-            free(entry);
+        index = (index+1)&mask;
+        entry = &table->entries[index];
 
+        if(!(entry->flags&FFILIB_ID_HASH_ENTRY_FLAG_USED))
             break;
-        }
 
-        entry = entry->next_node;
+        home = ComputeHash(entry->id)&mask;
+        if(((index-home)&mask) >= ((index-hole)&mask))
+        {
+            table->entries[hole] = *entry;
+            hole                 = index;
+        }
     }
+
+    table->entries[hole].flags = 0;
+    table->entries[hole].data  = NULL;
+
+    hash_data->entry_count--;
+
+remove_done:
+    UnlockHash(hash_data);
 }
 
 void* FFILib_GetIDData (unsigned int id, struct ffilib_id_hash* hash_data)
 {
-    struct ffilib_id_hash_node*  entry;
-    unsigned int                 hash;
-
-    hash  = ComputeHash(id);
-    entry = hash_data->id_hash[hash];
+    long  sequence;
+    void* data;
 
-    while(entry != NULL)
+    do
     {
-        if(entry->id == id)
-            return entry->data;
+        struct ffilib_id_hash_table* table;
 
-        entry = entry->next_node;
-    }
+        sequence = hash_data->sequence;
+        if(sequence&1)
+        {
+            YieldProcessor();
 
-    return NULL;
-}
+            continue;
+        }
+
+        MemoryBarrier();
+
+        data  = NULL;
+        table = hash_data->table;
+
+        if(table != NULL)
+        {
+            unsigned int mask;
+            unsigned int index;
+            unsigned int probe;
 
+            mask  = table->capacity-1;
+            index = ComputeHash(id)&mask;
+
+            /* A concurrent writer can leave no free slot to stop on, so
+               the probe is bounded and the sequence check retries it */
+            for(probe = 0; probe < table->capacity; probe++)
+            {
+                struct ffilib_id_hash_entry* entry;
+
+                entry = &table->entries[index];
+                if(!(entry->flags&FFILIB_ID_HASH_ENTRY_FLAG_USED))
+                    break;
+
+                if(entry->id == id)
+                {
+                    data = entry->data;
+
+                    break;
+                }
+
+                index = (index+1)&mask;
+            }
+        }
+
+        MemoryBarrier();
+    }while(sequence&1 || hash_data->sequence != sequence);
+
+    return data;
+}
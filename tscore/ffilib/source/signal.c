@@ -0,0 +1,139 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#include <ffilib/signal.h>
+#include <ffilib/module.h>
+
+#include <tsffi/execif.h>
+
+#include <windows.h>
+#include <stdlib.h>
+
+
+#define SIGNAL_BATCH_INITIAL_SIZE 16
+
+
+struct signal_batch
+{
+    unsigned int depth;
+
+    struct tsffi_execif* execif;
+    void*                execif_data;
+
+    void**       actions;
+    unsigned int action_count;
+    unsigned int action_capacity;
+};
+
+
+static int  InBatch    (void);
+static int  GrowBatch  (void);
+static void FlushBatch (void);
+
+
+/* Only the control thread batches, so the batch needs no locking */
+static struct signal_batch signal_batch;
+
+
+static int InBatch (void)
+{
+    if(signal_batch.depth == 0)
+        return 0;
+
+    return GetCurrentThreadId() == ffilib_control_thread.thread_id;
+}
+
+static int GrowBatch (void)
+{
+    void**       actions;
+    unsigned int action_capacity;
+
+    action_capacity = signal_batch.action_capacity*2;
+    if(action_capacity == 0)
+        action_capacity = SIGNAL_BATCH_INITIAL_SIZE;
+
+    actions = realloc(signal_batch.actions, sizeof(void*)*action_capacity);
+    if(actions == NULL)
+        return 0;
+
+    signal_batch.actions         = actions;
+    signal_batch.action_capacity = action_capacity;
+
+    return 1;
+}
+
+static void FlushBatch (void)
+{
+    if(signal_batch.action_count == 0)
+        return;
+
+    signal_batch.execif->signal_actions(
+                                        signal_batch.execif_data,
+                                        signal_batch.actions,
+                                        signal_batch.action_count
+                                       );
+
+    signal_batch.action_count = 0;
+}
+
+
+void FFILib_BeginSignalBatch (void)
+{
+    if(GetCurrentThreadId() != ffilib_control_thread.thread_id)
+        return;
+
+    signal_batch.depth++;
+}
+
+void FFILib_EndSignalBatch (void)
+{
+    if(!InBatch())
+        return;
+
+    signal_batch.depth--;
+    if(signal_batch.depth != 0)
+        return;
+
+    FlushBatch();
+
+    free(signal_batch.actions);
+
+    signal_batch.actions         = NULL;
+    signal_batch.action_capacity = 0;
+}
+
+void FFILib_SignalAction (struct tsffi_invocation_data* action_data)
+{
+    struct tsffi_execif* execif;
+
+    execif = action_data->execif;
+
+    if(!InBatch() || execif->signal_actions == NULL)
+        goto signal_directly;
+
+    /* A batch is flushed through a single execif, so switching to an
+       action owned by another interface flushes what was collected */
+    if(signal_batch.action_count != 0 && signal_batch.execif != execif)
+        FlushBatch();
+
+    if(signal_batch.action_count == signal_batch.action_capacity)
+    {
+        if(!GrowBatch())
+            goto signal_directly;
+    }
+
+    signal_batch.execif      = execif;
+    signal_batch.execif_data = action_data->execif_data;
+
+    signal_batch.actions[signal_batch.action_count++] = action_data->execif_data;
+
+    return;
+
+signal_directly:
+    execif->signal_action(action_data->execif_data);
+}
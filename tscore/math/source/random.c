@@ -10,8 +10,35 @@
 
 #include <tsffi/error.h>
 
+#include <windows.h>
 #include <math.h>
-#include <stdlib.h>
+
+
+#define RANDOM_MAX 0x7FFF
+
+
+static double NextUniform (void);
+
+
+/* Shared by every thread running math functions, the CRT keeps the rand()
+   state per thread so each dispatch worker would repeat one sequence.  The
+   generator is the CRT's own, so a single thread sees the same numbers */
+static volatile LONG random_state = 1;
+
+
+static double NextUniform (void)
+{
+    LONG current_state;
+    LONG next_state;
+
+    do
+    {
+        current_state = random_state;
+        next_state    = (LONG)((unsigned long)current_state*214013UL+2531011UL);
+    }while(InterlockedCompareExchange(&random_state, next_state, current_state) != current_state);
+
+    return (double)((((unsigned long)next_state>>16)&RANDOM_MAX)+1)/(double)(RANDOM_MAX+1);
+}
 
 
 int Math_UniformRandom (
@@ -23,7 +50,7 @@ int Math_UniformRandom (
 {
     double uniform_random;
 
-    uniform_random = (double)(rand()+1)/(double)(RAND_MAX+1);
+    uniform_random = NextUniform();
 
     output->real_data = (tsffi_real)uniform_random;
 
@@ -51,8 +78,8 @@ int Math_GaussianRandom (
 
    do
    {
-       uniform_random1 = (double)(rand()+1)/(double)(RAND_MAX+1);
-       uniform_random2 = (double)(rand()+1)/(double)(RAND_MAX+1);
+       uniform_random1 = NextUniform();
+       uniform_random2 = NextUniform();
        x = (double)2.0*uniform_random1-(double)1.0;
        y = (double)2.0*uniform_random2-(double)1.0;
 
@@ -0,0 +1,455 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+/* Appends timestamped lines to a file and drives a pipe listen action
+   over it the way the interpreter would, with the main thread standing in
+   for the module thread.  The first run appends at a fixed rate and
+   prints the p50 and p99 of the time from a line being written to its
+   action being signaled.  The second appends as fast as it can to a batch
+   listener and prints the lines read per second. */
+
+#include <notify/init.h>
+#include <notify/pipe.h>
+
+#include <ffilib/module.h>
+#include <ffilib/thread.h>
+#include <ffilib/idhash.h>
+#include <ffilib/error.h>
+#include <tsffi/execif.h>
+#include <tsffi/function.h>
+#include <tsffi/error.h>
+
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+#define BENCH_FILE_NAME "notify_bench_pipe.txt"
+
+#define LATENCY_LINE_COUNT 5000
+#define LATENCY_LINE_RATE  1000
+
+#define THROUGHPUT_LINE_COUNT 1000000
+#define THROUGHPUT_BATCH_SIZE 1024
+
+#define MAX_LINE_LENGTH 64
+
+
+struct pipe_bench
+{
+    LONGLONG frequency;
+    LONGLONG start_counter;
+
+    unsigned int line_count;
+    unsigned int line_rate;
+
+    HANDLE triggered;
+
+    HANDLE                 watch_handle;
+    tsffi_reactor_callback watch_callback;
+    void*                  watch_data;
+};
+
+
+static LONGLONG ReadMicroseconds  (void);
+static int      CompareSamples    (const void*, const void*);
+static void     Report            (char*, LONGLONG*, unsigned int);
+static DWORD WINAPI AppendLines   (LPVOID);
+static int      RunListener       (
+                                   struct notify_module_data*,
+                                   tsffi_action_controller,
+                                   union tsffi_value*,
+                                   unsigned int,
+                                   unsigned int,
+                                   LONGLONG*
+                                  );
+
+static void  SignalAction       (void*);
+static void  SignalActions      (void*, void**, unsigned int);
+static void  Alert              (void*, unsigned int, char*);
+static void  SetExceptionText   (void*, char*);
+static void* AllocateMemory     (void*, size_t);
+static void  FreeMemory         (void*, void*);
+static void* WatchHandle        (void*, tsffi_wait_handle, tsffi_reactor_callback, void*);
+static void* StartTimer         (void*, unsigned int, unsigned int, tsffi_reactor_callback, void*);
+static void  CancelRegistration (void*, void*);
+
+
+/* The bench links the ffilib thread code without the rest of the plugin */
+struct ffilib_thread_data ffilib_control_thread;
+
+static struct pipe_bench bench;
+
+static struct tsffi_execif bench_execif =
+{
+    &SignalAction,
+    &Alert,
+    &SetExceptionText,
+    &AllocateMemory,
+    &FreeMemory,
+    &WatchHandle,
+    &StartTimer,
+    &CancelRegistration,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    &SignalActions,
+    NULL
+};
+
+static struct tsffi_invocation_data bench_invocation =
+{
+    &bench_execif,
+    NULL,
+    1,
+    "bench",
+    0,
+    NULL
+};
+
+
+static LONGLONG ReadMicroseconds (void)
+{
+    LARGE_INTEGER counter;
+
+    QueryPerformanceCounter(&counter);
+
+    return (counter.QuadPart-bench.start_counter)*1000000/bench.frequency;
+}
+
+static int CompareSamples (const void* first, const void* second)
+{
+    LONGLONG first_sample;
+    LONGLONG second_sample;
+
+    first_sample  = *(const LONGLONG*)first;
+    second_sample = *(const LONGLONG*)second;
+
+    return (first_sample > second_sample)-(first_sample < second_sample);
+}
+
+static void Report (char* name, LONGLONG* samples, unsigned int sample_count)
+{
+    qsort(samples, sample_count, sizeof(LONGLONG), &CompareSamples);
+
+    printf(
+           "%-10s p50 %8I64d us  p99 %8I64d us\n",
+           name,
+           samples[sample_count/2],
+           samples[sample_count*99/100]
+          );
+}
+
+static DWORD WINAPI AppendLines (LPVOID user_data)
+{
+    HANDLE       file_handle;
+    LONGLONG     start_time;
+    unsigned int index;
+
+    file_handle = CreateFile(
+                             BENCH_FILE_NAME,
+                             FILE_APPEND_DATA,
+                             FILE_SHARE_READ|FILE_SHARE_WRITE,
+                             NULL,
+                             OPEN_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL,
+                             NULL
+                            );
+    if(file_handle == INVALID_HANDLE_VALUE)
+        return 1;
+
+    start_time = ReadMicroseconds();
+
+    for(index = 0; index < bench.line_count; index++)
+    {
+        char  line[MAX_LINE_LENGTH];
+        int   line_length;
+        DWORD written;
+
+        /* Hold every line to its slot so the reader is measured rather
+           than the writer's bursts */
+        if(bench.line_rate != 0)
+        {
+            LONGLONG slot_time;
+
+            slot_time = start_time+(LONGLONG)index*1000000/bench.line_rate;
+
+            while(ReadMicroseconds() < slot_time)
+                SwitchToThread();
+        }
+
+        line_length = _snprintf(line, MAX_LINE_LENGTH, "%u %I64d\n", index, ReadMicroseconds());
+
+        WriteFile(file_handle, line, line_length, &written, NULL);
+    }
+
+    CloseHandle(file_handle);
+
+    return 0;
+}
+
+static int RunListener (
+                        struct notify_module_data* module_data,
+                        tsffi_action_controller    controller,
+                        union tsffi_value*         input,
+                        unsigned int               line_count,
+                        unsigned int               line_rate,
+                        LONGLONG*                  samples
+                       )
+{
+    void*        user_action_data;
+    HANDLE       writer;
+    unsigned int state;
+    unsigned int received;
+    int          error;
+
+    error = controller(&bench_invocation, TSFFI_INIT_ACTION, module_data, input, &state, &user_action_data);
+    if(error != TSFFI_ERROR_NONE)
+        return error;
+
+    bench.line_count = line_count;
+    bench.line_rate  = line_rate;
+
+    writer = CreateThread(NULL, 0, &AppendLines, NULL, 0, NULL);
+    if(writer == NULL)
+        return TSFFI_ERROR_EXCEPTION;
+
+    received = 0;
+
+    while(received < line_count)
+    {
+        HANDLE wait_handles[2];
+        DWORD  wait_count;
+        DWORD  signaled_index;
+
+        Notify_ModuleState(&bench_execif, NULL, TSFFI_MODULE_SLEEPING, NULL, module_data);
+
+        wait_handles[0] = bench.triggered;
+        wait_count      = 1;
+
+        if(bench.watch_handle != NULL)
+            wait_handles[wait_count++] = bench.watch_handle;
+
+        signaled_index = WaitForMultipleObjects(wait_count, wait_handles, FALSE, INFINITE);
+
+        Notify_ModuleState(&bench_execif, NULL, TSFFI_MODULE_RUNNING, NULL, module_data);
+
+        if(signaled_index == WAIT_OBJECT_0+1)
+        {
+            bench.watch_callback(bench.watch_data);
+
+            continue;
+        }
+
+        /* Run the action for as long as it stays triggered, like the
+           interpreter does */
+        while(received < line_count)
+        {
+            union tsffi_value output;
+            union tsffi_value field;
+
+            controller(&bench_invocation, TSFFI_QUERY_ACTION, module_data, input, &state, &user_action_data);
+            if(state != TSFFI_ACTION_STATE_TRIGGERED)
+                break;
+
+            controller(&bench_invocation, TSFFI_RUNNING_ACTION, module_data, NULL, NULL, &user_action_data);
+
+            if(samples != NULL)
+            {
+                field.int_data = 1;
+
+                Notify_ReadPipeReal(&bench_invocation, module_data, &output, &field);
+
+                samples[received] = ReadMicroseconds()-(LONGLONG)output.real_data;
+            }
+
+            Notify_PipeLines(&bench_invocation, module_data, &output, NULL);
+
+            received += output.int_data;
+
+            controller(&bench_invocation, TSFFI_UPDATE_ACTION, module_data, input, &state, &user_action_data);
+        }
+    }
+
+    WaitForSingleObject(writer, INFINITE);
+    CloseHandle(writer);
+
+    controller(&bench_invocation, TSFFI_STOP_ACTION, module_data, input, &state, &user_action_data);
+
+    return TSFFI_ERROR_NONE;
+}
+
+
+static void SignalAction (void* execif_data)
+{
+    SetEvent(bench.triggered);
+}
+
+static void SignalActions (void* execif_data, void** action_data, unsigned int action_count)
+{
+    SetEvent(bench.triggered);
+}
+
+static void Alert (void* execif_data, unsigned int alert_type, char* text)
+{
+    printf("%s\n", text);
+}
+
+static void SetExceptionText (void* execif_data, char* text)
+{
+    fprintf(stderr, "%s\n", text);
+}
+
+static void* AllocateMemory (void* execif_data, size_t size)
+{
+    return malloc(size);
+}
+
+static void FreeMemory (void* execif_data, void* memory)
+{
+    free(memory);
+}
+
+static void* WatchHandle (
+                          void*                  execif_data,
+                          tsffi_wait_handle      handle,
+                          tsffi_reactor_callback callback,
+                          void*                  user_data
+                         )
+{
+    /* The bench listens on a single pipe */
+    if(bench.watch_handle != NULL)
+        return NULL;
+
+    bench.watch_handle   = handle;
+    bench.watch_callback = callback;
+    bench.watch_data     = user_data;
+
+    return &bench;
+}
+
+static void* StartTimer (
+                         void*                  execif_data,
+                         unsigned int           milliseconds,
+                         unsigned int           timer_flags,
+                         tsffi_reactor_callback callback,
+                         void*                  user_data
+                        )
+{
+    return NULL;
+}
+
+static void CancelRegistration (void* execif_data, void* registration)
+{
+    bench.watch_handle = NULL;
+}
+
+
+int main (int argc, char** argv)
+{
+    struct notify_module_data module_data;
+    union tsffi_value         output;
+    union tsffi_value         input[2];
+    LARGE_INTEGER             counter;
+    LONGLONG*                 samples;
+    LONGLONG                  start_time;
+    LONGLONG                  elapsed_time;
+    HANDLE                    file_handle;
+    int                       error;
+
+    QueryPerformanceFrequency(&counter);
+
+    bench.frequency = counter.QuadPart;
+
+    QueryPerformanceCounter(&counter);
+
+    bench.start_counter = counter.QuadPart;
+
+    bench.triggered = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if(bench.triggered == NULL)
+        return 1;
+
+    samples = malloc(sizeof(LONGLONG)*LATENCY_LINE_COUNT);
+    if(samples == NULL)
+        return 1;
+
+    file_handle = CreateFile(BENCH_FILE_NAME, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file_handle == INVALID_HANDLE_VALUE)
+        return 1;
+
+    CloseHandle(file_handle);
+
+    error = FFILib_InitializeThread(GetModuleHandle(NULL));
+    if(error != FFILIB_ERROR_NONE)
+        return 1;
+
+    error = FFILib_StartThread(&ffilib_control_thread);
+    if(error != FFILIB_ERROR_NONE)
+        return 1;
+
+    module_data.next_pipe_id       = 1;
+    module_data.pipe_poll_timer_id = 0;
+    module_data.open_pipes         = NULL;
+
+    FFILib_InitializeHash(&module_data.pipe_hash);
+    FFILib_InitializeHash(&module_data.unit_hash);
+
+    input[0].string_data = BENCH_FILE_NAME;
+
+    error = Notify_Pipe(&bench_invocation, &module_data, &output, input);
+    if(error != TSFFI_ERROR_NONE)
+        return 1;
+
+    error = RunListener(
+                        &module_data,
+                        &Notify_Action_ListenPipe,
+                        NULL,
+                        LATENCY_LINE_COUNT,
+                        LATENCY_LINE_RATE,
+                        samples
+                       );
+    if(error != TSFFI_ERROR_NONE)
+        return 1;
+
+    Report("latency", samples, LATENCY_LINE_COUNT);
+
+    input[0].int_data  = THROUGHPUT_BATCH_SIZE;
+    input[1].real_data = 0;
+
+    start_time = ReadMicroseconds();
+
+    error = RunListener(
+                        &module_data,
+                        &Notify_Action_ListenPipeBatch,
+                        input,
+                        THROUGHPUT_LINE_COUNT,
+                        0,
+                        NULL
+                       );
+    if(error != TSFFI_ERROR_NONE)
+        return 1;
+
+    elapsed_time = ReadMicroseconds()-start_time;
+
+    printf("throughput %10.0f lines/s\n", THROUGHPUT_LINE_COUNT*1000000.0/(double)elapsed_time);
+
+    Notify_DestroyPipes(&module_data, &bench_execif, NULL);
+
+    FFILib_DestroyHash(&module_data.unit_hash);
+    FFILib_DestroyHash(&module_data.pipe_hash);
+
+    FFILib_StopThread(&ffilib_control_thread);
+    FFILib_ShutdownThread();
+
+    DeleteFile(BENCH_FILE_NAME);
+
+    free(samples);
+
+    return 0;
+}
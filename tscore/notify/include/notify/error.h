@@ -10,8 +10,10 @@
 #define _NOTIFY_ERROR_H_
 
 
-#define NOTIFY_ERROR_NONE    0
-#define NOTIFY_ERROR_MEMORY -1
+#define NOTIFY_ERROR_NONE         0
+#define NOTIFY_ERROR_MEMORY      -1
+#define NOTIFY_ERROR_SYSTEM_CALL -2
+#define NOTIFY_ERROR_FRAME       -3
 
 
 #endif
@@ -0,0 +1,36 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#ifndef _NOTIFY_FILE_H_
+#define _NOTIFY_FILE_H_
+
+
+#include <tsffi/function.h>
+
+#include <windows.h>
+
+
+struct notify_file_read
+{
+    struct tsffi_execif* execif;
+    void*                execif_data;
+    void*                completion_token;
+
+    HANDLE file_handle;
+};
+
+
+extern int Notify_ReadFile (
+                            struct tsffi_invocation_data*,
+                            void*,
+                            void*,
+                            union tsffi_value*
+                           );
+
+
+#endif
@@ -11,30 +11,151 @@
 
 
 #include <tsffi/function.h>
+#include <tsffi/execif.h>
 
 #include <windows.h>
 
 
+#define NOTIFY_PIPE_SOURCE_FILE    0
+#define NOTIFY_PIPE_SOURCE_STREAM  1
+#define NOTIFY_PIPE_SOURCE_MESSAGE 2
+
+#define NOTIFY_PIPE_STREAM_FLAG_CONNECTED 0x01
+#define NOTIFY_PIPE_STREAM_FLAG_PENDING   0x02
+#define NOTIFY_PIPE_STREAM_FLAG_CLOSED    0x04
+
+#define NOTIFY_PIPE_LISTENER_FLAG_TRIGGERED 0x01
+#define NOTIFY_PIPE_LISTENER_FLAG_SELECTED  0x02
+#define NOTIFY_PIPE_LISTENER_FLAG_STARTING  0x04
+
+#define NOTIFY_PIPE_FIELD_TEXT 0
+#define NOTIFY_PIPE_FIELD_INT  1
+#define NOTIFY_PIPE_FIELD_REAL 2
+
+#define NOTIFY_PIPE_LINE_BLOCK_SIZE 64
+
+
+struct notify_module_data;
+
+struct notify_pipe_field
+{
+    unsigned int offset;
+    unsigned int length;
+    unsigned int type;
+};
+
+/* A line is read and split once, then shared by every listener of its
+   pipe.  Each listener that has yet to take the line or still holds it
+   in a batch owns one reference. */
+struct notify_pipe_line
+{
+    unsigned int references;
+
+    char*        text;
+    unsigned int text_capacity;
+
+    struct notify_pipe_field* fields;
+    unsigned int              field_count;
+    unsigned int              field_capacity;
+
+    struct notify_pipe_line* next_line;
+};
+
+struct notify_pipe_line_block
+{
+    struct notify_pipe_line lines[NOTIFY_PIPE_LINE_BLOCK_SIZE];
+
+    struct notify_pipe_line_block* next_block;
+};
+
+/* A file pipe reads a single stream.  A named pipe has one stream for
+   every connected writer, so lines from different writers are never
+   mixed, and one more that waits for the next writer to connect. */
+struct notify_pipe_stream
+{
+    unsigned int flags;
+
+    HANDLE     handle;
+    OVERLAPPED overlapped;
+    char*      channel_buffer;
+
+    char*        read_buffer;
+    unsigned int read_buffer_size;
+    unsigned int read_start;
+    unsigned int read_end;
+
+    struct notify_pipe_stream* next_stream;
+};
+
+struct notify_pipe_listener
+{
+    unsigned int flags;
+
+    struct notify_pipe_line** lines;
+    unsigned int              line_count;
+    unsigned int              line_capacity;
+    unsigned int              batch_size;
+    unsigned int              batch_latency;
+    DWORD                     batch_start;
+    UINT                      batch_timer_id;
+
+    struct notify_pipe_line*      next_line;
+    struct notify_pipe_data*      pipe_data;
+    struct tsffi_invocation_data* action_data;
+
+    struct notify_pipe_listener* next_listener;
+};
+
 struct notify_pipe_data
 {
     unsigned int pipe_id;
+    unsigned int source;
 
-    HANDLE       file_handle;
-    char*        current_line;
-    unsigned int line_argument_count;
+    char*        schema;
+    unsigned int schema_length;
 
-    struct tsffi_invocation_data* action_data;
+    struct notify_pipe_line*       last_line;
+    struct notify_pipe_line*       free_lines;
+    struct notify_pipe_line_block* line_blocks;
+    unsigned int                   queued_lines;
+
+    struct notify_pipe_stream* streams;
+    struct notify_pipe_stream* read_stream;
+    struct notify_pipe_stream* listen_stream;
+    unsigned int               stream_requests;
+
+    HANDLE        change_handle;
+    void*         change_watch;
+    unsigned int  change_id;
+    volatile LONG change_posted;
+
+    HANDLE       directory_handle;
+    OVERLAPPED   directory_overlapped;
+    char*        directory_buffer;
+    WCHAR*       file_name;
+    unsigned int file_name_size;
+    int          directory_armed;
+
+    struct tsffi_execif* watch_execif;
+    void*                watch_execif_data;
+    DWORD                watch_retry_time;
+    unsigned int         watch_backoff;
+
+    char* channel_name;
+
+    struct notify_module_data*   module_data;
+    struct notify_pipe_listener* listeners;
+    struct notify_pipe_listener* selected_listener;
 
     struct notify_pipe_data* next_pipe;
 };
 
-struct notify_module_data;
-
 
 extern int Notify_StartPipePolling (struct notify_module_data*);
 extern int Notify_StopPipePolling  (struct notify_module_data*);
 
-extern void Notify_DestroyPipes (struct notify_module_data*);
+extern int  Notify_WatchPipes   (struct notify_module_data*, struct tsffi_execif*, void*);
+extern void Notify_DestroyPipes (struct notify_module_data*, struct tsffi_execif*, void*);
 
 extern int Notify_Pipe (
                         struct tsffi_invocation_data*,
@@ -43,6 +164,26 @@ extern int Notify_Pipe (
                         union tsffi_value*
                        );
 
+extern int Notify_NamedPipe   (
+                              struct tsffi_invocation_data*,
+                              void*,
+                              union tsffi_value*,
+                              union tsffi_value*
+                             );
+extern int Notify_MessagePipe (
+                              struct tsffi_invocation_data*,
+                              void*,
+                              union tsffi_value*,
+                              union tsffi_value*
+                             );
+
+extern int Notify_FramePipe (
+                             struct tsffi_invocation_data*,
+                             void*,
+                             union tsffi_value*,
+                             union tsffi_value*
+                            );
+
 extern int Notify_ReadPipe  (
                              struct tsffi_invocation_data*,
                              void*,
@@ -56,22 +197,90 @@ extern int Notify_HReadPipe (
                              union tsffi_value*
                             );
 
-extern int Notify_Action_ListenPipe  (
-                                      struct tsffi_invocation_data*,
-                                      unsigned int,
-                                      void*,
-                                      union tsffi_value*,
-                                      unsigned int*,
-                                      void**
-                                     );
-extern int Notify_Action_HListenPipe (
-                                      struct tsffi_invocation_data*,
-                                      unsigned int,
-                                      void*,
-                                      union tsffi_value*,
-                                      unsigned int*,
-                                      void**
-                                     );
+extern int Notify_ReadPipeInt   (
+                                 struct tsffi_invocation_data*,
+                                 void*,
+                                 union tsffi_value*,
+                                 union tsffi_value*
+                                );
+extern int Notify_HReadPipeInt  (
+                                 struct tsffi_invocation_data*,
+                                 void*,
+                                 union tsffi_value*,
+                                 union tsffi_value*
+                                );
+extern int Notify_ReadPipeReal  (
+                                 struct tsffi_invocation_data*,
+                                 void*,
+                                 union tsffi_value*,
+                                 union tsffi_value*
+                                );
+extern int Notify_HReadPipeReal (
+                                 struct tsffi_invocation_data*,
+                                 void*,
+                                 union tsffi_value*,
+                                 union tsffi_value*
+                                );
+
+extern int Notify_PipeLines  (
+                              struct tsffi_invocation_data*,
+                              void*,
+                              union tsffi_value*,
+                              union tsffi_value*
+                             );
+extern int Notify_HPipeLines (
+                              struct tsffi_invocation_data*,
+                              void*,
+                              union tsffi_value*,
+                              union tsffi_value*
+                             );
+
+
+extern int Notify_ReadPipeLine  (
+                                 struct tsffi_invocation_data*,
+                                 void*,
+                                 union tsffi_value*,
+                                 union tsffi_value*
+                                );
+extern int Notify_HReadPipeLine (
+                                 struct tsffi_invocation_data*,
+                                 void*,
+                                 union tsffi_value*,
+                                 union tsffi_value*
+                                );
+
+extern int Notify_Action_ListenPipe       (
+                                           struct tsffi_invocation_data*,
+                                           unsigned int,
+                                           void*,
+                                           union tsffi_value*,
+                                           unsigned int*,
+                                           void**
+                                          );
+extern int Notify_Action_HListenPipe      (
+                                           struct tsffi_invocation_data*,
+                                           unsigned int,
+                                           void*,
+                                           union tsffi_value*,
+                                           unsigned int*,
+                                           void**
+                                          );
+extern int Notify_Action_ListenPipeBatch  (
+                                           struct tsffi_invocation_data*,
+                                           unsigned int,
+                                           void*,
+                                           union tsffi_value*,
+                                           unsigned int*,
+                                           void**
+                                          );
+extern int Notify_Action_HListenPipeBatch (
+                                           struct tsffi_invocation_data*,
+                                           unsigned int,
+                                           void*,
+                                           union tsffi_value*,
+                                           unsigned int*,
+                                           void**
+                                          );
 
 
 #endif
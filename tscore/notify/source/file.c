@@ -0,0 +1,163 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#include <notify/file.h>
+
+#include <tsffi/error.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+#define MAX_EXCEPTION_TEXT_LENGTH 1024
+
+
+static DWORD WINAPI ReadFileContents (LPVOID);
+
+
+static DWORD WINAPI ReadFileContents (LPVOID user_data)
+{
+    struct notify_file_read* read_data;
+    union tsffi_value        output;
+    char*                    contents;
+    DWORD                    file_size;
+    DWORD                    total_read;
+
+    read_data = user_data;
+
+    file_size = GetFileSize(read_data->file_handle, NULL);
+    if(file_size == INVALID_FILE_SIZE)
+        goto get_file_size_failed;
+
+    contents = read_data->execif->allocate_memory(read_data->execif_data, file_size+1);
+    if(contents == NULL)
+        goto allocate_contents_failed;
+
+    total_read = 0;
+    while(total_read < file_size)
+    {
+        DWORD bytes_read;
+        BOOL  result;
+
+        result = ReadFile(
+                          read_data->file_handle,
+                          contents+total_read,
+                          file_size-total_read,
+                          &bytes_read,
+                          NULL
+                         );
+        if(result == FALSE)
+            goto read_file_failed;
+
+        /* The file was truncated while being read */
+        if(bytes_read == 0)
+            break;
+
+        total_read += bytes_read;
+    }
+
+    contents[total_read] = 0;
+
+    CloseHandle(read_data->file_handle);
+
+    output.string_data = contents;
+
+    read_data->execif->complete_function(
+                                         read_data->execif_data,
+                                         read_data->completion_token,
+                                         TSFFI_ERROR_NONE,
+                                         &output
+                                        );
+
+    free(read_data);
+
+    return 0;
+
+read_file_failed:
+    read_data->execif->free_memory(read_data->execif_data, contents);
+allocate_contents_failed:
+get_file_size_failed:
+    CloseHandle(read_data->file_handle);
+
+    read_data->execif->complete_function(
+                                         read_data->execif_data,
+                                         read_data->completion_token,
+                                         TSFFI_ERROR_EXCEPTION,
+                                         NULL
+                                        );
+
+    free(read_data);
+
+    return 0;
+}
+
+
+int Notify_ReadFile (
+                     struct tsffi_invocation_data* invocation_data,
+                     void*                         group_data,
+                     void*                         completion_token,
+                     union tsffi_value*            input
+                    )
+{
+    struct notify_file_read* read_data;
+    BOOL                     result;
+
+    read_data = malloc(sizeof(struct notify_file_read));
+    if(read_data == NULL)
+        goto allocate_read_data_failed;
+
+    /* Open the file here so a bad path is reported against the caller,
+       only the read itself happens in the background */
+    read_data->file_handle = CreateFile(
+                                        input->string_data,
+                                        GENERIC_READ,
+                                        FILE_SHARE_READ|FILE_SHARE_WRITE,
+                                        NULL,
+                                        OPEN_EXISTING,
+                                        FILE_ATTRIBUTE_NORMAL,
+                                        NULL
+                                       );
+    if(read_data->file_handle == INVALID_HANDLE_VALUE)
+    {
+        char text[MAX_EXCEPTION_TEXT_LENGTH];
+
+        _snprintf(
+                  text,
+                  MAX_EXCEPTION_TEXT_LENGTH,
+                  "function=%s line=%d: The specified file could not be opened",
+                  invocation_data->unit_name,
+                  invocation_data->unit_location
+                 );
+
+        text[MAX_EXCEPTION_TEXT_LENGTH-1] = 0;
+
+        invocation_data->execif->set_exception_text(invocation_data->execif_data, text);
+
+        goto open_file_failed;
+    }
+
+    read_data->execif           = invocation_data->execif;
+    read_data->execif_data      = invocation_data->execif_data;
+    read_data->completion_token = completion_token;
+
+    /* Reads are short lived and may be frequent, so they share the system
+       thread pool rather than starting a thread each */
+    result = QueueUserWorkItem(&ReadFileContents, read_data, WT_EXECUTEDEFAULT);
+    if(result == FALSE)
+        goto queue_read_failed;
+
+    return TSFFI_ERROR_NONE;
+
+queue_read_failed:
+    CloseHandle(read_data->file_handle);
+open_file_failed:
+    free(read_data);
+
+allocate_read_data_failed:
+    return TSFFI_ERROR_EXCEPTION;
+}
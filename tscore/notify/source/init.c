@@ -62,7 +62,10 @@ int Notify_ModuleState (
     switch(state)
     {
     case TSFFI_MODULE_SLEEPING:
-        error = Notify_StartPipePolling(group_data);
+        /* Only pipes the module can't wait on need the poll timer */
+        error = TSFFI_ERROR_NONE;
+        if(Notify_WatchPipes(group_data, execif, execif_data))
+            error = Notify_StartPipePolling(group_data);
 
         break;
 
@@ -87,7 +90,7 @@ void Notify_EndModule (
 
     module_data = group_data;
 
-    Notify_DestroyPipes(module_data);
+    Notify_DestroyPipes(module_data, execif, execif_data);
 
     FFILib_DestroyHash(&module_data->unit_hash);
     FFILib_DestroyHash(&module_data->pipe_hash);
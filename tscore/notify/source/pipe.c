@@ -14,9 +14,11 @@
 #include <ffilib/thread.h>
 #include <ffilib/module.h>
 #include <ffilib/idhash.h>
+#include <ffilib/signal.h>
 #include <ffilib/error.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 
@@ -24,432 +26,2921 @@
 
 #define PIPE_POLL_TIMER_PERIOD 100
 
+#define PIPE_READ_BUFFER_SIZE 65536
 
-static int   ReadLine        (HANDLE, char**, unsigned int*);
-static char* ExtractArgument (char*, unsigned int, int, struct tsffi_invocation_data*);
+#define PIPE_CHANNEL_BUFFER_SIZE 4096
 
-static int PerformPipeListen (
+#define PIPE_CHANNEL_PREFIX "\\\\.\\pipe\\"
+
+#define PIPE_CHANGE_FILTER      (FILE_NOTIFY_CHANGE_SIZE|FILE_NOTIFY_CHANGE_LAST_WRITE)
+#define PIPE_CHANGE_BUFFER_SIZE 4096
+
+#define PIPE_WATCH_INITIAL_BACKOFF 100
+#define PIPE_WATCH_MAX_BACKOFF     10000
+
+#define PIPE_INITIAL_FIELD_CAPACITY 16
+
+#define PIPE_QUEUED_LINE_LIMIT 1024
+
+#define PIPE_FRAME_LENGTH_SIZE 4
+#define PIPE_FRAME_NUMBER_SIZE 8
+#define PIPE_MAX_FRAME_SIZE    (16*1024*1024)
+
+#define PIPE_SCHEMA_TYPES  "irs"
+#define PIPE_SCHEMA_INT    'i'
+#define PIPE_SCHEMA_STRING 's'
+
+#define PIPE_FIELD_TEXT_SIZE 32
+
+#define IS_FIELD_SEPARATOR(character) ((character) == ' ' || (character) == '\t' || (character) == '\r')
+
+
+static int   ReserveBuffer   (struct notify_pipe_stream*, unsigned int);
+static int   FillBuffer      (struct notify_pipe_data*, struct notify_pipe_stream*, DWORD*);
+static int   FillChannel     (struct notify_pipe_data*, struct notify_pipe_stream*, DWORD*);
+static int   TokenizeLine    (struct notify_pipe_line*, unsigned int);
+static int   DecodeRecord    (struct notify_pipe_line*, unsigned int, char*, unsigned int);
+static int   ReadRecord      (
+                              struct notify_pipe_data*,
+                              struct notify_pipe_stream*,
+                              struct notify_pipe_line*,
+                              int*
+                             );
+static int   ReadStreamLine  (
+                              struct notify_pipe_data*,
+                              struct notify_pipe_stream*,
+                              struct notify_pipe_line*,
+                              int*
+                             );
+static int   ReadLine        (struct notify_pipe_data*, struct notify_pipe_line*, int*);
+static char* ExtractArgument (struct notify_pipe_line*, int, struct tsffi_invocation_data*);
+
+static struct notify_pipe_field* AddField  (struct notify_pipe_line*, unsigned int);
+static char*                     FieldText (
+                                            struct notify_pipe_line*,
+                                            struct notify_pipe_field*,
+                                            char*,
+                                            unsigned int*
+                                           );
+static tsffi_int                 FieldInt  (struct notify_pipe_line*, int);
+static tsffi_real                FieldReal (struct notify_pipe_line*, int);
+
+static int  AllocLines  (struct notify_pipe_data*);
+static void ReleaseLine (struct notify_pipe_data*, struct notify_pipe_line*);
+static void PublishLine (struct notify_pipe_data*, struct notify_pipe_line*);
+static int  TakeLines   (struct notify_pipe_listener*);
+static int  PumpPipe    (struct notify_pipe_data*);
+
+static struct notify_pipe_listener* AddListener       (
+                                                       struct notify_pipe_data*,
+                                                       struct tsffi_invocation_data*,
+                                                       unsigned int,
+                                                       unsigned int
+                                                      );
+static void                         ReleaseBatch      (struct notify_pipe_listener*);
+static void                         RemoveListener    (struct notify_pipe_listener*);
+static struct notify_pipe_listener* TriggeredListener (
+                                                       struct notify_pipe_data*,
+                                                       struct tsffi_invocation_data*
+                                                      );
+
+static struct notify_pipe_line* TriggeredLine (
+                                               struct notify_pipe_data*,
+                                               struct tsffi_invocation_data*,
+                                               int
+                                              );
+static struct notify_pipe_data* UnitPipe      (struct tsffi_invocation_data*, void*);
+static struct notify_pipe_data* HandlePipe    (struct tsffi_invocation_data*, void*, int);
+
+static struct notify_pipe_data* AllocPipe    (unsigned int);
+static void                     FreePipe     (struct notify_pipe_data*, struct tsffi_execif*, void*);
+static int                      RegisterPipe (
+                                              struct tsffi_invocation_data*,
+                                              struct notify_module_data*,
+                                              struct notify_pipe_data*,
+                                              union tsffi_value*
+                                             );
+
+static struct notify_pipe_stream* AllocStream   (struct notify_pipe_data*, HANDLE);
+static void                       FreeStream    (struct notify_pipe_stream*);
+static void                       ReapStreams   (struct notify_pipe_data*);
+static void                       CancelStreams (struct notify_pipe_data*);
+
+static int    WatchPipeDirectory (struct notify_pipe_data*, char*);
+static int    ArmDirectoryWatch  (struct notify_pipe_data*);
+static int    FileChanged        (struct notify_pipe_data*, DWORD);
+static HANDLE CreateChannel      (struct notify_pipe_data*);
+static int    ListenChannel      (struct notify_pipe_data*, struct notify_pipe_stream*);
+static void   ChannelConnected   (struct notify_pipe_data*, struct notify_pipe_stream*);
+static void   ResetChannel       (struct notify_pipe_data*, struct notify_pipe_stream*);
+static int    OpenChannel        (
+                                  struct tsffi_invocation_data*,
+                                  void*,
+                                  union tsffi_value*,
+                                  union tsffi_value*,
+                                  unsigned int
+                                 );
+static void   DeferWatch         (struct notify_pipe_data*, DWORD);
+static void   PipeChanged        (void*);
+static int    PumpChangedPipe    (void*);
+
+static struct notify_pipe_stream* AddChannelInstance (struct notify_pipe_data*);
+
+static int ListenError       (struct tsffi_invocation_data*, int);
+static int StartPipeListen   (
                               struct notify_pipe_data*,
                               struct tsffi_invocation_data*,
+                              void**,
+                              unsigned int,
+                              unsigned int
+                             );
+static int PerformPipeListen (
+                              struct tsffi_invocation_data*,
+                              unsigned int,
+                              unsigned int*,
+                              void**
+                             );
+static int ListenUnitPipe    (
+                              struct tsffi_invocation_data*,
+                              void*,
+                              void**,
+                              unsigned int,
+                              unsigned int
+                             );
+static int ListenHandlePipe  (
+                              struct tsffi_invocation_data*,
+                              void*,
+                              int,
+                              void**,
                               unsigned int,
-                              unsigned int*
+                              unsigned int
                              );
 
+static unsigned int BatchLatency     (tsffi_real);
+static void         SetBatchLimits   (struct notify_pipe_listener*, int, tsffi_real);
+static int          ArmBatchTimer    (struct notify_pipe_listener*, DWORD);
+static void         DisarmBatchTimer (struct notify_pipe_listener*);
+
+static VOID CALLBACK BatchTimerProc (HWND, UINT, UINT, DWORD);
+
+static int BatchTimer (void*);
+
 static VOID CALLBACK PipePollTimerProc (HWND, UINT, UINT, DWORD);
 
+static int PollPipes        (void*);
 static int PipePollTimer    (void*);
 static int StartPipePolling (void*);
 static int StopPipePolling  (void*);
+static int ForgetPipes      (void*);
 
 
 FFILIB_DECLARE_STATIC_ID_HASH(timer_id_hash);
+FFILIB_DECLARE_STATIC_ID_HASH(batch_timer_hash);
+FFILIB_DECLARE_STATIC_ID_HASH(change_id_hash);
 
+/* Change IDs name pipes across every module, they are only handed out
+   on the control thread */
+static unsigned int next_change_id = 1;
 
-static int ReadLine (HANDLE file, char** new_line, unsigned int* arguments)
+
+static int ReserveBuffer (struct notify_pipe_stream* stream, unsigned int size)
 {
-    char*        line;
-    unsigned int argument_count;
-    int          bytes_read;
+    char*        buffer;
+    unsigned int buffer_size;
 
-    bytes_read = 0;
+    buffer_size = stream->read_buffer_size;
+    if(buffer_size-stream->read_end >= size)
+        return NOTIFY_ERROR_NONE;
 
-    while(1)
-    {
-        char*        scan_line;
-        unsigned int non_whitespace_count;
-        DWORD        read_size;
-        BOOL         error;
-        char         read_character;
-        char         current_character;
+    while(buffer_size-stream->read_end < size)
+        buffer_size *= 2;
 
-        do
-        {
-            error = ReadFile(file, &read_character, 1, &read_size, NULL);
+    buffer = realloc(stream->read_buffer, buffer_size);
+    if(buffer == NULL)
+        return NOTIFY_ERROR_MEMORY;
+
+    stream->read_buffer      = buffer;
+    stream->read_buffer_size = buffer_size;
+
+    return NOTIFY_ERROR_NONE;
+}
 
-            bytes_read += read_size;
+static int FillBuffer (
+                       struct notify_pipe_data*   pipe_data,
+                       struct notify_pipe_stream* stream,
+                       DWORD*                     read_size
+                      )
+{
+    char*        buffer;
+    unsigned int pending_size;
+    BOOL         read_result;
+    int          error;
 
-            if(error == 0 || read_size == 0)
-                goto no_eol_found;
-        }while(read_character != '\n');
+    buffer       = stream->read_buffer;
+    pending_size = stream->read_end-stream->read_start;
 
-        SetFilePointer(file, -bytes_read, NULL, FILE_CURRENT);
+    /* Only the tail of an unfinished line is ever left behind, so moving
+       it to the front is cheap */
+    if(stream->read_start != 0)
+    {
+        memmove(buffer, &buffer[stream->read_start], pending_size);
 
-        line = malloc(bytes_read);
-        if(line == NULL)
-            return NOTIFY_ERROR_MEMORY;
+        stream->read_start = 0;
+        stream->read_end   = pending_size;
+    }
+
+    if(pipe_data->source != NOTIFY_PIPE_SOURCE_FILE)
+        return FillChannel(pipe_data, stream, read_size);
+
+    error = ReserveBuffer(stream, 1);
+    if(error != NOTIFY_ERROR_NONE)
+        return error;
+
+    buffer = stream->read_buffer;
 
-        error = ReadFile(file, line, bytes_read, &read_size, NULL);
+    read_result = ReadFile(
+                           stream->handle,
+                           &buffer[stream->read_end],
+                           stream->read_buffer_size-stream->read_end,
+                           read_size,
+                           NULL
+                          );
+    if(read_result == 0)
+        *read_size = 0;
 
-        bytes_read--;
-        if(error == 0 || line[bytes_read] != '\n')
-            goto read_to_eol_failed;
+    stream->read_end += *read_size;
 
-        line[bytes_read] = 0;
+    return NOTIFY_ERROR_NONE;
+}
 
-        bytes_read--;
-        if(line[bytes_read] == '\r')
-            line[bytes_read] = 0;
+static int FillChannel (
+                        struct notify_pipe_data*   pipe_data,
+                        struct notify_pipe_stream* stream,
+                        DWORD*                     read_size
+                       )
+{
+    OVERLAPPED*  overlapped;
+    DWORD        transferred;
+    BOOL         result;
+    unsigned int terminate;
+    int          error;
+
+    *read_size = 0;
+    overlapped = &stream->overlapped;
+
+    /* Only one read is ever outstanding per writer and it is only issued
+       while the slowest listener has room for more lines, so a writer
+       that outpaces the script blocks on the full pipe instead of growing
+       our buffers */
+    while(1)
+    {
+        DWORD last_error;
 
-        scan_line = line;
+        if(stream->flags&NOTIFY_PIPE_STREAM_FLAG_CLOSED)
+            return NOTIFY_ERROR_NONE;
 
-        argument_count       = 0;
-        non_whitespace_count = 0;
-        do
+        if(!(stream->flags&NOTIFY_PIPE_STREAM_FLAG_PENDING))
         {
-            current_character = *scan_line;
+            if(!(stream->flags&NOTIFY_PIPE_STREAM_FLAG_CONNECTED))
+            {
+                error = ListenChannel(pipe_data, stream);
+                if(error != NOTIFY_ERROR_NONE)
+                    return error;
+
+                continue;
+            }
 
-            switch(current_character)
+            result = ReadFile(
+                              stream->handle,
+                              stream->channel_buffer,
+                              PIPE_CHANNEL_BUFFER_SIZE,
+                              NULL,
+                              overlapped
+                             );
+
+            pipe_data->stream_requests++;
+
+            if(result == 0)
             {
-            case 0:
-            case '\t':
-            case '\r':
-            case ' ':
-                if(non_whitespace_count != 0)
+                last_error = GetLastError();
+                if(last_error != ERROR_IO_PENDING && last_error != ERROR_MORE_DATA)
                 {
-                    *scan_line = 0;
+                    ResetChannel(pipe_data, stream);
 
-                    while(current_character != 0)
-                    {
-                        scan_line++;
+                    continue;
+                }
+            }
 
-                        current_character = *scan_line;
-                        if(
-                           current_character != ' ' &&
-                           current_character != '\t' &&
-                           current_character != '\r'
-                          )
-                        {
-                            break;
-                        }
-                    }
+            stream->flags |= NOTIFY_PIPE_STREAM_FLAG_PENDING;
+        }
 
-                    argument_count++;
-                    non_whitespace_count = 0;
-                }
-                else
-                    scan_line++;
+        result = GetOverlappedResult(stream->handle, overlapped, &transferred, FALSE);
+        if(result == 0)
+        {
+            last_error = GetLastError();
+            if(last_error == ERROR_IO_INCOMPLETE)
+                return NOTIFY_ERROR_NONE;
 
-                break;
+            stream->flags &= ~NOTIFY_PIPE_STREAM_FLAG_PENDING;
 
-            default:
-                non_whitespace_count++;
-                scan_line++;
+            if(last_error != ERROR_MORE_DATA)
+            {
+                ResetChannel(pipe_data, stream);
 
-                break;
+                continue;
             }
-        }while(current_character != 0);
 
-        if(argument_count == 0)
-            free(line);
+            terminate = 0;
+        }
         else
-            break;
+        {
+            stream->flags &= ~NOTIFY_PIPE_STREAM_FLAG_PENDING;
+
+            terminate = pipe_data->source == NOTIFY_PIPE_SOURCE_MESSAGE && pipe_data->schema == NULL;
+        }
+
+        if(!(stream->flags&NOTIFY_PIPE_STREAM_FLAG_CONNECTED))
+        {
+            ChannelConnected(pipe_data, stream);
+
+            continue;
+        }
+
+        break;
     }
 
-    *new_line  = line;
-    *arguments = argument_count;
+    /* A complete message always ends the line it started */
+    error = ReserveBuffer(stream, transferred+terminate);
+    if(error != NOTIFY_ERROR_NONE)
+        return error;
 
-    return NOTIFY_ERROR_NONE;
+    memcpy(&stream->read_buffer[stream->read_end], stream->channel_buffer, transferred);
+
+    stream->read_end += transferred;
+
+    if(terminate)
+    {
+        stream->read_buffer[stream->read_end] = '\n';
 
-read_to_eol_failed:
-    free(line);
-no_eol_found:
-    SetFilePointer(file, -bytes_read, NULL, FILE_CURRENT);
+        stream->read_end++;
+    }
 
-    *new_line = NULL;
+    *read_size = transferred+terminate;
 
     return NOTIFY_ERROR_NONE;
 }
 
-static char* ExtractArgument (
-                              char*                         line,
-                              unsigned int                  line_argument_count,
-                              int                           argument,
-                              struct tsffi_invocation_data* invocation_data
-                             )
+static int TokenizeLine (struct notify_pipe_line* line, unsigned int line_length)
 {
-    char*  duplicated_argument;
-    size_t alloc_size;
+    char*        text;
+    unsigned int field_count;
+    unsigned int index;
 
-    if(line == NULL || argument < 0 || (unsigned int)argument >= line_argument_count)
-        line = "";
-    else
+    text        = line->text;
+    field_count = 0;
+    index       = 0;
+
+    /* Record where each field lives so reads never rescan the line */
+    while(1)
     {
-        char current_character;
+        struct notify_pipe_field* field;
+        unsigned int              field_start;
 
-        while(argument--)
-            line += strlen(line)+1;
+        while(index < line_length && IS_FIELD_SEPARATOR(text[index]))
+            index++;
 
-        while(1)
-        {
-            current_character = *line;
+        if(index == line_length)
+            break;
 
-            if(
-               current_character != ' ' &&
-               current_character != '\t' &&
-               current_character != '\r'
-              )
-            {
-                break;
-            }
+        field_start = index;
 
-            line++;
-        }
-    }
+        while(index < line_length && !IS_FIELD_SEPARATOR(text[index]))
+            index++;
 
-    alloc_size = strlen(line)+1;
+        field = AddField(line, field_count);
+        if(field == NULL)
+            return NOTIFY_ERROR_MEMORY;
 
-    duplicated_argument = invocation_data->execif->allocate_memory(
-                                                                   invocation_data->execif_data,
-                                                                   alloc_size
-                                                                  );
-    if(duplicated_argument == NULL)
-        return NULL;
+        field->offset = field_start;
+        field->length = index-field_start;
+        field->type   = NOTIFY_PIPE_FIELD_TEXT;
+
+        field_count++;
+    }
 
-    strcpy(duplicated_argument, line);
+    line->field_count = field_count;
 
-    return duplicated_argument;
+    return NOTIFY_ERROR_NONE;
 }
 
-static int PerformPipeListen (
-                              struct notify_pipe_data*      pipe_data,
-                              struct tsffi_invocation_data* action_data,
-                              unsigned int                  request,
-                              unsigned int*                 state
-                             )
+static int DecodeRecord (
+                         struct notify_pipe_line* line,
+                         unsigned int             record_length,
+                         char*                    schema,
+                         unsigned int             schema_length
+                        )
 {
-    char  text[MAX_EXCEPTION_TEXT_LENGTH];
-    char* line;
-    int   error;
+    unsigned int field_count;
+    unsigned int offset;
+    unsigned int index;
 
-    switch(request)
-    {
-    case TSFFI_INIT_ACTION:
-        error = ReadLine(pipe_data->file_handle, &line, &pipe_data->line_argument_count);
-        if(error != NOTIFY_ERROR_NONE)
-            goto error_reading_file;
-
-        pipe_data->current_line = line;
-        pipe_data->action_data  = action_data;
+    field_count = 0;
+    offset      = 0;
 
-        if(line != NULL)
-            action_data->execif->signal_action(action_data->execif_data);
+    /* A record cut short by its writer keeps the fields it does hold */
+    for(index = 0; index < schema_length; index++)
+    {
+        struct notify_pipe_field* field;
+        unsigned int              field_offset;
+        unsigned int              field_length;
+        unsigned int              field_type;
 
-        break;
+        if(schema[index] == PIPE_SCHEMA_STRING)
+        {
+            if(record_length-offset < PIPE_FRAME_LENGTH_SIZE)
+                break;
 
-    case TSFFI_RUNNING_ACTION:
-        break;
+            memcpy(&field_length, &line->text[offset], PIPE_FRAME_LENGTH_SIZE);
 
-    case TSFFI_UPDATE_ACTION:
-        if(pipe_data->current_line != NULL)
-        {
-            free(pipe_data->current_line);
+            field_offset = offset+PIPE_FRAME_LENGTH_SIZE;
+            field_type   = NOTIFY_PIPE_FIELD_TEXT;
 
-            pipe_data->current_line = NULL;
+            if(field_length > record_length-field_offset)
+                break;
         }
+        else
+        {
+            if(record_length-offset < PIPE_FRAME_NUMBER_SIZE)
+                break;
 
-        error = ReadLine(pipe_data->file_handle, &line, &pipe_data->line_argument_count);
-        if(error != NOTIFY_ERROR_NONE)
-            goto error_reading_file;
-
-        pipe_data->current_line = line;
+            field_offset = offset;
+            field_length = PIPE_FRAME_NUMBER_SIZE;
 
-        if(line != NULL)
-            action_data->execif->signal_action(action_data->execif_data);
+            if(schema[index] == PIPE_SCHEMA_INT)
+                field_type = NOTIFY_PIPE_FIELD_INT;
+            else
+                field_type = NOTIFY_PIPE_FIELD_REAL;
+        }
 
-        break;
+        field = AddField(line, field_count);
+        if(field == NULL)
+            return NOTIFY_ERROR_MEMORY;
 
-    case TSFFI_QUERY_ACTION:
-        if(pipe_data->current_line != NULL)
-            *state = TSFFI_ACTION_STATE_TRIGGERED;
-        else
-            *state = TSFFI_ACTION_STATE_PENDING;
+        field->offset = field_offset;
+        field->length = field_length;
+        field->type   = field_type;
 
-        break;
+        offset = field_offset+field_length;
 
-    case TSFFI_STOP_ACTION:
-        break;
+        field_count++;
     }
 
-   return TSFFI_ERROR_NONE;
-
-error_reading_file:
-    _snprintf(
-              text,
-              MAX_EXCEPTION_TEXT_LENGTH,
-              "function=%s line=%d: The file could not be read",
-              action_data->unit_name,
-              action_data->unit_location
-             );
-
-    text[MAX_EXCEPTION_TEXT_LENGTH-1] = 0;
-
-    action_data->execif->set_exception_text(action_data->execif_data, text);
+    line->field_count = field_count;
 
-    return TSFFI_ERROR_EXCEPTION;
+    return NOTIFY_ERROR_NONE;
 }
 
-static VOID CALLBACK PipePollTimerProc (
-                                        HWND  window,
-                                        UINT  message,
-                                        UINT  timer_id,
-                                        DWORD time
-                                       )
+static int ReadRecord (
+                       struct notify_pipe_data*   pipe_data,
+                       struct notify_pipe_stream* stream,
+                       struct notify_pipe_line*   line,
+                       int*                       line_read
+                      )
 {
-    int result;
     int error;
 
-    error = FFILib_SynchronousFunction(&PipePollTimer, &timer_id, &ffilib_control_thread, &result);
-    if(error == FFILIB_ERROR_THREAD_SWITCH)
-        PipePollTimer(&timer_id);
-}
+    while(1)
+    {
+        char*        record_start;
+        unsigned int record_length;
+        unsigned int pending_size;
 
-static int PipePollTimer (void* user_data)
-{
-    struct notify_module_data* module_data;
-    struct notify_pipe_data*   open_pipes;
-    UINT*                      timer_id;
+        record_start  = &stream->read_buffer[stream->read_start];
+        pending_size  = stream->read_end-stream->read_start;
+        record_length = 0;
 
-    timer_id    = user_data;
-    module_data = FFILib_GetIDData(*timer_id, &timer_id_hash);
+        if(pending_size >= PIPE_FRAME_LENGTH_SIZE)
+        {
+            memcpy(&record_length, record_start, PIPE_FRAME_LENGTH_SIZE);
 
-    if(module_data == NULL)
-        return NOTIFY_ERROR_NONE;
+            /* A length this large means the writer is not framing its
+               records, there is no way to find the next one */
+            if(record_length > PIPE_MAX_FRAME_SIZE)
+                return NOTIFY_ERROR_FRAME;
+        }
 
-    for(
-        open_pipes = module_data->open_pipes;
-        open_pipes != NULL;
-        open_pipes = open_pipes->next_pipe
-       )
-    {
-        char* line;
-        int   error;
+        if(
+           pending_size < PIPE_FRAME_LENGTH_SIZE ||
+           pending_size-PIPE_FRAME_LENGTH_SIZE < record_length
+          )
+        {
+            DWORD read_size;
 
-        if(open_pipes->current_line != NULL)
-            continue;
+            error = FillBuffer(pipe_data, stream, &read_size);
+            if(error != NOTIFY_ERROR_NONE)
+                return error;
+
+            if(read_size == 0)
+                break;
 
-        error = ReadLine(open_pipes->file_handle, &line, &open_pipes->line_argument_count);
-        if(error != NOTIFY_ERROR_NONE)
             continue;
+        }
 
-        open_pipes->current_line = line;
+        stream->read_start += PIPE_FRAME_LENGTH_SIZE+record_length;
 
-        if(line != NULL)
+        if(record_length >= line->text_capacity)
         {
-            struct tsffi_invocation_data* action_data;
+            char* text;
+
+            text = realloc(line->text, record_length+1);
+            if(text == NULL)
+                return NOTIFY_ERROR_MEMORY;
+
+            line->text          = text;
+            line->text_capacity = record_length+1;
+        }
+
+        memcpy(line->text, record_start+PIPE_FRAME_LENGTH_SIZE, record_length);
 
-            action_data = open_pipes->action_data;
+        line->text[record_length] = 0;
 
-            action_data->execif->signal_action(action_data->execif_data);
+        error = DecodeRecord(line, record_length, pipe_data->schema, pipe_data->schema_length);
+        if(error != NOTIFY_ERROR_NONE)
+            return error;
+
+        if(line->field_count != 0)
+        {
+            *line_read = 1;
+
+            return NOTIFY_ERROR_NONE;
         }
     }
 
+    *line_read = 0;
+
     return NOTIFY_ERROR_NONE;
 }
 
-static int StartPipePolling (void* user_data)
+static int ReadStreamLine (
+                           struct notify_pipe_data*   pipe_data,
+                           struct notify_pipe_stream* stream,
+                           struct notify_pipe_line*   line,
+                           int*                       line_read
+                          )
 {
-    struct notify_module_data* module_data;
-    unsigned int               timer_id;
-    int                        error;
+    int error;
 
-    module_data = user_data;
+    if(pipe_data->schema != NULL)
+        return ReadRecord(pipe_data, stream, line, line_read);
 
-    timer_id = SetTimer(NULL, 0, PIPE_POLL_TIMER_PERIOD, &PipePollTimerProc);
-    if(timer_id == 0)
-        goto set_timer_failed;
+    while(1)
+    {
+        char*        line_start;
+        char*        line_end;
+        unsigned int line_length;
 
-    error = FFILib_AddID(timer_id, module_data, &timer_id_hash);
-    if(error != FFILIB_ERROR_NONE)
-        goto add_id_failed;
+        line_start = &stream->read_buffer[stream->read_start];
+        line_end   = memchr(line_start, '\n', stream->read_end-stream->read_start);
 
-    module_data->pipe_poll_timer_id = timer_id;
+        if(line_end == NULL)
+        {
+            DWORD read_size;
 
-    return TSFFI_ERROR_NONE;
+            error = FillBuffer(pipe_data, stream, &read_size);
+            if(error != NOTIFY_ERROR_NONE)
+                return error;
 
-add_id_failed:
-    KillTimer(NULL, timer_id);
+            if(read_size == 0)
+                break;
 
-set_timer_failed:
-    return TSFFI_ERROR_EXCEPTION;
-}
+            continue;
+        }
 
-static int StopPipePolling (void* user_data)
-{
-    struct notify_module_data* module_data;
-    unsigned int               timer_id;
+        line_length = (unsigned int)(line_end-line_start);
 
-    module_data = user_data;
-    timer_id    = module_data->pipe_poll_timer_id;
+        stream->read_start += line_length+1;
 
-    KillTimer(NULL, timer_id);
-    FFILib_RemoveID(timer_id, &timer_id_hash);
+        if(line_length != 0 && line_start[line_length-1] == '\r')
+            line_length--;
 
-    module_data->pipe_poll_timer_id = 0;
+        /* Line slots keep their storage between batches */
+        if(line_length >= line->text_capacity)
+        {
+            char* text;
 
-    return TSFFI_ERROR_NONE;
-}
+            text = realloc(line->text, line_length+1);
+            if(text == NULL)
+                return NOTIFY_ERROR_MEMORY;
 
+            line->text          = text;
+            line->text_capacity = line_length+1;
+        }
 
-int Notify_StartPipePolling (struct notify_module_data* module_data)
-{
-    int result;
+        memcpy(line->text, line_start, line_length);
 
-    FFILib_SynchronousFunction(&StartPipePolling, module_data, &ffilib_control_thread, &result);
+        line->text[line_length] = 0;
 
-    return result;
+        error = TokenizeLine(line, line_length);
+        if(error != NOTIFY_ERROR_NONE)
+            return error;
 
-}
+        if(line->field_count != 0)
+        {
+            *line_read = 1;
 
-int Notify_StopPipePolling (struct notify_module_data* module_data)
-{
-    int result;
+            return NOTIFY_ERROR_NONE;
+        }
+    }
 
-    FFILib_SynchronousFunction(&StartPipePolling, module_data, &ffilib_control_thread, &result);
+    *line_read = 0;
 
-    return result;
+    return NOTIFY_ERROR_NONE;
 }
 
-void Notify_DestroyPipes (struct notify_module_data* module_data)
+static int ReadLine (
+                     struct notify_pipe_data* pipe_data,
+                     struct notify_pipe_line* line,
+                     int*                     line_read
+                    )
 {
-    struct notify_pipe_data* pipes;
-
-    if(module_data->pipe_poll_timer_id != 0)
-        StopPipePolling(module_data);
+    ReapStreams(pipe_data);
+
+    /* Writers take turns so a busy one can't starve the others.  Every
+       instance signals the same event and issuing a request resets it, so
+       the scan only ends after a pass that issued none. */
+    while(1)
+    {
+        struct notify_pipe_stream* first_stream;
+        struct notify_pipe_stream* stream;
+        unsigned int               stream_requests;
+
+        stream_requests = pipe_data->stream_requests;
+
+        first_stream = pipe_data->read_stream;
+        if(first_stream == NULL)
+            first_stream = pipe_data->streams;
+
+        stream = first_stream;
+
+        while(stream != NULL)
+        {
+            int error;
+
+            error = ReadStreamLine(pipe_data, stream, line, line_read);
+            if(error != NOTIFY_ERROR_NONE)
+                return error;
+
+            stream = stream->next_stream;
+            if(stream == NULL)
+                stream = pipe_data->streams;
+
+            if(*line_read)
+            {
+                pipe_data->read_stream = stream;
+
+                return NOTIFY_ERROR_NONE;
+            }
+
+            if(stream == first_stream)
+                break;
+        }
+
+        if(pipe_data->stream_requests == stream_requests)
+            break;
+    }
+
+    *line_read = 0;
+
+    return NOTIFY_ERROR_NONE;
+}
+
+static int AllocLines (struct notify_pipe_data* pipe_data)
+{
+    struct notify_pipe_line_block* block;
+    unsigned int                   index;
+
+    /* Line slots are allocated a block at a time and only freed with the
+       pipe, so reading allocates nothing once the queue is deep enough */
+    block = calloc(1, sizeof(struct notify_pipe_line_block));
+    if(block == NULL)
+        return NOTIFY_ERROR_MEMORY;
+
+    for(index = 0; index < NOTIFY_PIPE_LINE_BLOCK_SIZE; index++)
+    {
+        block->lines[index].next_line = pipe_data->free_lines;
+        pipe_data->free_lines         = &block->lines[index];
+    }
+
+    block->next_block      = pipe_data->line_blocks;
+    pipe_data->line_blocks = block;
+
+    return NOTIFY_ERROR_NONE;
+}
+
+static void ReleaseLine (struct notify_pipe_data* pipe_data, struct notify_pipe_line* line)
+{
+    line->references--;
+    if(line->references != 0)
+        return;
+
+    if(line == pipe_data->last_line)
+        pipe_data->last_line = NULL;
+
+    /* Released lines keep their storage for the next line read */
+    line->next_line       = pipe_data->free_lines;
+    pipe_data->free_lines = line;
+
+    pipe_data->queued_lines--;
+}
+
+static void PublishLine (struct notify_pipe_data* pipe_data, struct notify_pipe_line* line)
+{
+    struct notify_pipe_listener* listener;
+
+    line->references = 0;
+    line->next_line  = NULL;
+
+    /* Listeners still working through older lines reach this one through
+       the newest line, which they hold */
+    for(
+        listener = pipe_data->listeners;
+        listener != NULL;
+        listener = listener->next_listener
+       )
+    {
+        line->references++;
+
+        if(listener->next_line == NULL)
+            listener->next_line = line;
+    }
+
+    if(pipe_data->last_line != NULL)
+        pipe_data->last_line->next_line = line;
+
+    pipe_data->last_line = line;
+
+    pipe_data->queued_lines++;
+}
+
+static int TakeLines (struct notify_pipe_listener* listener)
+{
+    unsigned int line_count;
+    DWORD        elapsed_time;
+
+    if(listener->flags&NOTIFY_PIPE_LISTENER_FLAG_TRIGGERED)
+        return NOTIFY_ERROR_NONE;
+
+    line_count = listener->line_count;
+
+    while(listener->next_line != NULL && line_count < listener->batch_size)
+    {
+        struct notify_pipe_line* line;
+
+        if(line_count == listener->line_capacity)
+        {
+            struct notify_pipe_line** lines;
+            unsigned int              line_capacity;
+
+            line_capacity = listener->line_capacity*2;
+            if(line_capacity == 0)
+                line_capacity = 1;
+
+            if(line_capacity > listener->batch_size)
+                line_capacity = listener->batch_size;
+
+            lines = realloc(listener->lines, line_capacity*sizeof(struct notify_pipe_line*));
+            if(lines == NULL)
+                return NOTIFY_ERROR_MEMORY;
+
+            listener->lines         = lines;
+            listener->line_capacity = line_capacity;
+        }
+
+        /* The reference the listener held on the queued line now keeps
+           it alive in the batch */
+        line                = listener->next_line;
+        listener->next_line = line->next_line;
+
+        listener->lines[line_count] = line;
+
+        if(line_count == 0)
+            listener->batch_start = GetTickCount();
+
+        line_count++;
+
+        listener->line_count = line_count;
+    }
+
+    if(line_count == 0)
+        return NOTIFY_ERROR_NONE;
+
+    /* A partial batch waits for more lines until its latency runs out.
+       The clock is read once so the timer gets exactly the time the
+       deadline check left over. */
+    if(line_count < listener->batch_size)
+    {
+        elapsed_time = GetTickCount()-listener->batch_start;
+
+        if(elapsed_time < listener->batch_latency)
+            return ArmBatchTimer(listener, listener->batch_latency-elapsed_time);
+    }
+
+    DisarmBatchTimer(listener);
+
+    listener->flags |= NOTIFY_PIPE_LISTENER_FLAG_TRIGGERED;
+
+    /* A listener that is still starting is signaled once its first pump
+       has succeeded */
+    if(!(listener->flags&NOTIFY_PIPE_LISTENER_FLAG_STARTING))
+        FFILib_SignalAction(listener->action_data);
+
+    return NOTIFY_ERROR_NONE;
+}
+
+static int PumpPipe (struct notify_pipe_data* pipe_data)
+{
+    struct notify_pipe_listener* listener;
+    unsigned int                 line_limit;
+    int                          error;
+
+    /* Every listener can hold a full batch on top of the lines queued
+       for listeners that fell behind */
+    line_limit = PIPE_QUEUED_LINE_LIMIT;
+
+    for(
+        listener = pipe_data->listeners;
+        listener != NULL;
+        listener = listener->next_listener
+       )
+    {
+        line_limit += listener->batch_size;
+    }
+
+    FFILib_BeginSignalBatch();
+
+    while(1)
+    {
+        struct notify_pipe_line* line;
+        int                      waiting;
+        int                      line_read;
+
+        waiting = 0;
+
+        for(
+            listener = pipe_data->listeners;
+            listener != NULL;
+            listener = listener->next_listener
+           )
+        {
+            error = TakeLines(listener);
+            if(error != NOTIFY_ERROR_NONE)
+                goto take_lines_failed;
+
+            if(
+               !(listener->flags&NOTIFY_PIPE_LISTENER_FLAG_TRIGGERED) &&
+               listener->next_line == NULL
+              )
+            {
+                waiting = 1;
+            }
+        }
+
+        /* Nothing more is read than the slowest listener allows, so a
+           writer that outpaces the script is held back by the source */
+        if(!waiting || pipe_data->queued_lines >= line_limit)
+            break;
+
+        if(pipe_data->free_lines == NULL)
+        {
+            error = AllocLines(pipe_data);
+            if(error != NOTIFY_ERROR_NONE)
+                goto allocate_line_failed;
+        }
+
+        line                  = pipe_data->free_lines;
+        pipe_data->free_lines = line->next_line;
+
+        error = ReadLine(pipe_data, line, &line_read);
+        if(error != NOTIFY_ERROR_NONE || line_read == 0)
+        {
+            line->next_line       = pipe_data->free_lines;
+            pipe_data->free_lines = line;
+
+            if(error != NOTIFY_ERROR_NONE)
+                goto read_line_failed;
+
+            break;
+        }
+
+        PublishLine(pipe_data, line);
+    }
+
+    FFILib_EndSignalBatch();
+
+    return NOTIFY_ERROR_NONE;
+
+read_line_failed:
+allocate_line_failed:
+take_lines_failed:
+    FFILib_EndSignalBatch();
+
+    return error;
+}
+
+static char* ExtractArgument (
+                              struct notify_pipe_line*      line,
+                              int                           argument,
+                              struct tsffi_invocation_data* invocation_data
+                             )
+{
+    char         field_scratch[PIPE_FIELD_TEXT_SIZE];
+    char*        duplicated_argument;
+    char*        field_text;
+    unsigned int field_length;
+
+    if(line == NULL || argument < 0 || (unsigned int)argument >= line->field_count)
+    {
+        field_text   = "";
+        field_length = 0;
+    }
+    else
+        field_text = FieldText(line, &line->fields[argument], field_scratch, &field_length);
+
+    duplicated_argument = invocation_data->execif->allocate_memory(
+                                                                   invocation_data->execif_data,
+                                                                   field_length+1
+                                                                  );
+    if(duplicated_argument == NULL)
+        return NULL;
+
+    memcpy(duplicated_argument, field_text, field_length);
+
+    duplicated_argument[field_length] = 0;
+
+    return duplicated_argument;
+}
+
+static struct notify_pipe_field* AddField (struct notify_pipe_line* line, unsigned int field_count)
+{
+    if(field_count == line->field_capacity)
+    {
+        struct notify_pipe_field* fields;
+        unsigned int              field_capacity;
+
+        field_capacity = line->field_capacity*2;
+        if(field_capacity == 0)
+            field_capacity = PIPE_INITIAL_FIELD_CAPACITY;
+
+        fields = realloc(line->fields, field_capacity*sizeof(struct notify_pipe_field));
+        if(fields == NULL)
+            return NULL;
+
+        line->fields         = fields;
+        line->field_capacity = field_capacity;
+    }
+
+    return &line->fields[field_count];
+}
+
+static char* FieldText (
+                        struct notify_pipe_line*  line,
+                        struct notify_pipe_field* field,
+                        char*                     scratch,
+                        unsigned int*             text_length
+                       )
+{
+    long long int_value;
+    double    real_value;
+
+    /* Framed numbers are only turned into text when a script asks for
+       them as text */
+    switch(field->type)
+    {
+    case NOTIFY_PIPE_FIELD_INT:
+        memcpy(&int_value, &line->text[field->offset], sizeof(int_value));
+
+        _snprintf(scratch, PIPE_FIELD_TEXT_SIZE, "%I64d", int_value);
+
+        break;
+
+    case NOTIFY_PIPE_FIELD_REAL:
+        memcpy(&real_value, &line->text[field->offset], sizeof(real_value));
+
+        _snprintf(scratch, PIPE_FIELD_TEXT_SIZE, "%.17g", real_value);
+
+        break;
+
+    default:
+        *text_length = field->length;
+
+        return &line->text[field->offset];
+    }
+
+    scratch[PIPE_FIELD_TEXT_SIZE-1] = 0;
+
+    *text_length = (unsigned int)strlen(scratch);
+
+    return scratch;
+}
+
+static tsffi_int FieldInt (struct notify_pipe_line* line, int argument)
+{
+    struct notify_pipe_field* field;
+    char                      field_scratch[PIPE_FIELD_TEXT_SIZE];
+    unsigned int              field_length;
+    long long                 int_value;
+    double                    real_value;
+
+    if(line == NULL || argument < 0 || (unsigned int)argument >= line->field_count)
+        return 0;
+
+    field = &line->fields[argument];
+
+    switch(field->type)
+    {
+    case NOTIFY_PIPE_FIELD_INT:
+        memcpy(&int_value, &line->text[field->offset], sizeof(int_value));
+
+        return (tsffi_int)int_value;
+
+    case NOTIFY_PIPE_FIELD_REAL:
+        memcpy(&real_value, &line->text[field->offset], sizeof(real_value));
+
+        return (tsffi_int)real_value;
+    }
+
+    field_length = field->length;
+    if(field_length >= PIPE_FIELD_TEXT_SIZE)
+        field_length = PIPE_FIELD_TEXT_SIZE-1;
+
+    memcpy(field_scratch, &line->text[field->offset], field_length);
+
+    field_scratch[field_length] = 0;
+
+    return (tsffi_int)strtol(field_scratch, NULL, 10);
+}
+
+static tsffi_real FieldReal (struct notify_pipe_line* line, int argument)
+{
+    struct notify_pipe_field* field;
+    char                      field_scratch[PIPE_FIELD_TEXT_SIZE];
+    unsigned int              field_length;
+    long long                 int_value;
+    double                    real_value;
+
+    if(line == NULL || argument < 0 || (unsigned int)argument >= line->field_count)
+        return 0.0;
+
+    field = &line->fields[argument];
+
+    switch(field->type)
+    {
+    case NOTIFY_PIPE_FIELD_INT:
+        memcpy(&int_value, &line->text[field->offset], sizeof(int_value));
+
+        return (tsffi_real)int_value;
+
+    case NOTIFY_PIPE_FIELD_REAL:
+        memcpy(&real_value, &line->text[field->offset], sizeof(real_value));
+
+        return (tsffi_real)real_value;
+    }
+
+    field_length = field->length;
+    if(field_length >= PIPE_FIELD_TEXT_SIZE)
+        field_length = PIPE_FIELD_TEXT_SIZE-1;
+
+    memcpy(field_scratch, &line->text[field->offset], field_length);
+
+    field_scratch[field_length] = 0;
+
+    return (tsffi_real)strtod(field_scratch, NULL);
+}
+
+static struct notify_pipe_listener* AddListener (
+                                                 struct notify_pipe_data*      pipe_data,
+                                                 struct tsffi_invocation_data* action_data,
+                                                 unsigned int                  batch_size,
+                                                 unsigned int                  batch_latency
+                                                )
+{
+    struct notify_pipe_listener* listener;
+
+    listener = malloc(sizeof(struct notify_pipe_listener));
+    if(listener == NULL)
+        return NULL;
+
+    /* A new listener only sees lines read after it started listening */
+    listener->flags          = NOTIFY_PIPE_LISTENER_FLAG_STARTING;
+    listener->lines          = NULL;
+    listener->line_count     = 0;
+    listener->line_capacity  = 0;
+    listener->batch_size     = batch_size;
+    listener->batch_latency  = batch_latency;
+    listener->batch_start    = 0;
+    listener->batch_timer_id = 0;
+    listener->next_line      = NULL;
+    listener->pipe_data      = pipe_data;
+    listener->action_data    = action_data;
+    listener->next_listener  = pipe_data->listeners;
+
+    pipe_data->listeners = listener;
+
+    return listener;
+}
+
+static void ReleaseBatch (struct notify_pipe_listener* listener)
+{
+    struct notify_pipe_data* pipe_data;
+    unsigned int             index;
+
+    pipe_data = listener->pipe_data;
+
+    for(index = 0; index < listener->line_count; index++)
+        ReleaseLine(pipe_data, listener->lines[index]);
+
+    listener->line_count  = 0;
+    listener->flags      &= ~(NOTIFY_PIPE_LISTENER_FLAG_TRIGGERED|NOTIFY_PIPE_LISTENER_FLAG_SELECTED);
+
+    if(pipe_data->selected_listener == listener)
+        pipe_data->selected_listener = NULL;
+}
+
+static void RemoveListener (struct notify_pipe_listener* listener)
+{
+    struct notify_pipe_data*      pipe_data;
+    struct notify_pipe_listener** link;
+    struct notify_pipe_line*      line;
+
+    pipe_data = listener->pipe_data;
+
+    DisarmBatchTimer(listener);
+    ReleaseBatch(listener);
+
+    line = listener->next_line;
+
+    while(line != NULL)
+    {
+        struct notify_pipe_line* next_line;
+
+        next_line = line->next_line;
+
+        ReleaseLine(pipe_data, line);
+
+        line = next_line;
+    }
+
+    for(link = &pipe_data->listeners; *link != listener; link = &(*link)->next_listener);
+
+    *link = listener->next_listener;
+
+    free(listener->lines);
+    free(listener);
+}
+
+static struct notify_pipe_listener* TriggeredListener (
+                                                       struct notify_pipe_data*      pipe_data,
+                                                       struct tsffi_invocation_data* invocation_data
+                                                      )
+{
+    struct notify_pipe_listener* listener;
+
+    /* A unit reading its own pipe prefers the listener of its running
+       action.  Reads through a handle, which may come from any unit,
+       see the batch of the pipe's running action. */
+    if(invocation_data != NULL)
+    {
+        for(
+            listener = pipe_data->listeners;
+            listener != NULL;
+            listener = listener->next_listener
+           )
+        {
+            if(
+               listener->flags&NOTIFY_PIPE_LISTENER_FLAG_SELECTED &&
+               listener->action_data->unit_invocation_id == invocation_data->unit_invocation_id
+              )
+            {
+                return listener;
+            }
+        }
+    }
+
+    return pipe_data->selected_listener;
+}
+
+static struct notify_pipe_line* TriggeredLine (
+                                               struct notify_pipe_data*      pipe_data,
+                                               struct tsffi_invocation_data* invocation_data,
+                                               int                           line_index
+                                              )
+{
+    struct notify_pipe_listener* listener;
+
+    listener = TriggeredListener(pipe_data, invocation_data);
+    if(listener == NULL)
+        return NULL;
+
+    if(line_index < 0 || (unsigned int)line_index >= listener->line_count)
+        return NULL;
+
+    return listener->lines[line_index];
+}
+
+static struct notify_pipe_data* UnitPipe (
+                                          struct tsffi_invocation_data* invocation_data,
+                                          void*                         group_data
+                                         )
+{
+    struct notify_module_data* module_data;
+    struct notify_pipe_data*   pipe_data;
+
+    module_data = group_data;
+    pipe_data   = FFILib_GetIDData(
+                                   invocation_data->unit_invocation_id,
+                                   &module_data->unit_hash
+                                  );
+    if(pipe_data == NULL)
+    {
+        char text[MAX_EXCEPTION_TEXT_LENGTH];
+
+        _snprintf(
+                  text,
+                  MAX_EXCEPTION_TEXT_LENGTH,
+                  "function=%s line=%d: Attempting to read from pipe which hasn't been created using 'pipe()'",
+                  invocation_data->unit_name,
+                  invocation_data->unit_location
+                 );
+
+        text[MAX_EXCEPTION_TEXT_LENGTH-1] = 0;
+
+        invocation_data->execif->set_exception_text(invocation_data->execif_data, text);
+    }
+
+    return pipe_data;
+}
+
+static struct notify_pipe_data* HandlePipe (
+                                            struct tsffi_invocation_data* invocation_data,
+                                            void*                         group_data,
+                                            int                           handle
+                                           )
+{
+    struct notify_module_data* module_data;
+    struct notify_pipe_data*   pipe_data;
+
+    module_data = group_data;
+    pipe_data   = FFILib_GetIDData(handle, &module_data->pipe_hash);
+    if(pipe_data == NULL)
+    {
+        char text[MAX_EXCEPTION_TEXT_LENGTH];
+
+        _snprintf(
+                  text,
+                  MAX_EXCEPTION_TEXT_LENGTH,
+                  "function=%s line=%d: Attempting to read from pipe using an invalid handle, retrieve a handle by calling 'pipe()'",
+                  invocation_data->unit_name,
+                  invocation_data->unit_location
+                 );
+
+        text[MAX_EXCEPTION_TEXT_LENGTH-1] = 0;
+
+        invocation_data->execif->set_exception_text(invocation_data->execif_data, text);
+    }
+
+    return pipe_data;
+}
+
+static struct notify_pipe_data* AllocPipe (unsigned int source)
+{
+    struct notify_pipe_data* pipe_data;
+
+    pipe_data = malloc(sizeof(struct notify_pipe_data));
+    if(pipe_data == NULL)
+        return NULL;
+
+    pipe_data->pipe_id           = 0;
+    pipe_data->source            = source;
+    pipe_data->schema            = NULL;
+    pipe_data->schema_length     = 0;
+    pipe_data->last_line         = NULL;
+    pipe_data->free_lines        = NULL;
+    pipe_data->line_blocks       = NULL;
+    pipe_data->queued_lines      = 0;
+    pipe_data->listeners         = NULL;
+    pipe_data->selected_listener = NULL;
+    pipe_data->streams           = NULL;
+    pipe_data->read_stream       = NULL;
+    pipe_data->listen_stream     = NULL;
+    pipe_data->stream_requests   = 0;
+    pipe_data->change_handle     = NULL;
+    pipe_data->change_watch      = NULL;
+    pipe_data->change_id         = 0;
+    pipe_data->change_posted     = 0;
+    pipe_data->directory_handle  = INVALID_HANDLE_VALUE;
+    pipe_data->directory_buffer  = NULL;
+    pipe_data->file_name         = NULL;
+    pipe_data->file_name_size    = 0;
+    pipe_data->directory_armed   = 0;
+    pipe_data->watch_execif      = NULL;
+    pipe_data->watch_execif_data = NULL;
+    pipe_data->watch_retry_time  = 0;
+    pipe_data->watch_backoff     = 0;
+    pipe_data->channel_name      = NULL;
+    pipe_data->module_data       = NULL;
+    pipe_data->next_pipe         = NULL;
+
+    memset(&pipe_data->directory_overlapped, 0, sizeof(OVERLAPPED));
+
+    return pipe_data;
+}
+
+static void FreePipe (
+                      struct notify_pipe_data* pipe_data,
+                      struct tsffi_execif*     execif,
+                      void*                    execif_data
+                     )
+{
+    while(pipe_data->listeners != NULL)
+        RemoveListener(pipe_data->listeners);
+
+    while(pipe_data->line_blocks != NULL)
+    {
+        struct notify_pipe_line_block* block;
+        unsigned int                   index;
+
+        block                  = pipe_data->line_blocks;
+        pipe_data->line_blocks = block->next_block;
+
+        for(index = 0; index < NOTIFY_PIPE_LINE_BLOCK_SIZE; index++)
+        {
+            free(block->lines[index].text);
+            free(block->lines[index].fields);
+        }
+
+        free(block);
+    }
+
+    if(pipe_data->change_watch != NULL)
+        execif->cancel_registration(execif_data, pipe_data->change_watch);
+
+    if(pipe_data->source == NOTIFY_PIPE_SOURCE_FILE)
+    {
+        /* The directory request was issued from the module thread, which
+           is the only thread that can cancel it */
+        if(pipe_data->directory_armed)
+        {
+            DWORD transferred;
+
+            CancelIo(pipe_data->directory_handle);
+            GetOverlappedResult(
+                                pipe_data->directory_handle,
+                                &pipe_data->directory_overlapped,
+                                &transferred,
+                                TRUE
+                               );
+        }
+
+        if(pipe_data->directory_handle != INVALID_HANDLE_VALUE)
+            CloseHandle(pipe_data->directory_handle);
+
+        free(pipe_data->directory_buffer);
+        free(pipe_data->file_name);
+    }
+
+    /* Channel reads were cancelled by the control thread that issued
+       them, see CancelStreams */
+    while(pipe_data->streams != NULL)
+    {
+        struct notify_pipe_stream* stream;
+
+        stream             = pipe_data->streams;
+        pipe_data->streams = stream->next_stream;
+
+        FreeStream(stream);
+    }
+
+    if(pipe_data->change_handle != NULL)
+        CloseHandle(pipe_data->change_handle);
+
+    free(pipe_data->channel_name);
+    free(pipe_data->schema);
+    free(pipe_data);
+}
+
+static struct notify_pipe_stream* AllocStream (struct notify_pipe_data* pipe_data, HANDLE handle)
+{
+    struct notify_pipe_stream* stream;
+
+    stream = malloc(sizeof(struct notify_pipe_stream));
+    if(stream == NULL)
+        goto allocate_stream_failed;
+
+    stream->read_buffer = malloc(PIPE_READ_BUFFER_SIZE);
+    if(stream->read_buffer == NULL)
+        goto allocate_buffer_failed;
+
+    stream->channel_buffer = NULL;
+    if(pipe_data->source != NOTIFY_PIPE_SOURCE_FILE)
+    {
+        stream->channel_buffer = malloc(PIPE_CHANNEL_BUFFER_SIZE);
+        if(stream->channel_buffer == NULL)
+            goto allocate_channel_buffer_failed;
+    }
+
+    memset(&stream->overlapped, 0, sizeof(OVERLAPPED));
+
+    /* Every instance of a channel signals the one event the module
+       waits on */
+    stream->flags             = 0;
+    stream->handle            = handle;
+    stream->overlapped.hEvent = pipe_data->change_handle;
+    stream->read_buffer_size  = PIPE_READ_BUFFER_SIZE;
+    stream->read_start        = 0;
+    stream->read_end          = 0;
+    stream->next_stream       = pipe_data->streams;
+
+    pipe_data->streams = stream;
+
+    return stream;
+
+allocate_channel_buffer_failed:
+    free(stream->read_buffer);
+
+allocate_buffer_failed:
+    free(stream);
+
+allocate_stream_failed:
+    return NULL;
+}
+
+static void FreeStream (struct notify_pipe_stream* stream)
+{
+    if(stream->handle != INVALID_HANDLE_VALUE)
+        CloseHandle(stream->handle);
+
+    free(stream->channel_buffer);
+    free(stream->read_buffer);
+    free(stream);
+}
+
+static void ReapStreams (struct notify_pipe_data* pipe_data)
+{
+    struct notify_pipe_stream** link;
+
+    link = &pipe_data->streams;
+
+    while(*link != NULL)
+    {
+        struct notify_pipe_stream* stream;
+
+        stream = *link;
+        if(!(stream->flags&NOTIFY_PIPE_STREAM_FLAG_CLOSED))
+        {
+            link = &stream->next_stream;
+
+            continue;
+        }
+
+        *link = stream->next_stream;
+
+        if(pipe_data->read_stream == stream)
+            pipe_data->read_stream = NULL;
+
+        FreeStream(stream);
+    }
+}
+
+static void CancelStreams (struct notify_pipe_data* pipe_data)
+{
+    struct notify_pipe_stream* stream;
+
+    /* The kernel owns a channel buffer until its pending request has been
+       cancelled, and only the thread that issued a request can cancel it */
+    for(
+        stream = pipe_data->streams;
+        stream != NULL;
+        stream = stream->next_stream
+       )
+    {
+        DWORD transferred;
+
+        if(!(stream->flags&NOTIFY_PIPE_STREAM_FLAG_PENDING))
+            continue;
+
+        CancelIo(stream->handle);
+        GetOverlappedResult(stream->handle, &stream->overlapped, &transferred, TRUE);
+
+        stream->flags &= ~NOTIFY_PIPE_STREAM_FLAG_PENDING;
+    }
+}
+
+static int RegisterPipe (
+                         struct tsffi_invocation_data* invocation_data,
+                         struct notify_module_data*    module_data,
+                         struct notify_pipe_data*      pipe_data,
+                         union tsffi_value*            output
+                        )
+{
+    unsigned int pipe_id;
+    unsigned int unit_invocation_id;
+    int          error;
+
+    pipe_id            = module_data->next_pipe_id;
+    unit_invocation_id = invocation_data->unit_invocation_id;
+
+    pipe_data->pipe_id     = pipe_id;
+    pipe_data->change_id   = next_change_id;
+    pipe_data->module_data = module_data;
+
+    error = FFILib_AddID(unit_invocation_id, pipe_data, &module_data->unit_hash);
+    if(error != FFILIB_ERROR_NONE)
+        goto add_unit_invocation_id_failed;
+
+    error = FFILib_AddID(pipe_id, pipe_data, &module_data->pipe_hash);
+    if(error != FFILIB_ERROR_NONE)
+        goto add_pipe_id_failed;
+
+    error = FFILib_AddID(pipe_data->change_id, pipe_data, &change_id_hash);
+    if(error != FFILIB_ERROR_NONE)
+        goto add_change_id_failed;
+
+    module_data->next_pipe_id++;
+    next_change_id++;
+
+    pipe_data->next_pipe    = module_data->open_pipes;
+    module_data->open_pipes = pipe_data;
+
+    output->int_data = pipe_id;
+
+    return NOTIFY_ERROR_NONE;
+
+add_change_id_failed:
+    FFILib_RemoveID(pipe_id, &module_data->pipe_hash);
+
+add_pipe_id_failed:
+    FFILib_RemoveID(unit_invocation_id, &module_data->unit_hash);
+
+add_unit_invocation_id_failed:
+    return NOTIFY_ERROR_MEMORY;
+}
+
+static int WatchPipeDirectory (struct notify_pipe_data* pipe_data, char* file_name)
+{
+    char   directory[MAX_PATH];
+    char*  file_part;
+    DWORD  length;
+    HANDLE event;
+    int    name_length;
+
+    length = GetFullPathName(file_name, MAX_PATH, directory, &file_part);
+    if(length == 0 || length >= MAX_PATH || file_part == NULL)
+        return NOTIFY_ERROR_SYSTEM_CALL;
+
+    /* Change records name files relative to the watched directory */
+    name_length = MultiByteToWideChar(CP_ACP, 0, file_part, -1, NULL, 0);
+    if(name_length <= 1)
+        return NOTIFY_ERROR_SYSTEM_CALL;
+
+    pipe_data->file_name = malloc(sizeof(WCHAR)*name_length);
+    if(pipe_data->file_name == NULL)
+        return NOTIFY_ERROR_MEMORY;
+
+    MultiByteToWideChar(CP_ACP, 0, file_part, -1, pipe_data->file_name, name_length);
+
+    pipe_data->file_name_size = sizeof(WCHAR)*(name_length-1);
+
+    *file_part = 0;
+
+    pipe_data->directory_buffer = malloc(PIPE_CHANGE_BUFFER_SIZE);
+    if(pipe_data->directory_buffer == NULL)
+        return NOTIFY_ERROR_MEMORY;
+
+    pipe_data->directory_handle = CreateFile(
+                                             directory,
+                                             FILE_LIST_DIRECTORY,
+                                             FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE,
+                                             NULL,
+                                             OPEN_EXISTING,
+                                             FILE_FLAG_BACKUP_SEMANTICS|FILE_FLAG_OVERLAPPED,
+                                             NULL
+                                            );
+    if(pipe_data->directory_handle == INVALID_HANDLE_VALUE)
+        return NOTIFY_ERROR_SYSTEM_CALL;
+
+    event = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if(event == NULL)
+        return NOTIFY_ERROR_SYSTEM_CALL;
+
+    pipe_data->change_handle               = event;
+    pipe_data->directory_overlapped.hEvent = event;
+
+    return NOTIFY_ERROR_NONE;
+}
+
+static int ArmDirectoryWatch (struct notify_pipe_data* pipe_data)
+{
+    BOOL result;
+
+    result = ReadDirectoryChangesW(
+                                   pipe_data->directory_handle,
+                                   pipe_data->directory_buffer,
+                                   PIPE_CHANGE_BUFFER_SIZE,
+                                   FALSE,
+                                   PIPE_CHANGE_FILTER,
+                                   NULL,
+                                   &pipe_data->directory_overlapped,
+                                   NULL
+                                  );
+    if(result == 0)
+        return NOTIFY_ERROR_SYSTEM_CALL;
+
+    pipe_data->directory_armed = 1;
+
+    return NOTIFY_ERROR_NONE;
+}
+
+static int FileChanged (struct notify_pipe_data* pipe_data, DWORD transferred)
+{
+    char* record;
+
+    /* The records didn't fit and were dropped, any file may have changed */
+    if(transferred == 0)
+        return 1;
+
+    record = pipe_data->directory_buffer;
+
+    while(1)
+    {
+        FILE_NOTIFY_INFORMATION* change;
+
+        change = (FILE_NOTIFY_INFORMATION*)record;
+
+        if(
+           change->FileNameLength == pipe_data->file_name_size &&
+           _wcsnicmp(change->FileName, pipe_data->file_name, change->FileNameLength/sizeof(WCHAR)) == 0
+          )
+        {
+            return 1;
+        }
+
+        if(change->NextEntryOffset == 0)
+            break;
+
+        record += change->NextEntryOffset;
+    }
+
+    return 0;
+}
+
+static HANDLE CreateChannel (struct notify_pipe_data* pipe_data)
+{
+    DWORD pipe_mode;
+
+    if(pipe_data->source == NOTIFY_PIPE_SOURCE_MESSAGE)
+        pipe_mode = PIPE_TYPE_MESSAGE|PIPE_READMODE_MESSAGE|PIPE_WAIT;
+    else
+        pipe_mode = PIPE_TYPE_BYTE|PIPE_READMODE_BYTE|PIPE_WAIT;
+
+    return CreateNamedPipe(
+                           pipe_data->channel_name,
+                           PIPE_ACCESS_INBOUND|FILE_FLAG_OVERLAPPED,
+                           pipe_mode,
+                           PIPE_UNLIMITED_INSTANCES,
+                           0,
+                           PIPE_CHANNEL_BUFFER_SIZE,
+                           0,
+                           NULL
+                          );
+}
+
+static struct notify_pipe_stream* AddChannelInstance (struct notify_pipe_data* pipe_data)
+{
+    struct notify_pipe_stream* stream;
+    HANDLE                     handle;
+
+    handle = CreateChannel(pipe_data);
+    if(handle == INVALID_HANDLE_VALUE)
+        goto create_channel_failed;
+
+    stream = AllocStream(pipe_data, handle);
+    if(stream == NULL)
+        goto allocate_stream_failed;
+
+    pipe_data->listen_stream = stream;
+
+    return stream;
+
+allocate_stream_failed:
+    CloseHandle(handle);
+
+create_channel_failed:
+    return NULL;
+}
+
+static int ListenChannel (struct notify_pipe_data* pipe_data, struct notify_pipe_stream* stream)
+{
+    BOOL result;
+
+    result = ConnectNamedPipe(stream->handle, &stream->overlapped);
+
+    pipe_data->stream_requests++;
+
+    if(result == 0)
+    {
+        switch(GetLastError())
+        {
+        case ERROR_IO_PENDING:
+            stream->flags |= NOTIFY_PIPE_STREAM_FLAG_PENDING;
+
+            return NOTIFY_ERROR_NONE;
+
+        case ERROR_PIPE_CONNECTED:
+            break;
+
+        case ERROR_NO_DATA:
+            /* The writer came and went before it was accepted */
+            DisconnectNamedPipe(stream->handle);
+
+            return NOTIFY_ERROR_NONE;
+
+        default:
+            return NOTIFY_ERROR_SYSTEM_CALL;
+        }
+    }
+
+    ChannelConnected(pipe_data, stream);
+
+    return NOTIFY_ERROR_NONE;
+}
+
+static void ChannelConnected (struct notify_pipe_data* pipe_data, struct notify_pipe_stream* stream)
+{
+    stream->flags |= NOTIFY_PIPE_STREAM_FLAG_CONNECTED;
+
+    if(pipe_data->listen_stream != stream)
+        return;
+
+    pipe_data->listen_stream = NULL;
+
+    /* The next writer needs an instance of its own to connect to.  If
+       none can be made, the first writer to leave hands its instance
+       back. */
+    stream = AddChannelInstance(pipe_data);
+    if(stream != NULL)
+        ListenChannel(pipe_data, stream);
+}
+
+static void ResetChannel (struct notify_pipe_data* pipe_data, struct notify_pipe_stream* stream)
+{
+    /* Whatever is left of an unfinished line belonged to the writer that
+       went away */
+    stream->read_end  = stream->read_start;
+    stream->flags    &= ~(NOTIFY_PIPE_STREAM_FLAG_CONNECTED|NOTIFY_PIPE_STREAM_FLAG_PENDING);
+
+    /* Another instance already waits for writers, so this one is freed
+       once the read that found it closed is done with the list */
+    if(pipe_data->listen_stream != NULL && pipe_data->listen_stream != stream)
+    {
+        stream->flags |= NOTIFY_PIPE_STREAM_FLAG_CLOSED;
+
+        return;
+    }
+
+    DisconnectNamedPipe(stream->handle);
+
+    pipe_data->listen_stream = stream;
+}
+
+static int OpenChannel (
+                        struct tsffi_invocation_data* invocation_data,
+                        void*                         group_data,
+                        union tsffi_value*            output,
+                        union tsffi_value*            input,
+                        unsigned int                  source
+                       )
+{
+    struct notify_pipe_data* pipe_data;
+    char                     path[MAX_PATH];
+    char*                    name;
+    HANDLE                   event;
+    int                      error;
+
+    pipe_data = AllocPipe(source);
+    if(pipe_data == NULL)
+        goto allocate_pipe_failed;
+
+    event = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if(event == NULL)
+        goto create_event_failed;
+
+    pipe_data->change_handle = event;
+
+    /* Bare names are placed in the local pipe namespace */
+    name = input->string_data;
+    if(strncmp(name, "\\\\", 2) != 0)
+    {
+        _snprintf(path, MAX_PATH, "%s%s", PIPE_CHANNEL_PREFIX, name);
+
+        path[MAX_PATH-1] = 0;
+        name             = path;
+    }
+
+    pipe_data->channel_name = _strdup(name);
+    if(pipe_data->channel_name == NULL)
+        goto copy_name_failed;
+
+    if(AddChannelInstance(pipe_data) == NULL)
+    {
+        char text[MAX_EXCEPTION_TEXT_LENGTH];
+
+        _snprintf(
+                  text,
+                  MAX_EXCEPTION_TEXT_LENGTH,
+                  "function=%s line=%d: The specified pipe could not be created",
+                  invocation_data->unit_name,
+                  invocation_data->unit_location
+                 );
+
+        text[MAX_EXCEPTION_TEXT_LENGTH-1] = 0;
+
+        invocation_data->execif->set_exception_text(invocation_data->execif_data, text);
+
+        goto create_channel_failed;
+    }
+
+    error = RegisterPipe(invocation_data, group_data, pipe_data, output);
+    if(error != NOTIFY_ERROR_NONE)
+        goto register_pipe_failed;
+
+    /* Writers may connect before anything listens, a failure here is
+       retried on the next read */
+    ListenChannel(pipe_data, pipe_data->listen_stream);
+
+    return TSFFI_ERROR_NONE;
+
+register_pipe_failed:
+create_channel_failed:
+copy_name_failed:
+create_event_failed:
+    FreePipe(pipe_data, invocation_data->execif, invocation_data->execif_data);
+
+allocate_pipe_failed:
+    return TSFFI_ERROR_EXCEPTION;
+}
+
+static void DeferWatch (struct notify_pipe_data* pipe_data, DWORD now)
+{
+    unsigned int backoff;
+
+    /* Running out of wait slots doesn't fix itself, so every failure
+       doubles the wait before the next attempt */
+    backoff = pipe_data->watch_backoff*2;
+    if(backoff == 0)
+        backoff = PIPE_WATCH_INITIAL_BACKOFF;
+    else if(backoff > PIPE_WATCH_MAX_BACKOFF)
+        backoff = PIPE_WATCH_MAX_BACKOFF;
+
+    pipe_data->watch_backoff    = backoff;
+    pipe_data->watch_retry_time = now+backoff;
+}
+
+static void PipeChanged (void* user_data)
+{
+    struct notify_pipe_data* pipe_data;
+    int                      changed;
+
+    pipe_data = user_data;
+    changed   = 1;
+
+    if(pipe_data->source == NOTIFY_PIPE_SOURCE_FILE)
+    {
+        DWORD transferred;
+        BOOL  result;
+
+        result = GetOverlappedResult(
+                                     pipe_data->directory_handle,
+                                     &pipe_data->directory_overlapped,
+                                     &transferred,
+                                     FALSE
+                                    );
+        if(result == 0 && GetLastError() == ERROR_IO_INCOMPLETE)
+            return;
+
+        pipe_data->directory_armed = 0;
+
+        if(result != 0)
+            changed = FileChanged(pipe_data, transferred);
+
+        /* A directory without a pending request never wakes the module
+           again, so the pipe goes back to the poll timer */
+        if(ArmDirectoryWatch(pipe_data) != NOTIFY_ERROR_NONE)
+        {
+            pipe_data->watch_execif->cancel_registration(
+                                                         pipe_data->watch_execif_data,
+                                                         pipe_data->change_watch
+                                                        );
+
+            pipe_data->change_watch = NULL;
+
+            DeferWatch(pipe_data, GetTickCount());
+
+            FFILib_AsynchronousFunction(&StartPipePolling, pipe_data->module_data, &ffilib_control_thread);
+        }
+    }
+    else
+        ResetEvent(pipe_data->change_handle);
+
+    if(!changed)
+        return;
+
+    /* The pipe is only read on the control thread, the module hands it
+       over without waiting and a change already handed over is enough */
+    if(InterlockedExchange(&pipe_data->change_posted, 1) != 0)
+        return;
+
+    FFILib_AsynchronousFunction(
+                                &PumpChangedPipe,
+                                (void*)(UINT_PTR)pipe_data->change_id,
+                                &ffilib_control_thread
+                               );
+}
+
+static int PumpChangedPipe (void* user_data)
+{
+    struct notify_pipe_data* pipe_data;
+
+    /* The pipe may have been freed while the change was queued */
+    pipe_data = FFILib_GetIDData((unsigned int)(UINT_PTR)user_data, &change_id_hash);
+    if(pipe_data == NULL)
+        return NOTIFY_ERROR_NONE;
+
+    InterlockedExchange(&pipe_data->change_posted, 0);
+
+    if(pipe_data->listeners == NULL)
+        return NOTIFY_ERROR_NONE;
+
+    return PumpPipe(pipe_data);
+}
+
+static int ListenError (struct tsffi_invocation_data* action_data, int error)
+{
+    char  text[MAX_EXCEPTION_TEXT_LENGTH];
+    char* message;
+
+    if(error == NOTIFY_ERROR_FRAME)
+        message = "The pipe sent a record that does not match its framing";
+    else
+        message = "The file could not be read";
+
+    _snprintf(
+              text,
+              MAX_EXCEPTION_TEXT_LENGTH,
+              "function=%s line=%d: %s",
+              action_data->unit_name,
+              action_data->unit_location,
+              message
+             );
+
+    text[MAX_EXCEPTION_TEXT_LENGTH-1] = 0;
+
+    action_data->execif->set_exception_text(action_data->execif_data, text);
+
+    return TSFFI_ERROR_EXCEPTION;
+}
+
+static int StartPipeListen (
+                            struct notify_pipe_data*      pipe_data,
+                            struct tsffi_invocation_data* action_data,
+                            void**                        user_action_data,
+                            unsigned int                  batch_size,
+                            unsigned int                  batch_latency
+                           )
+{
+    struct notify_pipe_listener* listener;
+    int                          error;
+
+    listener = AddListener(pipe_data, action_data, batch_size, batch_latency);
+    if(listener == NULL)
+        return ListenError(action_data, NOTIFY_ERROR_MEMORY);
+
+    error = PumpPipe(pipe_data);
+    if(error != NOTIFY_ERROR_NONE)
+    {
+        RemoveListener(listener);
+
+        return ListenError(action_data, error);
+    }
+
+    listener->flags &= ~NOTIFY_PIPE_LISTENER_FLAG_STARTING;
+
+    if(listener->flags&NOTIFY_PIPE_LISTENER_FLAG_TRIGGERED)
+        FFILib_SignalAction(action_data);
+
+    *user_action_data = listener;
+
+    return TSFFI_ERROR_NONE;
+}
+
+static int PerformPipeListen (
+                              struct tsffi_invocation_data* action_data,
+                              unsigned int                  request,
+                              unsigned int*                 state,
+                              void**                        user_action_data
+                             )
+{
+    struct notify_pipe_listener* listener;
+    int                          error;
+
+    listener = *user_action_data;
+
+    switch(request)
+    {
+    case TSFFI_RUNNING_ACTION:
+        /* The listener whose action is about to run is the one reads
+           of its pipe refer to until its batch is released */
+        if(listener->flags&NOTIFY_PIPE_LISTENER_FLAG_TRIGGERED)
+        {
+            listener->flags                        |= NOTIFY_PIPE_LISTENER_FLAG_SELECTED;
+            listener->pipe_data->selected_listener  = listener;
+        }
+
+        break;
+
+    case TSFFI_UPDATE_ACTION:
+        ReleaseBatch(listener);
+
+        error = PumpPipe(listener->pipe_data);
+        if(error != NOTIFY_ERROR_NONE)
+            return ListenError(action_data, error);
+
+        break;
+
+    case TSFFI_QUERY_ACTION:
+        if(listener->flags&NOTIFY_PIPE_LISTENER_FLAG_TRIGGERED)
+            *state = TSFFI_ACTION_STATE_TRIGGERED;
+        else
+            *state = TSFFI_ACTION_STATE_PENDING;
+
+        break;
+
+    case TSFFI_STOP_ACTION:
+        RemoveListener(listener);
+
+        break;
+    }
+
+    return TSFFI_ERROR_NONE;
+}
+
+static int ListenUnitPipe (
+                           struct tsffi_invocation_data* action_data,
+                           void*                         group_data,
+                           void**                        user_action_data,
+                           unsigned int                  batch_size,
+                           unsigned int                  batch_latency
+                          )
+{
+    struct notify_module_data* module_data;
+    struct notify_pipe_data*   pipe_data;
+    int                        error;
+
+    module_data = group_data;
+    pipe_data   = FFILib_GetIDData(
+                                   action_data->unit_invocation_id,
+                                   &module_data->unit_hash
+                                  );
+    if(pipe_data == NULL)
+    {
+        char text[MAX_EXCEPTION_TEXT_LENGTH];
+
+        _snprintf(
+                  text,
+                  MAX_EXCEPTION_TEXT_LENGTH,
+                  "function=%s line=%d: Attempting to listen on a pipe which hasn't been created using 'pipe()'",
+                  action_data->unit_name,
+                  action_data->unit_location
+                 );
+
+        text[MAX_EXCEPTION_TEXT_LENGTH-1] = 0;
+
+        action_data->execif->set_exception_text(action_data->execif_data, text);
+
+        return TSFFI_ERROR_EXCEPTION;
+    }
+
+    error = StartPipeListen(pipe_data, action_data, user_action_data, batch_size, batch_latency);
+
+    return error;
+}
+
+static int ListenHandlePipe (
+                             struct tsffi_invocation_data* action_data,
+                             void*                         group_data,
+                             int                           handle,
+                             void**                        user_action_data,
+                             unsigned int                  batch_size,
+                             unsigned int                  batch_latency
+                            )
+{
+    struct notify_module_data* module_data;
+    struct notify_pipe_data*   pipe_data;
+    int                        error;
+
+    module_data = group_data;
+    pipe_data   = FFILib_GetIDData(handle, &module_data->pipe_hash);
+    if(pipe_data == NULL)
+    {
+        char text[MAX_EXCEPTION_TEXT_LENGTH];
+
+        _snprintf(
+                  text,
+                  MAX_EXCEPTION_TEXT_LENGTH,
+                  "function=%s line=%d: Invalid handle used, retrieve a handle by calling 'pipe()'",
+                  action_data->unit_name,
+                  action_data->unit_location
+                 );
+
+        text[MAX_EXCEPTION_TEXT_LENGTH-1] = 0;
+
+        action_data->execif->set_exception_text(action_data->execif_data, text);
+
+        return TSFFI_ERROR_EXCEPTION;
+    }
+
+    error = StartPipeListen(pipe_data, action_data, user_action_data, batch_size, batch_latency);
+
+    return error;
+}
+
+static unsigned int BatchLatency (tsffi_real seconds)
+{
+    if(seconds <= 0)
+        return 0;
+
+    return (unsigned int)(seconds*1000);
+}
+
+static void SetBatchLimits (
+                            struct notify_pipe_listener* listener,
+                            int                          batch_size,
+                            tsffi_real                   latency
+                           )
+{
+    unsigned int batch_latency;
+
+    batch_latency = BatchLatency(latency);
+
+    /* A changed latency moves the deadline of the batch being gathered */
+    if(batch_latency != listener->batch_latency)
+        DisarmBatchTimer(listener);
+
+    listener->batch_size    = batch_size < 1 ? 1 : batch_size;
+    listener->batch_latency = batch_latency;
+}
+
+static int ArmBatchTimer (struct notify_pipe_listener* listener, DWORD remaining_time)
+{
+    UINT timer_id;
+    int  error;
+
+    if(listener->batch_timer_id != 0)
+        return NOTIFY_ERROR_NONE;
+
+    /* Reactor timers belong to the module thread, so the batch deadline
+       is a one-shot timer on the control thread where the lines are
+       gathered */
+    timer_id = SetTimer(NULL, 0, remaining_time, &BatchTimerProc);
+    if(timer_id == 0)
+        goto set_timer_failed;
+
+    error = FFILib_AddID(timer_id, listener, &batch_timer_hash);
+    if(error != FFILIB_ERROR_NONE)
+        goto add_id_failed;
+
+    listener->batch_timer_id = timer_id;
+
+    return NOTIFY_ERROR_NONE;
+
+add_id_failed:
+    KillTimer(NULL, timer_id);
+
+    return NOTIFY_ERROR_MEMORY;
+
+set_timer_failed:
+    return NOTIFY_ERROR_SYSTEM_CALL;
+}
+
+static void DisarmBatchTimer (struct notify_pipe_listener* listener)
+{
+    if(listener->batch_timer_id == 0)
+        return;
+
+    KillTimer(NULL, listener->batch_timer_id);
+    FFILib_RemoveID(listener->batch_timer_id, &batch_timer_hash);
+
+    listener->batch_timer_id = 0;
+}
+
+static VOID CALLBACK BatchTimerProc (
+                                     HWND  window,
+                                     UINT  message,
+                                     UINT  timer_id,
+                                     DWORD time
+                                    )
+{
+    int result;
+    int error;
+
+    error = FFILib_SynchronousFunction(&BatchTimer, &timer_id, &ffilib_control_thread, &result);
+    if(error == FFILIB_ERROR_THREAD_SWITCH)
+        BatchTimer(&timer_id);
+}
+
+static int BatchTimer (void* user_data)
+{
+    struct notify_pipe_listener* listener;
+    UINT*                        timer_id;
+    int                          error;
+
+    timer_id = user_data;
+    listener = FFILib_GetIDData(*timer_id, &batch_timer_hash);
+
+    if(listener == NULL)
+    {
+        KillTimer(NULL, *timer_id);
+
+        return NOTIFY_ERROR_NONE;
+    }
+
+    DisarmBatchTimer(listener);
+
+    /* Taking lines again triggers the partial batch now that its latency
+       has run out, or re-arms the timer for what is left of it */
+    FFILib_BeginSignalBatch();
+
+    error = PumpPipe(listener->pipe_data);
+
+    FFILib_EndSignalBatch();
+
+    return error;
+}
+
+static VOID CALLBACK PipePollTimerProc (
+                                        HWND  window,
+                                        UINT  message,
+                                        UINT  timer_id,
+                                        DWORD time
+                                       )
+{
+    int result;
+    int error;
+
+    error = FFILib_SynchronousFunction(&PipePollTimer, &timer_id, &ffilib_control_thread, &result);
+    if(error == FFILIB_ERROR_THREAD_SWITCH)
+        PipePollTimer(&timer_id);
+}
+
+static int PollPipes (void* user_data)
+{
+    struct notify_module_data* module_data;
+    struct notify_pipe_data*   open_pipes;
+
+    module_data = user_data;
+
+    /* Every listener that filled a batch wakes the interpreter once */
+    FFILib_BeginSignalBatch();
+
+    for(
+        open_pipes = module_data->open_pipes;
+        open_pipes != NULL;
+        open_pipes = open_pipes->next_pipe
+       )
+    {
+        if(open_pipes->listeners == NULL || open_pipes->change_watch != NULL)
+            continue;
+
+        PumpPipe(open_pipes);
+    }
+
+    FFILib_EndSignalBatch();
+
+    return NOTIFY_ERROR_NONE;
+}
+
+static int PipePollTimer (void* user_data)
+{
+    struct notify_module_data* module_data;
+    UINT*                      timer_id;
+
+    timer_id    = user_data;
+    module_data = FFILib_GetIDData(*timer_id, &timer_id_hash);
+
+    if(module_data == NULL)
+        return NOTIFY_ERROR_NONE;
+
+    return PollPipes(module_data);
+}
+
+static int StartPipePolling (void* user_data)
+{
+    struct notify_module_data* module_data;
+    unsigned int               timer_id;
+    int                        error;
+
+    module_data = user_data;
+
+    if(module_data->pipe_poll_timer_id != 0)
+        return TSFFI_ERROR_NONE;
+
+    timer_id = SetTimer(NULL, 0, PIPE_POLL_TIMER_PERIOD, &PipePollTimerProc);
+    if(timer_id == 0)
+        goto set_timer_failed;
+
+    error = FFILib_AddID(timer_id, module_data, &timer_id_hash);
+    if(error != FFILIB_ERROR_NONE)
+        goto add_id_failed;
+
+    module_data->pipe_poll_timer_id = timer_id;
+
+    return TSFFI_ERROR_NONE;
+
+add_id_failed:
+    KillTimer(NULL, timer_id);
+
+set_timer_failed:
+    return TSFFI_ERROR_EXCEPTION;
+}
+
+static int StopPipePolling (void* user_data)
+{
+    struct notify_module_data* module_data;
+    unsigned int               timer_id;
+
+    module_data = user_data;
+    timer_id    = module_data->pipe_poll_timer_id;
+
+    if(timer_id == 0)
+        return TSFFI_ERROR_NONE;
+
+    KillTimer(NULL, timer_id);
+    FFILib_RemoveID(timer_id, &timer_id_hash);
+
+    module_data->pipe_poll_timer_id = 0;
+
+    return TSFFI_ERROR_NONE;
+}
+
+static int ForgetPipes (void* user_data)
+{
+    struct notify_module_data* module_data;
+    struct notify_pipe_data*   open_pipes;
+
+    module_data = user_data;
+
+    StopPipePolling(module_data);
+
+    for(
+        open_pipes = module_data->open_pipes;
+        open_pipes != NULL;
+        open_pipes = open_pipes->next_pipe
+       )
+    {
+        struct notify_pipe_listener* listener;
+
+        FFILib_RemoveID(open_pipes->change_id, &change_id_hash);
+
+        CancelStreams(open_pipes);
+
+        /* Thread timers can only be killed by the thread that set them */
+        for(
+            listener = open_pipes->listeners;
+            listener != NULL;
+            listener = listener->next_listener
+           )
+        {
+            DisarmBatchTimer(listener);
+        }
+    }
+
+    return TSFFI_ERROR_NONE;
+}
+
+
+int Notify_StartPipePolling (struct notify_module_data* module_data)
+{
+    int result;
+
+    FFILib_SynchronousFunction(&StartPipePolling, module_data, &ffilib_control_thread, &result);
+
+    return result;
+
+}
+
+int Notify_StopPipePolling (struct notify_module_data* module_data)
+{
+    int result;
+
+    /* Skip the trip to the control thread when every pipe was watched */
+    if(module_data->pipe_poll_timer_id == 0)
+        return TSFFI_ERROR_NONE;
+
+    FFILib_SynchronousFunction(&StopPipePolling, module_data, &ffilib_control_thread, &result);
+
+    return result;
+}
+
+int Notify_WatchPipes (
+                       struct notify_module_data* module_data,
+                       struct tsffi_execif*       execif,
+                       void*                      execif_data
+                      )
+{
+    struct notify_pipe_data* open_pipes;
+    DWORD                    now;
+    int                      unwatched;
+
+    now       = GetTickCount();
+    unwatched = 0;
+
+    for(
+        open_pipes = module_data->open_pipes;
+        open_pipes != NULL;
+        open_pipes = open_pipes->next_pipe
+       )
+    {
+        int error;
+
+        if(open_pipes->change_watch != NULL)
+            continue;
+
+        if(
+           open_pipes->change_handle == NULL ||
+           (open_pipes->watch_backoff != 0 && (int)(now-open_pipes->watch_retry_time) < 0)
+          )
+        {
+            unwatched = 1;
+
+            continue;
+        }
+
+        error = NOTIFY_ERROR_NONE;
+        if(open_pipes->source == NOTIFY_PIPE_SOURCE_FILE && !open_pipes->directory_armed)
+            error = ArmDirectoryWatch(open_pipes);
+
+        if(error == NOTIFY_ERROR_NONE)
+        {
+            open_pipes->change_watch = execif->watch_handle(
+                                                            execif_data,
+                                                            open_pipes->change_handle,
+                                                            &PipeChanged,
+                                                            open_pipes
+                                                           );
+        }
+
+        if(open_pipes->change_watch == NULL)
+        {
+            DeferWatch(open_pipes, now);
+
+            unwatched = 1;
+
+            continue;
+        }
+
+        open_pipes->watch_execif      = execif;
+        open_pipes->watch_execif_data = execif_data;
+        open_pipes->watch_backoff     = 0;
+    }
+
+    return unwatched;
+}
+
+void Notify_DestroyPipes (
+                          struct notify_module_data* module_data,
+                          struct tsffi_execif*       execif,
+                          void*                      execif_data
+                         )
+{
+    struct notify_pipe_data* pipes;
+    int                      result;
+    int                      error;
+
+    /* Changes the module already handed to the control thread must find
+       nothing once the pipes are freed */
+    error = FFILib_SynchronousFunction(&ForgetPipes, module_data, &ffilib_control_thread, &result);
+    if(error == FFILIB_ERROR_THREAD_SWITCH)
+        ForgetPipes(module_data);
 
     pipes = module_data->open_pipes;
 
-    while(pipes != NULL)
+    while(pipes != NULL)
+    {
+        struct notify_pipe_data* free_pipe;
+
+        free_pipe = pipes;
+        pipes     = pipes->next_pipe;
+
+        FreePipe(free_pipe, execif, execif_data);
+    }
+}
+
+int Notify_Pipe (
+                 struct tsffi_invocation_data* invocation_data,
+                 void*                         group_data,
+                 union tsffi_value*            output,
+                 union tsffi_value*            input
+                )
+{
+    struct notify_pipe_data* pipe_data;
+    HANDLE                   file_handle;
+    int                      error;
+    int                      result;
+
+    error = FFILib_SynchronousFFIFunction(
+                                          &Notify_Pipe,
+                                          invocation_data,
+                                          group_data,
+                                          output,
+                                          input,
+                                          &ffilib_control_thread,
+                                          &result
+                                         );
+    if(error == FFILIB_ERROR_NONE)
+        return result;
+    else if(error != FFILIB_ERROR_THREAD_SWITCH)
+        return TSFFI_ERROR_EXCEPTION;
+
+    pipe_data = AllocPipe(NOTIFY_PIPE_SOURCE_FILE);
+    if(pipe_data == NULL)
+        goto allocate_pipe_failed;
+
+    file_handle = CreateFile(
+                             input->string_data,
+                             GENERIC_READ,
+                             FILE_SHARE_READ|FILE_SHARE_WRITE,
+                             NULL,
+                             OPEN_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL,
+                             NULL
+                            );
+    if(file_handle == INVALID_HANDLE_VALUE)
+    {
+        char text[MAX_EXCEPTION_TEXT_LENGTH];
+
+        _snprintf(
+                  text,
+                  MAX_EXCEPTION_TEXT_LENGTH,
+                  "function=%s line=%d: The specified file could not be opened",
+                  invocation_data->unit_name,
+                  invocation_data->unit_location
+                 );
+
+        text[MAX_EXCEPTION_TEXT_LENGTH-1] = 0;
+
+        invocation_data->execif->set_exception_text(invocation_data->execif_data, text);
+
+        goto open_file_failed;
+    }
+
+    if(AllocStream(pipe_data, file_handle) == NULL)
     {
-        struct notify_pipe_data* free_pipe;
+        CloseHandle(file_handle);
 
-        free_pipe = pipes;
-        pipes     = pipes->next_pipe;
+        goto allocate_stream_failed;
+    }
+
+    /* Without a directory watch the pipe is left to the poll timer */
+    WatchPipeDirectory(pipe_data, input->string_data);
+
+    error = RegisterPipe(invocation_data, group_data, pipe_data, output);
+    if(error != NOTIFY_ERROR_NONE)
+        goto register_pipe_failed;
+
+    return TSFFI_ERROR_NONE;
+
+register_pipe_failed:
+allocate_stream_failed:
+open_file_failed:
+    FreePipe(pipe_data, invocation_data->execif, invocation_data->execif_data);
+
+allocate_pipe_failed:
+    return TSFFI_ERROR_EXCEPTION;
+}
+
+int Notify_NamedPipe (
+                      struct tsffi_invocation_data* invocation_data,
+                      void*                         group_data,
+                      union tsffi_value*            output,
+                      union tsffi_value*            input
+                     )
+{
+    int error;
+    int result;
+
+    error = FFILib_SynchronousFFIFunction(
+                                          &Notify_NamedPipe,
+                                          invocation_data,
+                                          group_data,
+                                          output,
+                                          input,
+                                          &ffilib_control_thread,
+                                          &result
+                                         );
+    if(error == FFILIB_ERROR_NONE)
+        return result;
+    else if(error != FFILIB_ERROR_THREAD_SWITCH)
+        return TSFFI_ERROR_EXCEPTION;
+
+    return OpenChannel(invocation_data, group_data, output, input, NOTIFY_PIPE_SOURCE_STREAM);
+}
+
+int Notify_MessagePipe (
+                        struct tsffi_invocation_data* invocation_data,
+                        void*                         group_data,
+                        union tsffi_value*            output,
+                        union tsffi_value*            input
+                       )
+{
+    int error;
+    int result;
+
+    error = FFILib_SynchronousFFIFunction(
+                                          &Notify_MessagePipe,
+                                          invocation_data,
+                                          group_data,
+                                          output,
+                                          input,
+                                          &ffilib_control_thread,
+                                          &result
+                                         );
+    if(error == FFILIB_ERROR_NONE)
+        return result;
+    else if(error != FFILIB_ERROR_THREAD_SWITCH)
+        return TSFFI_ERROR_EXCEPTION;
+
+    return OpenChannel(invocation_data, group_data, output, input, NOTIFY_PIPE_SOURCE_MESSAGE);
+}
+
+int Notify_FramePipe (
+                      struct tsffi_invocation_data* invocation_data,
+                      void*                         group_data,
+                      union tsffi_value*            output,
+                      union tsffi_value*            input
+                     )
+{
+    struct notify_pipe_data* pipe_data;
+    char*                    schema;
+    size_t                   schema_length;
+    int                      error;
+    int                      result;
+
+    error = FFILib_SynchronousFFIFunction(
+                                          &Notify_FramePipe,
+                                          invocation_data,
+                                          group_data,
+                                          output,
+                                          input,
+                                          &ffilib_control_thread,
+                                          &result
+                                         );
+    if(error == FFILIB_ERROR_NONE)
+        return result;
+    else if(error != FFILIB_ERROR_THREAD_SWITCH)
+        return TSFFI_ERROR_EXCEPTION;
+
+    pipe_data = HandlePipe(invocation_data, group_data, input[0].int_data);
+    if(pipe_data == NULL)
+        return TSFFI_ERROR_EXCEPTION;
+
+    schema        = input[1].string_data;
+    schema_length = strlen(schema);
+
+    if(schema_length == 0 || strspn(schema, PIPE_SCHEMA_TYPES) != schema_length)
+    {
+        char text[MAX_EXCEPTION_TEXT_LENGTH];
+
+        _snprintf(
+                  text,
+                  MAX_EXCEPTION_TEXT_LENGTH,
+                  "function=%s line=%d: A pipe schema is a list of 'i', 'r' and 's' field types",
+                  invocation_data->unit_name,
+                  invocation_data->unit_location
+                 );
+
+        text[MAX_EXCEPTION_TEXT_LENGTH-1] = 0;
 
-        if(free_pipe->current_line != NULL)
-            free(free_pipe->current_line);
+        invocation_data->execif->set_exception_text(invocation_data->execif_data, text);
 
-        CloseHandle(free_pipe->file_handle);
-        free(free_pipe);
+        return TSFFI_ERROR_EXCEPTION;
     }
+
+    schema = malloc(schema_length+1);
+    if(schema == NULL)
+        return TSFFI_ERROR_EXCEPTION;
+
+    memcpy(schema, input[1].string_data, schema_length+1);
+
+    free(pipe_data->schema);
+
+    pipe_data->schema        = schema;
+    pipe_data->schema_length = (unsigned int)schema_length;
+
+    return TSFFI_ERROR_NONE;
 }
 
-int Notify_Pipe (
-                 struct tsffi_invocation_data* invocation_data,
-                 void*                         group_data,
-                 union tsffi_value*            output,
-                 union tsffi_value*            input
-                )
+int Notify_ReadPipe (
+                     struct tsffi_invocation_data* invocation_data,
+                     void*                         group_data,
+                     union tsffi_value*            output,
+                     union tsffi_value*            input
+                    )
+{
+    struct notify_pipe_data* pipe_data;
+    char*                    argument;
+    int                      error;
+    int                      result;
+
+    error = FFILib_SynchronousFFIFunction(
+                                          &Notify_ReadPipe,
+                                          invocation_data,
+                                          group_data,
+                                          output,
+                                          input,
+                                          &ffilib_control_thread,
+                                          &result
+                                         );
+    if(error == FFILIB_ERROR_NONE)
+        return result;
+    else if(error != FFILIB_ERROR_THREAD_SWITCH)
+        return TSFFI_ERROR_EXCEPTION;
+
+    pipe_data = UnitPipe(invocation_data, group_data);
+    if(pipe_data == NULL)
+        return TSFFI_ERROR_EXCEPTION;
+
+    argument = ExtractArgument(TriggeredLine(pipe_data, invocation_data, 0), input->int_data, invocation_data);
+    if(argument == NULL)
+        return TSFFI_ERROR_EXCEPTION;
+
+    output->string_data = (tsffi_string)argument;
+
+    return TSFFI_ERROR_NONE;
+}
+
+int Notify_HReadPipe (
+                      struct tsffi_invocation_data* invocation_data,
+                      void*                         group_data,
+                      union tsffi_value*            output,
+                      union tsffi_value*            input
+                     )
+{
+    struct notify_pipe_data* pipe_data;
+    char*                    argument;
+    int                      error;
+    int                      result;
+
+    error = FFILib_SynchronousFFIFunction(
+                                          &Notify_HReadPipe,
+                                          invocation_data,
+                                          group_data,
+                                          output,
+                                          input,
+                                          &ffilib_control_thread,
+                                          &result
+                                         );
+    if(error == FFILIB_ERROR_NONE)
+        return result;
+    else if(error != FFILIB_ERROR_THREAD_SWITCH)
+        return TSFFI_ERROR_EXCEPTION;
+
+    pipe_data = HandlePipe(invocation_data, group_data, input[0].int_data);
+    if(pipe_data == NULL)
+        return TSFFI_ERROR_EXCEPTION;
+
+    argument = ExtractArgument(TriggeredLine(pipe_data, NULL, 0), input[1].int_data, invocation_data);
+    if(argument == NULL)
+        return TSFFI_ERROR_EXCEPTION;
+
+    output->string_data = (tsffi_string)argument;
+
+    return TSFFI_ERROR_NONE;
+}
+
+int Notify_ReadPipeInt (
+                        struct tsffi_invocation_data* invocation_data,
+                        void*                         group_data,
+                        union tsffi_value*            output,
+                        union tsffi_value*            input
+                       )
+{
+    struct notify_pipe_data* pipe_data;
+    int                      error;
+    int                      result;
+
+    error = FFILib_SynchronousFFIFunction(
+                                          &Notify_ReadPipeInt,
+                                          invocation_data,
+                                          group_data,
+                                          output,
+                                          input,
+                                          &ffilib_control_thread,
+                                          &result
+                                         );
+    if(error == FFILIB_ERROR_NONE)
+        return result;
+    else if(error != FFILIB_ERROR_THREAD_SWITCH)
+        return TSFFI_ERROR_EXCEPTION;
+
+    pipe_data = UnitPipe(invocation_data, group_data);
+    if(pipe_data == NULL)
+        return TSFFI_ERROR_EXCEPTION;
+
+    output->int_data = FieldInt(TriggeredLine(pipe_data, invocation_data, 0), input->int_data);
+
+    return TSFFI_ERROR_NONE;
+}
+
+int Notify_HReadPipeInt (
+                         struct tsffi_invocation_data* invocation_data,
+                         void*                         group_data,
+                         union tsffi_value*            output,
+                         union tsffi_value*            input
+                        )
+{
+    struct notify_pipe_data* pipe_data;
+    int                      error;
+    int                      result;
+
+    error = FFILib_SynchronousFFIFunction(
+                                          &Notify_HReadPipeInt,
+                                          invocation_data,
+                                          group_data,
+                                          output,
+                                          input,
+                                          &ffilib_control_thread,
+                                          &result
+                                         );
+    if(error == FFILIB_ERROR_NONE)
+        return result;
+    else if(error != FFILIB_ERROR_THREAD_SWITCH)
+        return TSFFI_ERROR_EXCEPTION;
+
+    pipe_data = HandlePipe(invocation_data, group_data, input[0].int_data);
+    if(pipe_data == NULL)
+        return TSFFI_ERROR_EXCEPTION;
+
+    output->int_data = FieldInt(TriggeredLine(pipe_data, NULL, 0), input[1].int_data);
+
+    return TSFFI_ERROR_NONE;
+}
+
+int Notify_ReadPipeReal (
+                         struct tsffi_invocation_data* invocation_data,
+                         void*                         group_data,
+                         union tsffi_value*            output,
+                         union tsffi_value*            input
+                        )
+{
+    struct notify_pipe_data* pipe_data;
+    int                      error;
+    int                      result;
+
+    error = FFILib_SynchronousFFIFunction(
+                                          &Notify_ReadPipeReal,
+                                          invocation_data,
+                                          group_data,
+                                          output,
+                                          input,
+                                          &ffilib_control_thread,
+                                          &result
+                                         );
+    if(error == FFILIB_ERROR_NONE)
+        return result;
+    else if(error != FFILIB_ERROR_THREAD_SWITCH)
+        return TSFFI_ERROR_EXCEPTION;
+
+    pipe_data = UnitPipe(invocation_data, group_data);
+    if(pipe_data == NULL)
+        return TSFFI_ERROR_EXCEPTION;
+
+    output->real_data = FieldReal(TriggeredLine(pipe_data, invocation_data, 0), input->int_data);
+
+    return TSFFI_ERROR_NONE;
+}
+
+int Notify_HReadPipeReal (
+                          struct tsffi_invocation_data* invocation_data,
+                          void*                         group_data,
+                          union tsffi_value*            output,
+                          union tsffi_value*            input
+                         )
 {
-    struct notify_module_data* module_data;
-    struct notify_pipe_data*   pipe_data;
-    HANDLE                     file_handle;
-    unsigned int               pipe_id;
-    unsigned int               unit_invocation_id;
-    int                        error;
-    int                        result;
+    struct notify_pipe_data* pipe_data;
+    int                      error;
+    int                      result;
 
     error = FFILib_SynchronousFFIFunction(
-                                          &Notify_Pipe,
+                                          &Notify_HReadPipeReal,
                                           invocation_data,
                                           group_data,
                                           output,
@@ -462,92 +2953,107 @@ int Notify_Pipe (
     else if(error != FFILIB_ERROR_THREAD_SWITCH)
         return TSFFI_ERROR_EXCEPTION;
 
-    pipe_data = malloc(sizeof(struct notify_pipe_data));
+    pipe_data = HandlePipe(invocation_data, group_data, input[0].int_data);
     if(pipe_data == NULL)
-        goto allocate_definition_failed;
-
-    file_handle = CreateFile(
-                             input->string_data,
-                             GENERIC_READ,
-                             FILE_SHARE_READ|FILE_SHARE_WRITE,
-                             NULL,
-                             OPEN_ALWAYS,
-                             FILE_ATTRIBUTE_NORMAL,
-                             NULL
-                            );
-    if(file_handle == INVALID_HANDLE_VALUE)
-    {
-        char text[MAX_EXCEPTION_TEXT_LENGTH];
-
-        _snprintf(
-                  text,
-                  MAX_EXCEPTION_TEXT_LENGTH,
-                  "function=%s line=%d: The specified file could not be opened",
-                  invocation_data->unit_name,
-                  invocation_data->unit_location
-                 );
-
-        text[MAX_EXCEPTION_TEXT_LENGTH-1] = 0;
+        return TSFFI_ERROR_EXCEPTION;
 
-        invocation_data->execif->set_exception_text(invocation_data->execif_data, text);
+    output->real_data = FieldReal(TriggeredLine(pipe_data, NULL, 0), input[1].int_data);
 
-        goto open_file_failed;
-    }
+    return TSFFI_ERROR_NONE;
+}
 
-    module_data = group_data;
+int Notify_PipeLines (
+                      struct tsffi_invocation_data* invocation_data,
+                      void*                         group_data,
+                      union tsffi_value*            output,
+                      union tsffi_value*            input
+                     )
+{
+    struct notify_pipe_listener* listener;
+    struct notify_pipe_data*     pipe_data;
+    int                          error;
+    int                          result;
 
-    pipe_id = module_data->next_pipe_id;
+    error = FFILib_SynchronousFFIFunction(
+                                          &Notify_PipeLines,
+                                          invocation_data,
+                                          group_data,
+                                          output,
+                                          input,
+                                          &ffilib_control_thread,
+                                          &result
+                                         );
+    if(error == FFILIB_ERROR_NONE)
+        return result;
+    else if(error != FFILIB_ERROR_THREAD_SWITCH)
+        return TSFFI_ERROR_EXCEPTION;
 
-    pipe_data->pipe_id             = pipe_id;
-    pipe_data->file_handle         = file_handle;
-    pipe_data->current_line        = NULL;
-    pipe_data->line_argument_count = 0;
+    pipe_data = UnitPipe(invocation_data, group_data);
+    if(pipe_data == NULL)
+        return TSFFI_ERROR_EXCEPTION;
 
-    unit_invocation_id = invocation_data->unit_invocation_id;
+    listener = TriggeredListener(pipe_data, invocation_data);
+    if(listener != NULL)
+        output->int_data = listener->line_count;
+    else
+        output->int_data = 0;
 
-    error = FFILib_AddID(unit_invocation_id, pipe_data, &module_data->unit_hash);
-    if(error != FFILIB_ERROR_NONE)
-        goto add_unit_invocation_id_failed;
+    return TSFFI_ERROR_NONE;
+}
 
-    error = FFILib_AddID(pipe_id, pipe_data, &module_data->pipe_hash);
-    if(error != FFILIB_ERROR_NONE)
-        goto add_pipe_id_failed;
+int Notify_HPipeLines (
+                       struct tsffi_invocation_data* invocation_data,
+                       void*                         group_data,
+                       union tsffi_value*            output,
+                       union tsffi_value*            input
+                      )
+{
+    struct notify_pipe_listener* listener;
+    struct notify_pipe_data*     pipe_data;
+    int                          error;
+    int                          result;
 
-    module_data->next_pipe_id++;
+    error = FFILib_SynchronousFFIFunction(
+                                          &Notify_HPipeLines,
+                                          invocation_data,
+                                          group_data,
+                                          output,
+                                          input,
+                                          &ffilib_control_thread,
+                                          &result
+                                         );
+    if(error == FFILIB_ERROR_NONE)
+        return result;
+    else if(error != FFILIB_ERROR_THREAD_SWITCH)
+        return TSFFI_ERROR_EXCEPTION;
 
-    pipe_data->next_pipe    = module_data->open_pipes;
-    module_data->open_pipes = pipe_data;
+    pipe_data = HandlePipe(invocation_data, group_data, input[0].int_data);
+    if(pipe_data == NULL)
+        return TSFFI_ERROR_EXCEPTION;
 
-    output->int_data = pipe_id;
+    listener = TriggeredListener(pipe_data, NULL);
+    if(listener != NULL)
+        output->int_data = listener->line_count;
+    else
+        output->int_data = 0;
 
     return TSFFI_ERROR_NONE;
-
-add_pipe_id_failed:
-    FFILib_RemoveID(unit_invocation_id, &module_data->pipe_hash);
-add_unit_invocation_id_failed:
-    CloseHandle(file_handle);
-open_file_failed:
-    free(pipe_data);
-
-allocate_definition_failed:
-    return TSFFI_ERROR_EXCEPTION;
 }
 
-int Notify_ReadPipe (
-                     struct tsffi_invocation_data* invocation_data,
-                     void*                         group_data,
-                     union tsffi_value*            output,
-                     union tsffi_value*            input
-                    )
+int Notify_ReadPipeLine (
+                         struct tsffi_invocation_data* invocation_data,
+                         void*                         group_data,
+                         union tsffi_value*            output,
+                         union tsffi_value*            input
+                        )
 {
-    struct notify_module_data* module_data;
-    struct notify_pipe_data*   pipe_data;
-    char*                      argument;
-    int                        error;
-    int                        result;
+    struct notify_pipe_data* pipe_data;
+    char*                    argument;
+    int                      error;
+    int                      result;
 
     error = FFILib_SynchronousFFIFunction(
-                                          &Notify_ReadPipe,
+                                          &Notify_ReadPipeLine,
                                           invocation_data,
                                           group_data,
                                           output,
@@ -560,34 +3066,13 @@ int Notify_ReadPipe (
     else if(error != FFILIB_ERROR_THREAD_SWITCH)
         return TSFFI_ERROR_EXCEPTION;
 
-    module_data = group_data;
-    pipe_data   = FFILib_GetIDData(
-                                   invocation_data->unit_invocation_id,
-                                   &module_data->unit_hash
-                                  );
+    pipe_data = UnitPipe(invocation_data, group_data);
     if(pipe_data == NULL)
-    {
-        char text[MAX_EXCEPTION_TEXT_LENGTH];
-
-        _snprintf(
-                  text,
-                  MAX_EXCEPTION_TEXT_LENGTH,
-                  "function=%s line=%d: Attempting to read from pipe which hasn't been created using 'pipe()'",
-                  invocation_data->unit_name,
-                  invocation_data->unit_location
-                 );
-
-        text[MAX_EXCEPTION_TEXT_LENGTH-1] = 0;
-
-        invocation_data->execif->set_exception_text(invocation_data->execif_data, text);
-
         return TSFFI_ERROR_EXCEPTION;
-    }
 
     argument = ExtractArgument(
-                               pipe_data->current_line,
-                               pipe_data->line_argument_count,
-                               input->int_data,
+                               TriggeredLine(pipe_data, invocation_data, input[0].int_data),
+                               input[1].int_data,
                                invocation_data
                               );
     if(argument == NULL)
@@ -598,21 +3083,20 @@ int Notify_ReadPipe (
     return TSFFI_ERROR_NONE;
 }
 
-int Notify_HReadPipe (
-                      struct tsffi_invocation_data* invocation_data,
-                      void*                         group_data,
-                      union tsffi_value*            output,
-                      union tsffi_value*            input
-                     )
+int Notify_HReadPipeLine (
+                          struct tsffi_invocation_data* invocation_data,
+                          void*                         group_data,
+                          union tsffi_value*            output,
+                          union tsffi_value*            input
+                         )
 {
-    struct notify_module_data* module_data;
-    struct notify_pipe_data*   pipe_data;
-    char*                      argument;
-    int                        error;
-    int                        result;
+    struct notify_pipe_data* pipe_data;
+    char*                    argument;
+    int                      error;
+    int                      result;
 
     error = FFILib_SynchronousFFIFunction(
-                                          &Notify_HReadPipe,
+                                          &Notify_HReadPipeLine,
                                           invocation_data,
                                           group_data,
                                           output,
@@ -625,34 +3109,13 @@ int Notify_HReadPipe (
     else if(error != FFILIB_ERROR_THREAD_SWITCH)
         return TSFFI_ERROR_EXCEPTION;
 
-    module_data = group_data;
-    pipe_data   = FFILib_GetIDData(
-                                   input[0].int_data,
-                                   &module_data->pipe_hash
-                                  );
+    pipe_data = HandlePipe(invocation_data, group_data, input[0].int_data);
     if(pipe_data == NULL)
-    {
-        char text[MAX_EXCEPTION_TEXT_LENGTH];
-
-        _snprintf(
-                  text,
-                  MAX_EXCEPTION_TEXT_LENGTH,
-                  "function=%s line=%d: Attempting to read from pipe using an invalid handle, retrieve a handle by calling 'pipe()'",
-                  invocation_data->unit_name,
-                  invocation_data->unit_location
-                 );
-
-        text[MAX_EXCEPTION_TEXT_LENGTH-1] = 0;
-
-        invocation_data->execif->set_exception_text(invocation_data->execif_data, text);
-
         return TSFFI_ERROR_EXCEPTION;
-    }
 
     argument = ExtractArgument(
-                               pipe_data->current_line,
-                               pipe_data->line_argument_count,
-                               input[1].int_data,
+                               TriggeredLine(pipe_data, NULL, input[1].int_data),
+                               input[2].int_data,
                                invocation_data
                               );
     if(argument == NULL)
@@ -672,10 +3135,8 @@ int Notify_Action_ListenPipe (
                               void**                        user_action_data
                              )
 {
-    struct notify_module_data* module_data;
-    struct notify_pipe_data*   pipe_data;
-    int                        error;
-    int                        result;
+    int error;
+    int result;
 
     error = FFILib_SynchronousFFIAction(
                                         &Notify_Action_ListenPipe,
@@ -693,40 +3154,10 @@ int Notify_Action_ListenPipe (
     else if(error != FFILIB_ERROR_THREAD_SWITCH)
         return TSFFI_ERROR_EXCEPTION;
 
-    module_data = group_data;
-
-    if(request == TSFFI_INIT_ACTION)
-    {
-        pipe_data = FFILib_GetIDData(
-                                     action_data->unit_invocation_id,
-                                     &module_data->unit_hash
-                                    );
-
-        *user_action_data = pipe_data;
-    }
-    else
-        pipe_data = *user_action_data;
-
-    if(pipe_data == NULL)
-    {
-        char text[MAX_EXCEPTION_TEXT_LENGTH];
-
-        _snprintf(
-                  text,
-                  MAX_EXCEPTION_TEXT_LENGTH,
-                  "function=%s line=%d: Attempting to listen on a pipe which hasn't been created using 'pipe()'",
-                  action_data->unit_name,
-                  action_data->unit_location
-                 );
-
-        text[MAX_EXCEPTION_TEXT_LENGTH-1] = 0;
-
-        action_data->execif->set_exception_text(action_data->execif_data, text);
-
-        return TSFFI_ERROR_EXCEPTION;
-    }
+    if(request != TSFFI_INIT_ACTION)
+        return PerformPipeListen(action_data, request, state, user_action_data);
 
-    error = PerformPipeListen(pipe_data, action_data, request, state);
+    error = ListenUnitPipe(action_data, group_data, user_action_data, 1, 0);
 
     return error;
 }
@@ -740,10 +3171,8 @@ int Notify_Action_HListenPipe (
                                void**                        user_action_data
                               )
 {
-    struct notify_module_data* module_data;
-    struct notify_pipe_data*   pipe_data;
-    int                        error;
-    int                        result;
+    int error;
+    int result;
 
     error = FFILib_SynchronousFFIAction(
                                         &Notify_Action_HListenPipe,
@@ -761,41 +3190,103 @@ int Notify_Action_HListenPipe (
     else if(error != FFILIB_ERROR_THREAD_SWITCH)
         return TSFFI_ERROR_EXCEPTION;
 
-    module_data = group_data;
+    if(request != TSFFI_INIT_ACTION)
+        return PerformPipeListen(action_data, request, state, user_action_data);
 
-    if(request == TSFFI_INIT_ACTION)
-    {
-        pipe_data = FFILib_GetIDData(
-                                     input->int_data,
-                                     &module_data->pipe_hash
-                                    );
+    error = ListenHandlePipe(action_data, group_data, input[0].int_data, user_action_data, 1, 0);
 
-        *user_action_data = pipe_data;
-    }
-    else
-        pipe_data = *user_action_data;
+    return error;
+}
 
-    if(pipe_data == NULL)
-    {
-        char text[MAX_EXCEPTION_TEXT_LENGTH];
+int Notify_Action_ListenPipeBatch (
+                                   struct tsffi_invocation_data* action_data,
+                                   unsigned int                  request,
+                                   void*                         group_data,
+                                   union tsffi_value*            input,
+                                   unsigned int*                 state,
+                                   void**                        user_action_data
+                                  )
+{
+    int error;
+    int result;
 
-        _snprintf(
-                  text,
-                  MAX_EXCEPTION_TEXT_LENGTH,
-                  "function=%s line=%d: Invalid handle used, retrieve a handle by calling 'pipe()'",
-                  action_data->unit_name,
-                  action_data->unit_location
-                 );
+    error = FFILib_SynchronousFFIAction(
+                                        &Notify_Action_ListenPipeBatch,
+                                        action_data,
+                                        request,
+                                        group_data,
+                                        input,
+                                        state,
+                                        user_action_data,
+                                        &ffilib_control_thread,
+                                        &result
+                                       );
+    if(error == FFILIB_ERROR_NONE)
+        return result;
+    else if(error != FFILIB_ERROR_THREAD_SWITCH)
+        return TSFFI_ERROR_EXCEPTION;
 
-        text[MAX_EXCEPTION_TEXT_LENGTH-1] = 0;
+    /* The limits are evaluated again for every batch */
+    if(request == TSFFI_UPDATE_ACTION)
+        SetBatchLimits(*user_action_data, input[0].int_data, input[1].real_data);
 
-        action_data->execif->set_exception_text(action_data->execif_data, text);
+    if(request != TSFFI_INIT_ACTION)
+        return PerformPipeListen(action_data, request, state, user_action_data);
+
+    error = ListenUnitPipe(
+                           action_data,
+                           group_data,
+                           user_action_data,
+                           input[0].int_data < 1 ? 1 : input[0].int_data,
+                           BatchLatency(input[1].real_data)
+                          );
+
+    return error;
+}
+
+int Notify_Action_HListenPipeBatch (
+                                    struct tsffi_invocation_data* action_data,
+                                    unsigned int                  request,
+                                    void*                         group_data,
+                                    union tsffi_value*            input,
+                                    unsigned int*                 state,
+                                    void**                        user_action_data
+                                   )
+{
+    int error;
+    int result;
 
+    error = FFILib_SynchronousFFIAction(
+                                        &Notify_Action_HListenPipeBatch,
+                                        action_data,
+                                        request,
+                                        group_data,
+                                        input,
+                                        state,
+                                        user_action_data,
+                                        &ffilib_control_thread,
+                                        &result
+                                       );
+    if(error == FFILIB_ERROR_NONE)
+        return result;
+    else if(error != FFILIB_ERROR_THREAD_SWITCH)
         return TSFFI_ERROR_EXCEPTION;
-    }
 
-    error = PerformPipeListen(pipe_data, action_data, request, state);
+    /* The limits are evaluated again for every batch */
+    if(request == TSFFI_UPDATE_ACTION)
+        SetBatchLimits(*user_action_data, input[1].int_data, input[2].real_data);
+
+    if(request != TSFFI_INIT_ACTION)
+        return PerformPipeListen(action_data, request, state, user_action_data);
+
+    error = ListenHandlePipe(
+                             action_data,
+                             group_data,
+                             input[0].int_data,
+                             user_action_data,
+                             input[1].int_data < 1 ? 1 : input[1].int_data,
+                             BatchLatency(input[2].real_data)
+                            );
 
     return error;
 }
-
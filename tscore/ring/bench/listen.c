@@ -0,0 +1,413 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+/* Writes timestamped records into a ring from a producer thread and
+   drives a listen_ring action over it the way the interpreter would,
+   with the main thread standing in for the module thread.  The first run
+   writes at a fixed rate and prints the p50 and p99 of the time from a
+   record being written to its action running.  The second writes as fast
+   as the ring has room and prints the records read per second. */
+
+#include <ring/init.h>
+#include <ring/ring.h>
+#include <ring/producer.h>
+#include <ring/error.h>
+
+#include <ffilib/module.h>
+#include <ffilib/thread.h>
+#include <ffilib/idhash.h>
+#include <tsffi/execif.h>
+#include <tsffi/function.h>
+#include <tsffi/error.h>
+
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+#define BENCH_RING_NAME "ring_bench_listen"
+
+#define RECORD_SIZE  16
+#define RECORD_COUNT 4096
+
+#define LATENCY_RECORD_COUNT 5000
+#define LATENCY_RECORD_RATE  1000
+
+#define THROUGHPUT_RECORD_COUNT 1000000
+
+
+struct ring_bench
+{
+    LONGLONG frequency;
+    LONGLONG start_counter;
+
+    unsigned int record_count;
+    unsigned int record_rate;
+
+    HANDLE triggered;
+
+    HANDLE                 watch_handle;
+    tsffi_reactor_callback watch_callback;
+    void*                  watch_data;
+};
+
+
+static LONGLONG ReadMicroseconds    (void);
+static int      CompareSamples      (const void*, const void*);
+static void     Report              (char*, LONGLONG*, unsigned int);
+static DWORD WINAPI WriteRecords    (LPVOID);
+static int      RunListener         (
+                                     struct ring_module_data*,
+                                     union tsffi_value*,
+                                     unsigned int,
+                                     unsigned int,
+                                     LONGLONG*
+                                    );
+
+static void  SignalAction       (void*);
+static void  Alert              (void*, unsigned int, char*);
+static void  SetExceptionText   (void*, char*);
+static void* AllocateMemory     (void*, size_t);
+static void  FreeMemory         (void*, void*);
+static void* WatchHandle        (void*, tsffi_wait_handle, tsffi_reactor_callback, void*);
+static void* StartTimer         (void*, unsigned int, unsigned int, tsffi_reactor_callback, void*);
+static void  CancelRegistration (void*, void*);
+
+
+/* The bench links the ffilib signal code without the rest of the plugin */
+struct ffilib_thread_data ffilib_control_thread;
+
+static struct ring_bench bench;
+
+static struct tsffi_execif bench_execif =
+{
+    &SignalAction,
+    &Alert,
+    &SetExceptionText,
+    &AllocateMemory,
+    &FreeMemory,
+    &WatchHandle,
+    &StartTimer,
+    &CancelRegistration,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+static struct tsffi_invocation_data bench_invocation =
+{
+    &bench_execif,
+    NULL,
+    1,
+    "bench",
+    0,
+    NULL
+};
+
+
+static LONGLONG ReadMicroseconds (void)
+{
+    LARGE_INTEGER counter;
+
+    QueryPerformanceCounter(&counter);
+
+    return (counter.QuadPart-bench.start_counter)*1000000/bench.frequency;
+}
+
+static int CompareSamples (const void* first, const void* second)
+{
+    LONGLONG first_sample;
+    LONGLONG second_sample;
+
+    first_sample  = *(const LONGLONG*)first;
+    second_sample = *(const LONGLONG*)second;
+
+    return (first_sample > second_sample)-(first_sample < second_sample);
+}
+
+static void Report (char* name, LONGLONG* samples, unsigned int sample_count)
+{
+    qsort(samples, sample_count, sizeof(LONGLONG), &CompareSamples);
+
+    printf(
+           "%-10s p50 %8I64d us  p99 %8I64d us\n",
+           name,
+           samples[sample_count/2],
+           samples[sample_count*99/100]
+          );
+}
+
+static DWORD WINAPI WriteRecords (LPVOID user_data)
+{
+    struct ring_producer producer;
+    char                 record[RECORD_SIZE];
+    LONGLONG             start_time;
+    unsigned int         index;
+    int                  error;
+
+    error = Ring_OpenProducer(BENCH_RING_NAME, &producer);
+    if(error != RING_ERROR_NONE)
+        return 1;
+
+    start_time = ReadMicroseconds();
+
+    for(index = 0; index < bench.record_count; index++)
+    {
+        /* Hold every record to its slot so the reader is measured rather
+           than the producer's bursts */
+        if(bench.record_rate != 0)
+        {
+            LONGLONG slot_time;
+
+            slot_time = start_time+(LONGLONG)index*1000000/bench.record_rate;
+
+            while(ReadMicroseconds() < slot_time)
+                SwitchToThread();
+        }
+
+        Ring_SetInt(record, 1, index);
+
+        do
+        {
+            Ring_SetInt(record, 0, ReadMicroseconds());
+
+            error = Ring_Write(&producer, record, RECORD_SIZE);
+            if(error == RING_ERROR_FULL)
+                SwitchToThread();
+        }
+        while(error == RING_ERROR_FULL);
+    }
+
+    Ring_CloseProducer(&producer);
+
+    return 0;
+}
+
+static int RunListener (
+                        struct ring_module_data* module_data,
+                        union tsffi_value*       input,
+                        unsigned int             record_count,
+                        unsigned int             record_rate,
+                        LONGLONG*                samples
+                       )
+{
+    void*        user_action_data;
+    HANDLE       producer;
+    unsigned int state;
+    unsigned int received;
+    int          error;
+
+    error = Ring_Action_ListenRing(&bench_invocation, TSFFI_INIT_ACTION, module_data, input, &state, &user_action_data);
+    if(error != TSFFI_ERROR_NONE)
+        return error;
+
+    bench.record_count = record_count;
+    bench.record_rate  = record_rate;
+
+    producer = CreateThread(NULL, 0, &WriteRecords, NULL, 0, NULL);
+    if(producer == NULL)
+        return TSFFI_ERROR_EXCEPTION;
+
+    received = 0;
+
+    while(received < record_count)
+    {
+        HANDLE wait_handles[2];
+        DWORD  signaled_index;
+
+        wait_handles[0] = bench.triggered;
+        wait_handles[1] = bench.watch_handle;
+
+        signaled_index = WaitForMultipleObjects(2, wait_handles, FALSE, INFINITE);
+
+        if(signaled_index == WAIT_OBJECT_0+1)
+        {
+            bench.watch_callback(bench.watch_data);
+
+            continue;
+        }
+
+        /* Run the action for as long as it stays triggered, like the
+           interpreter does */
+        while(received < record_count)
+        {
+            Ring_Action_ListenRing(&bench_invocation, TSFFI_QUERY_ACTION, module_data, input, &state, &user_action_data);
+            if(state != TSFFI_ACTION_STATE_TRIGGERED)
+                break;
+
+            Ring_Action_ListenRing(&bench_invocation, TSFFI_RUNNING_ACTION, module_data, NULL, NULL, &user_action_data);
+
+            if(samples != NULL)
+            {
+                union tsffi_value output;
+                union tsffi_value slot[2];
+
+                slot[0].int_data = input[0].int_data;
+                slot[1].int_data = 0;
+
+                Ring_ReadInt(&bench_invocation, module_data, &output, slot);
+
+                samples[received] = ReadMicroseconds()-(LONGLONG)output.int_data;
+            }
+
+            received++;
+
+            Ring_Action_ListenRing(&bench_invocation, TSFFI_UPDATE_ACTION, module_data, input, &state, &user_action_data);
+        }
+    }
+
+    WaitForSingleObject(producer, INFINITE);
+    CloseHandle(producer);
+
+    Ring_Action_ListenRing(&bench_invocation, TSFFI_STOP_ACTION, module_data, input, &state, &user_action_data);
+
+    return TSFFI_ERROR_NONE;
+}
+
+
+static void SignalAction (void* execif_data)
+{
+    SetEvent(bench.triggered);
+}
+
+static void Alert (void* execif_data, unsigned int alert_type, char* text)
+{
+    printf("%s\n", text);
+}
+
+static void SetExceptionText (void* execif_data, char* text)
+{
+    fprintf(stderr, "%s\n", text);
+}
+
+static void* AllocateMemory (void* execif_data, size_t size)
+{
+    return malloc(size);
+}
+
+static void FreeMemory (void* execif_data, void* memory)
+{
+    free(memory);
+}
+
+static void* WatchHandle (
+                          void*                  execif_data,
+                          tsffi_wait_handle      handle,
+                          tsffi_reactor_callback callback,
+                          void*                  user_data
+                         )
+{
+    /* The bench listens on a single ring */
+    if(bench.watch_handle != NULL)
+        return NULL;
+
+    bench.watch_handle   = handle;
+    bench.watch_callback = callback;
+    bench.watch_data     = user_data;
+
+    return &bench;
+}
+
+static void* StartTimer (
+                         void*                  execif_data,
+                         unsigned int           milliseconds,
+                         unsigned int           timer_flags,
+                         tsffi_reactor_callback callback,
+                         void*                  user_data
+                        )
+{
+    return NULL;
+}
+
+static void CancelRegistration (void* execif_data, void* registration)
+{
+    bench.watch_handle = NULL;
+}
+
+
+int main (int argc, char** argv)
+{
+    struct ring_module_data module_data;
+    union tsffi_value       output;
+    union tsffi_value       input[3];
+    LARGE_INTEGER           counter;
+    LONGLONG*               samples;
+    LONGLONG                start_time;
+    LONGLONG                elapsed_time;
+    int                     error;
+
+    QueryPerformanceFrequency(&counter);
+
+    bench.frequency = counter.QuadPart;
+
+    QueryPerformanceCounter(&counter);
+
+    bench.start_counter = counter.QuadPart;
+
+    bench.triggered = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if(bench.triggered == NULL)
+        return 1;
+
+    samples = malloc(sizeof(LONGLONG)*LATENCY_RECORD_COUNT);
+    if(samples == NULL)
+        return 1;
+
+    module_data.next_ring_id = 1;
+    module_data.open_rings   = NULL;
+
+    FFILib_InitializeHash(&module_data.ring_hash);
+
+    input[0].string_data = BENCH_RING_NAME;
+    input[1].int_data    = RECORD_SIZE;
+    input[2].int_data    = RECORD_COUNT;
+
+    error = Ring_Ring(&bench_invocation, &module_data, &output, input);
+    if(error != TSFFI_ERROR_NONE)
+        return 1;
+
+    input[0].int_data = output.int_data;
+
+    error = RunListener(
+                        &module_data,
+                        input,
+                        LATENCY_RECORD_COUNT,
+                        LATENCY_RECORD_RATE,
+                        samples
+                       );
+    if(error != TSFFI_ERROR_NONE)
+        return 1;
+
+    Report("latency", samples, LATENCY_RECORD_COUNT);
+
+    start_time = ReadMicroseconds();
+
+    error = RunListener(
+                        &module_data,
+                        input,
+                        THROUGHPUT_RECORD_COUNT,
+                        0,
+                        NULL
+                       );
+    if(error != TSFFI_ERROR_NONE)
+        return 1;
+
+    elapsed_time = ReadMicroseconds()-start_time;
+
+    printf("throughput %10.0f records/s\n", THROUGHPUT_RECORD_COUNT*1000000.0/(double)elapsed_time);
+
+    Ring_DestroyRings(&module_data, &bench_execif, NULL);
+
+    FFILib_DestroyHash(&module_data.ring_hash);
+
+    free(samples);
+
+    return 0;
+}
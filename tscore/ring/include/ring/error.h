@@ -0,0 +1,21 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#ifndef _RING_ERROR_H_
+#define _RING_ERROR_H_
+
+
+#define RING_ERROR_NONE         0
+#define RING_ERROR_MEMORY      -1
+#define RING_ERROR_SYSTEM_CALL -2
+#define RING_ERROR_MISMATCH    -3
+#define RING_ERROR_FULL        -4
+#define RING_ERROR_BUSY        -5
+
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#ifndef _RING_INIT_H_
+#define _RING_INIT_H_
+
+
+#include <ring/ring.h>
+#include <ffilib/idhash.h>
+
+#include <tsffi/register.h>
+
+
+struct ring_module_data
+{
+    unsigned int next_ring_id;
+
+    struct ffilib_id_hash ring_hash;
+
+    struct ring_data* open_rings;
+};
+
+
+extern int  Ring_BeginModule (
+                              struct tsffi_execif*,
+                              void*,
+                              struct tsffi_registration_group*,
+                              void**
+                             );
+extern void Ring_EndModule   (
+                              struct tsffi_execif*,
+                              void*,
+                              int,
+                              struct tsffi_registration_group*,
+                              void*
+                             );
+
+
+#endif
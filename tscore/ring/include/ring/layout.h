@@ -0,0 +1,84 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#ifndef _RING_LAYOUT_H_
+#define _RING_LAYOUT_H_
+
+
+#include <windows.h>
+
+
+#define RING_MAGIC   0x474E4952
+#define RING_VERSION 2
+
+#define RING_SLOT_SIZE  8
+#define RING_LINE_SIZE 64
+
+#define RING_EVENT_SUFFIX ".wake"
+#define RING_MAX_NAME     MAX_PATH
+
+#define RING_INIT_TIMEOUT 100
+
+
+/* A ring is a named file mapping holding this header followed by
+   record_count records.  Each record starts with a ring_record and is
+   followed by record_size bytes of payload, read by scripts as 8 byte
+   slots: an int slot holds a little endian 64 bit integer, a real slot
+   a double, and a string starts at its slot and runs to a NUL or the end
+   of the record.
+
+   Records are claimed and published through their sequence numbers, so
+   any number of producers may write while the script reads.  A record at
+   position p is free to write while its sequence is p and readable once
+   it is p+1.  A reader that finds the ring empty sets waiting and checks
+   again before it sleeps, and the producer that clears waiting sets the
+   event named by the ring name followed by RING_EVENT_SUFFIX.
+
+   A ring has a single consumer.  read_index is advanced without a
+   claim, so the process reading the ring stores its id in reader and
+   every other attempt to read it is refused while that process lives.
+
+   The creator publishes magic last.  Anyone who opens the mapping while
+   magic is still 0 waits up to RING_INIT_TIMEOUT milliseconds for the
+   creator to finish before giving up on the ring. */
+struct ring_header
+{
+    unsigned int  magic;
+    unsigned int  version;
+    unsigned int  record_size;
+    unsigned int  record_count;
+    volatile LONG waiting;
+    volatile LONG reader;
+    char          header_pad[RING_LINE_SIZE-4*sizeof(unsigned int)-2*sizeof(LONG)];
+
+    volatile LONG reserve_index;
+    char          reserve_pad[RING_LINE_SIZE-sizeof(LONG)];
+
+    volatile LONG read_index;
+    char          read_pad[RING_LINE_SIZE-sizeof(LONG)];
+};
+
+struct ring_record
+{
+    volatile LONG sequence;
+    unsigned int  length;
+};
+
+
+#define RING_RECORD_STRIDE(header) (sizeof(struct ring_record)+(header)->record_size)
+
+#define RING_RECORD(header, position)                                   \
+    ((struct ring_record*)((char*)(header)+sizeof(struct ring_header)+ \
+                           ((position)&((header)->record_count-1))*RING_RECORD_STRIDE(header)))
+
+#define RING_MAPPING_SIZE(record_size, record_count)                     \
+    ((unsigned long long)sizeof(struct ring_header)+                     \
+     (unsigned long long)(record_count)*(sizeof(struct ring_record)+(record_size)))
+
+
+#endif
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#ifndef _RING_PRODUCER_H_
+#define _RING_PRODUCER_H_
+
+
+#include <ring/layout.h>
+
+#include <windows.h>
+
+
+/* The producer side of a ring, for programs that feed a script.  It only
+   depends on the win32 api and ring/layout.h, so it may be compiled into
+   any program.  A ring has to be created by a script calling ring()
+   before producers can open it. */
+struct ring_producer
+{
+    HANDLE              mapping;
+    HANDLE              wake_event;
+    struct ring_header* header;
+};
+
+
+extern int  Ring_OpenProducer  (char*, struct ring_producer*);
+extern void Ring_CloseProducer (struct ring_producer*);
+
+extern int Ring_Write (struct ring_producer*, void*, unsigned int);
+
+extern void Ring_SetInt    (void*, unsigned int, long long);
+extern void Ring_SetReal   (void*, unsigned int, double);
+extern void Ring_SetString (void*, unsigned int, char*, unsigned int);
+
+
+#endif
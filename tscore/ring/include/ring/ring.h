@@ -0,0 +1,83 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#ifndef _RING_RING_H_
+#define _RING_RING_H_
+
+
+#include <ring/layout.h>
+
+#include <tsffi/function.h>
+#include <tsffi/execif.h>
+
+#include <windows.h>
+
+
+#define RING_FLAG_TRIGGERED 0x01
+
+
+struct ring_data
+{
+    unsigned int ring_id;
+    unsigned int flags;
+
+    HANDLE              mapping;
+    HANDLE              wake_event;
+    struct ring_header* header;
+
+    char*        record;
+    unsigned int record_length;
+
+    void*                         wake_watch;
+    struct tsffi_invocation_data* action_data;
+
+    struct ring_data* next_ring;
+};
+
+struct ring_module_data;
+
+
+extern void Ring_DestroyRings (struct ring_module_data*, struct tsffi_execif*, void*);
+
+extern int Ring_Ring (
+                      struct tsffi_invocation_data*,
+                      void*,
+                      union tsffi_value*,
+                      union tsffi_value*
+                     );
+
+extern int Ring_ReadInt    (
+                            struct tsffi_invocation_data*,
+                            void*,
+                            union tsffi_value*,
+                            union tsffi_value*
+                           );
+extern int Ring_ReadReal   (
+                            struct tsffi_invocation_data*,
+                            void*,
+                            union tsffi_value*,
+                            union tsffi_value*
+                           );
+extern int Ring_ReadString (
+                            struct tsffi_invocation_data*,
+                            void*,
+                            union tsffi_value*,
+                            union tsffi_value*
+                           );
+
+extern int Ring_Action_ListenRing (
+                                   struct tsffi_invocation_data*,
+                                   unsigned int,
+                                   void*,
+                                   union tsffi_value*,
+                                   unsigned int*,
+                                   void**
+                                  );
+
+
+#endif
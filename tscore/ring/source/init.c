@@ -0,0 +1,68 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#include <ring/init.h>
+
+#include <ffilib/module.h>
+#include <ffilib/error.h>
+#include <tsffi/error.h>
+
+
+int Ring_BeginModule (
+                      struct tsffi_execif*             execif,
+                      void*                            execif_data,
+                      struct tsffi_registration_group* group,
+                      void**                           group_data
+                     )
+{
+    struct ring_module_data* module_data;
+    int                      error;
+
+    error = FFILib_BeginModule(execif, execif_data, group, NULL);
+    if(error != TSFFI_ERROR_NONE)
+        goto begin_ffilib_failed;
+
+    module_data = malloc(sizeof(struct ring_module_data));
+    if(module_data == NULL)
+        goto allocate_module_data_failed;
+
+    module_data->next_ring_id = 1;
+    module_data->open_rings   = NULL;
+
+    FFILib_InitializeHash(&module_data->ring_hash);
+
+    *group_data = module_data;
+
+    return TSFFI_ERROR_NONE;
+
+allocate_module_data_failed:
+    FFILib_EndModule(execif, execif_data, TSFFI_ERROR_EXCEPTION, group, NULL);
+
+begin_ffilib_failed:
+    return TSFFI_ERROR_EXCEPTION;
+}
+
+void Ring_EndModule (
+                     struct tsffi_execif*             execif,
+                     void*                            execif_data,
+                     int                              error,
+                     struct tsffi_registration_group* group,
+                     void*                            group_data
+                    )
+{
+    struct ring_module_data* module_data;
+
+    module_data = group_data;
+
+    Ring_DestroyRings(module_data, execif, execif_data);
+
+    FFILib_DestroyHash(&module_data->ring_hash);
+    free(module_data);
+
+    FFILib_EndModule(execif, execif_data, TSFFI_ERROR_EXCEPTION, group, NULL);
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#include <ring/producer.h>
+#include <ring/error.h>
+
+#include <stdio.h>
+#include <string.h>
+
+
+int Ring_OpenProducer (char* name, struct ring_producer* producer)
+{
+    char                event_name[RING_MAX_NAME];
+    HANDLE              mapping;
+    HANDLE              wake_event;
+    struct ring_header* header;
+    DWORD               start_time;
+    int                 error;
+
+    error = RING_ERROR_SYSTEM_CALL;
+
+    mapping = OpenFileMapping(FILE_MAP_ALL_ACCESS, FALSE, name);
+    if(mapping == NULL)
+        goto open_mapping_failed;
+
+    header = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if(header == NULL)
+        goto map_view_failed;
+
+    /* The script may still be laying the ring out */
+    start_time = GetTickCount();
+
+    while(
+          *(volatile unsigned int*)&header->magic == 0 &&
+          GetTickCount()-start_time < RING_INIT_TIMEOUT
+         )
+    {
+        SwitchToThread();
+    }
+
+    MemoryBarrier();
+
+    if(header->magic != RING_MAGIC || header->version != RING_VERSION)
+    {
+        error = RING_ERROR_MISMATCH;
+
+        goto check_header_failed;
+    }
+
+    _snprintf(event_name, RING_MAX_NAME, "%s%s", name, RING_EVENT_SUFFIX);
+
+    event_name[RING_MAX_NAME-1] = 0;
+
+    wake_event = CreateEvent(NULL, FALSE, FALSE, event_name);
+    if(wake_event == NULL)
+        goto create_event_failed;
+
+    producer->mapping    = mapping;
+    producer->wake_event = wake_event;
+    producer->header     = header;
+
+    return RING_ERROR_NONE;
+
+create_event_failed:
+check_header_failed:
+    UnmapViewOfFile(header);
+map_view_failed:
+    CloseHandle(mapping);
+
+open_mapping_failed:
+    return error;
+}
+
+void Ring_CloseProducer (struct ring_producer* producer)
+{
+    UnmapViewOfFile(producer->header);
+    CloseHandle(producer->wake_event);
+    CloseHandle(producer->mapping);
+}
+
+int Ring_Write (struct ring_producer* producer, void* data, unsigned int length)
+{
+    struct ring_header* header;
+    struct ring_record* record;
+    LONG                position;
+
+    header = producer->header;
+
+    if(length > header->record_size)
+        return RING_ERROR_MISMATCH;
+
+    position = header->reserve_index;
+
+    while(1)
+    {
+        LONG sequence;
+
+        record   = RING_RECORD(header, position);
+        sequence = record->sequence;
+
+        if(sequence == position)
+        {
+            LONG claimed_position;
+
+            claimed_position = InterlockedCompareExchange(&header->reserve_index, position+1, position);
+            if(claimed_position == position)
+                break;
+
+            position = claimed_position;
+        }
+        else if(sequence-position < 0)
+            return RING_ERROR_FULL;
+        else
+            position = header->reserve_index;
+    }
+
+    memcpy(record+1, data, length);
+
+    record->length = length;
+
+    InterlockedExchange(&record->sequence, position+1);
+
+    /* The reader asked to be woken, only one producer needs to do it */
+    if(header->waiting != 0 && InterlockedExchange(&header->waiting, 0) != 0)
+        SetEvent(producer->wake_event);
+
+    return RING_ERROR_NONE;
+}
+
+void Ring_SetInt (void* record, unsigned int slot, long long value)
+{
+    memcpy((char*)record+slot*RING_SLOT_SIZE, &value, sizeof(value));
+}
+
+void Ring_SetReal (void* record, unsigned int slot, double value)
+{
+    memcpy((char*)record+slot*RING_SLOT_SIZE, &value, sizeof(value));
+}
+
+void Ring_SetString (void* record, unsigned int slot, char* text, unsigned int record_size)
+{
+    char*        destination;
+    unsigned int offset;
+    unsigned int length;
+
+    offset = slot*RING_SLOT_SIZE;
+    if(offset >= record_size)
+        return;
+
+    destination = (char*)record+offset;
+    length      = (unsigned int)strlen(text);
+
+    if(length >= record_size-offset)
+        length = record_size-offset-1;
+
+    memcpy(destination, text, length);
+
+    destination[length] = 0;
+}
@@ -0,0 +1,647 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#include <ring/ring.h>
+#include <ring/init.h>
+#include <ring/error.h>
+
+#include <tsffi/error.h>
+#include <ffilib/idhash.h>
+#include <ffilib/signal.h>
+#include <ffilib/error.h>
+
+#include <stdio.h>
+#include <string.h>
+
+
+#define MAX_EXCEPTION_TEXT_LENGTH 1024
+
+#define RING_MIN_RECORD_COUNT 2
+
+/* The whole ring is mapped into a 32 bit process, keep it well short of
+   the address space */
+#define RING_MAX_MAPPING_SIZE (256*1024*1024)
+
+
+static int  OpenMapping   (char*, unsigned int, unsigned int, struct ring_data*);
+static int  ClaimReader   (struct ring_header*);
+static void ReleaseReader (struct ring_header*);
+static int  TakeRecord    (struct ring_data*);
+static int  AcquireRecord (struct ring_data*);
+static void RingWoken     (void*);
+
+static void              RaiseException (struct tsffi_invocation_data*, char*);
+static struct ring_data* HandleRing     (struct tsffi_invocation_data*, void*, int);
+static char*             RecordSlot     (struct ring_data*, int, unsigned int);
+static void              FreeRing       (struct ring_data*, struct tsffi_execif*, void*);
+
+
+static int OpenMapping (
+                        char*             name,
+                        unsigned int      record_size,
+                        unsigned int      record_count,
+                        struct ring_data* ring_data
+                       )
+{
+    char                event_name[RING_MAX_NAME];
+    HANDLE              mapping;
+    HANDLE              wake_event;
+    struct ring_header* header;
+    unsigned long long  mapping_size;
+    int                 existed;
+    int                 error;
+
+    error        = RING_ERROR_SYSTEM_CALL;
+    mapping_size = RING_MAPPING_SIZE(record_size, record_count);
+
+    mapping = CreateFileMapping(
+                                INVALID_HANDLE_VALUE,
+                                NULL,
+                                PAGE_READWRITE,
+                                (DWORD)(mapping_size>>32),
+                                (DWORD)mapping_size,
+                                name
+                               );
+    if(mapping == NULL)
+        goto create_mapping_failed;
+
+    existed = GetLastError() == ERROR_ALREADY_EXISTS;
+
+    header = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)mapping_size);
+    if(header == NULL)
+        goto map_view_failed;
+
+    if(existed)
+    {
+        DWORD start_time;
+
+        /* The creator may still be laying the ring out */
+        start_time = GetTickCount();
+
+        while(
+              *(volatile unsigned int*)&header->magic == 0 &&
+              GetTickCount()-start_time < RING_INIT_TIMEOUT
+             )
+        {
+            SwitchToThread();
+        }
+
+        MemoryBarrier();
+
+        /* Another script or a producer already laid the ring out, it is
+           only usable if both sides agree on the record layout */
+        if(
+           header->magic != RING_MAGIC         ||
+           header->version != RING_VERSION     ||
+           header->record_size != record_size  ||
+           header->record_count != record_count
+          )
+        {
+            error = RING_ERROR_MISMATCH;
+
+            goto check_header_failed;
+        }
+
+        error = ClaimReader(header);
+        if(error != RING_ERROR_NONE)
+            goto check_header_failed;
+
+        error = RING_ERROR_SYSTEM_CALL;
+    }
+    else
+    {
+        unsigned int position;
+
+        header->record_size   = record_size;
+        header->record_count  = record_count;
+        header->waiting       = 0;
+        header->reader        = (LONG)GetCurrentProcessId();
+        header->reserve_index = 0;
+        header->read_index    = 0;
+
+        for(position = 0; position < record_count; position++)
+        {
+            struct ring_record* record;
+
+            record = RING_RECORD(header, position);
+
+            record->sequence = position;
+            record->length   = 0;
+        }
+
+        header->version = RING_VERSION;
+
+        /* Producers check the magic before anything else, publish it last */
+        MemoryBarrier();
+
+        header->magic = RING_MAGIC;
+    }
+
+    _snprintf(event_name, RING_MAX_NAME, "%s%s", name, RING_EVENT_SUFFIX);
+
+    event_name[RING_MAX_NAME-1] = 0;
+
+    wake_event = CreateEvent(NULL, FALSE, FALSE, event_name);
+    if(wake_event == NULL)
+        goto create_event_failed;
+
+    ring_data->mapping    = mapping;
+    ring_data->wake_event = wake_event;
+    ring_data->header     = header;
+
+    return RING_ERROR_NONE;
+
+create_event_failed:
+    ReleaseReader(header);
+check_header_failed:
+    UnmapViewOfFile(header);
+map_view_failed:
+    CloseHandle(mapping);
+
+create_mapping_failed:
+    return error;
+}
+
+static int ClaimReader (struct ring_header* header)
+{
+    LONG process_id;
+    LONG reader;
+
+    process_id = (LONG)GetCurrentProcessId();
+    reader     = 0;
+
+    while(1)
+    {
+        HANDLE process;
+        LONG   claimed_reader;
+        int    alive;
+
+        claimed_reader = InterlockedCompareExchange(&header->reader, process_id, reader);
+        if(claimed_reader == reader)
+            return RING_ERROR_NONE;
+
+        reader = claimed_reader;
+
+        /* A second ring() on the same name in this process would be a
+           second reader as well */
+        if(reader == process_id)
+            return RING_ERROR_BUSY;
+
+        /* A reader that exited without closing the ring leaves its claim
+           behind, take it over */
+        process = OpenProcess(SYNCHRONIZE, FALSE, (DWORD)reader);
+        if(process != NULL)
+        {
+            alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+
+            CloseHandle(process);
+        }
+        else
+            alive = GetLastError() != ERROR_INVALID_PARAMETER;
+
+        if(alive)
+            return RING_ERROR_BUSY;
+    }
+}
+
+static void ReleaseReader (struct ring_header* header)
+{
+    InterlockedCompareExchange(&header->reader, 0, (LONG)GetCurrentProcessId());
+}
+
+static int TakeRecord (struct ring_data* ring_data)
+{
+    struct ring_header* header;
+    struct ring_record* record;
+    LONG                position;
+    unsigned int        length;
+
+    header   = ring_data->header;
+    position = header->read_index;
+    record   = RING_RECORD(header, position);
+
+    if(record->sequence != position+1)
+        return 0;
+
+    length = record->length;
+    if(length > header->record_size)
+        length = header->record_size;
+
+    memcpy(ring_data->record, record+1, length);
+
+    ring_data->record_length = length;
+
+    /* Hand the record back to producers for the next lap */
+    InterlockedExchange(&record->sequence, position+header->record_count);
+    InterlockedExchange(&header->read_index, position+1);
+
+    return 1;
+}
+
+static int AcquireRecord (struct ring_data* ring_data)
+{
+    if(ring_data->flags&RING_FLAG_TRIGGERED)
+        return 1;
+
+    if(!TakeRecord(ring_data))
+    {
+        /* Ask for a wakeup, then look again in case a producer published
+           before it could see the request */
+        InterlockedExchange(&ring_data->header->waiting, 1);
+
+        if(!TakeRecord(ring_data))
+            return 0;
+
+        InterlockedExchange(&ring_data->header->waiting, 0);
+    }
+
+    ring_data->flags |= RING_FLAG_TRIGGERED;
+
+    return 1;
+}
+
+static void RingWoken (void* user_data)
+{
+    struct ring_data* ring_data;
+
+    ring_data = user_data;
+
+    if(ring_data->action_data != NULL)
+        FFILib_SignalAction(ring_data->action_data);
+}
+
+static void RaiseException (struct tsffi_invocation_data* invocation_data, char* message)
+{
+    char text[MAX_EXCEPTION_TEXT_LENGTH];
+
+    _snprintf(
+              text,
+              MAX_EXCEPTION_TEXT_LENGTH,
+              "function=%s line=%d: %s",
+              invocation_data->unit_name,
+              invocation_data->unit_location,
+              message
+             );
+
+    text[MAX_EXCEPTION_TEXT_LENGTH-1] = 0;
+
+    invocation_data->execif->set_exception_text(invocation_data->execif_data, text);
+}
+
+static struct ring_data* HandleRing (
+                                     struct tsffi_invocation_data* invocation_data,
+                                     void*                         group_data,
+                                     int                           handle
+                                    )
+{
+    struct ring_module_data* module_data;
+    struct ring_data*        ring_data;
+
+    module_data = group_data;
+    ring_data   = FFILib_GetIDData(handle, &module_data->ring_hash);
+    if(ring_data == NULL)
+    {
+        RaiseException(
+                       invocation_data,
+                       "Attempting to use a ring with an invalid handle, retrieve a handle by calling 'ring()'"
+                      );
+    }
+
+    return ring_data;
+}
+
+static char* RecordSlot (struct ring_data* ring_data, int slot, unsigned int minimum_size)
+{
+    unsigned int offset;
+
+    if(!(ring_data->flags&RING_FLAG_TRIGGERED) || slot < 0)
+        return NULL;
+
+    if((unsigned int)slot >= ring_data->record_length/RING_SLOT_SIZE+1)
+        return NULL;
+
+    offset = (unsigned int)slot*RING_SLOT_SIZE;
+    if(offset+minimum_size > ring_data->record_length)
+        return NULL;
+
+    return &ring_data->record[offset];
+}
+
+static void FreeRing (
+                      struct ring_data*    ring_data,
+                      struct tsffi_execif* execif,
+                      void*                execif_data
+                     )
+{
+    if(ring_data->wake_watch != NULL)
+        execif->cancel_registration(execif_data, ring_data->wake_watch);
+
+    ReleaseReader(ring_data->header);
+    UnmapViewOfFile(ring_data->header);
+    CloseHandle(ring_data->wake_event);
+    CloseHandle(ring_data->mapping);
+
+    free(ring_data->record);
+    free(ring_data);
+}
+
+
+void Ring_DestroyRings (
+                        struct ring_module_data* module_data,
+                        struct tsffi_execif*     execif,
+                        void*                    execif_data
+                       )
+{
+    struct ring_data* rings;
+
+    rings = module_data->open_rings;
+
+    while(rings != NULL)
+    {
+        struct ring_data* free_ring;
+
+        free_ring = rings;
+        rings     = rings->next_ring;
+
+        FreeRing(free_ring, execif, execif_data);
+    }
+}
+
+int Ring_Ring (
+               struct tsffi_invocation_data* invocation_data,
+               void*                         group_data,
+               union tsffi_value*            output,
+               union tsffi_value*            input
+              )
+{
+    struct ring_module_data* module_data;
+    struct ring_data*        ring_data;
+    unsigned int             record_size;
+    unsigned int             record_count;
+    int                      error;
+
+    module_data = group_data;
+
+    if(input[1].int_data <= 0 || input[2].int_data <= 0)
+    {
+        RaiseException(invocation_data, "A ring needs a positive record size and record count");
+
+        goto check_arguments_failed;
+    }
+
+    record_size  = ((unsigned int)input[1].int_data+RING_SLOT_SIZE-1)&~(RING_SLOT_SIZE-1);
+    record_count = RING_MIN_RECORD_COUNT;
+
+    while(record_count < (unsigned int)input[2].int_data)
+        record_count <<= 1;
+
+    if(RING_MAPPING_SIZE(record_size, record_count) > RING_MAX_MAPPING_SIZE)
+    {
+        RaiseException(invocation_data, "A ring may not be larger than 256 MB");
+
+        goto check_arguments_failed;
+    }
+
+    ring_data = malloc(sizeof(struct ring_data));
+    if(ring_data == NULL)
+        goto allocate_ring_failed;
+
+    ring_data->record = malloc(record_size);
+    if(ring_data->record == NULL)
+        goto allocate_record_failed;
+
+    error = OpenMapping((char*)input[0].string_data, record_size, record_count, ring_data);
+    if(error != RING_ERROR_NONE)
+    {
+        if(error == RING_ERROR_MISMATCH)
+            RaiseException(invocation_data, "A ring with this name already exists with a different record layout");
+        else if(error == RING_ERROR_BUSY)
+            RaiseException(invocation_data, "A ring with this name is already being read, a ring may only have one reader");
+        else
+            RaiseException(invocation_data, "The ring could not be created");
+
+        goto open_mapping_failed;
+    }
+
+    ring_data->ring_id       = module_data->next_ring_id;
+    ring_data->flags         = 0;
+    ring_data->record_length = 0;
+    ring_data->wake_watch    = NULL;
+    ring_data->action_data   = NULL;
+
+    error = FFILib_AddID(ring_data->ring_id, ring_data, &module_data->ring_hash);
+    if(error != FFILIB_ERROR_NONE)
+        goto add_id_failed;
+
+    module_data->next_ring_id++;
+
+    ring_data->next_ring    = module_data->open_rings;
+    module_data->open_rings = ring_data;
+
+    output->int_data = ring_data->ring_id;
+
+    return TSFFI_ERROR_NONE;
+
+add_id_failed:
+    ReleaseReader(ring_data->header);
+    UnmapViewOfFile(ring_data->header);
+    CloseHandle(ring_data->wake_event);
+    CloseHandle(ring_data->mapping);
+open_mapping_failed:
+    free(ring_data->record);
+allocate_record_failed:
+    free(ring_data);
+
+allocate_ring_failed:
+check_arguments_failed:
+    return TSFFI_ERROR_EXCEPTION;
+}
+
+int Ring_ReadInt (
+                  struct tsffi_invocation_data* invocation_data,
+                  void*                         group_data,
+                  union tsffi_value*            output,
+                  union tsffi_value*            input
+                 )
+{
+    struct ring_data* ring_data;
+    char*             slot;
+    long long         value;
+
+    ring_data = HandleRing(invocation_data, group_data, input[0].int_data);
+    if(ring_data == NULL)
+        return TSFFI_ERROR_EXCEPTION;
+
+    slot = RecordSlot(ring_data, input[1].int_data, sizeof(value));
+    if(slot == NULL)
+        value = 0;
+    else
+        memcpy(&value, slot, sizeof(value));
+
+    output->int_data = (tsffi_int)value;
+
+    return TSFFI_ERROR_NONE;
+}
+
+int Ring_ReadReal (
+                   struct tsffi_invocation_data* invocation_data,
+                   void*                         group_data,
+                   union tsffi_value*            output,
+                   union tsffi_value*            input
+                  )
+{
+    struct ring_data* ring_data;
+    char*             slot;
+    double            value;
+
+    ring_data = HandleRing(invocation_data, group_data, input[0].int_data);
+    if(ring_data == NULL)
+        return TSFFI_ERROR_EXCEPTION;
+
+    slot = RecordSlot(ring_data, input[1].int_data, sizeof(value));
+    if(slot == NULL)
+        value = 0.0;
+    else
+        memcpy(&value, slot, sizeof(value));
+
+    output->real_data = (tsffi_real)value;
+
+    return TSFFI_ERROR_NONE;
+}
+
+int Ring_ReadString (
+                     struct tsffi_invocation_data* invocation_data,
+                     void*                         group_data,
+                     union tsffi_value*            output,
+                     union tsffi_value*            input
+                    )
+{
+    struct ring_data* ring_data;
+    char*             slot;
+    char*             text;
+    unsigned int      length;
+
+    ring_data = HandleRing(invocation_data, group_data, input[0].int_data);
+    if(ring_data == NULL)
+        return TSFFI_ERROR_EXCEPTION;
+
+    length = 0;
+    slot   = RecordSlot(ring_data, input[1].int_data, 0);
+
+    if(slot != NULL)
+    {
+        unsigned int remaining;
+
+        remaining = ring_data->record_length-(unsigned int)(slot-ring_data->record);
+
+        while(length < remaining && slot[length] != 0)
+            length++;
+    }
+
+    text = invocation_data->execif->allocate_memory(invocation_data->execif_data, length+1);
+    if(text == NULL)
+        return TSFFI_ERROR_EXCEPTION;
+
+    if(length != 0)
+        memcpy(text, slot, length);
+
+    text[length] = 0;
+
+    output->string_data = (tsffi_string)text;
+
+    return TSFFI_ERROR_NONE;
+}
+
+int Ring_Action_ListenRing (
+                            struct tsffi_invocation_data* action_data,
+                            unsigned int                  request,
+                            void*                         group_data,
+                            union tsffi_value*            input,
+                            unsigned int*                 state,
+                            void**                        user_action_data
+                           )
+{
+    struct ring_data* ring_data;
+
+    if(request == TSFFI_INIT_ACTION)
+    {
+        ring_data = HandleRing(action_data, group_data, input[0].int_data);
+        if(ring_data == NULL)
+            return TSFFI_ERROR_EXCEPTION;
+
+        *user_action_data = ring_data;
+    }
+    else
+        ring_data = *user_action_data;
+
+    switch(request)
+    {
+    case TSFFI_INIT_ACTION:
+        /* The wake watch and the record being read belong to the ring, a
+           second listener would steal both from the first */
+        if(ring_data->action_data != NULL)
+        {
+            RaiseException(action_data, "The ring is already being listened to, a ring may only have one listener");
+
+            return TSFFI_ERROR_EXCEPTION;
+        }
+
+        ring_data->wake_watch = action_data->execif->watch_handle(
+                                                                  action_data->execif_data,
+                                                                  ring_data->wake_event,
+                                                                  &RingWoken,
+                                                                  ring_data
+                                                                 );
+        if(ring_data->wake_watch == NULL)
+        {
+            RaiseException(action_data, "The ring's wake event could not be watched");
+
+            return TSFFI_ERROR_EXCEPTION;
+        }
+
+        ring_data->action_data = action_data;
+
+        if(AcquireRecord(ring_data))
+            FFILib_SignalAction(action_data);
+
+        break;
+
+    case TSFFI_RUNNING_ACTION:
+        break;
+
+    case TSFFI_UPDATE_ACTION:
+        ring_data->flags &= ~RING_FLAG_TRIGGERED;
+
+        if(AcquireRecord(ring_data))
+            FFILib_SignalAction(action_data);
+
+        break;
+
+    case TSFFI_QUERY_ACTION:
+        if(AcquireRecord(ring_data))
+            *state = TSFFI_ACTION_STATE_TRIGGERED;
+        else
+            *state = TSFFI_ACTION_STATE_PENDING;
+
+        break;
+
+    case TSFFI_STOP_ACTION:
+        if(ring_data->wake_watch != NULL)
+        {
+            action_data->execif->cancel_registration(action_data->execif_data, ring_data->wake_watch);
+
+            ring_data->wake_watch = NULL;
+        }
+
+        ring_data->action_data = NULL;
+
+        break;
+    }
+
+    return TSFFI_ERROR_NONE;
+}
@@ -0,0 +1,17 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#ifndef _TIME_ERROR_H_
+#define _TIME_ERROR_H_
+
+
+#define TIME_ERROR_NONE         0
+#define TIME_ERROR_SYSTEM_CALL -1
+
+
+#endif
@@ -13,18 +13,24 @@
 #include <tsffi/function.h>
 
 
-extern int Time_Time  (
-                       struct tsffi_invocation_data*,
-                       void*,
-                       union tsffi_value*,
-                       union tsffi_value*
-                      );
-extern int Time_Delay (
-                       struct tsffi_invocation_data*,
-                       void*,
-                       union tsffi_value*,
-                       union tsffi_value*
-                      );
+extern int Time_Time     (
+                          struct tsffi_invocation_data*,
+                          void*,
+                          union tsffi_value*,
+                          union tsffi_value*
+                         );
+extern int Time_WallTime (
+                          struct tsffi_invocation_data*,
+                          void*,
+                          union tsffi_value*,
+                          union tsffi_value*
+                         );
+extern int Time_Delay    (
+                          struct tsffi_invocation_data*,
+                          void*,
+                          union tsffi_value*,
+                          union tsffi_value*
+                         );
 
 
 #endif
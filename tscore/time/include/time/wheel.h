@@ -0,0 +1,41 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#ifndef _TIME_WHEEL_H_
+#define _TIME_WHEEL_H_
+
+
+#define TIME_WHEEL_LEVEL_COUNT 4
+#define TIME_WHEEL_SLOT_BITS   8
+#define TIME_WHEEL_SLOT_COUNT  (1<<TIME_WHEEL_SLOT_BITS)
+
+
+struct time_wheel_entry;
+
+typedef void (*time_wheel_callback) (struct time_wheel_entry*);
+
+struct time_wheel_entry
+{
+    struct time_wheel_entry* next_entry;
+    struct time_wheel_entry* previous_entry;
+
+    unsigned int expiry;
+    unsigned int period;
+
+    time_wheel_callback callback;
+    void*               data;
+};
+
+
+extern void Time_InitializeWheelEntry (struct time_wheel_entry*, time_wheel_callback, void*);
+
+extern int  Time_ScheduleWheelEntry (struct time_wheel_entry*, unsigned int, unsigned int);
+extern void Time_CancelWheelEntry   (struct time_wheel_entry*);
+
+
+#endif
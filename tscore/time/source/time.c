@@ -9,12 +9,76 @@
 #include <time/time.h>
 
 #include <tsffi/error.h>
+#include <tsffi/execif.h>
 
 #include <windows.h>
+#include <stdlib.h>
 
 
 #define FILETIME_TO_MS_COEFFICIENT (double)(1.0/10000.0)
 
+#define MS_PER_SECOND 1000.0
+
+
+struct delay_data
+{
+    struct tsffi_execif* execif;
+    void*                execif_data;
+
+    void* timer;
+    void* resume_token;
+};
+
+
+static LONGLONG CounterFrequency (void);
+
+static void DelayElapsed  (void*);
+static void DelayCanceled (void*);
+
+
+static LONGLONG counter_frequency;
+
+
+static LONGLONG CounterFrequency (void)
+{
+    LARGE_INTEGER frequency;
+
+    /* The frequency is fixed at boot, so racing threads all store the
+       same value */
+    if(counter_frequency == 0)
+    {
+        QueryPerformanceFrequency(&frequency);
+
+        counter_frequency = frequency.QuadPart;
+    }
+
+    return counter_frequency;
+}
+
+static void DelayElapsed (void* user_data)
+{
+    struct delay_data* data;
+
+    data = user_data;
+
+    data->execif->cancel_registration(data->execif_data, data->timer);
+    data->execif->resume_unit(data->execif_data, data->resume_token);
+
+    free(data);
+}
+
+static void DelayCanceled (void* user_data)
+{
+    struct delay_data* data;
+
+    data = user_data;
+
+    data->execif->cancel_registration(data->execif_data, data->timer);
+
+    free(data);
+}
+
+
 
 int Time_Time (
                struct tsffi_invocation_data* invocation_data,
@@ -22,14 +86,54 @@ int Time_Time (
                union tsffi_value*            output,
                union tsffi_value*            input
               )
+{
+    struct tsffi_execif* execif;
+    LARGE_INTEGER        counter;
+    LONGLONG             frequency;
+
+    /* A module in virtual time reads its own clock, which counts from
+       zero at the start of the module */
+    execif = invocation_data->execif;
+    if(execif->read_clock != NULL)
+    {
+        unsigned int clock;
+        int          clock_type;
+
+        clock_type = execif->read_clock(invocation_data->execif_data, &clock);
+        if(clock_type == TSFFI_CLOCK_VIRTUAL)
+        {
+            output->real_data = (tsffi_real)clock;
+
+            return TSFFI_ERROR_NONE;
+        }
+    }
+
+    frequency = CounterFrequency();
+
+    QueryPerformanceCounter(&counter);
+
+    /* Split the conversion so a large count keeps its sub-millisecond
+       digits */
+    output->real_data = (tsffi_real)(
+                                     (double)(counter.QuadPart/frequency)*MS_PER_SECOND+
+                                     (double)(counter.QuadPart%frequency)*MS_PER_SECOND/(double)frequency
+                                    );
+
+    return TSFFI_ERROR_NONE;
+}
+
+int Time_WallTime (
+                   struct tsffi_invocation_data* invocation_data,
+                   void*                         group_data,
+                   union tsffi_value*            output,
+                   union tsffi_value*            input
+                  )
 {
     ULARGE_INTEGER large_int;
-    SYSTEMTIME     system_time;
     FILETIME       file_time;
     double         time_ms;
 
-    GetSystemTime(&system_time);
-    SystemTimeToFileTime(&system_time, &file_time);
+    GetSystemTimeAsFileTime(&file_time);
 
     large_int.u.HighPart = file_time.dwHighDateTime;
     large_int.u.LowPart  = file_time.dwLowDateTime;
@@ -48,13 +152,48 @@ int Time_Delay (
                 union tsffi_value*            input
                )
 {
-    DWORD sleep_time;
+    struct tsffi_execif* execif;
+    struct delay_data*   data;
+    DWORD                sleep_time;
 
     sleep_time = (DWORD)input->real_data;
+    if(sleep_time == 0)
+        return TSFFI_ERROR_NONE;
+
+    /* Park the calling unit on an interpreter timer so other actions keep
+       running, and only block when the call can't be suspended */
+    execif = invocation_data->execif;
+
+    data = malloc(sizeof(struct delay_data));
+    if(data == NULL)
+        goto allocate_data_failed;
+
+    data->execif      = execif;
+    data->execif_data = invocation_data->execif_data;
+
+    data->timer = execif->start_timer(
+                                      invocation_data->execif_data,
+                                      sleep_time,
+                                      TSFFI_TIMER_ONCE,
+                                      &DelayElapsed,
+                                      data
+                                     );
+    if(data->timer == NULL)
+        goto start_timer_failed;
+
+    data->resume_token = execif->suspend_unit(invocation_data, &DelayCanceled, data);
+    if(data->resume_token == NULL)
+        goto suspend_unit_failed;
 
-    if(sleep_time > 0)
-        Sleep(sleep_time);
+    return TSFFI_ERROR_NONE;
+
+suspend_unit_failed:
+    execif->cancel_registration(invocation_data->execif_data, data->timer);
+start_timer_failed:
+    free(data);
+
+allocate_data_failed:
+    Sleep(sleep_time);
 
     return TSFFI_ERROR_NONE;
 }
-
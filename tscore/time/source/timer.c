@@ -7,11 +7,13 @@
  */
 
 #include <time/timer.h>
+#include <time/wheel.h>
+#include <time/error.h>
 
 #include <tsffi/error.h>
+#include <tsffi/execif.h>
 #include <ffilib/thread.h>
 #include <ffilib/module.h>
-#include <ffilib/idhash.h>
 #include <ffilib/error.h>
 
 #include <windows.h>
@@ -28,47 +30,135 @@
 struct timer_data
 {
     struct tsffi_invocation_data* action_data;
+    void**                        trigger_data;
 
-    unsigned int flags;
-    unsigned int timer_id;
+    unsigned int            flags;
+    unsigned int            clock;
+    struct time_wheel_entry wheel_entry;
+    void*                   reactor_timer;
 };
 
 
-static VOID CALLBACK TimerEvent (HWND, UINT, UINT_PTR, DWORD);
+static int          ClockOf     (struct tsffi_invocation_data*);
+static unsigned int TimerState  (struct timer_data*);
+static void         SignalState (struct timer_data*);
 
+static int  StartTimer (struct timer_data*, unsigned int, unsigned int);
+static void StopTimer  (struct timer_data*);
 
-FFILIB_DECLARE_STATIC_ID_HASH(timer_id_hash);
+static void TimerFired          (struct timer_data*);
+static void WheelTimerExpired   (struct time_wheel_entry*);
+static void ReactorTimerExpired (void*);
 
 
-static VOID CALLBACK TimerEvent (
-                                 HWND     window_handle,
-                                 UINT     message,
-                                 UINT_PTR timer_id,
-                                 DWORD    time_ellapsed
-                                )
+static int ClockOf (struct tsffi_invocation_data* action_data)
 {
-    struct timer_data* data;
+    unsigned int clock;
+
+    /* Only real time controllers are ever switched to the control thread,
+       and the module clock can't be read from there */
+    if(GetCurrentThreadId() == ffilib_control_thread.thread_id)
+        return TSFFI_CLOCK_REAL;
+
+    if(action_data->execif->read_clock == NULL)
+        return TSFFI_CLOCK_REAL;
+
+    return action_data->execif->read_clock(action_data->execif_data, &clock);
+}
+
+
+static unsigned int TimerState (struct timer_data* data)
+{
+    if(data->flags&TIMER_FLAG_FINISHED)
+        return TSFFI_ACTION_STATE_FINISHED;
+    else if(data->flags&TIMER_FLAG_TRIGGERED)
+        return TSFFI_ACTION_STATE_TRIGGERED;
+
+    return TSFFI_ACTION_STATE_PENDING;
+}
+
+static void SignalState (struct timer_data* data)
+{
+    struct tsffi_invocation_data* action_data;
+
+    action_data = data->action_data;
 
-    data = FFILib_GetIDData(timer_id, &timer_id_hash);
+    action_data->execif->signal_action_state(action_data->execif_data, data->trigger_data, TimerState(data));
+}
 
+/* Timers of a module running in virtual time have to follow its clock,
+   so they are kept on the interpreter's reactor instead of the wheel */
+static int StartTimer (struct timer_data* data, unsigned int delay, unsigned int period)
+{
+    struct tsffi_invocation_data* action_data;
+
+    if(data->clock == TSFFI_CLOCK_REAL)
+        return Time_ScheduleWheelEntry(&data->wheel_entry, delay, period);
+
+    action_data = data->action_data;
+
+    data->reactor_timer = action_data->execif->start_timer(
+                                                           action_data->execif_data,
+                                                           delay,
+                                                           period != 0 ? TSFFI_TIMER_PERIODIC : TSFFI_TIMER_ONCE,
+                                                           &ReactorTimerExpired,
+                                                           data
+                                                          );
+    if(data->reactor_timer == NULL)
+        return TIME_ERROR_SYSTEM_CALL;
+
+    return TIME_ERROR_NONE;
+}
+
+static void StopTimer (struct timer_data* data)
+{
+    struct tsffi_invocation_data* action_data;
+
+    if(data->clock == TSFFI_CLOCK_REAL)
+    {
+        Time_CancelWheelEntry(&data->wheel_entry);
+
+        return;
+    }
+
+    if(data->reactor_timer == NULL)
+        return;
+
+    action_data = data->action_data;
+
+    action_data->execif->cancel_registration(action_data->execif_data, data->reactor_timer);
+
+    data->reactor_timer = NULL;
+}
+
+static void TimerFired (struct timer_data* data)
+{
     if(data->flags&TIMER_FLAG_RUNNING)
         data->flags |= TIMER_FLAG_TRIGGERED_WAIT;
     else
     {
-        struct tsffi_invocation_data* action_data;
-
         data->flags |= TIMER_FLAG_TRIGGERED;
 
-        action_data = data->action_data;
-
-        action_data->execif->signal_action(data->action_data->execif_data);
+        SignalState(data);
     }
+}
 
+static void WheelTimerExpired (struct time_wheel_entry* entry)
+{
+    TimerFired(entry->data);
+}
+
+static void ReactorTimerExpired (void* user_data)
+{
+    struct timer_data* data;
+
+    data = user_data;
+
+    /* One shot reactor timers stay registered until they are cancelled */
     if(!(data->flags&TIMER_FLAG_PERIODIC))
-    {
-        KillTimer(NULL, timer_id);
-        FFILib_RemoveID(data->timer_id, &timer_id_hash);
-    }
+        StopTimer(data);
+
+    TimerFired(data);
 }
 
 
@@ -86,21 +176,25 @@ int Time_Action_Timer (
     int                delay;
     int                result;
 
-    error = FFILib_SynchronousFFIAction(
-                                        &Time_Action_Timer,
-                                        action_data,
-                                        request,
-                                        group_data,
-                                        input,
-                                        state,
-                                        user_action_data,
-                                        &ffilib_control_thread,
-                                        &result
-                                       );
-    if(error == FFILIB_ERROR_NONE)
-        return result;
-    else if(error != FFILIB_ERROR_THREAD_SWITCH)
-        return TSFFI_ERROR_EXCEPTION;
+    /* In virtual time the timer lives on the module thread's reactor */
+    if(ClockOf(action_data) == TSFFI_CLOCK_REAL)
+    {
+        error = FFILib_SynchronousFFIAction(
+                                            &Time_Action_Timer,
+                                            action_data,
+                                            request,
+                                            group_data,
+                                            input,
+                                            state,
+                                            user_action_data,
+                                            &ffilib_control_thread,
+                                            &result
+                                           );
+        if(error == FFILIB_ERROR_NONE)
+            return result;
+        else if(error != FFILIB_ERROR_THREAD_SWITCH)
+            return TSFFI_ERROR_EXCEPTION;
+    }
 
     switch(request)
     {
@@ -109,31 +203,28 @@ int Time_Action_Timer (
         if(data == NULL)
             return TSFFI_ERROR_EXCEPTION;
 
-        data->action_data = action_data;
+        data->action_data  = action_data;
+        data->trigger_data = user_action_data;
+
+        data->clock         = ClockOf(action_data);
+        data->reactor_timer = NULL;
+
+        Time_InitializeWheelEntry(&data->wheel_entry, &WheelTimerExpired, data);
 
         delay = (int)input->real_data;
         if(delay < 0)
         {
             data->flags = TIMER_FLAG_FINISHED;
 
-            action_data->execif->signal_action(action_data->execif_data);
+            SignalState(data);
         }
         else
         {
             data->flags = 0;
 
-            data->timer_id = SetTimer(
-                                      NULL,
-                                      0,
-                                      (unsigned int)delay,
-                                      &TimerEvent
-                                     );
-            if(data->timer_id == 0)
-                goto set_timer_failed;
-
-            error = FFILib_AddID(data->timer_id, data, &timer_id_hash);
-            if(error != FFILIB_ERROR_NONE)
-                goto add_id_failed;
+            error = StartTimer(data, (unsigned int)delay, 0);
+            if(error != TIME_ERROR_NONE)
+                goto schedule_failed;
         }
 
         *user_action_data = data;
@@ -154,25 +245,17 @@ int Time_Action_Timer (
 
         if(data->flags&TIMER_FLAG_TRIGGERED)
         {
-            struct tsffi_invocation_data* action_data;
-
             data->flags ^= TIMER_FLAG_TRIGGERED;
             data->flags |= TIMER_FLAG_FINISHED;
 
-            action_data = data->action_data;
-
-            action_data->execif->signal_action(data->action_data->execif_data);
+            SignalState(data);
         }
         else if(data->flags&TIMER_FLAG_TRIGGERED_WAIT)
         {
-            struct tsffi_invocation_data* action_data;
-
             data->flags ^= TIMER_FLAG_TRIGGERED_WAIT;
             data->flags |= TIMER_FLAG_TRIGGERED;
 
-            action_data = data->action_data;
-
-            action_data->execif->signal_action(data->action_data->execif_data);
+            SignalState(data);
         }
 
         break;
@@ -180,23 +263,14 @@ int Time_Action_Timer (
     case TSFFI_QUERY_ACTION:
         data = (struct timer_data*)*user_action_data;
 
-        if(data->flags&TIMER_FLAG_FINISHED)
-            *state = TSFFI_ACTION_STATE_FINISHED;
-        else if(data->flags&TIMER_FLAG_TRIGGERED)
-            *state = TSFFI_ACTION_STATE_TRIGGERED;
-        else
-            *state = TSFFI_ACTION_STATE_PENDING;
+        *state = TimerState(data);
 
         break;
 
     case TSFFI_STOP_ACTION:
         data = (struct timer_data*)*user_action_data;
 
-        if(!(data->flags&(TIMER_FLAG_FINISHED|TIMER_FLAG_TRIGGERED|TIMER_FLAG_TRIGGERED_WAIT)))
-        {
-            KillTimer(NULL, data->timer_id);
-            FFILib_RemoveID(data->timer_id, &timer_id_hash);
-        }
+        StopTimer(data);
 
         free(data);
 
@@ -205,9 +279,7 @@ int Time_Action_Timer (
 
    return TSFFI_ERROR_NONE;
 
-add_id_failed:
-    KillTimer(NULL, data->timer_id);
-set_timer_failed:
+schedule_failed:
     free(data);
 
     return TSFFI_ERROR_EXCEPTION;
@@ -227,21 +299,25 @@ int Time_Action_PTimer (
     int                delay;
     int                result;
 
-    error = FFILib_SynchronousFFIAction(
-                                        &Time_Action_PTimer,
-                                        action_data,
-                                        request,
-                                        group_data,
-                                        input,
-                                        state,
-                                        user_action_data,
-                                        &ffilib_control_thread,
-                                        &result
-                                       );
-    if(error == FFILIB_ERROR_NONE)
-        return result;
-    else if(error != FFILIB_ERROR_THREAD_SWITCH)
-        return TSFFI_ERROR_EXCEPTION;
+    /* In virtual time the timer lives on the module thread's reactor */
+    if(ClockOf(action_data) == TSFFI_CLOCK_REAL)
+    {
+        error = FFILib_SynchronousFFIAction(
+                                            &Time_Action_PTimer,
+                                            action_data,
+                                            request,
+                                            group_data,
+                                            input,
+                                            state,
+                                            user_action_data,
+                                            &ffilib_control_thread,
+                                            &result
+                                           );
+        if(error == FFILIB_ERROR_NONE)
+            return result;
+        else if(error != FFILIB_ERROR_THREAD_SWITCH)
+            return TSFFI_ERROR_EXCEPTION;
+    }
 
     switch(request)
     {
@@ -250,31 +326,29 @@ int Time_Action_PTimer (
         if(data == NULL)
             return TSFFI_ERROR_EXCEPTION;
 
-        data->action_data = action_data;
+        data->action_data  = action_data;
+        data->trigger_data = user_action_data;
+
+        data->clock         = ClockOf(action_data);
+        data->reactor_timer = NULL;
+
+        Time_InitializeWheelEntry(&data->wheel_entry, &WheelTimerExpired, data);
 
         delay = (int)input->real_data;
         if(delay < 0)
         {
             data->flags = TIMER_FLAG_FINISHED;
 
-            action_data->execif->signal_action(action_data->execif_data);
+            SignalState(data);
         }
         else
         {
             data->flags = TIMER_FLAG_PERIODIC;
 
-            data->timer_id = SetTimer(
-                                      NULL,
-                                      0,
-                                      (unsigned int)delay,
-                                      &TimerEvent
-                                     );
-            if(data->timer_id == 0)
-                goto set_timer_failed;
-
-            error = FFILib_AddID(data->timer_id, data, &timer_id_hash);
-            if(error != FFILIB_ERROR_NONE)
-                goto add_id_failed;
+            /* A zero period would make the entry one shot */
+            error = StartTimer(data, (unsigned int)delay, delay == 0 ? 1 : (unsigned int)delay);
+            if(error != TIME_ERROR_NONE)
+                goto schedule_failed;
         }
 
         *user_action_data = data;
@@ -295,25 +369,17 @@ int Time_Action_PTimer (
 
         if(data->flags&TIMER_FLAG_TRIGGERED)
         {
-            struct tsffi_invocation_data* action_data;
-
             data->flags ^= TIMER_FLAG_TRIGGERED;
 
-            action_data = data->action_data;
-
-            action_data->execif->signal_action(data->action_data->execif_data);
+            SignalState(data);
         }
 
         if(data->flags&TIMER_FLAG_TRIGGERED_WAIT)
         {
-            struct tsffi_invocation_data* action_data;
-
             data->flags ^= TIMER_FLAG_TRIGGERED_WAIT;
             data->flags |= TIMER_FLAG_TRIGGERED;
 
-            action_data = data->action_data;
-
-            action_data->execif->signal_action(data->action_data->execif_data);
+            SignalState(data);
         }
 
         break;
@@ -321,23 +387,14 @@ int Time_Action_PTimer (
     case TSFFI_QUERY_ACTION:
         data = (struct timer_data*)*user_action_data;
 
-        if(data->flags&TIMER_FLAG_FINISHED)
-            *state = TSFFI_ACTION_STATE_FINISHED;
-        else if(data->flags&TIMER_FLAG_TRIGGERED)
-            *state = TSFFI_ACTION_STATE_TRIGGERED;
-        else
-            *state = TSFFI_ACTION_STATE_PENDING;
+        *state = TimerState(data);
 
         break;
 
     case TSFFI_STOP_ACTION:
         data = (struct timer_data*)*user_action_data;
 
-        if(!(data->flags&TIMER_FLAG_FINISHED))
-        {
-            KillTimer(NULL, data->timer_id);
-            FFILib_RemoveID(data->timer_id, &timer_id_hash);
-        }
+        StopTimer(data);
 
         free(data);
 
@@ -346,9 +403,7 @@ int Time_Action_PTimer (
 
    return TSFFI_ERROR_NONE;
 
-add_id_failed:
-    KillTimer(NULL, data->timer_id);
-set_timer_failed:
+schedule_failed:
     free(data);
 
     return TSFFI_ERROR_EXCEPTION;
@@ -368,21 +423,25 @@ int Time_Action_VTimer (
     int                delay;
     int                result;
 
-    error = FFILib_SynchronousFFIAction(
-                                        &Time_Action_VTimer,
-                                        action_data,
-                                        request,
-                                        group_data,
-                                        input,
-                                        state,
-                                        user_action_data,
-                                        &ffilib_control_thread,
-                                        &result
-                                       );
-    if(error == FFILIB_ERROR_NONE)
-        return result;
-    else if(error != FFILIB_ERROR_THREAD_SWITCH)
-        return TSFFI_ERROR_EXCEPTION;
+    /* In virtual time the timer lives on the module thread's reactor */
+    if(ClockOf(action_data) == TSFFI_CLOCK_REAL)
+    {
+        error = FFILib_SynchronousFFIAction(
+                                            &Time_Action_VTimer,
+                                            action_data,
+                                            request,
+                                            group_data,
+                                            input,
+                                            state,
+                                            user_action_data,
+                                            &ffilib_control_thread,
+                                            &result
+                                           );
+        if(error == FFILIB_ERROR_NONE)
+            return result;
+        else if(error != FFILIB_ERROR_THREAD_SWITCH)
+            return TSFFI_ERROR_EXCEPTION;
+    }
 
     switch(request)
     {
@@ -391,31 +450,28 @@ int Time_Action_VTimer (
         if(data == NULL)
             return TSFFI_ERROR_EXCEPTION;
 
-        data->action_data = action_data;
+        data->action_data  = action_data;
+        data->trigger_data = user_action_data;
+
+        data->clock         = ClockOf(action_data);
+        data->reactor_timer = NULL;
+
+        Time_InitializeWheelEntry(&data->wheel_entry, &WheelTimerExpired, data);
 
         delay = (int)input->real_data;
         if(delay < 0)
         {
             data->flags = TIMER_FLAG_FINISHED;
 
-            action_data->execif->signal_action(action_data->execif_data);
+            SignalState(data);
         }
         else
         {
             data->flags = 0;
 
-            data->timer_id = SetTimer(
-                                      NULL,
-                                      0,
-                                      (unsigned int)delay,
-                                      &TimerEvent
-                                     );
-            if(data->timer_id == 0)
-                goto set_timer_failed;
-
-            error = FFILib_AddID(data->timer_id, data, &timer_id_hash);
-            if(error != FFILIB_ERROR_NONE)
-                goto add_id_failed;
+            error = StartTimer(data, (unsigned int)delay, 0);
+            if(error != TIME_ERROR_NONE)
+                goto schedule_failed;
         }
 
         *user_action_data = data;
@@ -432,42 +488,25 @@ int Time_Action_VTimer (
     case TSFFI_UPDATE_ACTION:
         data = (struct timer_data*)*user_action_data;
 
-        if(
-           !(data->flags&(TIMER_FLAG_FINISHED|TIMER_FLAG_TRIGGERED|TIMER_FLAG_TRIGGERED_WAIT)) &&
-           data->timer_id != 0
-          )
-        {
-            KillTimer(NULL, data->timer_id);
-            FFILib_RemoveID(data->timer_id, &timer_id_hash);
-        }
+        StopTimer(data);
 
         delay = (int)input->real_data;
         if(delay < 0)
         {
             data->flags = TIMER_FLAG_FINISHED;
 
-            action_data->execif->signal_action(action_data->execif_data);
+            SignalState(data);
         }
         else
         {
             data->flags = 0;
 
-            data->timer_id = SetTimer(
-                                      NULL,
-                                      0,
-                                      (unsigned int)delay,
-                                      &TimerEvent
-                                     );
-            if(data->timer_id == 0)
+            error = StartTimer(data, (unsigned int)delay, 0);
+            if(error != TIME_ERROR_NONE)
                 return TSFFI_ERROR_EXCEPTION;
 
-            error = FFILib_AddID(data->timer_id, data, &timer_id_hash);
-            if(error != FFILIB_ERROR_NONE)
-            {
-                KillTimer(NULL, data->timer_id);
-
-                return TSFFI_ERROR_EXCEPTION;
-            }
+            /* A restarted timer is pending again */
+            SignalState(data);
         }
 
         break;
@@ -475,26 +514,14 @@ int Time_Action_VTimer (
     case TSFFI_QUERY_ACTION:
         data = (struct timer_data*)*user_action_data;
 
-        if(data->flags&TIMER_FLAG_FINISHED)
-            *state = TSFFI_ACTION_STATE_FINISHED;
-        else if(data->flags&TIMER_FLAG_TRIGGERED)
-            *state = TSFFI_ACTION_STATE_TRIGGERED;
-        else
-            *state = TSFFI_ACTION_STATE_PENDING;
+        *state = TimerState(data);
 
         break;
 
     case TSFFI_STOP_ACTION:
         data = (struct timer_data*)*user_action_data;
 
-        if(
-           !(data->flags&(TIMER_FLAG_FINISHED|TIMER_FLAG_TRIGGERED|TIMER_FLAG_TRIGGERED_WAIT)) &&
-           data->timer_id != 0
-          )
-        {
-            KillTimer(NULL, data->timer_id);
-            FFILib_RemoveID(data->timer_id, &timer_id_hash);
-        }
+        StopTimer(data);
 
         free(data);
 
@@ -503,9 +530,7 @@ int Time_Action_VTimer (
 
    return TSFFI_ERROR_NONE;
 
-add_id_failed:
-    KillTimer(NULL, data->timer_id);
-set_timer_failed:
+schedule_failed:
     free(data);
 
     return TSFFI_ERROR_EXCEPTION;
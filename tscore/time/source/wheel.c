@@ -0,0 +1,257 @@
+/*
+ * Copyright 2011 Andrew Gottemoller.
+ *
+ * This software is a copyrighted work licensed under the terms of the
+ * Trigger Script license.  Please consult the file "TS_LICENSE" for
+ * details.
+ */
+
+#include <time/wheel.h>
+#include <time/error.h>
+
+#include <windows.h>
+
+
+#define WHEEL_TIMER_PERIOD USER_TIMER_MINIMUM
+
+#define WHEEL_SLOT_MASK (TIME_WHEEL_SLOT_COUNT-1)
+
+
+/* Every timer of the process lives in one wheel owned by the ffilib
+   control thread.  Level 0 slots are a millisecond apart and each level
+   above spans a full turn of the level below it, so any 32 bit delay is
+   reachable and inserting or cancelling a timer never searches */
+struct time_wheel
+{
+    struct time_wheel_entry slots[TIME_WHEEL_LEVEL_COUNT][TIME_WHEEL_SLOT_COUNT];
+
+    unsigned int current_tick;
+    unsigned int last_clock;
+    unsigned int entry_count;
+    UINT_PTR     timer_id;
+};
+
+
+static unsigned int ReadClock (void);
+
+static void LinkEntry   (struct time_wheel_entry*, struct time_wheel_entry*);
+static void UnlinkEntry (struct time_wheel_entry*);
+static void PlaceEntry  (struct time_wheel_entry*);
+static void Cascade     (unsigned int, unsigned int);
+static void AdvanceTick (void);
+
+static VOID CALLBACK WheelTimerEvent (HWND, UINT, UINT_PTR, DWORD);
+
+
+static struct time_wheel timer_wheel;
+
+
+static unsigned int ReadClock (void)
+{
+    return GetTickCount();
+}
+
+static void LinkEntry (struct time_wheel_entry* slot, struct time_wheel_entry* entry)
+{
+    if(slot->next_entry == NULL)
+    {
+        slot->next_entry     = slot;
+        slot->previous_entry = slot;
+    }
+
+    entry->next_entry     = slot;
+    entry->previous_entry = slot->previous_entry;
+
+    slot->previous_entry->next_entry = entry;
+    slot->previous_entry             = entry;
+}
+
+static void UnlinkEntry (struct time_wheel_entry* entry)
+{
+    entry->previous_entry->next_entry = entry->next_entry;
+    entry->next_entry->previous_entry = entry->previous_entry;
+
+    entry->next_entry     = NULL;
+    entry->previous_entry = NULL;
+}
+
+static void PlaceEntry (struct time_wheel_entry* entry)
+{
+    unsigned int remaining;
+    unsigned int level;
+
+    remaining = entry->expiry-timer_wheel.current_tick;
+
+    for(level = 0; level < TIME_WHEEL_LEVEL_COUNT-1; level++)
+    {
+        if(remaining < 1u<<(TIME_WHEEL_SLOT_BITS*(level+1)))
+            break;
+    }
+
+    LinkEntry(
+              &timer_wheel.slots[level][(entry->expiry>>(TIME_WHEEL_SLOT_BITS*level))&WHEEL_SLOT_MASK],
+              entry
+             );
+}
+
+static void Cascade (unsigned int level, unsigned int index)
+{
+    struct time_wheel_entry* slot;
+
+    slot = &timer_wheel.slots[level][index];
+    if(slot->next_entry == NULL)
+        return;
+
+    while(slot->next_entry != slot)
+    {
+        struct time_wheel_entry* entry;
+
+        entry = slot->next_entry;
+
+        UnlinkEntry(entry);
+        PlaceEntry(entry);
+    }
+}
+
+static void AdvanceTick (void)
+{
+    struct time_wheel_entry  expired;
+    struct time_wheel_entry* slot;
+    unsigned int             level;
+
+    timer_wheel.current_tick++;
+
+    /* Once the lowest level wraps, pull the next slot of each level above
+       it down toward the slot that now covers it */
+    for(level = 1; level < TIME_WHEEL_LEVEL_COUNT; level++)
+    {
+        unsigned int index;
+
+        if((timer_wheel.current_tick>>(TIME_WHEEL_SLOT_BITS*(level-1)))&WHEEL_SLOT_MASK)
+            break;
+
+        index = (timer_wheel.current_tick>>(TIME_WHEEL_SLOT_BITS*level))&WHEEL_SLOT_MASK;
+
+        Cascade(level, index);
+    }
+
+    slot = &timer_wheel.slots[0][timer_wheel.current_tick&WHEEL_SLOT_MASK];
+    if(slot->next_entry == NULL || slot->next_entry == slot)
+        return;
+
+    /* Everything in the slot expires on this tick, so it is fired as one
+       batch off a private list that callbacks can safely cancel from */
+    expired.next_entry     = slot->next_entry;
+    expired.previous_entry = slot->previous_entry;
+
+    expired.next_entry->previous_entry = &expired;
+    expired.previous_entry->next_entry = &expired;
+
+    slot->next_entry     = slot;
+    slot->previous_entry = slot;
+
+    while(expired.next_entry != &expired)
+    {
+        struct time_wheel_entry* entry;
+
+        entry = expired.next_entry;
+
+        UnlinkEntry(entry);
+
+        if(entry->period != 0)
+        {
+            entry->expiry += entry->period;
+
+            PlaceEntry(entry);
+        }
+        else
+            timer_wheel.entry_count--;
+
+        entry->callback(entry);
+    }
+}
+
+static VOID CALLBACK WheelTimerEvent (
+                                      HWND     window_handle,
+                                      UINT     message,
+                                      UINT_PTR timer_id,
+                                      DWORD    time_ellapsed
+                                     )
+{
+    unsigned int clock;
+    unsigned int elapsed;
+
+    clock   = ReadClock();
+    elapsed = clock-timer_wheel.last_clock;
+
+    timer_wheel.last_clock = clock;
+
+    while(elapsed-- && timer_wheel.entry_count != 0)
+        AdvanceTick();
+
+    if(timer_wheel.entry_count == 0 && timer_wheel.timer_id != 0)
+    {
+        KillTimer(NULL, timer_wheel.timer_id);
+
+        timer_wheel.timer_id = 0;
+    }
+}
+
+
+void Time_InitializeWheelEntry (
+                                struct time_wheel_entry* entry,
+                                time_wheel_callback      callback,
+                                void*                    data
+                               )
+{
+    entry->next_entry     = NULL;
+    entry->previous_entry = NULL;
+    entry->expiry         = 0;
+    entry->period         = 0;
+    entry->callback       = callback;
+    entry->data           = data;
+}
+
+int Time_ScheduleWheelEntry (
+                             struct time_wheel_entry* entry,
+                             unsigned int             delay,
+                             unsigned int             period
+                            )
+{
+    unsigned int clock;
+
+    clock = ReadClock();
+
+    if(timer_wheel.timer_id == 0)
+    {
+        timer_wheel.timer_id = SetTimer(NULL, 0, WHEEL_TIMER_PERIOD, &WheelTimerEvent);
+        if(timer_wheel.timer_id == 0)
+            return TIME_ERROR_SYSTEM_CALL;
+
+        timer_wheel.last_clock = clock;
+    }
+
+    if(delay == 0)
+        delay = 1;
+
+    /* The wheel only catches up to the clock when the OS timer fires, so
+       the delay is measured from the clock rather than the last tick */
+    entry->expiry = timer_wheel.current_tick+(clock-timer_wheel.last_clock)+delay;
+    entry->period = period;
+
+    PlaceEntry(entry);
+
+    timer_wheel.entry_count++;
+
+    return TIME_ERROR_NONE;
+}
+
+void Time_CancelWheelEntry (struct time_wheel_entry* entry)
+{
+    if(entry->next_entry == NULL)
+        return;
+
+    UnlinkEntry(entry);
+
+    timer_wheel.entry_count--;
+}